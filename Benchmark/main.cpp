@@ -0,0 +1,318 @@
+﻿#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <vsl/targa.h>
+#include <vsl/mapped_file.h>
+#include <vsl/fft.h>
+#include <vsl/cpu_fft.h>
+#include <vsl/thread_pool.h>
+
+
+namespace
+{
+	static const uint16_t	kTgaWidth = 2048;
+	static const uint16_t	kTgaHeight = 2048;
+	static const int		kTgaIterations = 20;
+
+	typedef std::chrono::high_resolution_clock Clock;
+
+	double ElapsedSec(const Clock::time_point& start)
+	{
+		return std::chrono::duration<double>(Clock::now() - start).count();
+	}
+
+	//----
+	// ランとノイズが混在するテスト画像を生成する
+	// RLE圧縮時にRLEパケットとRAWパケットの両方が出るようにしておく
+	std::vector<uint8_t> MakeTestImage(uint16_t width, uint16_t height, uint8_t bpp)
+	{
+		std::vector<uint8_t> pixels(width * height * bpp);
+		uint32_t seed = 12345;
+		for (uint32_t y = 0; y < height; y++)
+		{
+			for (uint32_t x = 0; x < width; x++)
+			{
+				uint8_t* p = &pixels[(y * width + x) * bpp];
+				bool flat = ((x / 64) + (y / 64)) % 2 == 0;
+				for (uint8_t c = 0; c < bpp; c++)
+				{
+					seed = seed * 1664525 + 1013904223;
+					p[c] = flat ? static_cast<uint8_t>(x / 64 + c * 40) : static_cast<uint8_t>(seed >> 24);
+				}
+			}
+		}
+		return pixels;
+	}
+
+	//----
+	// 従来の fread ベースのリーダー
+	bool ReadWithFILE(const std::string& filename, tga_image& tga)
+	{
+		return tga_read(&tga, filename.c_str()) == TGA_NOERR;
+	}
+
+	//----
+	// メモリマップ + tga_read_from_memory
+	bool ReadWithMapping(const std::string& filename, tga_image& tga)
+	{
+		vsl::MappedFile file;
+		if (!file.Open(filename))
+		{
+			return false;
+		}
+		return tga_read_from_memory(&tga, file.GetData(), file.GetSize()) == TGA_NOERR;
+	}
+
+	//----
+	double MeasureTga(const std::string& filename, bool (*readFunc)(const std::string&, tga_image&), std::vector<uint8_t>* pResult)
+	{
+		// ファイルキャッシュを温めるために1回空読みする
+		tga_image tga;
+		if (!readFunc(filename, tga))
+		{
+			return 0.0;
+		}
+		size_t bytes = tga.width * tga.height * tga.pixel_depth / 8;
+		if (pResult)
+		{
+			pResult->assign(tga.image_data, tga.image_data + bytes);
+		}
+		tga_free_buffers(&tga);
+
+		auto start = Clock::now();
+		for (int i = 0; i < kTgaIterations; i++)
+		{
+			readFunc(filename, tga);
+			tga_free_buffers(&tga);
+		}
+		double sec = ElapsedSec(start);
+
+		// デコード後のバイト数で MB/s を計算する
+		return static_cast<double>(bytes) * kTgaIterations / sec / (1024.0 * 1024.0);
+	}
+
+	//----
+	// Targa 読み込みのスループット比較
+	bool BenchTga()
+	{
+		printf("---- Targa decode (%ux%u, %d iterations) ----\n", kTgaWidth, kTgaHeight, kTgaIterations);
+		printf("%-12s %-6s %12s %12s %8s\n", "format", "depth", "FILE MB/s", "mmap MB/s", "speedup");
+
+		bool ret = true;
+		const uint8_t depths[] = { 24, 32 };
+		for (uint8_t depth : depths)
+		{
+			std::vector<uint8_t> pixels = MakeTestImage(kTgaWidth, kTgaHeight, depth / 8);
+			for (int rle = 0; rle < 2; rle++)
+			{
+				std::string filename = rle ? "bench_rle.tga" : "bench_raw.tga";
+				tga_result res = rle
+					? tga_write_bgr_rle(filename.c_str(), pixels.data(), kTgaWidth, kTgaHeight, depth)
+					: tga_write_bgr(filename.c_str(), pixels.data(), kTgaWidth, kTgaHeight, depth);
+				if (res != TGA_NOERR)
+				{
+					printf("failed to write %s : %s\n", filename.c_str(), tga_error(res));
+					return false;
+				}
+
+				std::vector<uint8_t> resultFILE, resultMapped;
+				double mbFILE = MeasureTga(filename, ReadWithFILE, &resultFILE);
+				double mbMapped = MeasureTga(filename, ReadWithMapping, &resultMapped);
+				bool match = !resultFILE.empty() && (resultFILE == resultMapped);
+				ret = ret && match;
+
+				printf("%-12s %-6u %12.1f %12.1f %7.2fx%s\n",
+					rle ? "BGR RLE" : "BGR raw", depth, mbFILE, mbMapped,
+					(mbFILE > 0.0) ? mbMapped / mbFILE : 0.0,
+					match ? "" : "  MISMATCH");
+
+				remove(filename.c_str());
+			}
+		}
+		return ret;
+	}
+
+	//----
+	// FFT 1回あたりのメモリ転送量の比較
+	// 中間をイメージ2枚で持つ場合と、複素数を詰めたバッファで持つ場合
+	bool BenchFFTTraffic()
+	{
+		printf("---- FFT bytes moved per transform (forward real -> complex + inverse complex -> real) ----\n");
+		printf("%-12s %14s %14s %8s\n", "size", "images MB", "packed MB", "ratio");
+
+		const uint32_t sizes[] = { 256, 512, 1024, 2048, 4096 };
+		for (uint32_t size : sizes)
+		{
+			vsl::FFTPlanDesc forward, inverse;
+			forward.width = forward.height = size;
+			forward.direction = vsl::FFTDirection::Forward;
+			inverse = forward;
+			inverse.direction = vsl::FFTDirection::Inverse;
+
+			uint64_t images = vsl::FFTPlan::ComputeBytesMoved(forward, vsl::FFTDataType::RealImage, vsl::FFTDataType::ComplexImages, vsl::FFTDataType::ComplexImages)
+				+ vsl::FFTPlan::ComputeBytesMoved(inverse, vsl::FFTDataType::ComplexImages, vsl::FFTDataType::RealImage, vsl::FFTDataType::ComplexImages);
+			uint64_t packed = vsl::FFTPlan::ComputeBytesMoved(forward, vsl::FFTDataType::RealImage, vsl::FFTDataType::PackedBuffer)
+				+ vsl::FFTPlan::ComputeBytesMoved(inverse, vsl::FFTDataType::PackedBuffer, vsl::FFTDataType::RealImage);
+
+			char name[32];
+			snprintf(name, sizeof(name), "%ux%u", size, size);
+			printf("%-12s %14.2f %14.2f %7.2fx\n", name,
+				images / (1024.0 * 1024.0), packed / (1024.0 * 1024.0),
+				static_cast<double>(images) / static_cast<double>(packed));
+		}
+		return true;
+	}
+
+	//----
+	// 精度ごとのメモリ転送量の比較
+	// PackedHalf は共有メモリのみ異なるため、転送量は Half と同じ
+	bool BenchFFTPrecisionTraffic()
+	{
+		printf("---- FFT bytes moved per transform by precision (packed, forward + inverse) ----\n");
+		printf("%-12s %14s %14s %8s\n", "size", "fp16 MB", "fp32 MB", "ratio");
+
+		const uint32_t sizes[] = { 256, 512, 1024, 2048, 4096 };
+		for (uint32_t size : sizes)
+		{
+			uint64_t bytes[2];
+			const vsl::FFTPrecision::Type precisions[] = { vsl::FFTPrecision::Half, vsl::FFTPrecision::Single };
+			for (int i = 0; i < 2; i++)
+			{
+				vsl::FFTPlanDesc forward, inverse;
+				forward.width = forward.height = size;
+				forward.direction = vsl::FFTDirection::Forward;
+				forward.precision = precisions[i];
+				inverse = forward;
+				inverse.direction = vsl::FFTDirection::Inverse;
+				bytes[i] = vsl::FFTPlan::ComputeBytesMoved(forward, vsl::FFTDataType::RealImage, vsl::FFTDataType::PackedBuffer)
+					+ vsl::FFTPlan::ComputeBytesMoved(inverse, vsl::FFTDataType::PackedBuffer, vsl::FFTDataType::RealImage);
+			}
+
+			char name[32];
+			snprintf(name, sizeof(name), "%ux%u", size, size);
+			printf("%-12s %14.2f %14.2f %7.2fx\n", name,
+				bytes[0] / (1024.0 * 1024.0), bytes[1] / (1024.0 * 1024.0),
+				static_cast<double>(bytes[1]) / static_cast<double>(bytes[0]));
+		}
+		return true;
+	}
+
+	//----
+	bool BenchFFTRealPair()
+	{
+		printf("---- FFT 1D transforms per transform (forward real -> complex + inverse complex -> real) ----\n");
+		printf("%-12s %14s %14s %8s\n", "size", "complex", "real pair", "ratio");
+
+		const uint32_t sizes[] = { 256, 512, 1024, 2048, 4096 };
+		for (uint32_t size : sizes)
+		{
+			vsl::FFTPlanDesc forward, inverse;
+			forward.width = forward.height = size;
+			forward.direction = vsl::FFTDirection::Forward;
+			forward.packRealPairs = false;
+			inverse = forward;
+			inverse.direction = vsl::FFTDirection::Inverse;
+
+			uint32_t complex = vsl::FFTPlan::ComputeLineTransforms(forward, vsl::FFTDataType::RealImage, vsl::FFTDataType::PackedBuffer)
+				+ vsl::FFTPlan::ComputeLineTransforms(inverse, vsl::FFTDataType::PackedBuffer, vsl::FFTDataType::RealImage);
+			forward.packRealPairs = inverse.packRealPairs = true;
+			uint32_t paired = vsl::FFTPlan::ComputeLineTransforms(forward, vsl::FFTDataType::RealImage, vsl::FFTDataType::PackedBuffer)
+				+ vsl::FFTPlan::ComputeLineTransforms(inverse, vsl::FFTDataType::PackedBuffer, vsl::FFTDataType::RealImage);
+
+			char name[32];
+			snprintf(name, sizeof(name), "%ux%u", size, size);
+			printf("%-12s %14u %14u %7.2fx\n", name, complex, paired,
+				static_cast<double>(complex) / static_cast<double>(paired));
+		}
+		return true;
+	}
+
+	//----
+	// CPU FFT の順変換の速度と、順変換 -> 逆変換で戻した結果の誤差
+	bool BenchCpuFFT()
+	{
+		static const int kIterations = 4;
+		static const char* kSimdStrs[] = { "scalar", "SSE", "AVX2" };
+
+		printf("---- CPU FFT forward (%d iterations, best) ----\n", kIterations);
+		printf("%-12s %-8s %-8s %12s %12s\n", "size", "simd", "threads", "ms", "round trip");
+
+		vsl::ThreadPool pool;
+		if (!pool.Initialize())
+		{
+			return false;
+		}
+
+		bool ret = true;
+		const uint32_t sizes[] = { 256, 512, 1024, 2048 };
+		for (uint32_t size : sizes)
+		{
+			vsl::CpuFFTImage source;
+			source.Initialize(size, size);
+			uint32_t seed = 12345;
+			for (auto& v : source.real)
+			{
+				seed = seed * 1103515245 + 12345;
+				v = static_cast<float>((seed >> 16) & 0xff) / 255.0f;
+			}
+
+			for (int simd = 0; simd <= vsl::CpuFFTPlan::GetSupportedSimd(); simd++)
+			{
+				for (int threaded = 0; threaded < 2; threaded++)
+				{
+					vsl::FFTPlanDesc desc;
+					desc.width = desc.height = size;
+					vsl::CpuFFTPlan forward, inverse;
+					vsl::ThreadPool* pPool = threaded ? &pool : nullptr;
+					if (!forward.Initialize(desc, pPool, static_cast<vsl::CpuFFTSimd::Type>(simd)))
+					{
+						return false;
+					}
+					desc.direction = vsl::FFTDirection::Inverse;
+					if (!inverse.Initialize(desc, pPool, static_cast<vsl::CpuFFTSimd::Type>(simd)))
+					{
+						return false;
+					}
+
+					vsl::CpuFFTImage spectrum, result;
+					double best = 1e30;
+					for (int i = 0; i < kIterations; i++)
+					{
+						Clock::time_point start = Clock::now();
+						forward.Execute(source, spectrum);
+						best = (std::min)(best, ElapsedSec(start));
+					}
+					inverse.Execute(spectrum, result);
+					vsl::FFTError error = vsl::FFTError::Compare(source, result);
+					ret = ret && (error.maxError < 1e-4);
+
+					char name[32];
+					snprintf(name, sizeof(name), "%ux%u", size, size);
+					printf("%-12s %-8s %-8u %12.2f %12.2e\n", name, kSimdStrs[simd],
+						threaded ? pool.GetThreadCount() + 1 : 1, best * 1000.0, error.maxError);
+				}
+			}
+		}
+		return ret;
+	}
+
+}	// namespace
+
+int main(int argc, char* argv[])
+{
+	bool ret = true;
+
+	ret = BenchTga() && ret;
+	ret = BenchFFTTraffic() && ret;
+	ret = BenchFFTPrecisionTraffic() && ret;
+	ret = BenchFFTRealPair() && ret;
+	ret = BenchCpuFFT() && ret;
+
+	return ret ? 0 : 1;
+}
+
+
+//	EOF
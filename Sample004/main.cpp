@@ -10,6 +10,8 @@
 #include <vsl/shader.h>
 #include <vsl/render_pass.h>
 #include <vsl/gui.h>
+#include <vsl/pipeline_builder.h>
+#include <vsl/pipeline_statistics.h>
 #include <imgui.h>
 
 
@@ -136,6 +138,10 @@ public:
 			}
 		}
 
+		// pCvCv̓CR}hobt@ƂɃNGv[
+		// ΉĂȂł͌vȂ
+		statistics_.Initialize(device, static_cast<uint32_t>(device.GetCommandBuffers().size()));
+
 		// `惊\[X̏
 		if (!InitializeRenderResource(device, initCmdBuffer))
 		{
@@ -186,9 +192,29 @@ public:
 		
 		static float sRotY = 1.0f;
 
+		// O񂱂̃R}hobt@Ōvv
+		statistics_.BeginFrame(cmdBuffer, device.GetCurrentBufferIndex());
+
 		// TEST: imgui
 		gui_.BeginNewFrame(kScreenWidth, kScreenHeight, input);
 		ImGui::Text("Hello, world!");
+
+		// pCvCv
+		// |XgpX͑Sʂ̋`Ȃ̂ŁAsNZVF[_̋N͉ʂ̃sNZƈv͂
+		if (statistics_.IsValid())
+		{
+			gui_.ShowPipelineStatistics(statistics_);
+			const vsl::PipelineStatisticsEntry* pPost = statistics_.Find("Post");
+			if (pPost)
+			{
+				double pixels = static_cast<double>(kScreenWidth) * kScreenHeight;
+				ImGui::Text("Post fragments per pixel : %.3f", pPost->values[vsl::PipelineStatisticsCounter::FragmentInvocations] / pixels);
+			}
+		}
+		else
+		{
+			ImGui::Text("Pipeline statistics query is not supported.");
+		}
 		
 		// UniformBufferAbvf[g
 		{
@@ -241,6 +267,7 @@ public:
 		}
 
 		// bVpXJn
+		statistics_.BeginScope(cmdBuffer, "Mesh");
 		vk::RenderPassBeginInfo renderPassBeginInfo;
 		renderPassBeginInfo.renderPass = meshPass_.GetPass();
 		renderPassBeginInfo.renderArea.extent = vk::Extent2D(kScreenWidth, kScreenHeight);
@@ -275,6 +302,7 @@ public:
 			cmdBuffer.drawIndexed(6, 1, 0, 0, 1);
 		}
 		cmdBuffer.endRenderPass();
+		statistics_.EndScope(cmdBuffer);
 
 		// ItXN[obt@̃CAEgύX
 		{
@@ -295,6 +323,7 @@ public:
 		}
 
 		// |XgpXJn
+		statistics_.BeginScope(cmdBuffer, "Post");
 		renderPassBeginInfo.renderPass = postPass_.GetPass();
 		renderPassBeginInfo.renderArea.extent = vk::Extent2D(kScreenWidth, kScreenHeight);
 		renderPassBeginInfo.clearValueCount = 0;
@@ -310,6 +339,7 @@ public:
 			cmdBuffer.draw(4, 1, 0, 0);
 		}
 		cmdBuffer.endRenderPass();
+		statistics_.EndScope(cmdBuffer);
 
 		// TEST: imgui render.
 		gui_.SetPassBeginInfo(renderPassBeginInfo);
@@ -327,10 +357,10 @@ public:
 		vk::Device& d = device.GetDevice();
 
 		gui_.Destroy();
+		statistics_.Destroy();
 
-		d.destroyPipeline(postPipeline_);
+		// pCvCDevicẽLbVLĂ
 		d.destroyPipelineLayout(postPipeLayout_);
-		d.destroyPipeline(pipeline_);
 		d.destroyPipelineLayout(pipeLayout_);
 
 		vsTest_.Destroy();
@@ -344,7 +374,6 @@ public:
 		}
 		d.destroyDescriptorPool(descPool_);
 
-		d.destroySampler(sampler_);
 		texture_.Destroy();
 
 		vbuffer_.Destroy();
@@ -422,7 +451,7 @@ private:
 			samplerCreateInfo.maxAnisotropy = 8;
 			samplerCreateInfo.anisotropyEnable = VK_TRUE;
 			samplerCreateInfo.borderColor = vk::BorderColor::eFloatOpaqueWhite;
-			sampler_ = device.GetDevice().createSampler(samplerCreateInfo);
+			sampler_ = device.GetSamplerCache().GetSampler(samplerCreateInfo);
 		}
 
 		// _obt@
@@ -581,118 +610,20 @@ private:
 			pipeLayout_ = device.GetDevice().createPipelineLayout(pPipelineLayoutCreateInfo);
 		}
 
-		// `g|W̐ݒ
-		vk::PipelineInputAssemblyStateCreateInfo inputAssemblyState;
-		inputAssemblyState.topology = vk::PrimitiveTopology::eTriangleList;
-
-		// X^CYXe[g̐ݒ
-		vk::PipelineRasterizationStateCreateInfo rasterizationState;
-		rasterizationState.polygonMode = vk::PolygonMode::eFill;
-		rasterizationState.cullMode = vk::CullModeFlagBits::eNone;
-		rasterizationState.frontFace = vk::FrontFace::eCounterClockwise;
-		rasterizationState.depthClampEnable = VK_FALSE;
-		rasterizationState.rasterizerDiscardEnable = VK_FALSE;
-		rasterizationState.depthBiasEnable = VK_FALSE;
-		rasterizationState.lineWidth = 1.0f;
-
-		// uh[h̐ݒ
-		vk::PipelineColorBlendStateCreateInfo colorBlendState;
-		vk::PipelineColorBlendAttachmentState blendAttachmentState[1] = {};
-		blendAttachmentState[0].colorWriteMask = vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG | vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA;
-		blendAttachmentState[0].blendEnable = VK_TRUE;
-		blendAttachmentState[0].colorBlendOp = vk::BlendOp::eAdd;
-		blendAttachmentState[0].srcColorBlendFactor = vk::BlendFactor::eSrcAlpha;
-		blendAttachmentState[0].dstColorBlendFactor = vk::BlendFactor::eOneMinusSrcAlpha;
-		blendAttachmentState[0].alphaBlendOp = vk::BlendOp::eAdd;
-		blendAttachmentState[0].srcAlphaBlendFactor = vk::BlendFactor::eOne;
-		blendAttachmentState[0].dstAlphaBlendFactor = vk::BlendFactor::eZero;
-		colorBlendState.attachmentCount = ARRAYSIZE(blendAttachmentState);
-		colorBlendState.pAttachments = blendAttachmentState;
-
-		// ViewportXe[g̐ݒ
-		vk::PipelineViewportStateCreateInfo viewportState;
-		viewportState.viewportCount = 1;
-		viewportState.scissorCount = 1;
-
-		// DynamicState𗘗pViewportScissorBoxύXł悤ɂĂ
-		vk::PipelineDynamicStateCreateInfo dynamicState;
-		std::vector<vk::DynamicState> dynamicStateEnables;
-		dynamicStateEnables.push_back(vk::DynamicState::eViewport);
-		dynamicStateEnables.push_back(vk::DynamicState::eScissor);
-		dynamicState.pDynamicStates = dynamicStateEnables.data();
-		dynamicState.dynamicStateCount = static_cast<uint32_t>(dynamicStateEnables.size());
-
-		// DepthStensilXe[g̐ݒ
-		vk::PipelineDepthStencilStateCreateInfo depthStencilState;
-		depthStencilState.depthTestEnable = VK_TRUE;
-		depthStencilState.depthWriteEnable = VK_TRUE;
-		depthStencilState.depthCompareOp = vk::CompareOp::eLessOrEqual;
-		depthStencilState.depthBoundsTestEnable = VK_FALSE;
-		depthStencilState.back.failOp = vk::StencilOp::eKeep;
-		depthStencilState.back.passOp = vk::StencilOp::eKeep;
-		depthStencilState.back.compareOp = vk::CompareOp::eAlways;
-		depthStencilState.stencilTestEnable = VK_FALSE;
-		depthStencilState.front = depthStencilState.back;
-
-		// }`TvXe[g
-		vk::PipelineMultisampleStateCreateInfo multisampleState;
-		multisampleState.pSampleMask = NULL;
-		multisampleState.rasterizationSamples = vk::SampleCountFlagBits::e1;
-
-		// VF[_ݒ
-		std::array<vk::PipelineShaderStageCreateInfo, 2> shaderStages;
-		shaderStages[0].stage = vk::ShaderStageFlagBits::eVertex;
-		shaderStages[0].module = vsTest_.GetModule();
-		shaderStages[0].pName = "main";
-		shaderStages[1].stage = vk::ShaderStageFlagBits::eFragment;
-		shaderStages[1].module = psTest_.GetModule();
-		shaderStages[1].pName = "main";
-
-		// _
-		std::array<vk::VertexInputBindingDescription, 1> bindDescs;
-		bindDescs[0].binding = 0;		// 0ԂփoCh
-		bindDescs[0].stride = sizeof(Vertex);
-		bindDescs[0].inputRate = vk::VertexInputRate::eVertex;
-
-		std::array<vk::VertexInputAttributeDescription, 3> attribDescs;
-		// Position
-		attribDescs[0].binding = 0;
-		attribDescs[0].location = 0;
-		attribDescs[0].format = vk::Format::eR32G32B32Sfloat;
-		attribDescs[0].offset = 0;
-		// Color
-		attribDescs[1].binding = 0;
-		attribDescs[1].location = 1;
-		attribDescs[1].format = vk::Format::eR32G32B32A32Sfloat;
-		attribDescs[1].offset = sizeof(glm::vec3);
-		// UV
-		attribDescs[2].binding = 0;
-		attribDescs[2].location = 2;
-		attribDescs[2].format = vk::Format::eR32G32Sfloat;
-		attribDescs[2].offset = attribDescs[1].offset + sizeof(glm::vec4);
-
-		vk::PipelineVertexInputStateCreateInfo vinputState;
-		vinputState.vertexBindingDescriptionCount = static_cast<uint32_t>(bindDescs.size());
-		vinputState.pVertexBindingDescriptions = bindDescs.data();
-		vinputState.vertexAttributeDescriptionCount = static_cast<uint32_t>(attribDescs.size());
-		vinputState.pVertexAttributeDescriptions = attribDescs.data();
-
-		// pCvCɊeXe[gݒ肵Đ
-		vk::GraphicsPipelineCreateInfo pipelineCreateInfo;
-		pipelineCreateInfo.layout = pipeLayout_;
-		pipelineCreateInfo.renderPass = meshPass_.GetPass();
-		pipelineCreateInfo.stageCount = static_cast<uint32_t>(shaderStages.size());
-		pipelineCreateInfo.pStages = shaderStages.data();
-		pipelineCreateInfo.pVertexInputState = &vinputState;
-		pipelineCreateInfo.pInputAssemblyState = &inputAssemblyState;
-		pipelineCreateInfo.pRasterizationState = &rasterizationState;
-		pipelineCreateInfo.pColorBlendState = &colorBlendState;
-		pipelineCreateInfo.pMultisampleState = &multisampleState;
-		pipelineCreateInfo.pViewportState = &viewportState;
-		pipelineCreateInfo.pDepthStencilState = &depthStencilState;
-		pipelineCreateInfo.pDynamicState = &dynamicState;
-
-		pipeline_ = device.GetDevice().createGraphicsPipelines(device.GetPipelineCache(), pipelineCreateInfo, nullptr)[0];
+		// pCvC
+		// [xeXg̔AViewportScissorBox͓IɕύX
+		vsl::PipelineBuilder builder;
+		builder.SetShader(vk::ShaderStageFlagBits::eVertex, vsTest_.GetModule())
+			.SetShader(vk::ShaderStageFlagBits::eFragment, psTest_.GetModule())
+			.SetVertexBinding(0, sizeof(Vertex))
+			.AddVertexAttribute(0, 0, vk::Format::eR32G32B32Sfloat, 0)										// Position
+			.AddVertexAttribute(1, 0, vk::Format::eR32G32B32A32Sfloat, sizeof(glm::vec3))					// Color
+			.AddVertexAttribute(2, 0, vk::Format::eR32G32Sfloat, sizeof(glm::vec3) + sizeof(glm::vec4))	// UV
+			.SetAlphaBlend(0)
+			.SetLayout(pipeLayout_)
+			.SetRenderPass(meshPass_);
+
+		pipeline_ = builder.Build(device);
 		if (!pipeline_)
 		{
 			return false;
@@ -712,92 +643,17 @@ private:
 			postPipeLayout_ = device.GetDevice().createPipelineLayout(pPipelineLayoutCreateInfo);
 		}
 
-		// `g|W̐ݒ
-		vk::PipelineInputAssemblyStateCreateInfo inputAssemblyState;
-		inputAssemblyState.topology = vk::PrimitiveTopology::eTriangleStrip;
-
-		// X^CYXe[g̐ݒ
-		vk::PipelineRasterizationStateCreateInfo rasterizationState;
-		rasterizationState.polygonMode = vk::PolygonMode::eFill;
-		rasterizationState.cullMode = vk::CullModeFlagBits::eNone;
-		rasterizationState.frontFace = vk::FrontFace::eCounterClockwise;
-		rasterizationState.depthClampEnable = VK_FALSE;
-		rasterizationState.rasterizerDiscardEnable = VK_FALSE;
-		rasterizationState.depthBiasEnable = VK_FALSE;
-		rasterizationState.lineWidth = 1.0f;
-
-		// uh[h̐ݒ
-		vk::PipelineColorBlendStateCreateInfo colorBlendState;
-		vk::PipelineColorBlendAttachmentState blendAttachmentState[1] = {};
-		blendAttachmentState[0].colorWriteMask = vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG | vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA;
-		blendAttachmentState[0].blendEnable = VK_TRUE;
-		blendAttachmentState[0].colorBlendOp = vk::BlendOp::eAdd;
-		blendAttachmentState[0].srcColorBlendFactor = vk::BlendFactor::eSrcAlpha;
-		blendAttachmentState[0].dstColorBlendFactor = vk::BlendFactor::eOneMinusSrcAlpha;
-		blendAttachmentState[0].alphaBlendOp = vk::BlendOp::eAdd;
-		blendAttachmentState[0].srcAlphaBlendFactor = vk::BlendFactor::eOne;
-		blendAttachmentState[0].dstAlphaBlendFactor = vk::BlendFactor::eZero;
-		colorBlendState.attachmentCount = ARRAYSIZE(blendAttachmentState);
-		colorBlendState.pAttachments = blendAttachmentState;
-
-		// ViewportXe[g̐ݒ
-		vk::PipelineViewportStateCreateInfo viewportState;
-		viewportState.viewportCount = 1;
-		viewportState.scissorCount = 1;
-
-		// DynamicState𗘗pViewportScissorBoxύXł悤ɂĂ
-		vk::PipelineDynamicStateCreateInfo dynamicState;
-		std::vector<vk::DynamicState> dynamicStateEnables;
-		dynamicStateEnables.push_back(vk::DynamicState::eViewport);
-		dynamicStateEnables.push_back(vk::DynamicState::eScissor);
-		dynamicState.pDynamicStates = dynamicStateEnables.data();
-		dynamicState.dynamicStateCount = static_cast<uint32_t>(dynamicStateEnables.size());
-
-		// DepthStensilXe[g̐ݒ
-		vk::PipelineDepthStencilStateCreateInfo depthStencilState;
-		depthStencilState.depthTestEnable = VK_TRUE;
-		depthStencilState.depthWriteEnable = VK_TRUE;
-		depthStencilState.depthCompareOp = vk::CompareOp::eLessOrEqual;
-		depthStencilState.depthBoundsTestEnable = VK_FALSE;
-		depthStencilState.back.failOp = vk::StencilOp::eKeep;
-		depthStencilState.back.passOp = vk::StencilOp::eKeep;
-		depthStencilState.back.compareOp = vk::CompareOp::eAlways;
-		depthStencilState.stencilTestEnable = VK_FALSE;
-		depthStencilState.front = depthStencilState.back;
-
-		// }`TvXe[g
-		vk::PipelineMultisampleStateCreateInfo multisampleState;
-		multisampleState.pSampleMask = NULL;
-		multisampleState.rasterizationSamples = vk::SampleCountFlagBits::e1;
-
-		// VF[_ݒ
-		std::array<vk::PipelineShaderStageCreateInfo, 2> shaderStages;
-		shaderStages[0].stage = vk::ShaderStageFlagBits::eVertex;
-		shaderStages[0].module = vsPost_.GetModule();
-		shaderStages[0].pName = "main";
-		shaderStages[1].stage = vk::ShaderStageFlagBits::eFragment;
-		shaderStages[1].module = psPost_.GetModule();
-		shaderStages[1].pName = "main";
-
-		// _
-		vk::PipelineVertexInputStateCreateInfo vinputState;
-
-		// pCvCɊeXe[gݒ肵Đ
-		vk::GraphicsPipelineCreateInfo pipelineCreateInfo;
-		pipelineCreateInfo.layout = postPipeLayout_;
-		pipelineCreateInfo.renderPass = postPass_.GetPass();
-		pipelineCreateInfo.stageCount = static_cast<uint32_t>(shaderStages.size());
-		pipelineCreateInfo.pStages = shaderStages.data();
-		pipelineCreateInfo.pVertexInputState = &vinputState;
-		pipelineCreateInfo.pInputAssemblyState = &inputAssemblyState;
-		pipelineCreateInfo.pRasterizationState = &rasterizationState;
-		pipelineCreateInfo.pColorBlendState = &colorBlendState;
-		pipelineCreateInfo.pMultisampleState = &multisampleState;
-		pipelineCreateInfo.pViewportState = &viewportState;
-		pipelineCreateInfo.pDepthStencilState = &depthStencilState;
-		pipelineCreateInfo.pDynamicState = &dynamicState;
-
-		postPipeline_ = device.GetDevice().createGraphicsPipelines(device.GetPipelineCache(), pipelineCreateInfo, nullptr)[0];
+		// pCvC
+		// _͂Ȃ̑Sʕ`
+		vsl::PipelineBuilder builder;
+		builder.SetShader(vk::ShaderStageFlagBits::eVertex, vsPost_.GetModule())
+			.SetShader(vk::ShaderStageFlagBits::eFragment, psPost_.GetModule())
+			.SetTopology(vk::PrimitiveTopology::eTriangleStrip)
+			.SetAlphaBlend(0)
+			.SetLayout(postPipeLayout_)
+			.SetRenderPass(postPass_);
+
+		postPipeline_ = builder.Build(device);
 		if (!postPipeline_)
 		{
 			return false;
@@ -831,6 +687,7 @@ private:
 	vk::Pipeline		postPipeline_;
 
 	vsl::Gui		gui_;
+	vsl::PipelineStatistics	statistics_;
 
 	vsl::Buffer		vbStaging_, ibStaging_, texStaging_, fontStaging_;
 };	// class MySample
@@ -10,6 +10,7 @@
 #include <vsl/shader.h>
 #include <vsl/render_pass.h>
 #include <vsl/gui.h>
+#include <vsl/pipeline_builder.h>
 #include <imgui.h>
 
 
@@ -383,11 +384,9 @@ public:
 
 		gui_.Destroy();
 
-		d.destroyPipeline(computePipeline_);
+		// pCvCDevicẽLbVLĂ
 		d.destroyPipelineLayout(computePipeLayout_);
-		d.destroyPipeline(postPipeline_);
 		d.destroyPipelineLayout(postPipeLayout_);
-		d.destroyPipeline(pipeline_);
 		d.destroyPipelineLayout(pipeLayout_);
 
 		vsTest_.Destroy();
@@ -402,7 +401,6 @@ public:
 		}
 		d.destroyDescriptorPool(descPool_);
 
-		d.destroySampler(sampler_);
 		texture_.Destroy();
 
 		vbuffer_.Destroy();
@@ -485,7 +483,7 @@ private:
 			samplerCreateInfo.maxAnisotropy = 8;
 			samplerCreateInfo.anisotropyEnable = VK_TRUE;
 			samplerCreateInfo.borderColor = vk::BorderColor::eFloatOpaqueWhite;
-			sampler_ = device.GetDevice().createSampler(samplerCreateInfo);
+			sampler_ = device.GetSamplerCache().GetSampler(samplerCreateInfo);
 		}
 
 		// _obt@
@@ -676,118 +674,20 @@ private:
 			pipeLayout_ = device.GetDevice().createPipelineLayout(pPipelineLayoutCreateInfo);
 		}
 
-		// `g|W̐ݒ
-		vk::PipelineInputAssemblyStateCreateInfo inputAssemblyState;
-		inputAssemblyState.topology = vk::PrimitiveTopology::eTriangleList;
-
-		// X^CYXe[g̐ݒ
-		vk::PipelineRasterizationStateCreateInfo rasterizationState;
-		rasterizationState.polygonMode = vk::PolygonMode::eFill;
-		rasterizationState.cullMode = vk::CullModeFlagBits::eNone;
-		rasterizationState.frontFace = vk::FrontFace::eCounterClockwise;
-		rasterizationState.depthClampEnable = VK_FALSE;
-		rasterizationState.rasterizerDiscardEnable = VK_FALSE;
-		rasterizationState.depthBiasEnable = VK_FALSE;
-		rasterizationState.lineWidth = 1.0f;
-
-		// uh[h̐ݒ
-		vk::PipelineColorBlendStateCreateInfo colorBlendState;
-		vk::PipelineColorBlendAttachmentState blendAttachmentState[1] = {};
-		blendAttachmentState[0].colorWriteMask = vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG | vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA;
-		blendAttachmentState[0].blendEnable = VK_TRUE;
-		blendAttachmentState[0].colorBlendOp = vk::BlendOp::eAdd;
-		blendAttachmentState[0].srcColorBlendFactor = vk::BlendFactor::eSrcAlpha;
-		blendAttachmentState[0].dstColorBlendFactor = vk::BlendFactor::eOneMinusSrcAlpha;
-		blendAttachmentState[0].alphaBlendOp = vk::BlendOp::eAdd;
-		blendAttachmentState[0].srcAlphaBlendFactor = vk::BlendFactor::eOne;
-		blendAttachmentState[0].dstAlphaBlendFactor = vk::BlendFactor::eZero;
-		colorBlendState.attachmentCount = ARRAYSIZE(blendAttachmentState);
-		colorBlendState.pAttachments = blendAttachmentState;
-
-		// ViewportXe[g̐ݒ
-		vk::PipelineViewportStateCreateInfo viewportState;
-		viewportState.viewportCount = 1;
-		viewportState.scissorCount = 1;
-
-		// DynamicState𗘗pViewportScissorBoxύXł悤ɂĂ
-		vk::PipelineDynamicStateCreateInfo dynamicState;
-		std::vector<vk::DynamicState> dynamicStateEnables;
-		dynamicStateEnables.push_back(vk::DynamicState::eViewport);
-		dynamicStateEnables.push_back(vk::DynamicState::eScissor);
-		dynamicState.pDynamicStates = dynamicStateEnables.data();
-		dynamicState.dynamicStateCount = static_cast<uint32_t>(dynamicStateEnables.size());
-
-		// DepthStensilXe[g̐ݒ
-		vk::PipelineDepthStencilStateCreateInfo depthStencilState;
-		depthStencilState.depthTestEnable = VK_TRUE;
-		depthStencilState.depthWriteEnable = VK_TRUE;
-		depthStencilState.depthCompareOp = vk::CompareOp::eLessOrEqual;
-		depthStencilState.depthBoundsTestEnable = VK_FALSE;
-		depthStencilState.back.failOp = vk::StencilOp::eKeep;
-		depthStencilState.back.passOp = vk::StencilOp::eKeep;
-		depthStencilState.back.compareOp = vk::CompareOp::eAlways;
-		depthStencilState.stencilTestEnable = VK_FALSE;
-		depthStencilState.front = depthStencilState.back;
-
-		// }`TvXe[g
-		vk::PipelineMultisampleStateCreateInfo multisampleState;
-		multisampleState.pSampleMask = NULL;
-		multisampleState.rasterizationSamples = vk::SampleCountFlagBits::e1;
-
-		// VF[_ݒ
-		std::array<vk::PipelineShaderStageCreateInfo, 2> shaderStages;
-		shaderStages[0].stage = vk::ShaderStageFlagBits::eVertex;
-		shaderStages[0].module = vsTest_.GetModule();
-		shaderStages[0].pName = "main";
-		shaderStages[1].stage = vk::ShaderStageFlagBits::eFragment;
-		shaderStages[1].module = psTest_.GetModule();
-		shaderStages[1].pName = "main";
-
-		// _
-		std::array<vk::VertexInputBindingDescription, 1> bindDescs;
-		bindDescs[0].binding = 0;		// 0ԂփoCh
-		bindDescs[0].stride = sizeof(Vertex);
-		bindDescs[0].inputRate = vk::VertexInputRate::eVertex;
-
-		std::array<vk::VertexInputAttributeDescription, 3> attribDescs;
-		// Position
-		attribDescs[0].binding = 0;
-		attribDescs[0].location = 0;
-		attribDescs[0].format = vk::Format::eR32G32B32Sfloat;
-		attribDescs[0].offset = 0;
-		// Color
-		attribDescs[1].binding = 0;
-		attribDescs[1].location = 1;
-		attribDescs[1].format = vk::Format::eR32G32B32A32Sfloat;
-		attribDescs[1].offset = sizeof(glm::vec3);
-		// UV
-		attribDescs[2].binding = 0;
-		attribDescs[2].location = 2;
-		attribDescs[2].format = vk::Format::eR32G32Sfloat;
-		attribDescs[2].offset = attribDescs[1].offset + sizeof(glm::vec4);
-
-		vk::PipelineVertexInputStateCreateInfo vinputState;
-		vinputState.vertexBindingDescriptionCount = static_cast<uint32_t>(bindDescs.size());
-		vinputState.pVertexBindingDescriptions = bindDescs.data();
-		vinputState.vertexAttributeDescriptionCount = static_cast<uint32_t>(attribDescs.size());
-		vinputState.pVertexAttributeDescriptions = attribDescs.data();
-
-		// pCvCɊeXe[gݒ肵Đ
-		vk::GraphicsPipelineCreateInfo pipelineCreateInfo;
-		pipelineCreateInfo.layout = pipeLayout_;
-		pipelineCreateInfo.renderPass = meshPass_.GetPass();
-		pipelineCreateInfo.stageCount = static_cast<uint32_t>(shaderStages.size());
-		pipelineCreateInfo.pStages = shaderStages.data();
-		pipelineCreateInfo.pVertexInputState = &vinputState;
-		pipelineCreateInfo.pInputAssemblyState = &inputAssemblyState;
-		pipelineCreateInfo.pRasterizationState = &rasterizationState;
-		pipelineCreateInfo.pColorBlendState = &colorBlendState;
-		pipelineCreateInfo.pMultisampleState = &multisampleState;
-		pipelineCreateInfo.pViewportState = &viewportState;
-		pipelineCreateInfo.pDepthStencilState = &depthStencilState;
-		pipelineCreateInfo.pDynamicState = &dynamicState;
-
-		pipeline_ = device.GetDevice().createGraphicsPipelines(device.GetPipelineCache(), pipelineCreateInfo, nullptr)[0];
+		// pCvC
+		// [xeXg̔AViewportScissorBox͓IɕύX
+		vsl::PipelineBuilder builder;
+		builder.SetShader(vk::ShaderStageFlagBits::eVertex, vsTest_.GetModule())
+			.SetShader(vk::ShaderStageFlagBits::eFragment, psTest_.GetModule())
+			.SetVertexBinding(0, sizeof(Vertex))
+			.AddVertexAttribute(0, 0, vk::Format::eR32G32B32Sfloat, 0)										// Position
+			.AddVertexAttribute(1, 0, vk::Format::eR32G32B32A32Sfloat, sizeof(glm::vec3))					// Color
+			.AddVertexAttribute(2, 0, vk::Format::eR32G32Sfloat, sizeof(glm::vec3) + sizeof(glm::vec4))	// UV
+			.SetAlphaBlend(0)
+			.SetLayout(pipeLayout_)
+			.SetRenderPass(meshPass_);
+
+		pipeline_ = builder.Build(device);
 		if (!pipeline_)
 		{
 			return false;
@@ -807,92 +707,17 @@ private:
 			postPipeLayout_ = device.GetDevice().createPipelineLayout(pPipelineLayoutCreateInfo);
 		}
 
-		// `g|W̐ݒ
-		vk::PipelineInputAssemblyStateCreateInfo inputAssemblyState;
-		inputAssemblyState.topology = vk::PrimitiveTopology::eTriangleStrip;
-
-		// X^CYXe[g̐ݒ
-		vk::PipelineRasterizationStateCreateInfo rasterizationState;
-		rasterizationState.polygonMode = vk::PolygonMode::eFill;
-		rasterizationState.cullMode = vk::CullModeFlagBits::eNone;
-		rasterizationState.frontFace = vk::FrontFace::eCounterClockwise;
-		rasterizationState.depthClampEnable = VK_FALSE;
-		rasterizationState.rasterizerDiscardEnable = VK_FALSE;
-		rasterizationState.depthBiasEnable = VK_FALSE;
-		rasterizationState.lineWidth = 1.0f;
-
-		// uh[h̐ݒ
-		vk::PipelineColorBlendStateCreateInfo colorBlendState;
-		vk::PipelineColorBlendAttachmentState blendAttachmentState[1] = {};
-		blendAttachmentState[0].colorWriteMask = vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG | vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA;
-		blendAttachmentState[0].blendEnable = VK_TRUE;
-		blendAttachmentState[0].colorBlendOp = vk::BlendOp::eAdd;
-		blendAttachmentState[0].srcColorBlendFactor = vk::BlendFactor::eSrcAlpha;
-		blendAttachmentState[0].dstColorBlendFactor = vk::BlendFactor::eOneMinusSrcAlpha;
-		blendAttachmentState[0].alphaBlendOp = vk::BlendOp::eAdd;
-		blendAttachmentState[0].srcAlphaBlendFactor = vk::BlendFactor::eOne;
-		blendAttachmentState[0].dstAlphaBlendFactor = vk::BlendFactor::eZero;
-		colorBlendState.attachmentCount = ARRAYSIZE(blendAttachmentState);
-		colorBlendState.pAttachments = blendAttachmentState;
-
-		// ViewportXe[g̐ݒ
-		vk::PipelineViewportStateCreateInfo viewportState;
-		viewportState.viewportCount = 1;
-		viewportState.scissorCount = 1;
-
-		// DynamicState𗘗pViewportScissorBoxύXł悤ɂĂ
-		vk::PipelineDynamicStateCreateInfo dynamicState;
-		std::vector<vk::DynamicState> dynamicStateEnables;
-		dynamicStateEnables.push_back(vk::DynamicState::eViewport);
-		dynamicStateEnables.push_back(vk::DynamicState::eScissor);
-		dynamicState.pDynamicStates = dynamicStateEnables.data();
-		dynamicState.dynamicStateCount = static_cast<uint32_t>(dynamicStateEnables.size());
-
-		// DepthStensilXe[g̐ݒ
-		vk::PipelineDepthStencilStateCreateInfo depthStencilState;
-		depthStencilState.depthTestEnable = VK_TRUE;
-		depthStencilState.depthWriteEnable = VK_TRUE;
-		depthStencilState.depthCompareOp = vk::CompareOp::eLessOrEqual;
-		depthStencilState.depthBoundsTestEnable = VK_FALSE;
-		depthStencilState.back.failOp = vk::StencilOp::eKeep;
-		depthStencilState.back.passOp = vk::StencilOp::eKeep;
-		depthStencilState.back.compareOp = vk::CompareOp::eAlways;
-		depthStencilState.stencilTestEnable = VK_FALSE;
-		depthStencilState.front = depthStencilState.back;
-
-		// }`TvXe[g
-		vk::PipelineMultisampleStateCreateInfo multisampleState;
-		multisampleState.pSampleMask = NULL;
-		multisampleState.rasterizationSamples = vk::SampleCountFlagBits::e1;
-
-		// VF[_ݒ
-		std::array<vk::PipelineShaderStageCreateInfo, 2> shaderStages;
-		shaderStages[0].stage = vk::ShaderStageFlagBits::eVertex;
-		shaderStages[0].module = vsPost_.GetModule();
-		shaderStages[0].pName = "main";
-		shaderStages[1].stage = vk::ShaderStageFlagBits::eFragment;
-		shaderStages[1].module = psPost_.GetModule();
-		shaderStages[1].pName = "main";
-
-		// _
-		vk::PipelineVertexInputStateCreateInfo vinputState;
-
-		// pCvCɊeXe[gݒ肵Đ
-		vk::GraphicsPipelineCreateInfo pipelineCreateInfo;
-		pipelineCreateInfo.layout = postPipeLayout_;
-		pipelineCreateInfo.renderPass = postPass_.GetPass();
-		pipelineCreateInfo.stageCount = static_cast<uint32_t>(shaderStages.size());
-		pipelineCreateInfo.pStages = shaderStages.data();
-		pipelineCreateInfo.pVertexInputState = &vinputState;
-		pipelineCreateInfo.pInputAssemblyState = &inputAssemblyState;
-		pipelineCreateInfo.pRasterizationState = &rasterizationState;
-		pipelineCreateInfo.pColorBlendState = &colorBlendState;
-		pipelineCreateInfo.pMultisampleState = &multisampleState;
-		pipelineCreateInfo.pViewportState = &viewportState;
-		pipelineCreateInfo.pDepthStencilState = &depthStencilState;
-		pipelineCreateInfo.pDynamicState = &dynamicState;
-
-		postPipeline_ = device.GetDevice().createGraphicsPipelines(device.GetPipelineCache(), pipelineCreateInfo, nullptr)[0];
+		// pCvC
+		// _͂Ȃ̑Sʕ`
+		vsl::PipelineBuilder builder;
+		builder.SetShader(vk::ShaderStageFlagBits::eVertex, vsPost_.GetModule())
+			.SetShader(vk::ShaderStageFlagBits::eFragment, psPost_.GetModule())
+			.SetTopology(vk::PrimitiveTopology::eTriangleStrip)
+			.SetAlphaBlend(0)
+			.SetLayout(postPipeLayout_)
+			.SetRenderPass(postPass_);
+
+		postPipeline_ = builder.Build(device);
 		if (!postPipeline_)
 		{
 			return false;
@@ -912,13 +737,12 @@ private:
 			computePipeLayout_ = device.GetDevice().createPipelineLayout(pPipelineLayoutCreateInfo);
 		}
 
-		// VF[_Xe[W̐ݒ
-		vk::PipelineShaderStageCreateInfo shaderInfo(vk::PipelineShaderStageCreateFlags(), vk::ShaderStageFlagBits::eCompute, csTest_.GetModule(), "main");
-
 		// pCvC
-		vk::ComputePipelineCreateInfo pipelineCreateInfo(vk::PipelineCreateFlags(), shaderInfo, computePipeLayout_);
+		vsl::ComputePipelineBuilder builder;
+		builder.SetShader(csTest_.GetModule())
+			.SetLayout(computePipeLayout_);
 
-		computePipeline_ = device.GetDevice().createComputePipeline(device.GetPipelineCache(), pipelineCreateInfo);
+		computePipeline_ = builder.Build(device);
 		if (!computePipeline_)
 		{
 			return false;
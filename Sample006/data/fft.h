@@ -1,22 +1,114 @@
 // require defines
-// LENGTH : row or collumn pixel length
-// BUTTERFLY_COUNT : butterfly pass count
-// ROWPASS : 1 is row pass, 0 is collumn pass
 // TRANSFORM_INVERSE : 1 is ifft, 0 is fft
+// STORAGE_FP32 : 1 stores images and packed buffers in fp32, 0 (default) in fp16
+//
+// specialization constants
+// local_size_x_id 0 : row or column pixel length (power of two)
+// constant_id 1 : BUTTERFLY_COUNT, log2(LENGTH)
+// constant_id 2 : ROWPASS, true is row pass, false is column pass
+// constant_id 3 : INPUT_TYPE, 0 is real image, 1 is complex images, 2 is packed buffer
+// constant_id 4 : OUTPUT_TYPE, 0 is real image, 1 is complex images, 2 is packed buffer
+// constant_id 5 : PITCH, element count of one row in the packed buffer
+// constant_id 6 : REAL_PAIR, true transforms two real lines at once (forward row pass from a real image,
+//                 or inverse column pass to a real image). the dispatch count is halved.
+// constant_id 7 : FUSE_PASSES, true runs two radix-2 passes between barriers (radix-4 step).
+//                 the first of the two passes is evaluated for both inputs instead of being shared.
+// constant_id 8 : STEP_TYPE, 0 is a single pass, 1 and 2 are the first and second steps of a four-step FFT
+// constant_id 9 : STEP_COUNT, number of sub transforms in one line for the four-step FFT.
+//                 the line length is LENGTH * STEP_COUNT and the sub transform index is gl_WorkGroupID.x.
+// constant_id 10 : SHARED_HALF, true keeps the scratch arrays in shared memory as fp16x2.
+//                  halves the shared memory per element, the arithmetic stays fp32.
+//
+// four-step FFT (line length N = N1 * N2, n = n1 + N1 * n2, k = k2 + N2 * k1)
+// first step  : LENGTH = N2, STEP_COUNT = N1. FFT over n2, multiply W_N^(n1 * k2), store to n1 + N1 * k2
+// second step : LENGTH = N1, STEP_COUNT = N2. FFT over n1, store to k2 + N2 * k1
+//
+// packed buffer layout
+// one element is 3 uints, each uint holds packHalf2x16(vec2(real, imaginary)) of R, G, B.
+// with STORAGE_FP32, one element is 6 uints, (real, imaginary) of R, G, B as floats.
+// alpha is not stored and becomes 1.0.
+//
+// scaling
+// every butterfly stage is scaled by 1/sqrt(2) in both directions, so one line is scaled by 1/sqrt(LENGTH)
+// and the 2D transform by 1/sqrt(width * height). the DC term is sum / sqrt(N) instead of sum,
+// which keeps fp16 storage finite for large images.
 
 precision highp float;
 
-layout(local_size_x = LENGTH) in;
-#if ROWPASS && !TRANSFORM_INVERSE
-layout(binding = 0, rgba8) uniform readonly image2D inputImageR;
+#ifndef STORAGE_FP32
+#define STORAGE_FP32 0
+#endif
+
+#if STORAGE_FP32
+#define STORAGE_FORMAT	rgba32f
+#define PACKED_STRIDE	6
 #else
-layout(binding = 0, rgba16f) uniform readonly image2D inputImageR;
+#define STORAGE_FORMAT	rgba16f
+#define PACKED_STRIDE	3
+#endif
+
+layout(local_size_x_id = 0) in;
+layout(constant_id = 1) const uint BUTTERFLY_COUNT = 8;
+layout(constant_id = 2) const bool ROWPASS = true;
+layout(constant_id = 3) const uint INPUT_TYPE = 2;
+layout(constant_id = 4) const uint OUTPUT_TYPE = 2;
+layout(constant_id = 5) const uint PITCH = 256;
+layout(constant_id = 6) const bool REAL_PAIR = false;
+layout(constant_id = 7) const bool FUSE_PASSES = false;
+layout(constant_id = 8) const uint STEP_TYPE = 0;
+layout(constant_id = 9) const uint STEP_COUNT = 1;
+layout(constant_id = 10) const bool SHARED_HALF = false;
+
+const uint LENGTH = gl_WorkGroupSize.x;
+
+#define TYPE_REAL_IMAGE		0
+#define TYPE_COMPLEX_IMAGES	1
+#define TYPE_PACKED_BUFFER	2
+
+#define STEP_SINGLE			0
+#define STEP_FIRST			1
+#define STEP_SECOND			2
+
+layout(binding = 0, STORAGE_FORMAT) uniform readonly image2D inputImageR;
+layout(binding = 1, STORAGE_FORMAT) uniform readonly image2D inputImageI;
+layout(binding = 2, STORAGE_FORMAT) uniform writeonly image2D outputImageR;
+layout(binding = 3, STORAGE_FORMAT) uniform writeonly image2D outputImageI;
+#if !TRANSFORM_INVERSE
+// original texture for the forward row pass
+layout(binding = 4, rgba8) uniform readonly image2D sourceImage;
 #endif
-layout(binding = 1, rgba16f) uniform readonly image2D inputImageI;
-layout(binding = 2, rgba16f) uniform image2D outputImageR;
-layout(binding = 3, rgba16f) uniform image2D outputImageI;
+layout(std430, binding = 5) readonly buffer InputBuffer
+{
+	uint inputData[];
+};
+layout(std430, binding = 6) writeonly buffer OutputBuffer
+{
+	uint outputData[];
+};
 
 #define PI 3.14159265
+#define STAGE_SCALE 0.70710678
+
+// twiddle factors e^(-2 pi i k / LENGTH) for k < LENGTH / 2
+// filled once per workgroup before the first barrier
+shared vec2 twiddleTable[LENGTH / 2];
+
+void InitTwiddleTable(uint x)
+{
+	if (x < LENGTH / 2)
+	{
+		float a = 2.0 * PI * float(x) / float(LENGTH);
+		twiddleTable[x] = vec2(cos(a), -sin(a));
+	}
+}
+
+vec2 GetTwiddle(uint sectionOffset, uint sectionWidth)
+{
+	// e^(-2 pi i k / W) is twiddleTable[k * LENGTH / W], the second half of the section is negated
+	uint halfSectionWidth = sectionWidth / 2;
+	vec2 w = twiddleTable[(sectionOffset & (halfSectionWidth - 1)) * (LENGTH / sectionWidth)];
+	return (sectionOffset < halfSectionWidth) ? w : -w;
+}
 
 void GetButterflyValues(uint passIndex, uint x, out uvec2 indices, out vec2 weights)
 {
@@ -27,10 +119,7 @@ void GetButterflyValues(uint passIndex, uint x, out uvec2 indices, out vec2 weig
 	uint halfSectionOffset = x & (halfSectionWidth - 1);
 	uint sectionOffset = x & (sectionWidth - 1);
 
-	float a = 2.0 * PI * float(sectionOffset) / float(sectionWidth);
-	weights.y = sin(a);
-	weights.x = cos(a);
-	weights.y = -weights.y;
+	weights = GetTwiddle(sectionOffset, sectionWidth);
 
 	indices.x = sectionStartOffset + halfSectionOffset;
 	indices.y = sectionStartOffset + halfSectionOffset + halfSectionWidth;
@@ -41,87 +130,327 @@ void GetButterflyValues(uint passIndex, uint x, out uvec2 indices, out vec2 weig
 	}
 }
 
-shared highp vec3 pingPongArray[4][LENGTH];
-void ButterflyPass(uint passIndex, uint x, uint t0, uint t1, out vec3 resultR, out vec3 resultI)
+void Butterfly(vec3 inputR1, vec3 inputI1, vec3 inputR2, vec3 inputI2, vec2 Weights, out vec3 resultR, out vec3 resultI)
+{
+#if TRANSFORM_INVERSE
+	resultR = (inputR1 + Weights.x * inputR2 + Weights.y * inputI2) * STAGE_SCALE;
+	resultI = (inputI1 - Weights.y * inputR2 + Weights.x * inputI2) * STAGE_SCALE;
+#else
+	resultR = (inputR1 + Weights.x * inputR2 - Weights.y * inputI2) * STAGE_SCALE;
+	resultI = (inputI1 + Weights.y * inputR2 + Weights.x * inputI2) * STAGE_SCALE;
+#endif
+}
+
+// two ping-pong scratch arrays of complex RGB
+// fp32 : 6 uints per element, real.rgb and imaginary.rgb as floats
+// fp16x2 : 3 uints per element, packHalf2x16(vec2(real, imaginary)) of R, G, B
+const uint SCRATCH_STRIDE = SHARED_HALF ? 3u : 6u;
+shared uint pingPongArray[2 * LENGTH * SCRATCH_STRIDE];
+
+void LoadScratch(uint t, uint i, out vec3 real, out vec3 imaginary)
+{
+	uint base = (t * LENGTH + i) * SCRATCH_STRIDE;
+	if (SHARED_HALF)
+	{
+		vec2 r = unpackHalf2x16(pingPongArray[base + 0]);
+		vec2 g = unpackHalf2x16(pingPongArray[base + 1]);
+		vec2 b = unpackHalf2x16(pingPongArray[base + 2]);
+		real = vec3(r.x, g.x, b.x);
+		imaginary = vec3(r.y, g.y, b.y);
+	}
+	else
+	{
+		real = uintBitsToFloat(uvec3(pingPongArray[base + 0], pingPongArray[base + 1], pingPongArray[base + 2]));
+		imaginary = uintBitsToFloat(uvec3(pingPongArray[base + 3], pingPongArray[base + 4], pingPongArray[base + 5]));
+	}
+}
+
+void StoreScratch(uint t, uint i, vec3 real, vec3 imaginary)
+{
+	uint base = (t * LENGTH + i) * SCRATCH_STRIDE;
+	if (SHARED_HALF)
+	{
+		pingPongArray[base + 0] = packHalf2x16(vec2(real.r, imaginary.r));
+		pingPongArray[base + 1] = packHalf2x16(vec2(real.g, imaginary.g));
+		pingPongArray[base + 2] = packHalf2x16(vec2(real.b, imaginary.b));
+	}
+	else
+	{
+		uvec3 r = floatBitsToUint(real);
+		uvec3 im = floatBitsToUint(imaginary);
+		pingPongArray[base + 0] = r.x;
+		pingPongArray[base + 1] = r.y;
+		pingPongArray[base + 2] = r.z;
+		pingPongArray[base + 3] = im.x;
+		pingPongArray[base + 4] = im.y;
+		pingPongArray[base + 5] = im.z;
+	}
+}
+
+void ButterflyPass(uint passIndex, uint x, uint t, out vec3 resultR, out vec3 resultI)
 {
 	uvec2 Indices;
 	vec2 Weights;
 	GetButterflyValues(passIndex, x, Indices, Weights);
 
-	vec3 inputR1 = pingPongArray[t0][Indices.x];
-	vec3 inputI1 = pingPongArray[t1][Indices.x];
+	vec3 inputR1, inputI1, inputR2, inputI2;
+	LoadScratch(t, Indices.x, inputR1, inputI1);
+	LoadScratch(t, Indices.y, inputR2, inputI2);
 
-	vec3 inputR2 = pingPongArray[t0][Indices.y];
-	vec3 inputI2 = pingPongArray[t1][Indices.y];
-
-#if TRANSFORM_INVERSE
-	resultR = (inputR1 + Weights.x * inputR2 + Weights.y * inputI2) * 0.5;
-	resultI = (inputI1 - Weights.y * inputR2 + Weights.x * inputI2) * 0.5;
-#else
-	resultR = inputR1 + Weights.x * inputR2 - Weights.y * inputI2;
-	resultI = inputI1 + Weights.y * inputR2 + Weights.x * inputI2;
-#endif
+	Butterfly(inputR1, inputI1, inputR2, inputI2, Weights, resultR, resultI);
 }
 
-void ButterflyPassFinalNoI(uint passIndex, uint x, uint t0, uint t1, out vec3 resultR)
+void ButterflyPassFinalNoI(uint passIndex, uint x, uint t, out vec3 resultR)
 {
 	uvec2 Indices;
 	vec2 Weights;
 	GetButterflyValues(passIndex, x, Indices, Weights);
 
-	vec3 inputR1 = pingPongArray[t0][Indices.x];
+	vec3 inputR1, inputI1, inputR2, inputI2;
+	LoadScratch(t, Indices.x, inputR1, inputI1);
+	LoadScratch(t, Indices.y, inputR2, inputI2);
 
-	vec3 inputR2 = pingPongArray[t0][Indices.y];
-	vec3 inputI2 = pingPongArray[t1][Indices.y];
+	resultR = (inputR1 + Weights.x * inputR2 + Weights.y * inputI2) * STAGE_SCALE;
+}
 
-	resultR = (inputR1 + Weights.x * inputR2 + Weights.y * inputI2) * 0.5;
+// number of passes processed by the next ButterflyStep
+uint GetPassStep(uint passIndex)
+{
+	return (FUSE_PASSES && (passIndex + 1 < BUTTERFLY_COUNT)) ? 2 : 1;
 }
 
-void main()
+// one or two passes from the scratch array t
+// the fused step evaluates the first pass at both inputs of the second pass in registers
+void ButterflyStep(uint passIndex, uint x, uint t, out vec3 resultR, out vec3 resultI)
+{
+	if (GetPassStep(passIndex) == 1)
+	{
+		ButterflyPass(passIndex, x, t, resultR, resultI);
+		return;
+	}
+
+	uvec2 Indices;
+	vec2 Weights;
+	GetButterflyValues(passIndex + 1, x, Indices, Weights);
+
+	vec3 inputR1, inputI1, inputR2, inputI2;
+	ButterflyPass(passIndex, Indices.x, t, inputR1, inputI1);
+	ButterflyPass(passIndex, Indices.y, t, inputR2, inputI2);
+
+	Butterfly(inputR1, inputI1, inputR2, inputI2, Weights, resultR, resultI);
+}
+
+void LoadPacked(uvec2 pos, out vec3 real, out vec3 imaginary)
 {
-	uvec2 position = uvec2(gl_GlobalInvocationID.xy);
-#if ROWPASS
-	uvec2 texturePos = position.xy;
-	uvec2 outPos = texturePos;
+	uint base = (pos.y * PITCH + pos.x) * PACKED_STRIDE;
+#if STORAGE_FP32
+	vec2 r = uintBitsToFloat(uvec2(inputData[base + 0], inputData[base + 1]));
+	vec2 g = uintBitsToFloat(uvec2(inputData[base + 2], inputData[base + 3]));
+	vec2 b = uintBitsToFloat(uvec2(inputData[base + 4], inputData[base + 5]));
 #else
-	uvec2 texturePos = position.yx;
-	uvec2 outPos = texturePos;
+	vec2 r = unpackHalf2x16(inputData[base + 0]);
+	vec2 g = unpackHalf2x16(inputData[base + 1]);
+	vec2 b = unpackHalf2x16(inputData[base + 2]);
 #endif
+	real = vec3(r.x, g.x, b.x);
+	imaginary = vec3(r.y, g.y, b.y);
+}
 
-	// Load entire row or column into scratch array
-	vec4 inputR = imageLoad(inputImageR, ivec2(texturePos));
-	pingPongArray[0][position.x].xyz = inputR.xyz;
-#if ROWPASS && !TRANSFORM_INVERSE
-	// don't load values from the imaginary texture when loading the original texture
-	pingPongArray[1][position.x].xyz = vec3(0.0);
+void StorePacked(uvec2 pos, vec3 real, vec3 imaginary)
+{
+	uint base = (pos.y * PITCH + pos.x) * PACKED_STRIDE;
+#if STORAGE_FP32
+	uvec3 r = floatBitsToUint(real);
+	uvec3 im = floatBitsToUint(imaginary);
+	outputData[base + 0] = r.x;
+	outputData[base + 1] = im.x;
+	outputData[base + 2] = r.y;
+	outputData[base + 3] = im.y;
+	outputData[base + 4] = r.z;
+	outputData[base + 5] = im.z;
 #else
-	pingPongArray[1][position.x].xyz = imageLoad(inputImageI, ivec2(texturePos)).xyz;
+	outputData[base + 0] = packHalf2x16(vec2(real.r, imaginary.r));
+	outputData[base + 1] = packHalf2x16(vec2(real.g, imaginary.g));
+	outputData[base + 2] = packHalf2x16(vec2(real.b, imaginary.b));
+#endif
+}
+
+uvec2 GetPos(uint line, uint x)
+{
+	return ROWPASS ? uvec2(x, line) : uvec2(line, x);
+}
+
+// multiply W_N^(n1 * k2) between the four-step passes
+void ApplyStepTwiddle(uint sub, uint x, inout vec3 real, inout vec3 imaginary)
+{
+	uint n = LENGTH * STEP_COUNT;
+	float a = 2.0 * PI * float((sub * x) & (n - 1)) / float(n);
+#if TRANSFORM_INVERSE
+	vec2 w = vec2(cos(a), sin(a));
+#else
+	vec2 w = vec2(cos(a), -sin(a));
+#endif
+	vec3 r = real * w.x - imaginary * w.y;
+	imaginary = real * w.y + imaginary * w.x;
+	real = r;
+}
+
+void main()
+{
+	uint x = gl_LocalInvocationID.x;
+	uint line = gl_WorkGroupID.y;
+
+	// REAL_PAIR packs two real lines into one complex transform: z = line0 + i * line1
+	uint line0 = REAL_PAIR ? line * 2 : line;
+	uint line1 = line0 + 1;
+
+	// element index in the line
+	uint sub = gl_WorkGroupID.x;
+	uint loadIndex = x;
+	uint storeIndex = x;
+	if (STEP_TYPE == STEP_FIRST)
+	{
+		loadIndex = sub + STEP_COUNT * x;
+		storeIndex = loadIndex;
+	}
+	else if (STEP_TYPE == STEP_SECOND)
+	{
+		loadIndex = x + LENGTH * sub;
+		storeIndex = sub + STEP_COUNT * x;
+	}
+
+	// Load entire row or column into scratch array
+	vec3 inputR = vec3(0.0);
+	vec3 inputI = vec3(0.0);
+	float alpha = 1.0;
+#if !TRANSFORM_INVERSE
+	if (INPUT_TYPE == TYPE_REAL_IMAGE)
+	{
+		// don't load values from the imaginary texture when loading the original texture
+		vec4 v = imageLoad(sourceImage, ivec2(GetPos(line0, loadIndex)));
+		inputR = v.rgb;
+		alpha = v.a;
+		if (REAL_PAIR)
+		{
+			inputI = imageLoad(sourceImage, ivec2(GetPos(line1, loadIndex))).rgb;
+		}
+	}
 #endif
+	if (INPUT_TYPE == TYPE_COMPLEX_IMAGES)
+	{
+		vec4 v = imageLoad(inputImageR, ivec2(GetPos(line0, loadIndex)));
+		inputR = v.rgb;
+		inputI = imageLoad(inputImageI, ivec2(GetPos(line0, loadIndex))).rgb;
+		alpha = v.a;
+		if (REAL_PAIR)
+		{
+			// z = X0 + i * X1
+			vec3 r1 = imageLoad(inputImageR, ivec2(GetPos(line1, loadIndex))).rgb;
+			vec3 i1 = imageLoad(inputImageI, ivec2(GetPos(line1, loadIndex))).rgb;
+			inputR -= i1;
+			inputI += r1;
+		}
+	}
+	else if (INPUT_TYPE == TYPE_PACKED_BUFFER)
+	{
+		LoadPacked(GetPos(line0, loadIndex), inputR, inputI);
+		if (REAL_PAIR)
+		{
+			vec3 r1, i1;
+			LoadPacked(GetPos(line1, loadIndex), r1, i1);
+			inputR -= i1;
+			inputI += r1;
+		}
+	}
+	StoreScratch(0u, x, inputR, inputI);
+	InitTwiddleTable(x);
 
-	uvec4 textureIndices = ivec4(0, 1, 2, 3);
+	// the scratch array to read, the other one is written
+	uint src = 0;
 
-	for (int i = 0; i < BUTTERFLY_COUNT - 1; i++)
+	uint passIndex = 0;
+	while (passIndex + GetPassStep(passIndex) < BUTTERFLY_COUNT)
 	{
 		groupMemoryBarrier();
 		barrier();
-		ButterflyPass(i, position.x, textureIndices.x, textureIndices.y, pingPongArray[textureIndices.z][position.x].xyz, pingPongArray[textureIndices.w][position.x].xyz);
-		textureIndices.xyzw = textureIndices.zwxy;
+		vec3 resultR, resultI;
+		ButterflyStep(passIndex, x, src, resultR, resultI);
+		StoreScratch(src ^ 1u, x, resultR, resultI);
+		src ^= 1u;
+		passIndex += GetPassStep(passIndex);
 	}
 
-	// Final butterfly will write directly to the target texture
+	// Final butterfly will write directly to the target
 	groupMemoryBarrier();
 	barrier();
 
-	// The final pass writes to the output UAV texture
-#if !ROWPASS && TRANSFORM_INVERSE
-	// last pass of the inverse transform. The imaginary value is no longer needed
-	vec3 outputR;
-	ButterflyPassFinalNoI(BUTTERFLY_COUNT - 1, position.x, textureIndices.x, textureIndices.y, outputR);
-	imageStore(outputImageR, ivec2(outPos), vec4(outputR.rgb, inputR.a));
-#else
-	vec3 outputR, outputI;
-	ButterflyPass(BUTTERFLY_COUNT - 1, position.x, textureIndices.x, textureIndices.y, outputR, outputI);
-	imageStore(outputImageR, ivec2(outPos), vec4(outputR.rgb, inputR.a));
-	imageStore(outputImageI, ivec2(outPos), vec4(outputI.rgb, inputR.a));
+#if TRANSFORM_INVERSE
+	if (OUTPUT_TYPE == TYPE_REAL_IMAGE)
+	{
+		if (REAL_PAIR)
+		{
+			// the real part is line0 and the imaginary part is line1
+			vec3 outputR, outputI;
+			ButterflyStep(passIndex, x, src, outputR, outputI);
+			imageStore(outputImageR, ivec2(GetPos(line0, storeIndex)), vec4(outputR, alpha));
+			imageStore(outputImageR, ivec2(GetPos(line1, storeIndex)), vec4(outputI, alpha));
+		}
+		else if (GetPassStep(passIndex) == 2)
+		{
+			vec3 outputR, outputI;
+			ButterflyStep(passIndex, x, src, outputR, outputI);
+			imageStore(outputImageR, ivec2(GetPos(line0, storeIndex)), vec4(outputR, alpha));
+		}
+		else
+		{
+			// last pass of the inverse transform. The imaginary value is no longer needed
+			vec3 outputR;
+			ButterflyPassFinalNoI(passIndex, x, src, outputR);
+			imageStore(outputImageR, ivec2(GetPos(line0, storeIndex)), vec4(outputR, alpha));
+		}
+		return;
+	}
 #endif
-}
\ No newline at end of file
+	vec3 outputR, outputI;
+	ButterflyStep(passIndex, x, src, outputR, outputI);
+	if (STEP_TYPE == STEP_FIRST)
+	{
+		ApplyStepTwiddle(sub, x, outputR, outputI);
+	}
+
+	vec3 outputR1, outputI1;
+	if (REAL_PAIR)
+	{
+		// split Z into the spectra of the two real lines
+		// X0[k] = (Z[k] + conj(Z[N-k])) / 2, X1[k] = (Z[k] - conj(Z[N-k])) / 2i
+		StoreScratch(src ^ 1u, x, outputR, outputI);
+		groupMemoryBarrier();
+		barrier();
+		uint mirror = (LENGTH - x) & (LENGTH - 1);
+		vec3 mirrorR, mirrorI;
+		LoadScratch(src ^ 1u, mirror, mirrorR, mirrorI);
+		outputR1 = (outputI + mirrorI) * 0.5;
+		outputI1 = (mirrorR - outputR) * 0.5;
+		outputR = (outputR + mirrorR) * 0.5;
+		outputI = (outputI - mirrorI) * 0.5;
+	}
+
+	if (OUTPUT_TYPE == TYPE_PACKED_BUFFER)
+	{
+		StorePacked(GetPos(line0, storeIndex), outputR, outputI);
+		if (REAL_PAIR)
+		{
+			StorePacked(GetPos(line1, storeIndex), outputR1, outputI1);
+		}
+	}
+	else
+	{
+		imageStore(outputImageR, ivec2(GetPos(line0, storeIndex)), vec4(outputR, alpha));
+		imageStore(outputImageI, ivec2(GetPos(line0, storeIndex)), vec4(outputI, alpha));
+		if (REAL_PAIR)
+		{
+			imageStore(outputImageR, ivec2(GetPos(line1, storeIndex)), vec4(outputR1, alpha));
+			imageStore(outputImageI, ivec2(GetPos(line1, storeIndex)), vec4(outputI1, alpha));
+		}
+	}
+}
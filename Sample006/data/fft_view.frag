@@ -16,6 +16,7 @@ void main()
 	vec4 r = texture(texR, inUV - 0.5, 0);
 	vec4 i = texture(texI, inUV - 0.5, 0);
 	outFragColor.rgb = r.rgb * r.rgb + i.rgb * i.rgb;
-	outFragColor.rgb = 0.1 * log2(sqrt(outFragColor.rgb));
+	// the spectrum is scaled by 1/sqrt(256 * 256), add log2(256) back to keep the brightness
+	outFragColor.rgb = 0.1 * (log2(sqrt(outFragColor.rgb)) + 8.0);
 	outFragColor.a = 1.0;
 }
\ No newline at end of file
@@ -8,15 +8,47 @@
 #include <vsl/image.h>
 #include <vsl/buffer.h>
 #include <vsl/shader.h>
+#include <vsl/shader_bundle.h>
 #include <vsl/render_pass.h>
 #include <vsl/gui.h>
+#include <vsl/pipeline_builder.h>
+#include <vsl/descriptor_writer.h>
+#include <vsl/fft.h>
+#include <vsl/fft_validator.h>
+#include <vsl/fft_benchmark.h>
+#include <vsl/fft_convolution.h>
+#include <vsl/command_bundle.h>
+#include <vsl/gpu_profiler.h>
+#include <vsl/texture_loader.h>
 #include <imgui.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 
 
 namespace
 {
 	static const uint16_t kScreenWidth = 1920;
 	static const uint16_t kScreenHeight = 1080;
+
+	// FFTΏۂ1ӂ̃sNZ
+	static const uint32_t kFFTLength = 256;
+
+	// FFTx`}[N̔
+	static const uint32_t kFFTBenchmarkWarmup = 10;
+	static const uint32_t kFFTBenchmarkIterations = 100;
+
+	// FFTPrecision ̕\
+	static const char* kFFTPrecisionStrs[] = { "fp16", "fp32", "fp16x2" };
+
+	// ݍ݃J[l̍ő唼a
+	// ڏݍ݂ kConvolutionMaxSpatialRadius ܂ŁA傫ꍇ͏FFTgp
+	static const int kConvolutionMaxRadius = 64;
+	static const uint32_t kConvolutionMaxSpatialRadius = 32;
+	static const uint32_t kConvolutionStreakCount = 6;
+
+	static const char* kConvolutionMethodStrs[] = { "Auto", "Spatial", "FFT" };
+	static const char* kConvolutionKernelStrs[] = { "Gaussian", "Star" };
 }	// namespace
 
 bool Initialize(vsl::Device& device)
@@ -105,19 +137,6 @@ public:
 			return false;
 		}
 
-		// FFTpobt@̏
-		for (auto& image : fftTargets_)
-		{
-			if (!image.InitializeAsColorBuffer(
-				device, initCmdBuffer,
-				vk::Format::eR16G16B16A16Sfloat,
-				256, 256, 1, 1, true))
-			{
-				return false;
-			}
-			image.SetImageLayout(initCmdBuffer, vk::ImageLayout::eGeneral, vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1));
-		}
-
 		// t[obt@ݒ
 		{
 			std::array<vk::ImageView, 1> views;
@@ -159,6 +178,19 @@ public:
 		}
 
 		// `惊\[X̏
+		// OɋL^R}h͔񓯊Rs[g̃L[Ŏs
+		if (!commandBundles_.Initialize(device, device.GetComputeCommandPool()))
+		{
+			return false;
+		}
+
+		// GPUԂ̌v̓CR}hobt@ƂɃNGv[
+		// ^CX^vgȂł͌vȂ
+		if (!gpuProfiler_.Initialize(device, static_cast<uint32_t>(device.GetCommandBuffers().size())))
+		{
+			OutputDebugString(L"GPU profiler is not supported.\n");
+		}
+
 		if (!InitializeRenderResource(device, initCmdBuffer))
 		{
 			return false;
@@ -177,16 +209,30 @@ public:
 		vk::SubmitInfo copySubmitInfo;
 		copySubmitInfo.commandBufferCount = 1;
 		copySubmitInfo.pCommandBuffers = &initCmdBuffer;
-		device.GetQueue().submit(copySubmitInfo, VK_NULL_HANDLE);
+		vsl::QueueSubmit(device.GetQueue(), copySubmitInfo, vk::Fence());
 		device.GetQueue().waitIdle();
 
+		// CPUFFTƂ̔rʂ󂯎
+		for (int i = 0; i < vsl::FFTPrecision::Max; i++)
+		{
+			isFFTValidated_[i] = fftValidators_[i].Resolve(fftErrors_[i]);
+		}
+
+		// ݍ݃J[l̃XyNg̓v̏R}h̊ɌvZ
+		if (fftConvolution_.IsValid())
+		{
+			UpdateConvolutionKernel();
+		}
+
 		// ꎞ\[X̔j
+		// rp̃v͐xƂ̃x`}[NɎgp̂ŎcĂ
 		fontStaging_.Destroy();
 		texStaging_.Destroy();
 		vbStaging_.Destroy();
 		ibStaging_.Destroy();
 
 		// pCvC̏
+		// ̂̓[J[XbhōsÂ`Ɏgp
 		if (!InitializePipeline(device))
 		{
 			return false;
@@ -199,11 +245,6 @@ public:
 		{
 			return false;
 		}
-		if (!InitializeFFTPipeline(device))
-		{
-			return false;
-		}
-
 		return true;
 	}
 
@@ -213,60 +254,172 @@ public:
 		auto currentIndex = device.AcquireNextImage();
 		auto& cmdBuffer = device.BeginMainCommandBuffer();
 		auto& currentImage = device.GetCurrentSwapchainImage();
+
+		// O񂱂̃R}hobt@Ōvʂ
+		gpuProfiler_.BeginFrame(cmdBuffer, device.GetCurrentBufferIndex());
+		gpuProfiler_.BeginScope(cmdBuffer, "Frame");
 		
 		static float sRotY = 1.0f;
 
+		// pCvC󂯎
+		if (!UpdatePendingPipelines(device))
+		{
+			return false;
+		}
+
 		// GUI
 		gui_.BeginNewFrame(kScreenWidth, kScreenHeight, input);
 		if (ImGui::Button(isComputeOn_ ? "Compute Enable" : "Compute Disable"))
 		{
 			isComputeOn_ = !isComputeOn_;
-
-			vk::DescriptorImageInfo postDescInfo(
-				sampler_, isComputeOn_ ? computeBuffer_.GetView() : offscreenBuffer_.GetView(), vk::ImageLayout::eGeneral);
-
-			// fXNv^Zbg̏XV
-			std::array<vk::WriteDescriptorSet, 1> descSetInfos{
-				vk::WriteDescriptorSet(descSets_[1], 1, 0, 1, vk::DescriptorType::eCombinedImageSampler, &postDescInfo, nullptr, nullptr),
-			};
-			device.GetDevice().updateDescriptorSets(descSetInfos, nullptr);
 		}
 		ImGui::Checkbox("Sync FFT", &isSyncFFT_);
-		if (ImGui::Button("Compute FFT"))
+		if (isFFTAvailable_)
+		{
+			if (fft_.IsFixedKernel())
+			{
+				ImGui::Text("FFT Length : %u (fixed 256 shaders, fft.comp / ifft.comp are not in the bundle)", kFFTLength);
+			}
+			else
+			{
+				ImGui::Text("FFT Length : %u (Max %u, %u in one pass, %u with fp16x2)", kFFTLength, fft_.GetMaxTransformLength(), fft_.GetMaxLength(),
+					fft_.GetMaxLength(vsl::FFTPrecision::PackedHalf));
+			}
+			ImGui::Text("FFT Traffic : %.2f MB (image layout %.2f MB)", fftBytesMoved_[0] / (1024.0 * 1024.0), fftBytesMoved_[1] / (1024.0 * 1024.0));
+			for (int i = 0; i < vsl::FFTPrecision::Max; i++)
+			{
+				if (!isFFTValidated_[i])
+				{
+					ImGui::Text("FFT Error (%s) : not supported", kFFTPrecisionStrs[i]);
+					continue;
+				}
+				// 256Œ̃VF[_ł PackedBuffer ̌؂͍sȂ
+				const vsl::FFTValidationErrors& errors = fftErrors_[i];
+				if (errors.isPackedValid)
+				{
+					ImGui::Text("FFT Error (%s) : max %.2e / rms %.2e", kFFTPrecisionStrs[i], errors.packed.maxError, errors.packed.rmsError);
+				}
+				ImGui::Text("FFT Error (%s, rgba8) : max %.2e / rms %.2e, round trip max %.2e", kFFTPrecisionStrs[i],
+					errors.realImage.maxError, errors.realImage.rmsError, errors.roundTrip.maxError);
+				if (isFFTPrecisionBenchmarked_[i])
+				{
+					ImGui::Text("FFT Time (%s) : %.3f ms", kFFTPrecisionStrs[i], fftPrecisionResults_[i].totalMilliseconds);
+				}
+			}
+		}
+		else
+		{
+			ImGui::Text("FFT shaders are not found in the bundle.");
+		}
+		if (ImGui::Button("Compute FFT") && isFFTAvailable_)
 		{
 			RunFFT(device);
 		}
 		EndCalcFFT(device);
+		if (ImGui::Button("Benchmark FFT") && isFFTAvailable_)
+		{
+			RunFFTBenchmark(device);
+		}
+		if (isFFTBenchmarked_)
+		{
+			static const char* kBenchmarkStrs[] = { "Forward", "Inverse" };
+			for (int i = 0; i < 2; i++)
+			{
+				const auto& result = fftBenchmarkResults_[i];
+				ImGui::Text("FFT %s : %.3f ms, %.2f GB/s (copy %.2f GB/s)", kBenchmarkStrs[i],
+					result.totalMilliseconds, result.gigaBytesPerSecond, result.referenceGigaBytesPerSecond);
+			}
+		}
 
-		static const char* kViewTypeStrs[] = {"Texture", "FFT", "InvFFT"};
+		// ݍ
+		// J[lύXƂXyNgvZ
+		if (fftConvolution_.IsValid())
+		{
+			bool isKernelChanged = ImGui::SliderInt("Kernel Radius", &convolutionRadius_, 1, kConvolutionMaxRadius);
+			isKernelChanged |= ImGui::Combo("Kernel Type", &convolutionKernelType_, kConvolutionKernelStrs, ARRAYSIZE(kConvolutionKernelStrs));
+			if (isKernelChanged)
+			{
+				UpdateConvolutionKernel();
+			}
+			ImGui::Combo("Convolution", &convolutionMethod_, kConvolutionMethodStrs, ARRAYSIZE(kConvolutionMethodStrs));
+
+			uint32_t radius = fftConvolution_.GetRadius();
+			auto method = fftConvolution_.ResolveMethod(static_cast<vsl::FFTConvolutionMethod::Type>(convolutionMethod_));
+			ImGui::Text("Convolution : %s (cost spatial %.0f / FFT %.0f)", kConvolutionMethodStrs[method],
+				vsl::FFTConvolution::EstimateCost(vsl::FFTConvolutionMethod::Spatial, kFFTLength, kFFTLength, radius),
+				vsl::FFTConvolution::EstimateCost(vsl::FFTConvolutionMethod::FFT, kFFTLength, kFFTLength, radius));
+		}
+		else
+		{
+			ImGui::Text("Convolution shaders are not found in the bundle.");
+		}
+
+		static const char* kViewTypeStrs[] = {"Texture", "FFT", "InvFFT", "Convolution"};
 		if (ImGui::Combo("View Type", &viewType_, kViewTypeStrs, ARRAYSIZE(kViewTypeStrs)) || isForceTypeChange_)
 		{
-			if (isFFTComplete_)
+			// XyNg\͕ʂ̃Zbggp
+			vk::ImageView view = texture_.GetView();
+			if (isFFTComplete_ && (viewType_ == 2))
 			{
-				if (viewType_ == 0)
-				{
-					vk::DescriptorImageInfo texDescInfo(
-						sampler_, texture_.GetView(), vk::ImageLayout::eGeneral);
-
-					// fXNv^Zbg̏XV
-					std::array<vk::WriteDescriptorSet, 1> descSetInfos{
-						vk::WriteDescriptorSet(descSets_[0], 1, 0, 1, vk::DescriptorType::eCombinedImageSampler, &texDescInfo, nullptr, nullptr),
-					};
-					device.GetDevice().updateDescriptorSets(descSetInfos, nullptr);
-				}
-				else if (viewType_ == 2)
-				{
-					vk::DescriptorImageInfo texDescInfo(
-						sampler_, fftTargets_[4].GetView(), vk::ImageLayout::eGeneral);
-
-					// fXNv^Zbg̏XV
-					std::array<vk::WriteDescriptorSet, 1> descSetInfos{
-						vk::WriteDescriptorSet(descSets_[0], 1, 0, 1, vk::DescriptorType::eCombinedImageSampler, &texDescInfo, nullptr, nullptr),
-					};
-					device.GetDevice().updateDescriptorSets(descSetInfos, nullptr);
-				}
+				view = fftTargets_[2].GetView();
+			}
+			else if ((viewType_ == 3) && fftConvolution_.HasKernel())
+			{
+				view = fftTargets_[3].GetView();
+			}
+			vk::DescriptorImageInfo texDescInfo(
+				sampler_, view, vk::ImageLayout::eGeneral);
+			descWriter_.WriteImage(descSets_[0], 1, vk::DescriptorType::eCombinedImageSampler, texDescInfo);
+		}
+
+		// t[
+		gui_.ShowFrameStats(input.GetFrameStats());
+
+		// APIĂяo
+		gui_.ShowApiCounters();
+		if (ImGui::Button("Export API Counters"))
+		{
+			OutputDebugStringA(vsl::ApiCounters::Instance().ToText().c_str());
+			if (vsl::ApiCounters::Instance().ExportCsv("api_counters.csv"))
+			{
+				OutputDebugString(L"API counters are exported to api_counters.csv.\n");
+			}
+		}
+
+		// GPU
+		if (gpuProfiler_.IsValid())
+		{
+			gui_.ShowGpuProfiler(gpuProfiler_);
+			if (ImGui::Button("Log GPU Profile"))
+			{
+				OutputDebugStringA(gpuProfiler_.ToText().c_str());
+			}
+		}
+
+		// CPUԂChromẽg[X`ŏo͂
+#if VSL_CPU_PROFILER
+		if (ImGui::Button("Export CPU Trace"))
+		{
+			if (vsl::CpuProfiler::Instance().ExportChromeTrace("cpu_trace.json"))
+			{
+				OutputDebugString(L"CPU trace is exported to cpu_trace.json.\n");
 			}
 		}
+#endif
+
+		// GUIŕύXꂽfXNv^܂Ƃ߂Ĕf
+		// R}hɐςޑOɍsKv
+		descWriter_.Flush();
+
+		// pCvCLbV̏
+		{
+			if (!pendingPipelines_.empty())
+			{
+				ImGui::Text("Compiling pipelines... (%u left)", static_cast<uint32_t>(pendingPipelines_.size()));
+			}
+			auto stats = device.GetPipelineStateCache().GetStats();
+			ImGui::Text("Pipeline Cache : hit %u / miss %u (%.2f ms)", stats.hitCount, stats.missCount, stats.compileMilliseconds);
+		}
 
 		// UniformBufferAbvf[g
 		{
@@ -277,6 +430,20 @@ public:
 			cmdBuffer.updateBuffer(sceneBuffer_.GetBuffer(), 0, sizeof(scene), reinterpret_cast<uint32_t*>(&scene));
 		}
 
+		// ݍ
+		// ʂ̓bVpX̃sNZVF[_ŎQƂ
+		if ((viewType_ == 3) && fftConvolution_.HasKernel())
+		{
+			vsl::FFTData source = vsl::FFTData::Real(texture_);
+			vsl::FFTData result = vsl::FFTData::Real(fftTargets_[3]);
+			vsl::GpuProfileScope scope(gpuProfiler_, cmdBuffer, "Convolution");
+			if (fftConvolution_.Execute(cmdBuffer, source, result, static_cast<vsl::FFTConvolutionMethod::Type>(convolutionMethod_)))
+			{
+				vk::MemoryBarrier barrier(vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead);
+				vsl::CmdPipelineBarrier(cmdBuffer, vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eFragmentShader, vk::DependencyFlags(), barrier, nullptr, nullptr);
+			}
+		}
+
 		// obt@NA
 		{
 			vk::ClearColorValue clearColor(std::array<float, 4>{ 0.0f, 0.0f, 0.5f, 1.0f });
@@ -322,6 +489,7 @@ public:
 		}
 
 		// bVpXJn
+		gpuProfiler_.BeginScope(cmdBuffer, "Mesh");
 		vk::RenderPassBeginInfo renderPassBeginInfo;
 		renderPassBeginInfo.renderPass = meshPass_.GetPass();
 		renderPassBeginInfo.renderArea.extent = vk::Extent2D(kScreenWidth, kScreenHeight);
@@ -337,16 +505,21 @@ public:
 			cmdBuffer.setScissor(0, scissor);
 
 			// e\[X̃oCh
+			// pCvCIĂȂꍇ͕`悵Ȃ
 			vk::DeviceSize offsets = 0;
-			if (!isFFTComplete_ || (viewType_ != 1))
+			bool isViewFFT = isFFTComplete_ && (viewType_ == 1);
+			vk::Pipeline meshPipeline = isViewFFT ? fftViewPipeline_ : pipeline_;
+			if (!isViewFFT)
 			{
-				cmdBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pipeLayout_, 0, descSets_[0], nullptr);
-				cmdBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline_);
+				vsl::CmdBindDescriptorSets(cmdBuffer, vk::PipelineBindPoint::eGraphics, pipeLayout_, 0, descSets_[0], nullptr);
 			}
 			else
 			{
-				cmdBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, fftViewPipeLayout_, 0, descSets_[3], nullptr);
-				cmdBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, fftViewPipeline_);
+				vsl::CmdBindDescriptorSets(cmdBuffer, vk::PipelineBindPoint::eGraphics, fftViewPipeLayout_, 0, descSets_[2], nullptr);
+			}
+			if (meshPipeline)
+			{
+				vsl::CmdBindPipeline(cmdBuffer, vk::PipelineBindPoint::eGraphics, meshPipeline);
 			}
 			cmdBuffer.bindVertexBuffers(0, vbuffer_.GetBuffer(), offsets);
 			cmdBuffer.bindIndexBuffer(ibuffer_.GetBuffer(), 0, vk::IndexType::eUint32);
@@ -358,9 +531,13 @@ public:
 			sAngle += 0.1f; if (sAngle > 360.0f) sAngle -= 360.0f;
 			mesh1.mtxModel_[3].z = 0.0f;
 			cmdBuffer.pushConstants(pipeLayout_, vk::ShaderStageFlagBits::eVertex, 0, sizeof(mesh1), &mesh1);
-			cmdBuffer.drawIndexed(6, 1, 0, 0, 1);
+			if (meshPipeline)
+			{
+				vsl::CmdDrawIndexed(cmdBuffer, 6, 1, 0, 0, 1);
+			}
 		}
 		cmdBuffer.endRenderPass();
+		gpuProfiler_.EndScope(cmdBuffer);
 
 		// ItXN[obt@̃CAEgύX
 		{
@@ -388,12 +565,13 @@ public:
 		}
 
 		// Compute ShaderN
-		if (isComputeOn_)
+		if (isComputeOn_ && computePipeline_)
 		{
 			{
-				cmdBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, computePipeline_);
-				cmdBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, computePipeLayout_, 0, descSets_[2], nullptr);
-				cmdBuffer.dispatch(kScreenWidth / 16, kScreenHeight / 16, 1);
+				vsl::GpuProfileScope scope(gpuProfiler_, cmdBuffer, "Compute");
+				vsl::CmdBindPipeline(cmdBuffer, vk::PipelineBindPoint::eCompute, computePipeline_);
+				vsl::CmdBindDescriptorSets(cmdBuffer, vk::PipelineBindPoint::eCompute, computePipeLayout_, 0, descSets_[1], nullptr);
+				vsl::CmdDispatch(cmdBuffer, kScreenWidth / 16, kScreenHeight / 16, 1);
 			}
 
 			// Computeo̓obt@̃CAEgύX
@@ -408,6 +586,7 @@ public:
 		}
 
 		// |XgpXJn
+		gpuProfiler_.BeginScope(cmdBuffer, "Post");
 		renderPassBeginInfo.renderPass = postPass_.GetPass();
 		renderPassBeginInfo.renderArea.extent = vk::Extent2D(kScreenWidth, kScreenHeight);
 		renderPassBeginInfo.clearValueCount = 0;
@@ -421,18 +600,43 @@ public:
 			vk::Rect2D scissor = vk::Rect2D(vk::Offset2D(), vk::Extent2D(kScreenWidth, kScreenHeight));
 			cmdBuffer.setScissor(0, scissor);
 
-			// e\[X̃oCh
-			vk::DeviceSize offsets = 0;
-			cmdBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, postPipeLayout_, 0, descSets_[1], nullptr);
-			cmdBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, postPipeline_);
+			// |XgpX̓͂̓t[p̃AP[^疈t[mۂ
+			// j̓R}hobt@̊ɂ܂Ƃ߂čs
+			vk::DescriptorSet postSet = device.GetFrameDescriptorAllocator().Allocate(postSetLayout_);
+			if (!postSet)
+			{
+				return false;
+			}
+			vk::DescriptorImageInfo postDescInfo(
+				sampler_, isComputeOn_ ? computeBuffer_.GetView() : offscreenBuffer_.GetView(), vk::ImageLayout::eGeneral);
+			vk::DescriptorImageInfo postDepthDescInfo(
+				sampler_, depthBuffer_.GetDepthView(), vk::ImageLayout::eGeneral);
+			std::array<vk::WriteDescriptorSet, 2> descSetInfos{
+				vk::WriteDescriptorSet(postSet, 1, 0, 1, vk::DescriptorType::eCombinedImageSampler, &postDescInfo, nullptr, nullptr),
+				vk::WriteDescriptorSet(postSet, 2, 0, 1, vk::DescriptorType::eCombinedImageSampler, &postDepthDescInfo, nullptr, nullptr),
+			};
+			vsl::UpdateDescriptorSets(device.GetDevice(), descSetInfos);
 
-			cmdBuffer.draw(4, 1, 0, 0);
+			// e\[X̃oCh
+			vsl::CmdBindDescriptorSets(cmdBuffer, vk::PipelineBindPoint::eGraphics, postPipeLayout_, 0, postSet, nullptr);
+			if (postPipeline_)
+			{
+				vsl::CmdBindPipeline(cmdBuffer, vk::PipelineBindPoint::eGraphics, postPipeline_);
+				vsl::CmdDraw(cmdBuffer, 4, 1, 0, 0);
+			}
 		}
 		cmdBuffer.endRenderPass();
+		gpuProfiler_.EndScope(cmdBuffer);
 
 		// imgui render.
 		gui_.SetPassBeginInfo(renderPassBeginInfo);
-		ImGui::Render();
+		{
+			vsl::GpuProfileScope scope(gpuProfiler_, cmdBuffer, "GUI");
+			ImGui::Render();
+		}
+
+		// t[Ŝ̌vI
+		gpuProfiler_.EndScope(cmdBuffer);
 
 		device.ReadyPresentAndEndMainCommandBuffer();
 
@@ -454,6 +658,13 @@ public:
 	{
 		vk::Device& d = device.GetDevice();
 
+		// ̃pCvC̓VF[_⃌CAEgQƂĂ̂Ŋ҂
+		for (auto& pending : pendingPipelines_)
+		{
+			pending.future.wait();
+		}
+		pendingPipelines_.clear();
+
 		if (computeSemaphore_)
 		{
 			d.destroySemaphore(computeSemaphore_);
@@ -465,20 +676,9 @@ public:
 		}
 
 		gui_.Destroy();
+		gpuProfiler_.Destroy();
 
-		for (auto& pipe : fftPipelines_)
-		{
-			d.destroyPipeline(pipe);
-		}
-		d.destroyPipelineLayout(fftPipeLayout_);
-		d.destroyPipeline(computePipeline_);
-		d.destroyPipelineLayout(computePipeLayout_);
-		d.destroyPipeline(postPipeline_);
-		d.destroyPipelineLayout(postPipeLayout_);
-		d.destroyPipeline(fftViewPipeline_);
-		d.destroyPipelineLayout(fftViewPipeLayout_);
-		d.destroyPipeline(pipeline_);
-		d.destroyPipelineLayout(pipeLayout_);
+		// pCvCƃCAEgDevicẽLbVLĂ
 
 		vsTest_.Destroy();
 		psTest_.Destroy();
@@ -486,18 +686,22 @@ public:
 		vsPost_.Destroy();
 		psPost_.Destroy();
 		csTest_.Destroy();
-		for (auto& s : csFFTs_)
+		fftBenchmark_.Destroy();
+		fftConvolution_.Destroy();
+		commandBundles_.Destroy();
+		for (auto& validator : fftValidators_)
 		{
-			s.Destroy();
+			validator.Destroy();
 		}
-
-		for (auto& dl : descLayouts_)
+		for (auto& plan : fftPlans_)
 		{
-			d.destroyDescriptorSetLayout(dl);
+			plan.Destroy();
 		}
-		d.destroyDescriptorPool(descPool_);
+		fft_.Destroy();
+
+		// fXNv^ZbgDevicẽAP[^LĂ
+		descWriter_.Destroy();
 
-		d.destroySampler(sampler_);
 		texture_.Destroy();
 
 		vbuffer_.Destroy();
@@ -515,6 +719,7 @@ public:
 		{
 			image.Destroy();
 		}
+		fftSpectrum_.Destroy();
 		depthBuffer_.Destroy();
 		meshPass_.Destroy();
 		postPass_.Destroy();
@@ -540,38 +745,139 @@ private:
 	//----
 	bool InitializeRenderResource(vsl::Device& device, vk::CommandBuffer& initCmdBuffer)
 	{
-		// VF[_
-		if (!vsTest_.CreateFromFile(device, "data/test.vert.spv"))
+		// eNX`ǂݍ݃NGXg
+		// fR[h̓[J[XbhōŝŁAVF[_ǂݍ݂ƕsĐi
+		vsl::TextureLoader texLoader;
+		if (!texLoader.Initialize(device))
 		{
 			return false;
 		}
-		if (!psTest_.CreateFromFile(device, "data/test.frag.spv"))
+		texLoader.Load(texture_, "data/icon.tga");
+
+		// VF[_
+		// ShaderPackerō쐬oh܂Ƃ߂ēǂݍ
 		{
-			return false;
+			vsl::ShaderBundle bundle;
+			if (!bundle.Open("data/shaders.vslb"))
+			{
+				return false;
+			}
+			if (!vsTest_.CreateFromBundle(device, bundle, "test.vert.spv"))
+			{
+				return false;
+			}
+			if (!psTest_.CreateFromBundle(device, bundle, "test.frag.spv"))
+			{
+				return false;
+			}
+			if (!psView_.CreateFromBundle(device, bundle, "fft_view.frag.spv"))
+			{
+				return false;
+			}
+			if (!vsPost_.CreateFromBundle(device, bundle, "post.vert.spv"))
+			{
+				return false;
+			}
+			if (!psPost_.CreateFromBundle(device, bundle, "post.frag.spv"))
+			{
+				return false;
+			}
+			if (!csTest_.CreateFromBundle(device, bundle, "test.comp.spv"))
+			{
+				return false;
+			}
+
+			// FFTGW̏
+			// Âoh fft.comp.spv, ifft.comp.spv ܂܂ĂȂꍇ256Œ̃VF[_g
+			// ǂ܂܂ĂȂꍇFFT𖳌ɂ
+			isFFTAvailable_ = fft_.Initialize(device, bundle);
+
+			// ݍ݂̏
+			// fft_multiply.comp.spv, convolve.comp.spv ܂܂ĂȂꍇ͏ݍ݂ɂ
+			if (isFFTAvailable_)
+			{
+				vsl::FFTConvolutionDesc desc;
+				desc.width = desc.height = kFFTLength;
+				desc.maxSpatialRadius = kConvolutionMaxSpatialRadius;
+				if (!fftConvolution_.Initialize(fft_, bundle, initCmdBuffer, desc))
+				{
+					fftConvolution_.Destroy();
+				}
+			}
 		}
-		if (!psView_.CreateFromFile(device, "data/fft_view.frag.spv"))
+
+		// FFT̊i[x߂
+		//  fp16 ŐxۂĂ͈͂𒴂ꍇ́Afp32̃VF[_ Single ŕϊ
+		if (isFFTAvailable_)
 		{
-			return false;
+			vsl::FFTPlanDesc desc;
+			desc.width = desc.height = kFFTLength;
+			fftPrecision_ = fft_.ResolvePrecision(desc);
 		}
-		if (!vsPost_.CreateFromFile(device, "data/post.vert.spv"))
+
+		// FFTʂ̃obt@̏
+		// XyNg̎AAtϊʁAݍ݌ʂ̏
+		// ݍ݂ Half ݂̂Ȃ̂ŁAݍ݌ʂ͏ rgba16f ɂ
+		// ԃobt@FFTvL
+		for (int i = 0; i < 4; i++)
 		{
-			return false;
+			vk::Format format = ((i < 3) && (fftPrecision_ == vsl::FFTPrecision::Single)) ? vk::Format::eR32G32B32A32Sfloat : vk::Format::eR16G16B16A16Sfloat;
+			if (!fftTargets_[i].InitializeAsColorBuffer(
+				device, initCmdBuffer,
+				format,
+				kFFTLength, kFFTLength, 1, 1, true))
+			{
+				return false;
+			}
+			fftTargets_[i].SetImageLayout(initCmdBuffer, vk::ImageLayout::eGeneral, vk::ImageSubresourceRange(vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1));
 		}
-		if (!psPost_.CreateFromFile(device, "data/post.frag.spv"))
+		// ϊƋtϊ̊Ԃ̃XyNg͕fl߂obt@Ŏ󂯓n
+		if (!fftSpectrum_.InitializeAsStorageBuffer(device, static_cast<size_t>(vsl::FFTPlan::GetPackedSize(kFFTLength, kFFTLength, fftPrecision_))))
 		{
 			return false;
 		}
-		if (!csTest_.CreateFromFile(device, "data/test.comp.spv"))
+
+		// FFTv̏
+		// ϊƋtϊ1쐬
+		if (isFFTAvailable_)
 		{
-			return false;
+			vsl::FFTPlanDesc desc;
+			desc.width = desc.height = kFFTLength;
+			desc.precision = fftPrecision_;
+			desc.direction = vsl::FFTDirection::Forward;
+			if (!fftPlans_[0].Initialize(fft_, initCmdBuffer, desc))
+			{
+				return false;
+			}
+			desc.direction = vsl::FFTDirection::Inverse;
+			if (!fftPlans_[1].Initialize(fft_, initCmdBuffer, desc))
+			{
+				return false;
+			}
+
+			// ϊƋtϊ1񂸂œǂݏ郁
+			// rpɁAԂƃXyNgC[W2ŎꍇvZĂ
+			vsl::FFTDataType::Type spectrumType = GetFFTSpectrum().type;
+			fftBytesMoved_[0] = fftPlans_[0].GetBytesMoved(vsl::FFTDataType::RealImage, spectrumType)
+				+ fftPlans_[1].GetBytesMoved(spectrumType, vsl::FFTDataType::RealImage);
+			fftBytesMoved_[1] = vsl::FFTPlan::ComputeBytesMoved(fftPlans_[0].GetDesc(), vsl::FFTDataType::RealImage, vsl::FFTDataType::ComplexImages, vsl::FFTDataType::ComplexImages)
+				+ vsl::FFTPlan::ComputeBytesMoved(fftPlans_[1].GetDesc(), vsl::FFTDataType::ComplexImages, vsl::FFTDataType::RealImage, vsl::FFTDataType::ComplexImages);
+
+			// xƂCPUFFTƂ̔rςł
+			// ʂ͏R}h̊Ɏ󂯎
+			desc.direction = vsl::FFTDirection::Forward;
+			for (int i = 0; i < vsl::FFTPrecision::Max; i++)
+			{
+				desc.precision = static_cast<vsl::FFTPrecision::Type>(i);
+				if (fftValidators_[i].Initialize(fft_, initCmdBuffer, desc))
+				{
+					fftValidators_[i].Record(initCmdBuffer);
+				}
+			}
 		}
-		if (!csFFTs_[0].CreateFromFile(device, "data/fft_r.comp.spv")) { return false; }
-		if (!csFFTs_[1].CreateFromFile(device, "data/fft_c.comp.spv")) { return false; }
-		if (!csFFTs_[2].CreateFromFile(device, "data/ifft_r.comp.spv")) { return false; }
-		if (!csFFTs_[3].CreateFromFile(device, "data/ifft_c.comp.spv")) { return false; }
 
-		// eNX`ǂݍ
-		if (!texture_.InitializeFromTgaImage(device, initCmdBuffer, texStaging_, "data/icon.tga"))
+		// eNX`]
+		if (!texLoader.Flush(initCmdBuffer, texStaging_))
 		{
 			return false;
 		}
@@ -592,7 +898,7 @@ private:
 			samplerCreateInfo.maxAnisotropy = 8;
 			samplerCreateInfo.anisotropyEnable = VK_TRUE;
 			samplerCreateInfo.borderColor = vk::BorderColor::eFloatOpaqueWhite;
-			sampler_ = device.GetDevice().createSampler(samplerCreateInfo);
+			sampler_ = device.GetSamplerCache().GetSampler(samplerCreateInfo);
 		}
 
 		// _obt@
@@ -638,133 +944,35 @@ private:
 
 		// fXNv^Zbg𐶐
 		{
-			// fXNv^v[쐬
-			{
-				std::array<vk::DescriptorPoolSize, 3> typeCounts;
-				typeCounts[0].type = vk::DescriptorType::eUniformBuffer;
-				typeCounts[0].descriptorCount = 3;
-				typeCounts[1].type = vk::DescriptorType::eCombinedImageSampler;
-				typeCounts[1].descriptorCount = 5;
-				typeCounts[2].type = vk::DescriptorType::eStorageImage;
-				typeCounts[2].descriptorCount = 18;
-
-				// fXNv^v[𐶐
-				vk::DescriptorPoolCreateInfo descriptorPoolInfo;
-				descriptorPoolInfo.poolSizeCount = static_cast<uint32_t>(typeCounts.size());
-				descriptorPoolInfo.pPoolSizes = typeCounts.data();
-				descriptorPoolInfo.maxSets = 8;
-				descPool_ = device.GetDevice().createDescriptorPool(descriptorPoolInfo);
-			}
-
-			// fXNv^ZbgCAEg쐬
+			// VF[_̃tNV񂩂烌CAEg擾
+			// CAEgDevicẽLbVLĂ
 			std::vector<vk::DescriptorSetLayout> refLayouts;
 			{
-				// `掞̃VF[_Zbgɑ΂fXNv^Zbg̃CAEgw肷
-				std::array<vk::DescriptorSetLayoutBinding, 2> layoutBindings;
-				// UniformBuffer for VertexShader
-				layoutBindings[0].descriptorType = vk::DescriptorType::eUniformBuffer;
-				layoutBindings[0].descriptorCount = 1;
-				layoutBindings[0].binding = 0;
-				layoutBindings[0].stageFlags = vk::ShaderStageFlagBits::eVertex;
-				layoutBindings[0].pImmutableSamplers = nullptr;
-				// CombinedImageSampler for PixelShader
-				layoutBindings[1].descriptorType = vk::DescriptorType::eCombinedImageSampler;
-				layoutBindings[1].descriptorCount = 1;
-				layoutBindings[1].binding = 1;
-				layoutBindings[1].stageFlags = vk::ShaderStageFlagBits::eFragment;
-				layoutBindings[1].pImmutableSamplers = nullptr;
-
-				// CAEg𐶐
-				vk::DescriptorSetLayoutCreateInfo descriptorLayout;
-				descriptorLayout.bindingCount = static_cast<uint32_t>(layoutBindings.size());
-				descriptorLayout.pBindings = layoutBindings.data();
-				vk::DescriptorSetLayout sl = device.GetDevice().createDescriptorSetLayout(descriptorLayout, nullptr);
-				descLayouts_.push_back(sl);
-				refLayouts.push_back(sl);
-			}
-			{
-				// `掞̃VF[_Zbgɑ΂fXNv^Zbg̃CAEgw肷
-				std::array<vk::DescriptorSetLayoutBinding, 2> layoutBindings;
-				// CombinedImageSampler (Color buffer) for PixelShader
-				layoutBindings[0].descriptorType = vk::DescriptorType::eCombinedImageSampler;
-				layoutBindings[0].descriptorCount = 1;
-				layoutBindings[0].binding = 1;
-				layoutBindings[0].stageFlags = vk::ShaderStageFlagBits::eFragment;
-				layoutBindings[0].pImmutableSamplers = nullptr;
-				// CombinedImageSampler (Depth buffer) for PixelShader
-				layoutBindings[1].descriptorType = vk::DescriptorType::eCombinedImageSampler;
-				layoutBindings[1].descriptorCount = 1;
-				layoutBindings[1].binding = 2;
-				layoutBindings[1].stageFlags = vk::ShaderStageFlagBits::eFragment;
-				layoutBindings[1].pImmutableSamplers = nullptr;
-
-				// CAEg𐶐
-				vk::DescriptorSetLayoutCreateInfo descriptorLayout;
-				descriptorLayout.bindingCount = static_cast<uint32_t>(layoutBindings.size());
-				descriptorLayout.pBindings = layoutBindings.data();
-				vk::DescriptorSetLayout sl = device.GetDevice().createDescriptorSetLayout(descriptorLayout, nullptr);
-				descLayouts_.push_back(sl);
-				refLayouts.push_back(sl);
-			}
-			{
-				// `掞̃VF[_Zbgɑ΂fXNv^Zbg̃CAEgw肷
-				std::array<vk::DescriptorSetLayoutBinding, 2> layoutBindings;
-				// read only image for ComputeShader
-				layoutBindings[0].descriptorType = vk::DescriptorType::eStorageImage;
-				layoutBindings[0].descriptorCount = 1;
-				layoutBindings[0].binding = 0;
-				layoutBindings[0].stageFlags = vk::ShaderStageFlagBits::eCompute;
-				layoutBindings[0].pImmutableSamplers = nullptr;
-				// write only image for ComputeShader
-				layoutBindings[1].descriptorType = vk::DescriptorType::eStorageImage;
-				layoutBindings[1].descriptorCount = 1;
-				layoutBindings[1].binding = 1;
-				layoutBindings[1].stageFlags = vk::ShaderStageFlagBits::eCompute;
-				layoutBindings[1].pImmutableSamplers = nullptr;
-
-				// CAEg𐶐
-				vk::DescriptorSetLayoutCreateInfo descriptorLayout;
-				descriptorLayout.bindingCount = static_cast<uint32_t>(layoutBindings.size());
-				descriptorLayout.pBindings = layoutBindings.data();
-				vk::DescriptorSetLayout sl = device.GetDevice().createDescriptorSetLayout(descriptorLayout, nullptr);
-				descLayouts_.push_back(sl);
-				refLayouts.push_back(sl);
-			}
-			{
-				// `掞̃VF[_Zbgɑ΂fXNv^Zbg̃CAEgw肷
-				std::array<vk::DescriptorSetLayoutBinding, 3> layoutBindings{
-					vk::DescriptorSetLayoutBinding(0, vk::DescriptorType::eUniformBuffer, 1, vk::ShaderStageFlagBits::eVertex),
-					vk::DescriptorSetLayoutBinding(1, vk::DescriptorType::eCombinedImageSampler, 1, vk::ShaderStageFlagBits::eFragment),
-					vk::DescriptorSetLayoutBinding(2, vk::DescriptorType::eCombinedImageSampler, 1, vk::ShaderStageFlagBits::eFragment),
-				};
-
-				// CAEg𐶐
-				vk::DescriptorSetLayoutCreateInfo descriptorLayout;
-				descriptorLayout.bindingCount = static_cast<uint32_t>(layoutBindings.size());
-				descriptorLayout.pBindings = layoutBindings.data();
-				vk::DescriptorSetLayout sl = device.GetDevice().createDescriptorSetLayout(descriptorLayout, nullptr);
-				descLayouts_.push_back(sl);
-				refLayouts.push_back(sl);
-			}
-			{
-				// `掞̃VF[_Zbgɑ΂fXNv^Zbg̃CAEgw肷
-				std::array<vk::DescriptorSetLayoutBinding, 4> layoutBindings{
-					vk::DescriptorSetLayoutBinding(0, vk::DescriptorType::eStorageImage, 1, vk::ShaderStageFlagBits::eCompute),
-					vk::DescriptorSetLayoutBinding(1, vk::DescriptorType::eStorageImage, 1, vk::ShaderStageFlagBits::eCompute),
-					vk::DescriptorSetLayoutBinding(2, vk::DescriptorType::eStorageImage, 1, vk::ShaderStageFlagBits::eCompute),
-					vk::DescriptorSetLayoutBinding(3, vk::DescriptorType::eStorageImage, 1, vk::ShaderStageFlagBits::eCompute),
+				// setCount 0̂̂̓t[ƂɃZbgmۂ
+				auto GetLayouts = [&](std::initializer_list<const vsl::Shader*> shaders, vk::PipelineLayout& pipeLayout, int setCount)
+				{
+					std::vector<vk::DescriptorSetLayout> setLayouts;
+					if (!device.GetLayoutCache().GetLayouts(shaders, setLayouts, pipeLayout) || setLayouts.empty())
+					{
+						return false;
+					}
+					if (setCount == 0)
+					{
+						postSetLayout_ = setLayouts[0];
+					}
+					for (int i = 0; i < setCount; i++)
+					{
+						refLayouts.push_back(setLayouts[0]);
+					}
+					return true;
 				};
-
-				// CAEg𐶐
-				vk::DescriptorSetLayoutCreateInfo descriptorLayout;
-				descriptorLayout.bindingCount = static_cast<uint32_t>(layoutBindings.size());
-				descriptorLayout.pBindings = layoutBindings.data();
-				vk::DescriptorSetLayout sl = device.GetDevice().createDescriptorSetLayout(descriptorLayout, nullptr);
-				descLayouts_.push_back(sl);
-				refLayouts.push_back(sl);
-				refLayouts.push_back(sl);
-				refLayouts.push_back(sl);
-				refLayouts.push_back(sl);
+				if (!GetLayouts({ &vsTest_, &psTest_ }, pipeLayout_, 1)
+					|| !GetLayouts({ &vsPost_, &psPost_ }, postPipeLayout_, 0)
+					|| !GetLayouts({ &csTest_ }, computePipeLayout_, 1)
+					|| !GetLayouts({ &vsTest_, &psView_ }, fftViewPipeLayout_, 1))
+				{
+					return false;
+				}
 			}
 
 			// fXNv^Zbg쐬
@@ -772,12 +980,6 @@ private:
 				vk::DescriptorImageInfo texDescInfo(
 					sampler_, texture_.GetView(), vk::ImageLayout::eGeneral);
 
-				vk::DescriptorImageInfo postDescInfo(
-					sampler_, computeBuffer_.GetView(), vk::ImageLayout::eGeneral);
-
-				vk::DescriptorImageInfo postDepthDescInfo(
-					sampler_, depthBuffer_.GetDepthView(), vk::ImageLayout::eGeneral);
-
 				vk::DescriptorImageInfo computeInDescInfo(
 					vk::Sampler(), offscreenBuffer_.GetView(), vk::ImageLayout::eGeneral);
 
@@ -785,62 +987,37 @@ private:
 					vk::Sampler(), computeBuffer_.GetView(), vk::ImageLayout::eGeneral);
 
 				vk::DescriptorImageInfo fftvRDescInfo(
-					sampler_, fftTargets_[2].GetView(), vk::ImageLayout::eGeneral);
+					sampler_, fftTargets_[0].GetView(), vk::ImageLayout::eGeneral);
 				vk::DescriptorImageInfo fftvIDescInfo(
-					sampler_, fftTargets_[3].GetView(), vk::ImageLayout::eGeneral);
-
-				vk::DescriptorImageInfo fftSrcDescInfo(
-					vk::Sampler(), texture_.GetView(), vk::ImageLayout::eGeneral);
-				vk::DescriptorImageInfo fft0DescInfo(
-					vk::Sampler(), fftTargets_[0].GetView(), vk::ImageLayout::eGeneral);
-				vk::DescriptorImageInfo fft1DescInfo(
-					vk::Sampler(), fftTargets_[1].GetView(), vk::ImageLayout::eGeneral);
-				vk::DescriptorImageInfo fft2DescInfo(
-					vk::Sampler(), fftTargets_[2].GetView(), vk::ImageLayout::eGeneral);
-				vk::DescriptorImageInfo fft3DescInfo(
-					vk::Sampler(), fftTargets_[3].GetView(), vk::ImageLayout::eGeneral);
-				vk::DescriptorImageInfo fft4DescInfo(
-					vk::Sampler(), fftTargets_[4].GetView(), vk::ImageLayout::eGeneral);
-				vk::DescriptorImageInfo fft5DescInfo(
-					vk::Sampler(), fftTargets_[5].GetView(), vk::ImageLayout::eGeneral);
+					sampler_, fftTargets_[1].GetView(), vk::ImageLayout::eGeneral);
 
 				vk::DescriptorBufferInfo dbInfo = sceneBuffer_.GetDescInfo();
 
-				// fXNv^Zbg͍쐬ς݂̃fXNv^v[mۂ
-				vk::DescriptorSetAllocateInfo allocInfo;
-				allocInfo.descriptorPool = descPool_;
-				allocInfo.descriptorSetCount = static_cast<uint32_t>(refLayouts.size());
-				allocInfo.pSetLayouts = refLayouts.data();
-				descSets_ = device.GetDevice().allocateDescriptorSets(allocInfo);
+				// fXNv^ZbgDevicẽAP[^mۂ
+				for (auto& layout : refLayouts)
+				{
+					vk::DescriptorSet set = device.GetDescriptorAllocator().Allocate(layout);
+					if (!set)
+					{
+						return false;
+					}
+					descSets_.push_back(set);
+				}
 
 				// fXNv^Zbg̏XV
-				std::array<vk::WriteDescriptorSet, 24> descSetInfos{
-					vk::WriteDescriptorSet(descSets_[0], 0, 0, 1, vk::DescriptorType::eUniformBuffer, nullptr, &dbInfo, nullptr),
-					vk::WriteDescriptorSet(descSets_[0], 1, 0, 1, vk::DescriptorType::eCombinedImageSampler, &texDescInfo, nullptr, nullptr),
-					vk::WriteDescriptorSet(descSets_[1], 1, 0, 1, vk::DescriptorType::eCombinedImageSampler, &postDescInfo, nullptr, nullptr),
-					vk::WriteDescriptorSet(descSets_[1], 2, 0, 1, vk::DescriptorType::eCombinedImageSampler, &postDepthDescInfo, nullptr, nullptr),
-					vk::WriteDescriptorSet(descSets_[2], 0, 0, 1, vk::DescriptorType::eStorageImage, &computeInDescInfo, nullptr, nullptr),
-					vk::WriteDescriptorSet(descSets_[2], 1, 0, 1, vk::DescriptorType::eStorageImage, &computeOutDescInfo, nullptr, nullptr),
-					vk::WriteDescriptorSet(descSets_[3], 0, 0, 1, vk::DescriptorType::eUniformBuffer, nullptr, &dbInfo, nullptr),
-					vk::WriteDescriptorSet(descSets_[3], 1, 0, 1, vk::DescriptorType::eCombinedImageSampler, &fftvRDescInfo, nullptr, nullptr),
-					vk::WriteDescriptorSet(descSets_[3], 2, 0, 1, vk::DescriptorType::eCombinedImageSampler, &fftvIDescInfo, nullptr, nullptr),
-					vk::WriteDescriptorSet(descSets_[4], 0, 0, 1, vk::DescriptorType::eStorageImage, &fftSrcDescInfo, nullptr, nullptr),
-					vk::WriteDescriptorSet(descSets_[4], 2, 0, 1, vk::DescriptorType::eStorageImage, &fft0DescInfo, nullptr, nullptr),
-					vk::WriteDescriptorSet(descSets_[4], 3, 0, 1, vk::DescriptorType::eStorageImage, &fft1DescInfo, nullptr, nullptr),
-					vk::WriteDescriptorSet(descSets_[5], 0, 0, 1, vk::DescriptorType::eStorageImage, &fft0DescInfo, nullptr, nullptr),
-					vk::WriteDescriptorSet(descSets_[5], 1, 0, 1, vk::DescriptorType::eStorageImage, &fft1DescInfo, nullptr, nullptr),
-					vk::WriteDescriptorSet(descSets_[5], 2, 0, 1, vk::DescriptorType::eStorageImage, &fft2DescInfo, nullptr, nullptr),
-					vk::WriteDescriptorSet(descSets_[5], 3, 0, 1, vk::DescriptorType::eStorageImage, &fft3DescInfo, nullptr, nullptr),
-					vk::WriteDescriptorSet(descSets_[6], 0, 0, 1, vk::DescriptorType::eStorageImage, &fft2DescInfo, nullptr, nullptr),
-					vk::WriteDescriptorSet(descSets_[6], 1, 0, 1, vk::DescriptorType::eStorageImage, &fft3DescInfo, nullptr, nullptr),
-					vk::WriteDescriptorSet(descSets_[6], 2, 0, 1, vk::DescriptorType::eStorageImage, &fft0DescInfo, nullptr, nullptr),
-					vk::WriteDescriptorSet(descSets_[6], 3, 0, 1, vk::DescriptorType::eStorageImage, &fft1DescInfo, nullptr, nullptr),
-					vk::WriteDescriptorSet(descSets_[7], 0, 0, 1, vk::DescriptorType::eStorageImage, &fft0DescInfo, nullptr, nullptr),
-					vk::WriteDescriptorSet(descSets_[7], 1, 0, 1, vk::DescriptorType::eStorageImage, &fft1DescInfo, nullptr, nullptr),
-					vk::WriteDescriptorSet(descSets_[7], 2, 0, 1, vk::DescriptorType::eStorageImage, &fft4DescInfo, nullptr, nullptr),
-					vk::WriteDescriptorSet(descSets_[7], 3, 0, 1, vk::DescriptorType::eStorageImage, &fft5DescInfo, nullptr, nullptr),
-				};
-				device.GetDevice().updateDescriptorSets(descSetInfos, nullptr);
+				// ݂͋L^ĂA܂Ƃ߂Ĕf
+				if (!descWriter_.Initialize(device))
+				{
+					return false;
+				}
+				descWriter_.WriteBuffer(descSets_[0], 0, vk::DescriptorType::eUniformBuffer, dbInfo);
+				descWriter_.WriteImage(descSets_[0], 1, vk::DescriptorType::eCombinedImageSampler, texDescInfo);
+				descWriter_.WriteImage(descSets_[1], 0, vk::DescriptorType::eStorageImage, computeInDescInfo);
+				descWriter_.WriteImage(descSets_[1], 1, vk::DescriptorType::eStorageImage, computeOutDescInfo);
+				descWriter_.WriteBuffer(descSets_[2], 0, vk::DescriptorType::eUniformBuffer, dbInfo);
+				descWriter_.WriteImage(descSets_[2], 1, vk::DescriptorType::eCombinedImageSampler, fftvRDescInfo);
+				descWriter_.WriteImage(descSets_[2], 2, vk::DescriptorType::eCombinedImageSampler, fftvIDescInfo);
+				descWriter_.Flush();
 			}
 		}
 
@@ -849,327 +1026,111 @@ private:
 
 	bool InitializePipeline(vsl::Device& device)
 	{
-		{
-			// PushConstant𗘗p
-			// ȃTCY̒萔obt@̓R}hobt@ɏ悹ăVF[_ɑ邱Ƃ\
-			vk::PushConstantRange pushConstantRange(vk::ShaderStageFlagBits::eVertex, 0, sizeof(MeshData));
-
-			// fXNv^ZbgCAEgɑΉpCvCCAEg𐶐
-			// ʏ11Ő̂ȁH
-			vk::PipelineLayoutCreateInfo pPipelineLayoutCreateInfo;
-			pPipelineLayoutCreateInfo.setLayoutCount = 1;
-			pPipelineLayoutCreateInfo.pSetLayouts = &descLayouts_[0];
-			pPipelineLayoutCreateInfo.pushConstantRangeCount = 1;
-			pPipelineLayoutCreateInfo.pPushConstantRanges = &pushConstantRange;
-			pipeLayout_ = device.GetDevice().createPipelineLayout(pPipelineLayoutCreateInfo);
-		}
-		{
-			// PushConstant𗘗p
-			// ȃTCY̒萔obt@̓R}hobt@ɏ悹ăVF[_ɑ邱Ƃ\
-			vk::PushConstantRange pushConstantRange(vk::ShaderStageFlagBits::eVertex, 0, sizeof(MeshData));
-
-			// fXNv^ZbgCAEgɑΉpCvCCAEg𐶐
-			// ʏ11Ő̂ȁH
-			vk::PipelineLayoutCreateInfo pPipelineLayoutCreateInfo;
-			pPipelineLayoutCreateInfo.setLayoutCount = 1;
-			pPipelineLayoutCreateInfo.pSetLayouts = &descLayouts_[3];
-			pPipelineLayoutCreateInfo.pushConstantRangeCount = 1;
-			pPipelineLayoutCreateInfo.pPushConstantRanges = &pushConstantRange;
-			fftViewPipeLayout_ = device.GetDevice().createPipelineLayout(pPipelineLayoutCreateInfo);
-		}
-
-		// `g|W̐ݒ
-		vk::PipelineInputAssemblyStateCreateInfo inputAssemblyState;
-		inputAssemblyState.topology = vk::PrimitiveTopology::eTriangleList;
-
-		// X^CYXe[g̐ݒ
-		vk::PipelineRasterizationStateCreateInfo rasterizationState;
-		rasterizationState.polygonMode = vk::PolygonMode::eFill;
-		rasterizationState.cullMode = vk::CullModeFlagBits::eNone;
-		rasterizationState.frontFace = vk::FrontFace::eCounterClockwise;
-		rasterizationState.depthClampEnable = VK_FALSE;
-		rasterizationState.rasterizerDiscardEnable = VK_FALSE;
-		rasterizationState.depthBiasEnable = VK_FALSE;
-		rasterizationState.lineWidth = 1.0f;
-
-		// uh[h̐ݒ
-		vk::PipelineColorBlendStateCreateInfo colorBlendState;
-		vk::PipelineColorBlendAttachmentState blendAttachmentState[1] = {};
-		blendAttachmentState[0].colorWriteMask = vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG | vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA;
-		blendAttachmentState[0].blendEnable = VK_TRUE;
-		blendAttachmentState[0].colorBlendOp = vk::BlendOp::eAdd;
-		blendAttachmentState[0].srcColorBlendFactor = vk::BlendFactor::eSrcAlpha;
-		blendAttachmentState[0].dstColorBlendFactor = vk::BlendFactor::eOneMinusSrcAlpha;
-		blendAttachmentState[0].alphaBlendOp = vk::BlendOp::eAdd;
-		blendAttachmentState[0].srcAlphaBlendFactor = vk::BlendFactor::eOne;
-		blendAttachmentState[0].dstAlphaBlendFactor = vk::BlendFactor::eZero;
-		colorBlendState.attachmentCount = ARRAYSIZE(blendAttachmentState);
-		colorBlendState.pAttachments = blendAttachmentState;
-
-		// ViewportXe[g̐ݒ
-		vk::PipelineViewportStateCreateInfo viewportState;
-		viewportState.viewportCount = 1;
-		viewportState.scissorCount = 1;
-
-		// DynamicState𗘗pViewportScissorBoxύXł悤ɂĂ
-		vk::PipelineDynamicStateCreateInfo dynamicState;
-		std::vector<vk::DynamicState> dynamicStateEnables;
-		dynamicStateEnables.push_back(vk::DynamicState::eViewport);
-		dynamicStateEnables.push_back(vk::DynamicState::eScissor);
-		dynamicState.pDynamicStates = dynamicStateEnables.data();
-		dynamicState.dynamicStateCount = static_cast<uint32_t>(dynamicStateEnables.size());
-
-		// DepthStensilXe[g̐ݒ
-		vk::PipelineDepthStencilStateCreateInfo depthStencilState;
-		depthStencilState.depthTestEnable = VK_TRUE;
-		depthStencilState.depthWriteEnable = VK_TRUE;
-		depthStencilState.depthCompareOp = vk::CompareOp::eLessOrEqual;
-		depthStencilState.depthBoundsTestEnable = VK_FALSE;
-		depthStencilState.back.failOp = vk::StencilOp::eKeep;
-		depthStencilState.back.passOp = vk::StencilOp::eKeep;
-		depthStencilState.back.compareOp = vk::CompareOp::eAlways;
-		depthStencilState.stencilTestEnable = VK_FALSE;
-		depthStencilState.front = depthStencilState.back;
-
-		// }`TvXe[g
-		vk::PipelineMultisampleStateCreateInfo multisampleState;
-		multisampleState.pSampleMask = NULL;
-		multisampleState.rasterizationSamples = vk::SampleCountFlagBits::e1;
-
-		// VF[_ݒ
-		std::array<vk::PipelineShaderStageCreateInfo, 2> shaderStages;
-		shaderStages[0].stage = vk::ShaderStageFlagBits::eVertex;
-		shaderStages[0].module = vsTest_.GetModule();
-		shaderStages[0].pName = "main";
-		shaderStages[1].stage = vk::ShaderStageFlagBits::eFragment;
-		shaderStages[1].module = psTest_.GetModule();
-		shaderStages[1].pName = "main";
-
-		// _
-		std::array<vk::VertexInputBindingDescription, 1> bindDescs;
-		bindDescs[0].binding = 0;		// 0ԂփoCh
-		bindDescs[0].stride = sizeof(Vertex);
-		bindDescs[0].inputRate = vk::VertexInputRate::eVertex;
-
-		std::array<vk::VertexInputAttributeDescription, 3> attribDescs;
-		// Position
-		attribDescs[0].binding = 0;
-		attribDescs[0].location = 0;
-		attribDescs[0].format = vk::Format::eR32G32B32Sfloat;
-		attribDescs[0].offset = 0;
-		// Color
-		attribDescs[1].binding = 0;
-		attribDescs[1].location = 1;
-		attribDescs[1].format = vk::Format::eR32G32B32A32Sfloat;
-		attribDescs[1].offset = sizeof(glm::vec3);
-		// UV
-		attribDescs[2].binding = 0;
-		attribDescs[2].location = 2;
-		attribDescs[2].format = vk::Format::eR32G32Sfloat;
-		attribDescs[2].offset = attribDescs[1].offset + sizeof(glm::vec4);
-
-		vk::PipelineVertexInputStateCreateInfo vinputState;
-		vinputState.vertexBindingDescriptionCount = static_cast<uint32_t>(bindDescs.size());
-		vinputState.pVertexBindingDescriptions = bindDescs.data();
-		vinputState.vertexAttributeDescriptionCount = static_cast<uint32_t>(attribDescs.size());
-		vinputState.pVertexAttributeDescriptions = attribDescs.data();
-
-		// pCvCɊeXe[gݒ肵Đ
-		vk::GraphicsPipelineCreateInfo pipelineCreateInfo;
-		pipelineCreateInfo.layout = pipeLayout_;
-		pipelineCreateInfo.renderPass = meshPass_.GetPass();
-		pipelineCreateInfo.stageCount = static_cast<uint32_t>(shaderStages.size());
-		pipelineCreateInfo.pStages = shaderStages.data();
-		pipelineCreateInfo.pVertexInputState = &vinputState;
-		pipelineCreateInfo.pInputAssemblyState = &inputAssemblyState;
-		pipelineCreateInfo.pRasterizationState = &rasterizationState;
-		pipelineCreateInfo.pColorBlendState = &colorBlendState;
-		pipelineCreateInfo.pMultisampleState = &multisampleState;
-		pipelineCreateInfo.pViewportState = &viewportState;
-		pipelineCreateInfo.pDepthStencilState = &depthStencilState;
-		pipelineCreateInfo.pDynamicState = &dynamicState;
-
-		pipeline_ = device.GetDevice().createGraphicsPipelines(device.GetPipelineCache(), pipelineCreateInfo, nullptr)[0];
-		if (!pipeline_)
-		{
-			return false;
-		}
-
-		shaderStages[1].stage = vk::ShaderStageFlagBits::eFragment;
-		shaderStages[1].module = psView_.GetModule();
-		shaderStages[1].pName = "main";
-
-		pipelineCreateInfo.layout = fftViewPipeLayout_;
-
-		fftViewPipeline_ = device.GetDevice().createGraphicsPipelines(device.GetPipelineCache(), pipelineCreateInfo, nullptr)[0];
-		if (!fftViewPipeline_)
-		{
-			return false;
-		}
+		// pCvC
+		// [xeXg̔AViewportScissorBox͓IɕύX
+		vsl::PipelineBuilder builder;
+		builder.SetShader(vk::ShaderStageFlagBits::eVertex, vsTest_.GetModule())
+			.SetShader(vk::ShaderStageFlagBits::eFragment, psTest_.GetModule())
+			.SetVertexBinding(0, sizeof(Vertex))
+			.AddVertexAttribute(0, 0, vk::Format::eR32G32B32Sfloat, 0)										// Position
+			.AddVertexAttribute(1, 0, vk::Format::eR32G32B32A32Sfloat, sizeof(glm::vec3))					// Color
+			.AddVertexAttribute(2, 0, vk::Format::eR32G32Sfloat, sizeof(glm::vec3) + sizeof(glm::vec4))	// UV
+			.SetAlphaBlend(0)
+			.SetLayout(pipeLayout_)
+			.SetRenderPass(meshPass_);
+
+		RequestPipeline(device, builder, pipeline_);
+
+		// FFT\p̓sNZVF[_ƃCAEgւ
+		builder.SetShader(vk::ShaderStageFlagBits::eFragment, psView_.GetModule())
+			.SetLayout(fftViewPipeLayout_);
+
+		RequestPipeline(device, builder, fftViewPipeline_);
 
 		return true;
 	}
 
 	bool InitializePostPipeline(vsl::Device& device)
 	{
-		{
-			// fXNv^ZbgCAEgɑΉpCvCCAEg𐶐
-			// ʏ11Ő̂ȁH
-			vk::PipelineLayoutCreateInfo pPipelineLayoutCreateInfo;
-			pPipelineLayoutCreateInfo.setLayoutCount = 1;
-			pPipelineLayoutCreateInfo.pSetLayouts = &descLayouts_[1];
-			postPipeLayout_ = device.GetDevice().createPipelineLayout(pPipelineLayoutCreateInfo);
-		}
-
-		// `g|W̐ݒ
-		vk::PipelineInputAssemblyStateCreateInfo inputAssemblyState;
-		inputAssemblyState.topology = vk::PrimitiveTopology::eTriangleStrip;
-
-		// X^CYXe[g̐ݒ
-		vk::PipelineRasterizationStateCreateInfo rasterizationState;
-		rasterizationState.polygonMode = vk::PolygonMode::eFill;
-		rasterizationState.cullMode = vk::CullModeFlagBits::eNone;
-		rasterizationState.frontFace = vk::FrontFace::eCounterClockwise;
-		rasterizationState.depthClampEnable = VK_FALSE;
-		rasterizationState.rasterizerDiscardEnable = VK_FALSE;
-		rasterizationState.depthBiasEnable = VK_FALSE;
-		rasterizationState.lineWidth = 1.0f;
-
-		// uh[h̐ݒ
-		vk::PipelineColorBlendStateCreateInfo colorBlendState;
-		vk::PipelineColorBlendAttachmentState blendAttachmentState[1] = {};
-		blendAttachmentState[0].colorWriteMask = vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG | vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA;
-		blendAttachmentState[0].blendEnable = VK_TRUE;
-		blendAttachmentState[0].colorBlendOp = vk::BlendOp::eAdd;
-		blendAttachmentState[0].srcColorBlendFactor = vk::BlendFactor::eSrcAlpha;
-		blendAttachmentState[0].dstColorBlendFactor = vk::BlendFactor::eOneMinusSrcAlpha;
-		blendAttachmentState[0].alphaBlendOp = vk::BlendOp::eAdd;
-		blendAttachmentState[0].srcAlphaBlendFactor = vk::BlendFactor::eOne;
-		blendAttachmentState[0].dstAlphaBlendFactor = vk::BlendFactor::eZero;
-		colorBlendState.attachmentCount = ARRAYSIZE(blendAttachmentState);
-		colorBlendState.pAttachments = blendAttachmentState;
-
-		// ViewportXe[g̐ݒ
-		vk::PipelineViewportStateCreateInfo viewportState;
-		viewportState.viewportCount = 1;
-		viewportState.scissorCount = 1;
-
-		// DynamicState𗘗pViewportScissorBoxύXł悤ɂĂ
-		vk::PipelineDynamicStateCreateInfo dynamicState;
-		std::vector<vk::DynamicState> dynamicStateEnables;
-		dynamicStateEnables.push_back(vk::DynamicState::eViewport);
-		dynamicStateEnables.push_back(vk::DynamicState::eScissor);
-		dynamicState.pDynamicStates = dynamicStateEnables.data();
-		dynamicState.dynamicStateCount = static_cast<uint32_t>(dynamicStateEnables.size());
-
-		// DepthStensilXe[g̐ݒ
-		vk::PipelineDepthStencilStateCreateInfo depthStencilState;
-		depthStencilState.depthTestEnable = VK_TRUE;
-		depthStencilState.depthWriteEnable = VK_TRUE;
-		depthStencilState.depthCompareOp = vk::CompareOp::eLessOrEqual;
-		depthStencilState.depthBoundsTestEnable = VK_FALSE;
-		depthStencilState.back.failOp = vk::StencilOp::eKeep;
-		depthStencilState.back.passOp = vk::StencilOp::eKeep;
-		depthStencilState.back.compareOp = vk::CompareOp::eAlways;
-		depthStencilState.stencilTestEnable = VK_FALSE;
-		depthStencilState.front = depthStencilState.back;
-
-		// }`TvXe[g
-		vk::PipelineMultisampleStateCreateInfo multisampleState;
-		multisampleState.pSampleMask = NULL;
-		multisampleState.rasterizationSamples = vk::SampleCountFlagBits::e1;
-
-		// VF[_ݒ
-		std::array<vk::PipelineShaderStageCreateInfo, 2> shaderStages;
-		shaderStages[0].stage = vk::ShaderStageFlagBits::eVertex;
-		shaderStages[0].module = vsPost_.GetModule();
-		shaderStages[0].pName = "main";
-		shaderStages[1].stage = vk::ShaderStageFlagBits::eFragment;
-		shaderStages[1].module = psPost_.GetModule();
-		shaderStages[1].pName = "main";
-
-		// _
-		vk::PipelineVertexInputStateCreateInfo vinputState;
-
-		// pCvCɊeXe[gݒ肵Đ
-		vk::GraphicsPipelineCreateInfo pipelineCreateInfo;
-		pipelineCreateInfo.layout = postPipeLayout_;
-		pipelineCreateInfo.renderPass = postPass_.GetPass();
-		pipelineCreateInfo.stageCount = static_cast<uint32_t>(shaderStages.size());
-		pipelineCreateInfo.pStages = shaderStages.data();
-		pipelineCreateInfo.pVertexInputState = &vinputState;
-		pipelineCreateInfo.pInputAssemblyState = &inputAssemblyState;
-		pipelineCreateInfo.pRasterizationState = &rasterizationState;
-		pipelineCreateInfo.pColorBlendState = &colorBlendState;
-		pipelineCreateInfo.pMultisampleState = &multisampleState;
-		pipelineCreateInfo.pViewportState = &viewportState;
-		pipelineCreateInfo.pDepthStencilState = &depthStencilState;
-		pipelineCreateInfo.pDynamicState = &dynamicState;
-
-		postPipeline_ = device.GetDevice().createGraphicsPipelines(device.GetPipelineCache(), pipelineCreateInfo, nullptr)[0];
-		if (!postPipeline_)
-		{
-			return false;
-		}
+		// pCvC
+		// _͂Ȃ̑Sʕ`
+		vsl::PipelineBuilder builder;
+		builder.SetShader(vk::ShaderStageFlagBits::eVertex, vsPost_.GetModule())
+			.SetShader(vk::ShaderStageFlagBits::eFragment, psPost_.GetModule())
+			.SetTopology(vk::PrimitiveTopology::eTriangleStrip)
+			.SetAlphaBlend(0)
+			.SetLayout(postPipeLayout_)
+			.SetRenderPass(postPass_);
+
+		RequestPipeline(device, builder, postPipeline_);
 
 		return true;
 	}
 
 	bool InitializeComputePipeline(vsl::Device& device)
 	{
-		{
-			// fXNv^ZbgCAEgɑΉpCvCCAEg𐶐
-			// ʏ11Ő̂ȁH
-			vk::PipelineLayoutCreateInfo pPipelineLayoutCreateInfo;
-			pPipelineLayoutCreateInfo.setLayoutCount = 1;
-			pPipelineLayoutCreateInfo.pSetLayouts = &descLayouts_[2];
-			computePipeLayout_ = device.GetDevice().createPipelineLayout(pPipelineLayoutCreateInfo);
-		}
-
-		// VF[_Xe[W̐ݒ
-		vk::PipelineShaderStageCreateInfo shaderInfo(vk::PipelineShaderStageCreateFlags(), vk::ShaderStageFlagBits::eCompute, csTest_.GetModule(), "main");
-
 		// pCvC
-		vk::ComputePipelineCreateInfo pipelineCreateInfo(vk::PipelineCreateFlags(), shaderInfo, computePipeLayout_);
+		vsl::ComputePipelineBuilder builder;
+		builder.SetShader(csTest_.GetModule())
+			.SetLayout(computePipeLayout_);
 
-		computePipeline_ = device.GetDevice().createComputePipeline(device.GetPipelineCache(), pipelineCreateInfo);
-		if (!computePipeline_)
-		{
-			return false;
-		}
+		RequestPipeline(device, builder, computePipeline_);
 
 		return true;
 	}
 
-	bool InitializeFFTPipeline(vsl::Device& device)
+	// pCvC̓[J[XbhōsÂgp
+	template <typename Builder>
+	void RequestPipeline(vsl::Device& device, const Builder& builder, vk::Pipeline& target)
+	{
+		PendingPipeline pending;
+		pending.future = builder.BuildAsync(device);
+		pending.pTarget = &target;
+		pendingPipelines_.push_back(pending);
+	}
+
+	// pCvC󂯎
+	// Sđ_Ń[J[̃pCvCLbV𓝍
+	bool UpdatePendingPipelines(vsl::Device& device)
 	{
+		if (pendingPipelines_.empty())
 		{
-			// fXNv^ZbgCAEgɑΉpCvCCAEg𐶐
-			// ʏ11Ő̂ȁH
-			vk::PipelineLayoutCreateInfo pPipelineLayoutCreateInfo;
-			pPipelineLayoutCreateInfo.setLayoutCount = 1;
-			pPipelineLayoutCreateInfo.pSetLayouts = &descLayouts_[4];
-			fftPipeLayout_ = device.GetDevice().createPipelineLayout(pPipelineLayoutCreateInfo);
+			return true;
 		}
 
-		for (int i = 0; i < ARRAYSIZE(fftPipelines_); i++)
+		for (auto it = pendingPipelines_.begin(); it != pendingPipelines_.end();)
 		{
-			// VF[_Xe[W̐ݒ
-			vk::PipelineShaderStageCreateInfo shaderInfo(vk::PipelineShaderStageCreateFlags(), vk::ShaderStageFlagBits::eCompute, csFFTs_[i].GetModule(), "main");
-
-			// pCvC
-			vk::ComputePipelineCreateInfo pipelineCreateInfo(vk::PipelineCreateFlags(), shaderInfo, fftPipeLayout_);
-
-			fftPipelines_[i] = device.GetDevice().createComputePipeline(device.GetPipelineCache(), pipelineCreateInfo);
-			if (!fftPipelines_[i])
+			if (it->future.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+			{
+				++it;
+				continue;
+			}
+			*it->pTarget = it->future.get();
+			if (!*it->pTarget)
 			{
 				return false;
 			}
+			it = pendingPipelines_.erase(it);
 		}
 
+		if (pendingPipelines_.empty())
+		{
+			device.GetPipelineStateCache().MergeWorkerCaches();
+		}
 		return true;
 	}
 
+	// ϊƋtϊ̊Ԃ̃XyNg
+	// 256Œ̃VF[_̓obt@Ȃ߁A\p̃C[Wɒڏ
+	vsl::FFTData GetFFTSpectrum()
+	{
+		if (fft_.IsFixedKernel())
+		{
+			return vsl::FFTData::Complex(fftTargets_[0], fftTargets_[1]);
+		}
+		return vsl::FFTData::Packed(fftSpectrum_);
+	}
+
 	void RunFFT(vsl::Device& device)
 	{
 		if (computeFence_)
@@ -1180,81 +1141,39 @@ private:
 		isForceTypeChange_ = true;
 		viewType_ = 0;
 
-		auto& cmdBuffer = device.GetComputeCommandBuffers()[0];
-
-		if (!isFFTCommandLoaded_)
+		// FFTvZ̃R}h
+		// o͂v蒼ꂽꍇ̂ݐςݒ
+		vsl::CommandBundleDeps deps;
+		deps.Add(texture_).Add(fftSpectrum_)
+			.Add(fftTargets_[0]).Add(fftTargets_[1]).Add(fftTargets_[2])
+			.Add(fftPlans_[0]).Add(fftPlans_[1]);
+		vk::CommandBuffer cmdBuffer = commandBundles_.Get("fft", deps, [&](vk::CommandBuffer& cmd)
 		{
-			cmdBuffer.reset(vk::CommandBufferResetFlags());
-
-			// R}hςݍ݊Jn
-			vk::CommandBufferBeginInfo beginInfo;
-			cmdBuffer.begin(&beginInfo);
-
-			// FFTvZ̃R}hςݍ
+			// ϊŃXyNg߁Â܂܋tϊ
+			vsl::FFTData source = vsl::FFTData::Real(texture_);
+			vsl::FFTData spectrum = GetFFTSpectrum();
+			vsl::FFTData result = vsl::FFTData::Real(fftTargets_[2]);
 			for (int i = 0; i < 5000; i++)
 			{
-				vk::ImageSubresourceRange colorSubRange;
-				colorSubRange.aspectMask = vk::ImageAspectFlagBits::eColor;
-				colorSubRange.levelCount = 1;
-				colorSubRange.layerCount = 1;
-				fftTargets_[0].SetImageLayout(cmdBuffer, vk::ImageLayout::eGeneral, colorSubRange);
-				fftTargets_[1].SetImageLayout(cmdBuffer, vk::ImageLayout::eGeneral, colorSubRange);
-
-				// row pass 
-				{
-					// dispatch
-					cmdBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, fftPipelines_[0]);
-					cmdBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, fftPipeLayout_, 0, descSets_[4], nullptr);
-					cmdBuffer.dispatch(1, texture_.GetHeight(), 1);
-				}
-
-				fftTargets_[0].SetImageLayout(cmdBuffer, vk::ImageLayout::eGeneral, colorSubRange);
-				fftTargets_[1].SetImageLayout(cmdBuffer, vk::ImageLayout::eGeneral, colorSubRange);
-				fftTargets_[2].SetImageLayout(cmdBuffer, vk::ImageLayout::eGeneral, colorSubRange);
-				fftTargets_[3].SetImageLayout(cmdBuffer, vk::ImageLayout::eGeneral, colorSubRange);
-
-				// collums pass 
+				if (!fftPlans_[0].Execute(cmd, source, spectrum) || !fftPlans_[1].Execute(cmd, spectrum, result))
 				{
-					// dispatch
-					cmdBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, fftPipelines_[1]);
-					cmdBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, fftPipeLayout_, 0, descSets_[5], nullptr);
-					cmdBuffer.dispatch(1, texture_.GetWidth(), 1);
+					return false;
 				}
-
-				fftTargets_[2].SetImageLayout(cmdBuffer, vk::ImageLayout::eGeneral, colorSubRange);
-				fftTargets_[3].SetImageLayout(cmdBuffer, vk::ImageLayout::eGeneral, colorSubRange);
-				fftTargets_[0].SetImageLayout(cmdBuffer, vk::ImageLayout::eGeneral, colorSubRange);
-				fftTargets_[1].SetImageLayout(cmdBuffer, vk::ImageLayout::eGeneral, colorSubRange);
-
-				// invert row pass 
-				{
-					// dispatch
-					cmdBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, fftPipelines_[2]);
-					cmdBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, fftPipeLayout_, 0, descSets_[6], nullptr);
-					cmdBuffer.dispatch(1, texture_.GetHeight(), 1);
-				}
-
-				fftTargets_[0].SetImageLayout(cmdBuffer, vk::ImageLayout::eGeneral, colorSubRange);
-				fftTargets_[1].SetImageLayout(cmdBuffer, vk::ImageLayout::eGeneral, colorSubRange);
-				fftTargets_[4].SetImageLayout(cmdBuffer, vk::ImageLayout::eGeneral, colorSubRange);
-				fftTargets_[5].SetImageLayout(cmdBuffer, vk::ImageLayout::eGeneral, colorSubRange);
-
-				// invert collums pass 
-				{
-					// dispatch
-					cmdBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, fftPipelines_[3]);
-					cmdBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, fftPipeLayout_, 0, descSets_[7], nullptr);
-					cmdBuffer.dispatch(1, texture_.GetWidth(), 1);
-				}
-
-				fftTargets_[4].SetImageLayout(cmdBuffer, vk::ImageLayout::eGeneral, colorSubRange);
-				fftTargets_[5].SetImageLayout(cmdBuffer, vk::ImageLayout::eGeneral, colorSubRange);
 			}
 
-			// R}hςݍ݊
-			cmdBuffer.end();
-
-			isFFTCommandLoaded_ = true;
+			// \pɃXyNgC[Wɂo
+			// 256Œ̃VF[_ł͊ɃC[Wɏ܂Ă
+			if (spectrum.type == vsl::FFTDataType::ComplexImages)
+			{
+				return true;
+			}
+			vsl::FFTData spectrumView = vsl::FFTData::Complex(fftTargets_[0], fftTargets_[1]);
+			return fftPlans_[0].Execute(cmd, source, spectrumView);
+		});
+		if (!cmdBuffer)
+		{
+			OutputDebugString(L"Failed to record the FFT commands.\n");
+			return;
 		}
 
 		// tFX̍쐬
@@ -1273,7 +1192,80 @@ private:
 			submitInfo.signalSemaphoreCount = 1;
 		}
 
-		device.GetComputeQueue().submit(submitInfo, computeFence_);
+		vsl::QueueSubmit(device.GetComputeQueue(), submitInfo, computeFence_);
+	}
+
+	void RunFFTBenchmark(vsl::Device& device)
+	{
+		// 񓯊FFTƓo͂L̂ŁAs͌vȂ
+		if (computeFence_)
+		{
+			return;
+		}
+
+		// ɍ쐬Aш̊ƂăRs[xvĂ
+		if (!fftBenchmark_.IsValid())
+		{
+			if (!fftBenchmark_.Initialize(device) || !fftBenchmark_.MeasureCopyBandwidth())
+			{
+				fftBenchmark_.Destroy();
+				OutputDebugString(L"FFT benchmark is not supported.\n");
+				return;
+			}
+		}
+
+		vsl::FFTData source = vsl::FFTData::Real(texture_);
+		vsl::FFTData spectrum = GetFFTSpectrum();
+		vsl::FFTData result = vsl::FFTData::Real(fftTargets_[2]);
+		isFFTBenchmarked_ = fftBenchmark_.Run(fftPlans_[0], source, spectrum, kFFTBenchmarkWarmup, kFFTBenchmarkIterations, fftBenchmarkResults_[0])
+			&& fftBenchmark_.Run(fftPlans_[1], spectrum, result, kFFTBenchmarkWarmup, kFFTBenchmarkIterations, fftBenchmarkResults_[1]);
+		if (!isFFTBenchmarked_)
+		{
+			return;
+		}
+
+		// xƂ̑x͔rp̃v(PackedBufferm̏ϊ)Ōv
+		for (int i = 0; i < vsl::FFTPrecision::Max; i++)
+		{
+			isFFTPrecisionBenchmarked_[i] = fftValidators_[i].IsValid()
+				&& fftValidators_[i].Benchmark(fftBenchmark_, kFFTBenchmarkWarmup, kFFTBenchmarkIterations, fftPrecisionResults_[i]);
+		}
+
+		// ʂ̓fobOo͂CSVt@Cɏo
+		static const char* kBenchmarkStrs[] = { "Forward", "Inverse" };
+		std::string csv = vsl::FFTBenchmark::GetCsvHeader();
+		for (int i = 0; i < 2; i++)
+		{
+			OutputDebugStringA(vsl::FFTBenchmark::ToText(kBenchmarkStrs[i], fftPlans_[i], fftBenchmarkResults_[i]).c_str());
+			csv += vsl::FFTBenchmark::ToCsv(kBenchmarkStrs[i], fftPlans_[i], fftBenchmarkResults_[i]);
+		}
+		for (int i = 0; i < vsl::FFTPrecision::Max; i++)
+		{
+			if (isFFTPrecisionBenchmarked_[i])
+			{
+				std::string name = std::string("Packed ") + kFFTPrecisionStrs[i];
+				OutputDebugStringA(vsl::FFTBenchmark::ToText(name.c_str(), fftValidators_[i].GetPlan(), fftPrecisionResults_[i]).c_str());
+				csv += vsl::FFTBenchmark::ToCsv(name.c_str(), fftValidators_[i].GetPlan(), fftPrecisionResults_[i]);
+			}
+		}
+		FILE* fp;
+		if (fopen_s(&fp, "fft_benchmark.csv", "w") == 0)
+		{
+			fputs(csv.c_str(), fp);
+			fclose(fp);
+		}
+	}
+
+	void UpdateConvolutionKernel()
+	{
+		uint32_t radius = static_cast<uint32_t>(convolutionRadius_);
+		vsl::FFTConvolutionKernel kernel = (convolutionKernelType_ == 0)
+			? vsl::FFTConvolutionKernel::Gaussian(radius, static_cast<float>(radius) / 3.0f)
+			: vsl::FFTConvolutionKernel::Star(radius, kConvolutionStreakCount);
+		if (!fftConvolution_.SetKernel(kernel))
+		{
+			OutputDebugString(L"Failed to set the convolution kernel.\n");
+		}
 	}
 
 	void EndCalcFFT(vsl::Device& device)
@@ -1302,22 +1294,22 @@ private:
 	vsl::RenderPass	meshPass_, postPass_;
 	vsl::Image		depthBuffer_;
 	vsl::Image		offscreenBuffer_, computeBuffer_;
-	vsl::Image		fftTargets_[6];
+	vsl::Image		fftTargets_[4];
+	vsl::Buffer		fftSpectrum_;
 	std::vector<vk::Framebuffer>	frameBuffers_;
 	vk::Framebuffer	offscreenFrame_;
 
 	vsl::Shader		vsTest_, psTest_, psView_;
 	vsl::Shader		vsPost_, psPost_;
 	vsl::Shader		csTest_;
-	vsl::Shader		csFFTs_[4];
 	vsl::Buffer		vbuffer_, ibuffer_;
 	vsl::Buffer		sceneBuffer_;
 	vsl::Image		texture_;
 	vk::Sampler		sampler_;
 
-	vk::DescriptorPool						descPool_;
-	std::vector<vk::DescriptorSetLayout>	descLayouts_;
 	std::vector<vk::DescriptorSet>			descSets_;
+	vsl::DescriptorWriter					descWriter_;
+	vk::DescriptorSetLayout					postSetLayout_;
 
 	vk::PipelineLayout	pipeLayout_;
 	vk::Pipeline		pipeline_;
@@ -1330,8 +1322,30 @@ private:
 	vk::PipelineLayout	computePipeLayout_;
 	vk::Pipeline		computePipeline_;
 
-	vk::PipelineLayout	fftPipeLayout_;
-	vk::Pipeline		fftPipelines_[4];
+	vsl::FFT		fft_;
+	vsl::FFTPlan	fftPlans_[2];
+	vsl::FFTPrecision::Type	fftPrecision_{ vsl::FFTPrecision::Half };
+	uint64_t		fftBytesMoved_[2]{};
+	vsl::FFTValidator	fftValidators_[vsl::FFTPrecision::Max];
+	vsl::FFTValidationErrors	fftErrors_[vsl::FFTPrecision::Max];
+	bool				isFFTValidated_[vsl::FFTPrecision::Max]{};
+	vsl::FFTBenchmark		fftBenchmark_;
+	vsl::FFTBenchmarkResult	fftBenchmarkResults_[2];
+	vsl::FFTBenchmarkResult	fftPrecisionResults_[vsl::FFTPrecision::Max];
+	bool					isFFTPrecisionBenchmarked_[vsl::FFTPrecision::Max]{};
+	vsl::FFTConvolution		fftConvolution_;
+
+	// OɋL^ĂR}h
+	vsl::CommandBundleCache	commandBundles_;
+
+	vsl::GpuProfiler	gpuProfiler_;
+
+	struct PendingPipeline
+	{
+		std::shared_future<vk::Pipeline>	future;
+		vk::Pipeline*						pTarget;
+	};	// struct PendingPipeline
+	std::vector<PendingPipeline>	pendingPipelines_;
 
 	vsl::Gui		gui_;
 
@@ -1344,8 +1358,12 @@ private:
 	bool isFFTComplete_{ false };
 	bool isForceTypeChange_{ false };
 	bool isSyncFFT_{ false };
-	bool isFFTCommandLoaded_{ false };
+	bool isFFTAvailable_{ false };
+	bool isFFTBenchmarked_{ false };
 	int viewType_{ 0 };
+	int convolutionRadius_{ 4 };
+	int convolutionKernelType_{ 0 };
+	int convolutionMethod_{ vsl::FFTConvolutionMethod::Auto };
 };	// class MySample
 
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR pCmdLine, int nCmdShow)
@@ -1357,6 +1375,15 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR pCmdLine,
 		std::bind(&MySample::Initialize, std::ref(mySample), _1),
 		std::bind(&MySample::Loop, std::ref(mySample), _1, _2),
 		std::bind(&MySample::Terminate, std::ref(mySample), _1));
+
+	// "-benchmark N" w莞 N t[̃t[ԂCSVɏoďI
+	const char* benchmarkArg = strstr(pCmdLine, "-benchmark");
+	if (benchmarkArg)
+	{
+		uint32_t frameCount = static_cast<uint32_t>(strtoul(benchmarkArg + strlen("-benchmark"), nullptr, 10));
+		app.SetFrameCapture("frame_times.csv", (frameCount > 0) ? frameCount : 1000);
+	}
+
 	app.Run(kScreenWidth, kScreenHeight);
 
 	return 0;
@@ -0,0 +1,153 @@
+﻿#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include <vsl/shader_bundle.h>
+#include <vsl/hash.h>
+
+
+namespace
+{
+	struct SourceFile
+	{
+		std::string				name;
+		std::vector<uint8_t>	data;
+	};	// struct SourceFile
+
+	//----
+	// パスからファイル名部分を取り出す
+	std::string GetFileName(const std::string& path)
+	{
+		size_t pos = path.find_last_of("/\\");
+		return (pos == std::string::npos) ? path : path.substr(pos + 1);
+	}
+
+	//----
+	bool ReadFile(const std::string& path, std::vector<uint8_t>& outData)
+	{
+		std::ifstream ifs(path, std::ios::binary);
+		if (!ifs)
+		{
+			return false;
+		}
+		outData.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+		return true;
+	}
+
+	//----
+	uint32_t AlignUp(uint32_t value, uint32_t align)
+	{
+		return (value + align - 1) / align * align;
+	}
+
+	//----
+	bool WriteBundle(const std::string& path, const std::vector<SourceFile>& files)
+	{
+		// 名前、データの順に配置する
+		uint32_t entryCount = static_cast<uint32_t>(files.size());
+		uint32_t offset = static_cast<uint32_t>(sizeof(vsl::ShaderBundleHeader) + sizeof(vsl::ShaderBundleEntry) * entryCount);
+		std::vector<vsl::ShaderBundleEntry> entries(entryCount);
+		for (uint32_t i = 0; i < entryCount; i++)
+		{
+			entries[i].nameOffset = offset;
+			entries[i].nameLength = static_cast<uint32_t>(files[i].name.size());
+			offset += entries[i].nameLength + 1;
+		}
+		for (uint32_t i = 0; i < entryCount; i++)
+		{
+			offset = AlignUp(offset, vsl::kShaderBundleAlignment);
+			entries[i].dataOffset = offset;
+			entries[i].dataSize = static_cast<uint32_t>(files[i].data.size());
+			entries[i].contentHash = vsl::HashBytes(files[i].data.data(), files[i].data.size());
+			offset += entries[i].dataSize;
+		}
+
+		std::vector<uint8_t> bin(offset, 0);
+		vsl::ShaderBundleHeader header;
+		header.magic = vsl::kShaderBundleMagic;
+		header.version = vsl::kShaderBundleVersion;
+		header.entryCount = entryCount;
+		header.reserved = 0;
+		memcpy(bin.data(), &header, sizeof(header));
+		if (entryCount > 0)
+		{
+			memcpy(bin.data() + sizeof(header), entries.data(), sizeof(vsl::ShaderBundleEntry) * entryCount);
+		}
+		for (uint32_t i = 0; i < entryCount; i++)
+		{
+			memcpy(bin.data() + entries[i].nameOffset, files[i].name.c_str(), entries[i].nameLength + 1);
+			if (entries[i].dataSize > 0)
+			{
+				memcpy(bin.data() + entries[i].dataOffset, files[i].data.data(), entries[i].dataSize);
+			}
+		}
+
+		std::ofstream ofs(path, std::ios::binary);
+		if (!ofs)
+		{
+			return false;
+		}
+		ofs.write(reinterpret_cast<const char*>(bin.data()), bin.size());
+		return ofs.good();
+	}
+}	// namespace
+
+
+//----
+// 使い方: ShaderPacker <出力ファイル> <SPIR-Vファイル>...
+// バンドル内ではディレクトリを除いたファイル名で参照する
+int main(int argc, char* argv[])
+{
+	if (argc < 3)
+	{
+		printf("usage: ShaderPacker <output> <input.spv>...\n");
+		return 1;
+	}
+
+	std::vector<SourceFile> files;
+	for (int i = 2; i < argc; i++)
+	{
+		SourceFile file;
+		file.name = GetFileName(argv[i]);
+		if (!ReadFile(argv[i], file.data))
+		{
+			printf("error: cannot read %s\n", argv[i]);
+			return 1;
+		}
+		if (file.data.size() < 4 || (file.data.size() % 4) != 0 || file.data[0] != 0x03 || file.data[1] != 0x02 || file.data[2] != 0x23 || file.data[3] != 0x07)
+		{
+			printf("error: %s is not SPIR-V\n", argv[i]);
+			return 1;
+		}
+		files.push_back(std::move(file));
+	}
+
+	// 実行時に二分探索するので名前順に並べる
+	std::sort(files.begin(), files.end(), [](const SourceFile& l, const SourceFile& r)
+	{
+		return strcmp(l.name.c_str(), r.name.c_str()) < 0;
+	});
+	for (size_t i = 1; i < files.size(); i++)
+	{
+		if (files[i - 1].name == files[i].name)
+		{
+			printf("error: duplicate name %s\n", files[i].name.c_str());
+			return 1;
+		}
+	}
+
+	if (!WriteBundle(argv[1], files))
+	{
+		printf("error: cannot write %s\n", argv[1]);
+		return 1;
+	}
+
+	printf("%s : %u shaders\n", argv[1], static_cast<uint32_t>(files.size()));
+	return 0;
+}
+
+
+//	EOF
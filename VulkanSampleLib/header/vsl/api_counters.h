@@ -0,0 +1,180 @@
+﻿#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <string>
+#include <utility>
+#include <vector>
+#include <vulkan/vulkan.h>
+#include <vulkan/vulkan.hpp>
+
+
+// APIカウンタの有効化
+// 計数はアトミック加算のみなので、指定がない場合はリリースビルドでも有効にする
+#if !defined(VSL_API_COUNTERS)
+#	define VSL_API_COUNTERS	1
+#endif
+
+#if VSL_API_COUNTERS
+#	define VSL_API_COUNT_N(type, n)		vsl::ApiCounters::Instance().Add(vsl::ApiCounter::type, n)
+#else
+#	define VSL_API_COUNT_N(type, n)		((void)0)
+#endif
+#define VSL_API_COUNT(type)				VSL_API_COUNT_N(type, 1)
+
+
+namespace vsl
+{
+	class ApiCounter
+	{
+	public:
+		enum Type
+		{
+			Draw,
+			Dispatch,
+			PipelineBarrier,
+			BindPipeline,
+			BindDescriptorSets,
+			UpdateDescriptorSets,
+			DescriptorWrite,		// UpdateDescriptorSets に渡した書き込みの数
+			DescriptorAllocate,
+			QueueSubmit,
+			ObjectCreate,
+			ObjectDestroy,
+
+			Max
+		};
+	};	// class ApiCounter
+
+	//----
+	struct ApiCounterFrame
+	{
+		uint64_t	frameIndex{ 0 };
+		uint64_t	values[ApiCounter::Max]{};
+	};	// struct ApiCounterFrame
+
+	//----
+	// フレームごとのAPI呼び出し回数
+	// Add() はどのスレッドからでも呼び出せる
+	// EndFrame() 以降の関数はメインスレッドから呼び出すこと
+	class ApiCounters
+	{
+	public:
+		static const uint32_t	kDefaultHistoryLength = 600;
+
+	public:
+		static ApiCounters& Instance();
+
+		void Add(ApiCounter::Type type, uint64_t count)
+		{
+			counts_[type].fetch_add(count, std::memory_order_relaxed);
+		}
+
+		// 現在のフレームの計数を履歴に移してリセットする
+		// Application::Run() がフレームの先頭で呼び出す
+		void EndFrame();
+
+		// 履歴と最大値を破棄する、累計は残す
+		void Clear();
+
+		// 直前のフレーム
+		const ApiCounterFrame& GetLastFrame() const	{ return lastFrame_; }
+		// 履歴に残っているフレームの中での最大値
+		const ApiCounterFrame& GetMaxFrame() const	{ return maxFrame_; }
+		// 起動からの累計
+		uint64_t GetTotal(ApiCounter::Type type) const	{ return totals_[type]; }
+		// 生成数と破棄数の差、リークの確認用
+		// vsl の中で生成したオブジェクトのみを数える
+		int64_t GetLiveObjectCount() const
+		{
+			return static_cast<int64_t>(totals_[ApiCounter::ObjectCreate] - totals_[ApiCounter::ObjectDestroy]);
+		}
+
+		std::string ToText() const;
+		// 履歴を "frame,Draw,..." 形式のCSVで出力する
+		bool ExportCsv(const char* filename) const;
+
+		static const char* GetCounterName(ApiCounter::Type type);
+
+	private:
+		ApiCounters();
+		ApiCounters(const ApiCounters&) = delete;
+		ApiCounters& operator=(const ApiCounters&) = delete;
+
+	private:
+		std::atomic<uint64_t>			counts_[ApiCounter::Max];
+		uint64_t						totals_[ApiCounter::Max]{};
+		uint64_t						frameIndex_{ 0 };
+
+		ApiCounterFrame					lastFrame_;
+		ApiCounterFrame					maxFrame_;
+		std::vector<ApiCounterFrame>	history_;
+		uint32_t						historyIndex_{ 0 };
+		uint32_t						historyCount_{ 0 };
+	};	// class ApiCounters
+
+	//----
+	// 計数付きのコマンド記録
+	// 引数は vk::CommandBuffer の同名関数にそのまま渡す
+	template <typename... Args>
+	inline void CmdDraw(vk::CommandBuffer& cmdBuffer, Args&&... args)
+	{
+		VSL_API_COUNT(Draw);
+		cmdBuffer.draw(std::forward<Args>(args)...);
+	}
+
+	template <typename... Args>
+	inline void CmdDrawIndexed(vk::CommandBuffer& cmdBuffer, Args&&... args)
+	{
+		VSL_API_COUNT(Draw);
+		cmdBuffer.drawIndexed(std::forward<Args>(args)...);
+	}
+
+	template <typename... Args>
+	inline void CmdDispatch(vk::CommandBuffer& cmdBuffer, Args&&... args)
+	{
+		VSL_API_COUNT(Dispatch);
+		cmdBuffer.dispatch(std::forward<Args>(args)...);
+	}
+
+	template <typename... Args>
+	inline void CmdPipelineBarrier(vk::CommandBuffer& cmdBuffer, Args&&... args)
+	{
+		VSL_API_COUNT(PipelineBarrier);
+		cmdBuffer.pipelineBarrier(std::forward<Args>(args)...);
+	}
+
+	template <typename... Args>
+	inline void CmdBindPipeline(vk::CommandBuffer& cmdBuffer, Args&&... args)
+	{
+		VSL_API_COUNT(BindPipeline);
+		cmdBuffer.bindPipeline(std::forward<Args>(args)...);
+	}
+
+	template <typename... Args>
+	inline void CmdBindDescriptorSets(vk::CommandBuffer& cmdBuffer, Args&&... args)
+	{
+		VSL_API_COUNT(BindDescriptorSets);
+		cmdBuffer.bindDescriptorSets(std::forward<Args>(args)...);
+	}
+
+	//----
+	inline void UpdateDescriptorSets(vk::Device& device, vk::ArrayProxy<const vk::WriteDescriptorSet> writes)
+	{
+		VSL_API_COUNT(UpdateDescriptorSets);
+		VSL_API_COUNT_N(DescriptorWrite, writes.size());
+		device.updateDescriptorSets(writes, nullptr);
+	}
+
+	//----
+	template <typename... Args>
+	inline void QueueSubmit(vk::Queue& queue, Args&&... args)
+	{
+		VSL_API_COUNT(QueueSubmit);
+		queue.submit(std::forward<Args>(args)...);
+	}
+
+}	// namespace vsl
+
+
+//	EOF
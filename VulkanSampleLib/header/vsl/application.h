@@ -1,9 +1,12 @@
 ﻿#pragma once
 
 #include <functional>
+#include <string>
+#include <vector>
 #include <vulkan/vulkan.h>
 #include <vulkan/vulkan.hpp>
 #include <vsl/device.h>
+#include <vsl/frame_stats.h>
 
 
 namespace vsl
@@ -28,9 +31,18 @@ namespace vsl
 		int GetMouseY() const { return mouseY_; }
 		bool IsMouseButtonPressed(MouseButton::Type btn) const { return (mouseButton_ & (int)btn) != 0; }
 
+		// 前フレームからの経過時間(秒)
+		// 最初のフレームは 0
+		float GetDeltaTime() const { return deltaTime_; }
+		const FrameStats& GetFrameStats() const { return *pFrameStats_; }
+
 	public:
 		int mouseX_{ 0 }, mouseY_{ 0 };
 		int mouseButton_{ 0 };
+
+	private:
+		float				deltaTime_{ 0.0f };
+		const FrameStats*	pFrameStats_{ nullptr };
 	};	// class InputData
 
 	//----
@@ -54,6 +66,15 @@ namespace vsl
 
 		void Run(uint16_t screenWidth, uint16_t screenHeight);
 
+		// フレーム時間をCSVに書き出す
+		// frameCount フレームを計測したらファイルに書き出してループを終了する
+		// Run() の前に呼び出す
+		void SetFrameCapture(const char* filename, uint32_t frameCount)
+		{
+			captureFilename_ = filename;
+			captureFrameCount_ = frameCount;
+		}
+
 		// getter
 		HINSTANCE	GetInstanceHandle() const	{ return hInstance_; }
 		HWND		GetWndHandle() const		{ return hWnd_; }
@@ -61,10 +82,12 @@ namespace vsl
 		uint16_t	GetScreenHeight() const		{ return screenHeight_; }
 
 		Device&		GetDevice() { return device_; }
+		const FrameStats&	GetFrameStats() const	{ return frameStats_; }
 
 	private:
 		void PollEvents();
 		bool InitializeWindow();
+		bool WriteFrameCapture();
 
 	private:
 		HINSTANCE	hInstance_;
@@ -81,6 +104,11 @@ namespace vsl
 		bool	closeRequest_;
 
 		InputData inputData_;
+
+		FrameStats				frameStats_;
+		std::string				captureFilename_;
+		uint32_t				captureFrameCount_{ 0 };
+		std::vector<double>		captureTimes_;
 	};	// class Application
 
 }	// namespace vsl
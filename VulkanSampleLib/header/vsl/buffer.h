@@ -2,6 +2,7 @@
 
 #include <vulkan/vulkan.h>
 #include <vulkan/vulkan.hpp>
+#include <vsl/resource_generation.h>
 
 
 namespace vsl
@@ -25,6 +26,7 @@ namespace vsl
 		bool InitializeAsIndexBuffer(Device& owner, size_t size);
 		bool InitializeAsMappableIndexBuffer(Device& owner, size_t size);
 		bool InitializeAsUniformBuffer(Device& owner, size_t size, const void* pData = nullptr);
+		bool InitializeAsStorageBuffer(Device& owner, size_t size);
 
 		void Destroy();
 
@@ -40,6 +42,7 @@ namespace vsl
 		vk::DeviceMemory& GetDevMem()	{ return devMem_; }
 		vk::BufferView& GetView()		{ return view_; }
 		size_t GetSize()				{ return size_; }
+		uint64_t GetGeneration() const	{ return generation_; }
 
 	private:
 		bool InitializeCommon(Device& owner, size_t size, vk::BufferUsageFlags usage, vk::MemoryPropertyFlags memProp, const void* pData = nullptr);
@@ -51,6 +54,7 @@ namespace vsl
 		vk::DeviceMemory	devMem_;
 		vk::BufferView		view_;
 		size_t				size_{ 0 };
+		uint64_t			generation_{ 0 };
 	};	// class Buffer
 
 }	// namespace vsl
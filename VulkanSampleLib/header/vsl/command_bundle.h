@@ -0,0 +1,115 @@
+﻿#pragma once
+
+#include <stdint.h>
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan.h>
+#include <vulkan/vulkan.hpp>
+
+
+namespace vsl
+{
+	class Device;
+
+	//----
+	// コマンドバンドルが参照するリソースの一覧
+	// 記録時と同じ順で同じ値が並んでいれば、記録済みのコマンドを再利用できる
+	class CommandBundleDeps
+	{
+	public:
+		// Image, Buffer, FFTPlan など GetGeneration() を持つもの
+		template <typename T>
+		CommandBundleDeps& Add(const T& resource)
+		{
+			ids_.push_back(resource.GetGeneration());
+			return *this;
+		}
+
+		// パイプラインやフレームバッファなどのハンドル
+		// 破棄後に同じ値が再利用されると検出できないため、可能な限り Add() を使用すること
+		template <typename T>
+		CommandBundleDeps& AddHandle(const T& handle)
+		{
+			uint64_t id = 0;
+			memcpy(&id, &handle, (std::min)(sizeof(id), sizeof(handle)));
+			ids_.push_back(id);
+			return *this;
+		}
+
+		// getter
+		const std::vector<uint64_t>&	GetIds() const	{ return ids_; }
+
+	private:
+		std::vector<uint64_t>	ids_;
+	};	// class CommandBundleDeps
+
+	//----
+	struct CommandBundleStats
+	{
+		uint32_t	recordCount{ 0 };		// 記録した回数
+		uint32_t	reuseCount{ 0 };		// 記録済みのコマンドを返した回数
+	};	// struct CommandBundleStats
+
+	//----
+	// 記録済みのコマンドバッファを名前ごとに保持するキャッシュ
+	// 依存するリソースが作り直された場合のみ記録し直す
+	// 記録し直す際にリセットするため、実行中のバンドルを取得しないこと
+	class CommandBundleCache
+	{
+	public:
+		// 記録に失敗した場合は false を返す
+		typedef std::function<bool(vk::CommandBuffer&)>	RecordFunc;
+
+	public:
+		CommandBundleCache()
+		{}
+		~CommandBundleCache()
+		{
+			Destroy();
+		}
+
+		// pool は eResetCommandBuffer を指定して生成されたもの
+		// 取得したコマンドバッファは pool と同じキューファミリーで実行する
+		bool Initialize(Device& owner, vk::CommandPool pool);
+		void Destroy();
+
+		// プライマリコマンドバッファ
+		// 失敗した場合は無効なハンドルを返す
+		vk::CommandBuffer Get(const std::string& name, const CommandBundleDeps& deps, const RecordFunc& record);
+		// レンダーパス内で実行するセカンダリコマンドバッファ
+		// レンダーパスとフレームバッファは依存に自動で追加する
+		vk::CommandBuffer GetSecondary(const std::string& name, const CommandBundleDeps& deps, const vk::CommandBufferInheritanceInfo& inheritance, const RecordFunc& record);
+
+		// 次回の取得時に記録し直す
+		void Invalidate(const std::string& name);
+		void InvalidateAll();
+
+		// getter
+		const CommandBundleStats&	GetStats() const	{ return stats_; }
+
+	private:
+		struct Bundle
+		{
+			vk::CommandBuffer		cmdBuffer;
+			std::vector<uint64_t>	deps;
+			bool					isValid{ false };
+		};	// struct Bundle
+
+		vk::CommandBuffer GetCommon(const std::string& name, vk::CommandBufferLevel level, const std::vector<uint64_t>& deps, const vk::CommandBufferInheritanceInfo* pInheritance, const RecordFunc& record);
+
+	private:
+		Device*				pOwner_{ nullptr };
+		vk::CommandPool		pool_;
+
+		std::map<std::string, Bundle>	bundles_;
+		CommandBundleStats				stats_;
+	};	// class CommandBundleCache
+
+}	// namespace vsl
+
+
+//	EOF
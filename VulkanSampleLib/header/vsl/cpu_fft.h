@@ -0,0 +1,136 @@
+﻿#pragma once
+
+#include <stdint.h>
+#include <functional>
+#include <vector>
+#include <vsl/fft.h>
+
+
+namespace vsl
+{
+	class ThreadPool;
+
+	class CpuFFTSimd
+	{
+	public:
+		enum Type
+		{
+			Scalar,
+			SSE,			// 4要素ずつ
+			AVX2,			// 8要素ずつ、FMAを使用する
+
+			Max
+		};
+	};	// class CpuFFTSimd
+
+	//----
+	// CPUで扱う複素画像
+	// RGBの3チャンネルをチャンネルごとの平面で持ち、アルファは持たない
+	struct CpuFFTImage
+	{
+		static const uint32_t	kChannelCount = 3;
+
+		uint32_t			width{ 0 };
+		uint32_t			height{ 0 };
+		std::vector<float>	real;			// [channel][y][x]
+		std::vector<float>	imaginary;
+
+		void Initialize(uint32_t w, uint32_t h);
+
+		// rgba8 の画像を実部に設定する、虚部は0になる
+		void SetRGBA8(const uint8_t* pPixels);
+
+		// RealImage, ComplexImages から読み戻した rgba16f (Single は rgba32f) のピクセルを設定する
+		// pImaginary が nullptr の場合は虚部を0にする
+		void FromImagePixels(const void* pReal, const void* pImaginary, FFTPrecision::Type precision = FFTPrecision::Half);
+
+		// FFTPlan の PackedBuffer 形式との変換
+		// Single 以外はfp16に丸められるため、比較の入力は ToPacked -> FromPacked したものを使用すること
+		void FromPacked(const void* pPacked, FFTPrecision::Type precision = FFTPrecision::Half);
+		void ToPacked(void* pPacked, FFTPrecision::Type precision = FFTPrecision::Half) const;
+
+		float* GetReal(uint32_t channel)				{ return real.data() + channel * width * height; }
+		float* GetImaginary(uint32_t channel)			{ return imaginary.data() + channel * width * height; }
+		const float* GetReal(uint32_t channel) const		{ return real.data() + channel * width * height; }
+		const float* GetImaginary(uint32_t channel) const	{ return imaginary.data() + channel * width * height; }
+	};	// struct CpuFFTImage
+
+	//----
+	// 比較結果
+	// 誤差は参照側の大きさで正規化する
+	struct FFTError
+	{
+		double	maxError{ 0.0 };		// 最大誤差 / 参照の最大絶対値
+		double	rmsError{ 0.0 };		// 誤差のRMS / 参照のRMS
+
+		static FFTError Compare(const CpuFFTImage& reference, const CpuFFTImage& target);
+	};	// struct FFTError
+
+	//----
+	// CPUによる2次元FFT
+	// FFTPlan と同じ設定で作成し、GPUの結果の検証やGPUが使えない環境での代替に使用する
+	// 1次元FFTは radix-4 (段数が奇数の場合は最初の1段だけ radix-2) で、SIMDで複数のバタフライを同時に計算する
+	// 列は隣り合う列をまとめ、SIMDの各要素で別の列を計算する
+	// 行と列はそれぞれスレッドプールに分割して処理する
+	// FFTPlan と同じく、順変換も逆変換も 1/sqrt(width * height) でスケーリングする
+	class CpuFFTPlan
+	{
+	public:
+		CpuFFTPlan()
+		{}
+		~CpuFFTPlan()
+		{
+			Destroy();
+		}
+
+		// pPool が nullptr の場合は呼び出しスレッドのみで処理する
+		// precision と butterfly は無視し、fp32で計算する
+		bool Initialize(const FFTPlanDesc& desc, ThreadPool* pPool = nullptr, CpuFFTSimd::Type simd = CpuFFTSimd::Max);
+		void Destroy();
+
+		// pInputs, pOutputs はバッチ数分の配列
+		// 入力と出力に同じ画像を指定してもよい
+		bool Execute(const CpuFFTImage* pInputs, CpuFFTImage* pOutputs);
+		bool Execute(const CpuFFTImage& input, CpuFFTImage& output)
+		{
+			return Execute(&input, &output);
+		}
+
+		// getter
+		const FFTPlanDesc&	GetDesc() const		{ return desc_; }
+		bool				IsValid() const		{ return isValid_; }
+		CpuFFTSimd::Type	GetSimd() const		{ return simd_; }
+
+	public:
+		// 実行環境で使用できる最も広いSIMD
+		static CpuFFTSimd::Type GetSupportedSimd();
+
+	private:
+		// 1次元FFTの回転因子とビット反転のテーブル
+		struct LineTable
+		{
+			uint32_t				length{ 0 };
+			uint32_t				log2{ 0 };
+			std::vector<uint32_t>	bitReverse;
+			// 半分の幅 h の段の回転因子 W_2h^j を [h + j] に持つ
+			std::vector<float>		cosTable;
+			std::vector<float>		sinTable;
+		};	// struct LineTable
+
+		void InitializeTable(LineTable& table, uint32_t length);
+		void TransformRows(float* pReal, float* pImag);
+		void TransformColumns(float* pReal, float* pImag);
+		void ParallelFor(uint32_t count, const std::function<void(uint32_t, uint32_t)>& func);
+
+	private:
+		FFTPlanDesc			desc_;
+		ThreadPool*			pPool_{ nullptr };
+		CpuFFTSimd::Type	simd_{ CpuFFTSimd::Scalar };
+		LineTable			rowTable_, columnTable_;
+		bool				isValid_{ false };
+	};	// class CpuFFTPlan
+
+}	// namespace vsl
+
+
+//	EOF
@@ -0,0 +1,132 @@
+﻿#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+
+// CPUプロファイラの有効化
+// 指定がない場合はデバッグビルドのみ有効にし、リリースビルドではスコープのマクロを空にする
+#if !defined(VSL_CPU_PROFILER)
+#	if defined(NDEBUG)
+#		define VSL_CPU_PROFILER	0
+#	else
+#		define VSL_CPU_PROFILER	1
+#	endif
+#endif
+
+#define VSL_CPU_CONCAT_IMPL(a, b)	a##b
+#define VSL_CPU_CONCAT(a, b)		VSL_CPU_CONCAT_IMPL(a, b)
+
+#if VSL_CPU_PROFILER
+// name は文字列リテラルなど、エクスポートまで有効なものを渡すこと
+#	define VSL_CPU_SCOPE(name)				vsl::CpuProfileScope VSL_CPU_CONCAT(cpuProfileScope_, __LINE__)(name)
+#	define VSL_CPU_THREAD_NAME(name)		vsl::CpuProfiler::Instance().SetThreadName(name)
+#else
+#	define VSL_CPU_SCOPE(name)				((void)0)
+#	define VSL_CPU_THREAD_NAME(name)		((void)0)
+#endif
+
+
+namespace vsl
+{
+	//----
+	struct CpuProfileEvent
+	{
+		const char*		name{ nullptr };
+		int64_t			begin{ 0 };		// CpuProfiler 生成時からのナノ秒
+		int64_t			end{ 0 };
+	};	// struct CpuProfileEvent
+
+	//----
+	// スレッドごとのリングバッファにスコープの開始・終了時刻を記録する
+	// 記録はロックを取らずスレッド内で完結する
+	// 古いイベントは上書きされるため、問題が起きた直後にエクスポートすること
+	// エクスポート中に上書きされたイベントは壊れた値になることがある
+	class CpuProfiler
+	{
+	public:
+		static const uint32_t	kDefaultEventsPerThread = 16384;
+
+		typedef std::chrono::steady_clock	Clock;
+
+	public:
+		static CpuProfiler& Instance();
+
+		// 現在時刻、CpuProfiler 生成時からのナノ秒
+		int64_t Now() const
+		{
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - epoch_).count();
+		}
+
+		void Record(const char* name, int64_t begin, int64_t end);
+
+		// 呼び出したスレッドの表示名
+		void SetThreadName(const std::string& name);
+
+		// 記録を止める、記録済みのイベントは残る
+		void SetEnabled(bool enabled)	{ isEnabled_ = enabled; }
+		bool IsEnabled() const			{ return isEnabled_; }
+
+		// 全スレッドの記録を破棄する
+		// 記録中のスレッドとは競合するので、SetEnabled(false) にしてから呼び出すこと
+		void Clear();
+
+		// chrome://tracing, Perfetto で読み込める JSON を出力する
+		std::string ToChromeTrace();
+		bool ExportChromeTrace(const char* filename);
+
+	private:
+		struct ThreadBuffer
+		{
+			uint32_t						threadId{ 0 };
+			std::string						name;			// mutex_ で保護する
+			std::vector<CpuProfileEvent>	events;
+			std::atomic<uint64_t>			writeCount{ 0 };
+		};	// struct ThreadBuffer
+
+		CpuProfiler();
+		CpuProfiler(const CpuProfiler&) = delete;
+		CpuProfiler& operator=(const CpuProfiler&) = delete;
+
+		ThreadBuffer* GetThreadBuffer();
+
+	private:
+		Clock::time_point	epoch_;
+		std::atomic<bool>	isEnabled_{ true };
+
+		std::mutex									mutex_;
+		std::vector<std::unique_ptr<ThreadBuffer>>	threadBuffers_;
+	};	// class CpuProfiler
+
+	//----
+	// 生成から破棄までをイベントとして記録する
+	class CpuProfileScope
+	{
+	public:
+		explicit CpuProfileScope(const char* name)
+			: name_(name), begin_(CpuProfiler::Instance().Now())
+		{}
+		~CpuProfileScope()
+		{
+			CpuProfiler& profiler = CpuProfiler::Instance();
+			profiler.Record(name_, begin_, profiler.Now());
+		}
+
+	private:
+		CpuProfileScope(const CpuProfileScope&) = delete;
+		CpuProfileScope& operator=(const CpuProfileScope&) = delete;
+
+	private:
+		const char*		name_;
+		int64_t			begin_;
+	};	// class CpuProfileScope
+
+}	// namespace vsl
+
+
+//	EOF
@@ -0,0 +1,80 @@
+﻿#pragma once
+
+#include <vector>
+#include <vulkan/vulkan.h>
+#include <vulkan/vulkan.hpp>
+
+
+namespace vsl
+{
+	class Device;
+
+	//----
+	// デスクリプタセットアロケータ
+	// デスクリプタプールを連結して使用し、プールが足りなくなったら新しいプールを追加する
+	// 個別のセットの解放はできない、Reset() ですべてのプールを再利用可能にする
+	// リセットしたセットは同じハンドルで再び確保されることがあるので、DescriptorWriter の記録も消す
+	// スレッドセーフではないので、スレッドごとにアロケータを用意すること
+	class DescriptorAllocator
+	{
+	public:
+		// 1セットあたりのデスクリプタ数の比率
+		struct PoolSizeRatio
+		{
+			vk::DescriptorType	type;
+			float				ratio;
+		};	// struct PoolSizeRatio
+
+		static const uint32_t	kMaxSetsPerPool = 4096;
+
+	public:
+		DescriptorAllocator()
+		{}
+		~DescriptorAllocator()
+		{
+			Destroy();
+		}
+
+		// ratios を省略した場合は一般的な比率を使用する
+		bool Initialize(Device& owner, uint32_t setsPerPool = 64, const std::vector<PoolSizeRatio>& ratios = std::vector<PoolSizeRatio>());
+		void Destroy();
+
+		vk::DescriptorSet Allocate(const vk::DescriptorSetLayout& layout);
+
+		// 確保したすべてのセットを無効にする
+		// GPUがセットを参照していないことを保証してから呼び出すこと
+		void Reset();
+
+		// getter
+		size_t		GetPoolCount() const			{ return usedPools_.size() + freePools_.size() + (currentPool_.pool ? 1 : 0); }
+		uint32_t	GetAllocatedSetCount() const	{ return allocatedSetCount_; }
+
+	private:
+		struct Pool
+		{
+			vk::DescriptorPool	pool;
+			uint32_t			maxSets{ 0 };
+			uint32_t			setCount{ 0 };
+		};	// struct Pool
+
+		// minCounts を指定した場合は空きプールを使わず、種類ごとに少なくともその数を持つプールを作成する
+		bool GrabPool(const std::vector<vk::DescriptorPoolSize>* pMinCounts = nullptr);
+
+	private:
+		Device*		pOwner_{ nullptr };
+
+		std::vector<PoolSizeRatio>	ratios_;
+		uint32_t					nextSetsPerPool_{ 0 };
+
+		Pool				currentPool_;
+		std::vector<Pool>	usedPools_;
+		std::vector<Pool>	freePools_;
+		uint32_t			allocatedSetCount_{ 0 };
+
+		std::vector<vk::DescriptorSet>	allocatedSets_;		// DescriptorWriter の記録を消すため
+	};	// class DescriptorAllocator
+
+}	// namespace vsl
+
+
+//	EOF
@@ -0,0 +1,98 @@
+﻿#pragma once
+
+#include <unordered_map>
+#include <vector>
+#include <vulkan/vulkan.h>
+#include <vulkan/vulkan.hpp>
+
+
+namespace vsl
+{
+	class Device;
+
+	//----
+	// デスクリプタ更新のバッファリング
+	// 書き込みを記録しておき、Flush() でまとめて1回の vkUpdateDescriptorSets で更新する
+	// 同じバインド先への書き込みは最後のものだけが残り、前回のFlushから変化がない書き込みは省略する
+	// DescriptorAllocator の Reset() と Destroy() で無効になったセットの記録は、初期化済みの全ライターから自動で消される
+	// リセットはライターを使うスレッドで行うこと
+	class DescriptorWriter
+	{
+	public:
+		DescriptorWriter()
+		{}
+		~DescriptorWriter()
+		{
+			Destroy();
+		}
+		DescriptorWriter(const DescriptorWriter&) = delete;
+		DescriptorWriter& operator=(const DescriptorWriter&) = delete;
+
+		bool Initialize(Device& owner);
+		void Destroy();
+
+		DescriptorWriter& WriteImage(const vk::DescriptorSet& set, uint32_t binding, vk::DescriptorType type, const vk::DescriptorImageInfo& info, uint32_t arrayElement = 0);
+		DescriptorWriter& WriteBuffer(const vk::DescriptorSet& set, uint32_t binding, vk::DescriptorType type, const vk::DescriptorBufferInfo& info, uint32_t arrayElement = 0);
+
+		// 記録中の書き込みをまとめて反映する
+		// 反映した書き込みの数を返す
+		uint32_t Flush();
+
+		// セットの書き込み記録を破棄する
+		void Invalidate(const vk::DescriptorSet& set);
+		void Invalidate(const std::vector<vk::DescriptorSet>& sets);
+
+		// 初期化済みの全ライターからセットの記録を破棄する
+		// DescriptorAllocator がセットを無効にしたときに呼び出す
+		static void InvalidateAll(const std::vector<vk::DescriptorSet>& sets);
+
+		// getter
+		size_t		GetPendingCount() const		{ return pending_.size(); }
+		uint32_t	GetWriteCount() const		{ return writeCount_; }
+		uint32_t	GetSkipCount() const		{ return skipCount_; }
+
+	private:
+		struct WriteKey
+		{
+			VkDescriptorSet	set;
+			uint32_t		binding;
+			uint32_t		arrayElement;
+
+			bool operator==(const WriteKey& rhs) const
+			{
+				return (set == rhs.set) && (binding == rhs.binding) && (arrayElement == rhs.arrayElement);
+			}
+		};	// struct WriteKey
+
+		struct WriteKeyHash
+		{
+			size_t operator()(const WriteKey& key) const;
+		};	// struct WriteKeyHash
+
+		struct WriteValue
+		{
+			vk::DescriptorType		type;
+			vk::DescriptorImageInfo	image;
+			vk::DescriptorBufferInfo	buffer;
+
+			bool operator==(const WriteValue& rhs) const
+			{
+				return (type == rhs.type) && (image == rhs.image) && (buffer == rhs.buffer);
+			}
+		};	// struct WriteValue
+
+		void Write(const WriteKey& key, const WriteValue& value);
+
+	private:
+		Device*		pOwner_{ nullptr };
+
+		std::unordered_map<WriteKey, WriteValue, WriteKeyHash>	pending_;
+		std::unordered_map<WriteKey, WriteValue, WriteKeyHash>	current_;
+		uint32_t	writeCount_{ 0 };
+		uint32_t	skipCount_{ 0 };
+	};	// class DescriptorWriter
+
+}	// namespace vsl
+
+
+//	EOF
@@ -4,6 +4,15 @@
 #include <vulkan/vulkan.h>
 #include <vulkan/vulkan.hpp>
 #include <vsl/swapchain.h>
+#include <vsl/sampler_cache.h>
+#include <vsl/image_view_cache.h>
+#include <vsl/layout_cache.h>
+#include <vsl/shader_module_cache.h>
+#include <vsl/descriptor_allocator.h>
+#include <vsl/pipeline_state_cache.h>
+#include <vsl/thread_pool.h>
+#include <vsl/cpu_profiler.h>
+#include <vsl/api_counters.h>
 
 
 namespace vsl
@@ -24,6 +33,7 @@ namespace vsl
 		void DestroyContext();
 
 		uint32_t AcquireNextImage() { return currentBufferIndex_ = vkSwapchain_.AcquireNextImage(vkPresentComplete_); }
+		// 開始から終了までをCPUプロファイラに "RecordCommands" として記録する
 		vk::CommandBuffer& BeginMainCommandBuffer();
 		void ReadyPresentAndEndMainCommandBuffer();
 		void SubmitAndPresent(uint32_t waitSemaphoreCount = 0, vk::Semaphore* pWaitSemaphores = nullptr, vk::PipelineStageFlags* pWaitStages = nullptr, uint32_t signalSemaphoreCount = 0, vk::Semaphore* pSignalSemaphores = nullptr);
@@ -40,6 +50,7 @@ namespace vsl
 		vk::Queue&			GetQueue()			{ return vkQueue_; }
 		vk::Queue&			GetComputeQueue()	{ return vkComputeQueue_; }
 		vk::CommandPool&	GetCommandPool()	{ return vkCmdPool_; }
+		vk::CommandPool&	GetComputeCommandPool()	{ return vkComputeCmdPool_; }
 
 		std::vector<vk::CommandBuffer>&	GetCommandBuffers()				{ return vkCmdBuffers_; }
 		vk::CommandBuffer&				GetCurrentCommandBuffer()		{ return vkCmdBuffers_[currentBufferIndex_]; }
@@ -47,7 +58,18 @@ namespace vsl
 		vk::CommandBuffer&				GetCurrentComputeCommandBuffer(){ return vkComputeCmdBuffers_[currentBufferIndex_]; }
 
 		Swapchain&	GetSwapchain()					{ return vkSwapchain_; }
+		ThreadPool&	GetThreadPool()					{ return threadPool_; }
+		SamplerCache&	GetSamplerCache()			{ return samplerCache_; }
+		ImageViewCache&	GetImageViewCache()			{ return imageViewCache_; }
+		LayoutCache&	GetLayoutCache()			{ return layoutCache_; }
+		ShaderModuleCache&	GetShaderModuleCache()	{ return shaderModuleCache_; }
+		DescriptorAllocator&	GetDescriptorAllocator()		{ return descAllocator_; }
+		// 現在のフレーム用、BeginMainCommandBuffer() で前回の同じフレームの確保分がリセットされる
+		DescriptorAllocator&	GetFrameDescriptorAllocator()	{ return frameDescAllocators_[currentBufferIndex_]; }
+		PipelineStateCache&	GetPipelineStateCache()	{ return pipelineStateCache_; }
 		uint32_t	GetCurrentBufferIndex() const	{ return currentBufferIndex_; }
+		// グラフィクスキューのタイムスタンプの有効ビットのマスク、0 の場合はタイムスタンプを使用できない
+		uint64_t	GetTimestampMask() const		{ return timestampMask_; }
 		vk::Image&	GetCurrentSwapchainImage()		{ return vkSwapchain_.GetImages()[currentBufferIndex_].image; }
 
 	private:
@@ -65,6 +87,19 @@ namespace vsl
 
 		Swapchain	vkSwapchain_;
 		uint32_t	currentBufferIndex_{ 0 };
+
+		ThreadPool	threadPool_;
+
+		SamplerCache	samplerCache_;
+		ImageViewCache	imageViewCache_;
+		LayoutCache		layoutCache_;
+		ShaderModuleCache	shaderModuleCache_;
+		DescriptorAllocator					descAllocator_;
+		std::vector<DescriptorAllocator>	frameDescAllocators_;
+		PipelineStateCache	pipelineStateCache_;
+
+		int64_t		recordBeginTime_{ 0 };
+		uint64_t	timestampMask_{ 0 };
 	};	// class Device
 
 }	// namespace vsl
@@ -0,0 +1,382 @@
+﻿#pragma once
+
+#include <map>
+#include <vector>
+#include <vulkan/vulkan.h>
+#include <vulkan/vulkan.hpp>
+#include <vsl/shader.h>
+#include <vsl/image.h>
+#include <vsl/buffer.h>
+#include <vsl/descriptor_allocator.h>
+#include <vsl/descriptor_writer.h>
+#include <vsl/resource_generation.h>
+
+
+namespace vsl
+{
+	class Device;
+	class ShaderBundle;
+	class FFT;
+
+	class FFTDirection
+	{
+	public:
+		enum Type
+		{
+			Forward,		// 実数画像 -> 複素スペクトル
+			Inverse,		// 複素スペクトル -> 実数画像
+		};
+		// どちらの向きも 1/sqrt(width * height) でスケーリングするため、fp16 でもスペクトルが溢れにくい
+	};	// class FFTDirection
+
+	class FFTPrecision
+	{
+	public:
+		enum Type
+		{
+			Half,			// fp16で格納、fp32で計算
+			Single,			// fp32で格納、fp32で計算、fft32.comp.spv, ifft32.comp.spv が必要
+			PackedHalf,		// fp16で格納し、共有メモリの中間値もfp16x2に詰める、計算はfp32
+
+			Max
+		};
+	};	// class FFTPrecision
+
+	class FFTButterfly
+	{
+	public:
+		enum Type
+		{
+			Radix2,			// 1パスごとに共有メモリで同期する
+			Radix4,			// 2パスごとに同期する、前半のパスはレジスタ上で重複して計算する
+		};
+	};	// class FFTButterfly
+
+	//----
+	// FFTプランの設定
+	// width, height は2のべき乗で、FFT::GetMaxTransformLength() 以下であること
+	// FFT::GetMaxLength() を超える長さは four-step FFT の2パスに分割して変換する
+	struct FFTPlanDesc
+	{
+		uint32_t				width{ 256 };
+		uint32_t				height{ 256 };
+		uint32_t				batch{ 1 };
+		FFTDirection::Type		direction{ FFTDirection::Forward };
+		FFTPrecision::Type		precision{ FFTPrecision::Half };
+		FFTButterfly::Type		butterfly{ FFTButterfly::Radix4 };
+		// 実数データの2行(2列)を実部と虚部にまとめて1回の複素FFTで変換する
+		// エルミート対称性を利用して分離するため、順変換の行パスと逆変換の列パスの起動数が半分になる
+		bool					packRealPairs{ true };
+	};	// struct FFTPlanDesc
+
+	class FFTDataType
+	{
+	public:
+		enum Type
+		{
+			RealImage,		// 実数のみのイメージ、順変換の入力は rgba8、逆変換の出力は rgba16f (Single は rgba32f)
+			ComplexImages,	// 実部と虚部を別々に持つ rgba16f (Single は rgba32f) のイメージ
+			PackedBuffer,	// RGBごとに実部と虚部をfp16x2 (Single はfp32 2つ) で詰めたバッファ、アルファは持たない
+
+			Max
+		};
+	};	// class FFTDataType
+
+	//----
+	// FFTの入出力
+	// イメージはストレージイメージで、レイアウトは eGeneral であること
+	// バッファのオフセットは minStorageBufferOffsetAlignment に揃えること
+	// Image, Buffer から作成した場合はその世代でデスクリプタセットのキャッシュを引く
+	// ハンドルから作成した場合、作り直したリソースは FFTPlan::ReleaseDescriptorSets() まで区別できない
+	struct FFTData
+	{
+		FFTDataType::Type	type{ FFTDataType::RealImage };
+		vk::ImageView		real;
+		vk::ImageView		imaginary;
+		vk::Buffer			buffer;
+		vk::DeviceSize		offset{ 0 };
+		// [0] は real または buffer、[1] は imaginary の世代、0 は不明
+		uint64_t			generations[2]{};
+
+		static FFTData Real(vk::ImageView r)
+		{
+			FFTData ret;
+			ret.type = FFTDataType::RealImage;
+			ret.real = r;
+			return ret;
+		}
+		static FFTData Complex(vk::ImageView r, vk::ImageView i)
+		{
+			FFTData ret;
+			ret.type = FFTDataType::ComplexImages;
+			ret.real = r;
+			ret.imaginary = i;
+			return ret;
+		}
+		static FFTData Packed(vk::Buffer b, vk::DeviceSize o = 0)
+		{
+			FFTData ret;
+			ret.type = FFTDataType::PackedBuffer;
+			ret.buffer = b;
+			ret.offset = o;
+			return ret;
+		}
+
+		static FFTData Real(Image& r)
+		{
+			FFTData ret = Real(r.GetView());
+			ret.generations[0] = r.GetGeneration();
+			return ret;
+		}
+		static FFTData Complex(Image& r, Image& i)
+		{
+			FFTData ret = Complex(r.GetView(), i.GetView());
+			ret.generations[0] = r.GetGeneration();
+			ret.generations[1] = i.GetGeneration();
+			return ret;
+		}
+		static FFTData Packed(Buffer& b, vk::DeviceSize o = 0)
+		{
+			FFTData ret = Packed(b.GetBuffer(), o);
+			ret.generations[0] = b.GetGeneration();
+			return ret;
+		}
+	};	// struct FFTData
+
+	//----
+	// 各パスの前後に書き込むタイムスタンプ
+	// firstQuery から FFTPlan::GetPassCount() + 1 個のクエリを使用する、リセットは呼び出し側で行うこと
+	struct FFTTimestamp
+	{
+		vk::QueryPool	pool;
+		uint32_t		firstQuery{ 0 };
+	};	// struct FFTTimestamp
+
+	//----
+	// 2次元FFTのプラン
+	// サイズ、方向、精度ごとに作成し、中間バッファとデスクリプタセットを所有する
+	// 行パスと列パスの間は PackedBuffer 形式の中間バッファを経由する
+	// 分割したパスの間はもう1枚の中間バッファを経由する
+	// 256固定のシェーダでは中間もイメージ2枚(実部、虚部)になる
+	class FFTPlan
+	{
+	public:
+		// PackedBuffer の1要素のバイト数
+		// Single はfp32で格納するため2倍になる
+		static const uint32_t	kPackedElementSize = 3 * sizeof(uint32_t);
+		// デスクリプタセットを保持する入出力の組み合わせの上限
+		static const uint32_t	kMaxDescriptorSetEntries = 32;
+		static uint32_t GetPackedElementSize(FFTPrecision::Type precision)
+		{
+			return (precision == FFTPrecision::Single) ? kPackedElementSize * 2 : kPackedElementSize;
+		}
+
+	public:
+		FFTPlan()
+		{}
+		~FFTPlan()
+		{
+			Destroy();
+		}
+
+		bool Initialize(FFT& engine, vk::CommandBuffer& cmdBuffer, const FFTPlanDesc& desc);
+		void Destroy();
+
+		// 任意のコマンドバッファにFFTを積む
+		// pInputs, pOutputs はバッチ数分の配列で、バッチ内は同じ形式であること
+		// 順変換の出力と逆変換の入力に RealImage は使用できない
+		// 開始時に直前の計算シェーダの書き込みとの同期をとる、終了後の同期は呼び出し側で行うこと
+		// pTimestamp を指定した場合は各パスの前後にタイムスタンプを書き込む
+		// 入出力の組み合わせが kMaxDescriptorSetEntries を超える場合は false を返す
+		bool Execute(vk::CommandBuffer& cmdBuffer, const FFTData* pInputs, const FFTData* pOutputs, const FFTTimestamp* pTimestamp = nullptr);
+		bool Execute(vk::CommandBuffer& cmdBuffer, const FFTData& input, const FFTData& output, const FFTTimestamp* pTimestamp = nullptr)
+		{
+			return Execute(cmdBuffer, &input, &output, pTimestamp);
+		}
+
+		// 1回の変換で読み書きするメモリ量の見積もり
+		// 分割したパスの中間バッファの読み書きも含む
+		uint64_t GetBytesMoved(FFTDataType::Type input, FFTDataType::Type output) const;
+
+		// 入出力の組み合わせごとのデスクリプタセットをすべて解放する
+		// GPUがセットを参照していないことを保証してから呼び出すこと
+		// 世代が変わるので、このプランを記録したコマンドも作り直すこと
+		void ReleaseDescriptorSets();
+
+		// getter
+		const FFTPlanDesc&	GetDesc() const		{ return desc_; }
+		bool				IsValid() const		{ return pEngine_ != nullptr; }
+		vk::DeviceSize		GetPackedSize() const	{ return GetPackedSize(desc_.width, desc_.height, desc_.precision); }
+		// 初期化とデスクリプタセットの解放で変わる
+		uint64_t			GetGeneration() const	{ return generation_; }
+
+		// 1回の変換のパス数
+		// 行パス、列パスの順で、分割した場合はそれぞれ2パスになる
+		uint32_t GetPassCount() const
+		{
+			return 2 + (rowSplit_[0] ? 1 : 0) + (columnSplit_[0] ? 1 : 0);
+		}
+		const char* GetPassName(uint32_t index) const;
+
+	public:
+		static vk::DeviceSize GetPackedSize(uint32_t width, uint32_t height, FFTPrecision::Type precision = FFTPrecision::Half)
+		{
+			return static_cast<vk::DeviceSize>(width) * height * GetPackedElementSize(precision);
+		}
+
+		// work は行パスと列パスの間の中間形式
+		// 以前のイメージ2枚の中間形式と比較する場合は ComplexImages を指定する
+		static uint64_t ComputeBytesMoved(const FFTPlanDesc& desc, FFTDataType::Type input, FFTDataType::Type output, FFTDataType::Type work = FFTDataType::PackedBuffer);
+
+		// 1回の変換で実行する1次元FFTの数(ワークグループ数)
+		// 1パスで変換できるサイズの場合
+		static uint32_t ComputeLineTransforms(const FFTPlanDesc& desc, FFTDataType::Type input, FFTDataType::Type output);
+
+	private:
+		// 実数の2行をまとめて変換するか
+		static bool IsRowPaired(const FFTPlanDesc& desc, FFTDataType::Type input)
+		{
+			return desc.packRealPairs && (desc.direction == FFTDirection::Forward) && (input == FFTDataType::RealImage);
+		}
+		static bool IsColumnPaired(const FFTPlanDesc& desc, FFTDataType::Type output)
+		{
+			return desc.packRealPairs && (desc.direction == FFTDirection::Inverse) && (output == FFTDataType::RealImage);
+		}
+
+	private:
+		// バッチごとにパス数分のセット
+		const std::vector<vk::DescriptorSet>& GetDescriptorSets(const FFTData* pInputs, const FFTData* pOutputs);
+		void WriteDescriptorSet(const vk::DescriptorSet& set, const FFTData& input, const FFTData& output);
+
+	private:
+		FFT*			pEngine_{ nullptr };
+		FFTPlanDesc		desc_;
+
+		// 入出力の形式ごとのパイプライン
+		// 行パスは入力、列パスは出力の形式で決まる
+		// 分割する場合、行パスの2段目と列パスの1段目は中間バッファ同士の変換になる
+		vk::Pipeline	rowPipelines_[FFTDataType::Max];
+		vk::Pipeline	columnPipelines_[FFTDataType::Max];
+		vk::Pipeline	rowSecondPipeline_, columnFirstPipeline_;
+
+		// four-step FFT の分割数
+		// [0] は1段目の変換数(2段目の長さ)、[1] は2段目の変換数(1段目の長さ)、分割しない場合は0
+		uint32_t		rowSplit_[2]{};
+		uint32_t		columnSplit_[2]{};
+
+		// 中間バッファ
+		// バッチごとに workStride_ * workSlices_ ずつずらして使用する
+		// 1枚目は行パスの結果、2枚目は分割したパスの1段目の結果
+		Buffer			workBuffer_;
+		vk::DeviceSize	workStride_{ 0 };
+		uint32_t		workSlices_{ 1 };
+
+		// 256固定のシェーダの中間イメージ
+		// バッチごとに実部、虚部の2枚
+		std::vector<Image>	workImages_;
+
+		// 使用しないバインドに設定するイメージ
+		Image			dummyImage_, dummySource_;
+
+		// 入出力の組み合わせごとにデスクリプタセットを保持する
+		// 実行中のコマンドバッファが参照するセットを書き換えないようにするため
+		// セットはプランのアロケータから確保し、プランの破棄か ReleaseDescriptorSets() でまとめて解放する
+		// キーはハンドルと世代なので、同じ値のハンドルが再利用されても古いセットは返さない
+		std::map<std::vector<uint64_t>, std::vector<vk::DescriptorSet>>	descSets_;
+		DescriptorAllocator	descAllocator_;
+		DescriptorWriter	descWriter_;
+
+		uint64_t		generation_{ 0 };
+	};	// class FFTPlan
+
+	//----
+	// GPU FFTエンジン
+	// 順変換、逆変換のシェーダを格納形式(fp16, fp32)ごとに持ち、長さと行/列パスは特殊化定数で切り替える
+	// パイプラインはDeviceのキャッシュから取得するため、同じ長さのプランは同じパイプラインを共有する
+	// 1つのワークグループで処理できない長さは four-step FFT で2パスに分割する
+	// fft.comp.spv, ifft.comp.spv が無い古いバンドルでは256固定のシェーダを使用する
+	class FFT
+	{
+		friend class FFTPlan;
+
+	public:
+		// 256固定のシェーダの長さ
+		static const uint32_t	kFixedLength = 256;
+		// fp16で格納して精度を保てる最大長、これより長い場合は ResolvePrecision() で Single を選ぶ
+		static const uint32_t	kMaxHalfLength = 1024;
+
+	public:
+		FFT()
+		{}
+		~FFT()
+		{
+			Destroy();
+		}
+
+		// バンドルから fft.comp.spv, ifft.comp.spv を読み込む
+		// fft32.comp.spv, ifft32.comp.spv があれば FFTPrecision::Single も使用できる
+		// 無い場合は fft_r, fft_c, ifft_r, ifft_c (.comp.spv) を読み込み、Half の 256x256 のみ変換できる
+		// この場合の入出力は 順変換が RealImage -> ComplexImages、逆変換が ComplexImages -> RealImage のみ
+		bool Initialize(Device& owner, const ShaderBundle& bundle);
+		void Destroy();
+
+		bool IsSupported(const FFTPlanDesc& desc) const;
+
+		// fp16で格納する精度で kMaxHalfLength を超える場合、Single が使用できれば Single を返す
+		// それ以外は desc.precision をそのまま返す
+		FFTPrecision::Type ResolvePrecision(const FFTPlanDesc& desc) const;
+
+		// getter
+		Device*		GetDevice()			{ return pOwner_; }
+		bool		IsFixedKernel() const	{ return isFixedKernel_; }
+		// 1パスで変換できる最大長
+		// 共有メモリの使用量が精度ごとに異なるため、PackedHalf が最も長い
+		uint32_t	GetMaxLength(FFTPrecision::Type precision = FFTPrecision::Half) const	{ return maxLengths_[precision]; }
+		// 分割して変換できる最大長
+		uint32_t	GetMaxTransformLength(FFTPrecision::Type precision = FFTPrecision::Half) const
+		{
+			return isFixedKernel_ ? maxLengths_[precision] : maxLengths_[precision] * maxLengths_[precision];
+		}
+
+	private:
+		// 1回のディスパッチの設定
+		struct PassDesc
+		{
+			uint32_t			length{ 0 };
+			bool				isRowPass{ true };
+			FFTDataType::Type	input{ FFTDataType::PackedBuffer };
+			FFTDataType::Type	output{ FFTDataType::PackedBuffer };
+			uint32_t			pitch{ 0 };
+			bool				realPair{ false };
+			bool				fusePasses{ false };
+			uint32_t			stepType{ 0 };		// 0 は1パス、1, 2 は four-step の1段目、2段目
+			uint32_t			stepCount{ 1 };
+			FFTPrecision::Type	precision{ FFTPrecision::Half };
+		};	// struct PassDesc
+
+		bool InitializeFixed(Device& owner, const ShaderBundle& bundle);
+
+		vk::Pipeline GetPipeline(FFTDirection::Type direction, const PassDesc& pass);
+
+		// 1パスで変換できない長さを分割する、分割しない場合は false を返す
+		bool GetSplit(uint32_t length, FFTPrecision::Type precision, uint32_t* pSplit) const;
+
+	private:
+		Device*		pOwner_{ nullptr };
+
+		// [0] はfp16、[1] はfp32で格納するシェーダ、それぞれ順変換と逆変換
+		Shader		shaders_[2][2];
+		bool		isSingleAvailable_{ false };
+		// 256固定のシェーダ、方向ごとに行パスと列パス
+		Shader		fixedShaders_[2][2];
+		bool		isFixedKernel_{ false };
+		vk::DescriptorSetLayout	setLayout_;
+		vk::PipelineLayout		pipeLayout_;
+		uint32_t	maxLengths_[FFTPrecision::Max]{};
+		vk::DeviceSize	storageAlignment_{ 1 };
+	};	// class FFT
+
+}	// namespace vsl
+
+
+//	EOF
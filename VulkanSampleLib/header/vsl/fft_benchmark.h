@@ -0,0 +1,90 @@
+﻿#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vulkan/vulkan.hpp>
+#include <vsl/fft.h>
+#include <vsl/buffer.h>
+#include <string>
+#include <vector>
+
+
+namespace vsl
+{
+	class Device;
+
+	//----
+	// FFTベンチマークの結果
+	// 時間は計測した反復の平均
+	struct FFTBenchmarkResult
+	{
+		std::vector<double>	passMilliseconds;		// FFTPlan::GetPassName() の順
+		double				totalMilliseconds{ 0.0 };
+		double				transformsPerSecond{ 0.0 };	// バッチ内の1枚を1回と数える
+		double				gigaBytesPerSecond{ 0.0 };		// FFTPlan::GetBytesMoved() による実効帯域
+		double				referenceGigaBytesPerSecond{ 0.0 };
+	};	// struct FFTBenchmarkResult
+
+	//----
+	// タイムスタンプクエリによるFFTのベンチマーク
+	// 専用のコマンドバッファをグラフィクスキューに投入し、完了を待って結果を読み出す
+	class FFTBenchmark
+	{
+	public:
+		FFTBenchmark()
+		{}
+		~FFTBenchmark()
+		{
+			Destroy();
+		}
+
+		// maxQueries は計測する反復数 * (パス数 + 1) 以上にすること
+		bool Initialize(Device& owner, uint32_t maxQueries = 1024);
+		void Destroy();
+
+		// ウォームアップ後に iterations 回の変換を計測する
+		// 入出力の形式は FFTPlan::Execute() と同じ
+		bool Run(FFTPlan& plan, const FFTData* pInputs, const FFTData* pOutputs, uint32_t warmup, uint32_t iterations, FFTBenchmarkResult& result);
+		bool Run(FFTPlan& plan, const FFTData& input, const FFTData& output, uint32_t warmup, uint32_t iterations, FFTBenchmarkResult& result)
+		{
+			return Run(plan, &input, &output, warmup, iterations, result);
+		}
+
+		// 実効帯域の基準としてバッファコピーの速度を計測する
+		// Vulkan ではメモリの理論帯域を取得できないため、転送コマンドで得られる値を上限の目安とする
+		bool MeasureCopyBandwidth(vk::DeviceSize size = 256 * 1024 * 1024, uint32_t iterations = 8);
+
+		// 結果を文字列にする
+		// テキストはパスごとに1行、CSVは1回の計測を1行にまとめる
+		static std::string ToText(const char* name, const FFTPlan& plan, const FFTBenchmarkResult& result);
+		static std::string GetCsvHeader();
+		static std::string ToCsv(const char* name, const FFTPlan& plan, const FFTBenchmarkResult& result);
+
+		// getter
+		bool	IsValid() const							{ return pOwner_ != nullptr; }
+		double	GetReferenceBandwidth() const			{ return referenceGigaBytesPerSecond_; }
+
+	public:
+		// CSVで出力するパスの列数
+		static const uint32_t kMaxCsvPasses = 4;
+
+	private:
+		bool SubmitAndWait();
+		bool ReadTimestamps(uint32_t count, std::vector<uint64_t>& timestamps);
+		// 有効ビットでマスクした差分、一周した場合も正しい経過時間になる
+		uint64_t GetTicks(uint64_t begin, uint64_t end) const	{ return (end - begin) & timestampMask_; }
+
+	private:
+		Device*				pOwner_{ nullptr };
+		vk::QueryPool		queryPool_;
+		uint32_t			queryCount_{ 0 };
+		vk::CommandBuffer	cmdBuffer_;
+		vk::Fence			fence_;
+		double				nanosecondsPerTick_{ 1.0 };
+		uint64_t			timestampMask_{ 0 };
+		double				referenceGigaBytesPerSecond_{ 0.0 };
+	};	// class FFTBenchmark
+
+}	// namespace vsl
+
+
+//	EOF
@@ -0,0 +1,145 @@
+﻿#pragma once
+
+#include <functional>
+#include <map>
+#include <vector>
+#include <vulkan/vulkan.h>
+#include <vulkan/vulkan.hpp>
+#include <vsl/fft.h>
+#include <vsl/shader.h>
+#include <vsl/buffer.h>
+#include <vsl/descriptor_allocator.h>
+#include <vsl/descriptor_writer.h>
+
+
+namespace vsl
+{
+	class Device;
+	class ShaderBundle;
+
+	class FFTConvolutionMethod
+	{
+	public:
+		enum Type
+		{
+			Auto,			// カーネルサイズから見積もった負荷の小さい方
+			Spatial,		// 直接畳み込む
+			FFT,			// 周波数空間で乗算する
+
+			Max
+		};
+	};	// class FFTConvolutionMethod
+
+	//----
+	// 畳み込みカーネル
+	// 中心を原点とした (2 * radius + 1)^2 の重みをRGBごとに持つ
+	struct FFTConvolutionKernel
+	{
+		uint32_t			radius{ 0 };
+		std::vector<float>	weights;		// [y][x][rgb]
+
+		uint32_t GetWidth() const	{ return radius * 2 + 1; }
+
+		// 合計が1になるガウスカーネル、ブルーム用
+		static FFTConvolutionKernel Gaussian(uint32_t radius, float sigma);
+		// 中心から streakCount 本の光条が伸びるカーネル、レンズフレア用
+		// 光条ごとにRGBの減衰を変えて色ずれを出す
+		static FFTConvolutionKernel Star(uint32_t radius, uint32_t streakCount);
+	};	// struct FFTConvolutionKernel
+
+	//----
+	// 畳み込みの設定
+	// width, height は2のべき乗で、画像の端は反対側に回り込む(循環畳み込み)
+	struct FFTConvolutionDesc
+	{
+		uint32_t			width{ 256 };
+		uint32_t			height{ 256 };
+		// 出力イメージが rgba16f のため Single は使用できない
+		FFTPrecision::Type	precision{ FFTPrecision::Half };
+		// 直接畳み込みで使用できる最大半径
+		uint32_t			maxSpatialRadius{ 32 };
+	};	// struct FFTConvolutionDesc
+
+	//----
+	// 画像の畳み込み
+	// カーネルのスペクトルは SetKernel() で1度だけ計算してキャッシュし、
+	// 実行時は 順変換 -> スペクトルの乗算 -> 逆変換 の3段で処理する
+	// 小さいカーネルは直接畳み込む方が速いため、カーネルサイズで自動的に切り替える
+	class FFTConvolution
+	{
+	public:
+		// 直接畳み込みのデスクリプタセットを保持する入出力の組み合わせの上限
+		static const uint32_t	kMaxSpatialSets = 16;
+
+	public:
+		FFTConvolution()
+		{}
+		~FFTConvolution()
+		{
+			Destroy();
+		}
+
+		// バンドルから fft_multiply.comp.spv, convolve.comp.spv を読み込む
+		bool Initialize(FFT& engine, const ShaderBundle& bundle, vk::CommandBuffer& cmdBuffer, const FFTConvolutionDesc& desc);
+		void Destroy();
+
+		// カーネルを設定し、スペクトルを計算する
+		// 転送とFFTをグラフィクスキューに積み、専用のフェンスで完了を待つため、毎フレーム呼び出さないこと
+		// 先に積まれた Execute() とはキュー内のバリアで同期する、Execute() を別のキューに積んだ場合は呼び出し側でその完了を待つこと
+		bool SetKernel(const FFTConvolutionKernel& kernel);
+
+		// input は RealImage (rgba8)、output は RealImage (rgba16f)
+		// 開始時に直前の計算シェーダの書き込みとの同期をとる、終了後の同期は呼び出し側で行うこと
+		// 入出力の組み合わせが上限を超える場合は false を返す
+		bool Execute(vk::CommandBuffer& cmdBuffer, const FFTData& input, const FFTData& output, FFTConvolutionMethod::Type method = FFTConvolutionMethod::Auto);
+
+		// 入出力の組み合わせごとのデスクリプタセットをすべて解放する、内部のプランのセットも含む
+		// GPUがセットを参照していないことを保証してから呼び出すこと
+		void ReleaseDescriptorSets();
+
+		// Auto を解決した方法
+		FFTConvolutionMethod::Type ResolveMethod(FFTConvolutionMethod::Type method) const;
+
+		// getter
+		const FFTConvolutionDesc&	GetDesc() const		{ return desc_; }
+		bool						IsValid() const		{ return pEngine_ != nullptr; }
+		bool						HasKernel() const	{ return hasKernel_; }
+		uint32_t					GetRadius() const	{ return radius_; }
+
+	public:
+		// 1ピクセルあたりの負荷の見積もり、直接畳み込みの1タップを1とする
+		static double EstimateCost(FFTConvolutionMethod::Type method, uint32_t width, uint32_t height, uint32_t radius);
+		static FFTConvolutionMethod::Type ChooseMethod(uint32_t width, uint32_t height, uint32_t radius);
+
+	private:
+		bool SubmitAndWait(const std::function<void(vk::CommandBuffer&)>& record);
+		vk::DescriptorSet GetSpatialSet(const FFTData& input, const FFTData& output);
+
+	private:
+		FFT*				pEngine_{ nullptr };
+		FFTConvolutionDesc	desc_;
+
+		FFTPlan				forward_, inverse_;
+		Buffer				spectrum_, kernelSpectrum_;
+		Buffer				weights_;
+
+		Shader				multiplyShader_, spatialShader_;
+		vk::DescriptorSetLayout	multiplySetLayout_, spatialSetLayout_;
+		vk::PipelineLayout	multiplyPipeLayout_, spatialPipeLayout_;
+		vk::Pipeline		multiplyPipeline_, spatialPipeline_;
+		vk::DescriptorSet	multiplySet_;
+
+		// 入出力の組み合わせごとの直接畳み込みのセット
+		// キーはハンドルと世代で、セットは乗算のセットとは別のアロケータから確保する
+		std::map<std::vector<uint64_t>, vk::DescriptorSet>	spatialSets_;
+		DescriptorAllocator	descAllocator_, spatialAllocator_;
+		DescriptorWriter	descWriter_;
+
+		uint32_t			radius_{ 0 };
+		bool				hasKernel_{ false };
+	};	// class FFTConvolution
+
+}	// namespace vsl
+
+
+//	EOF
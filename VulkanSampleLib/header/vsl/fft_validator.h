@@ -0,0 +1,85 @@
+﻿#pragma once
+
+#include <vulkan/vulkan.h>
+#include <vulkan/vulkan.hpp>
+#include <vsl/fft.h>
+#include <vsl/cpu_fft.h>
+#include <vsl/fft_benchmark.h>
+#include <vsl/buffer.h>
+#include <vsl/image.h>
+
+
+namespace vsl
+{
+	class Device;
+
+	//----
+	// 検証ごとの誤差
+	struct FFTValidationErrors
+	{
+		FFTError	packed;			// PackedBuffer -> PackedBuffer の順変換
+		FFTError	realImage;		// rgba8 の RealImage -> ComplexImages の順変換、packRealPairs の場合は2行の分離も含む
+		FFTError	roundTrip;		// 順変換の結果を ComplexImages -> RealImage で逆変換し、元の画像と比較したもの
+		bool		isPackedValid{ false };		// 256固定のシェーダでは PackedBuffer を検証しない
+	};	// struct FFTValidationErrors
+
+	//----
+	// GPUのFFT結果をCPUのFFTと比較する
+	// テスト画像を PackedBuffer で転送してGPUで変換し、読み戻した結果を同じ入力のCPUの結果と比較する
+	// 入力は格納形式に丸めたものをCPUにも与えるため、誤差は計算と中間、出力の精度によるものになる
+	// 同じテスト画像を rgba8 のイメージからも変換し、逆変換で元に戻るかも確認する
+	// desc.direction は無視し、順変換と逆変換のプランを1つずつ作成する
+	// 256固定のシェーダでも RealImage -> ComplexImages -> RealImage は検証できる
+	class FFTValidator
+	{
+	public:
+		FFTValidator()
+		{}
+		~FFTValidator()
+		{
+			Destroy();
+		}
+
+		bool Initialize(FFT& engine, vk::CommandBuffer& cmdBuffer, const FFTPlanDesc& desc);
+		void Destroy();
+
+		// 転送、FFT、読み戻しのコマンドを積む
+		bool Record(vk::CommandBuffer& cmdBuffer);
+
+		// Record したコマンドの完了後に呼び出す
+		bool Resolve(FFTValidationErrors& errors);
+
+		// 検証と同じプランとバッファで変換速度を計測する
+		// 256固定のシェーダでは RealImage -> ComplexImages を計測する
+		bool Benchmark(FFTBenchmark& benchmark, uint32_t warmup, uint32_t iterations, FFTBenchmarkResult& result);
+
+		// getter
+		const FFTPlanDesc&	GetDesc() const		{ return plan_.GetDesc(); }
+		const FFTPlan&		GetPlan() const		{ return plan_; }
+		bool				IsValid() const		{ return plan_.IsValid(); }
+
+	private:
+		bool InitializeImages(vk::CommandBuffer& cmdBuffer, const std::vector<uint8_t>& pixels);
+		bool ReadBack(Buffer& buffer, vk::DeviceSize size, std::vector<uint8_t>& outData);
+
+	private:
+		Device*			pOwner_{ nullptr };
+		FFTPlan			plan_, inversePlan_;
+		CpuFFTPlan		cpuPlan_;
+		CpuFFTImage		source_;		// PackedBuffer の精度に丸めた入力
+		CpuFFTImage		imageSource_;	// rgba8 に丸めた入力
+
+		// PackedBuffer の検証用
+		Buffer			upload_, input_, output_, readback_;
+		bool			isPackedChecked_{ false };
+
+		// イメージの検証用、スペクトルは実部と虚部、読み戻しはスペクトル2枚と逆変換結果の順に詰める
+		Buffer			imageUpload_, imageReadback_;
+		Image			inputImage_, spectrumImages_[2], resultImage_;
+		vk::DeviceSize	imageBytes_{ 0 };
+	};	// class FFTValidator
+
+}	// namespace vsl
+
+
+//	EOF
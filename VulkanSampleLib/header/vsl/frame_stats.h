@@ -0,0 +1,72 @@
+﻿#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+
+namespace vsl
+{
+	//----
+	// 直近 historyLength フレームの集計
+	struct FrameStatsSummary
+	{
+		double		lastMilliseconds{ 0.0 };
+		double		averageMilliseconds{ 0.0 };
+		double		p50Milliseconds{ 0.0 };
+		double		p95Milliseconds{ 0.0 };
+		double		p99Milliseconds{ 0.0 };
+		double		maxMilliseconds{ 0.0 };
+		uint32_t	sampleCount{ 0 };
+	};	// struct FrameStatsSummary
+
+	//----
+	// フレーム時間の統計
+	// 直近のフレーム時間をリングバッファとヒストグラムで保持し、パーセンタイルを求める
+	// ヒストグラムは kBucketMilliseconds 刻みで、範囲外の値は最後のビンに入る
+	class FrameStats
+	{
+	public:
+		static const uint32_t	kDefaultHistoryLength = 600;
+		static const uint32_t	kBucketCount = 1000;
+		static const double		kBucketMilliseconds;
+
+	public:
+		FrameStats()
+		{
+			Initialize();
+		}
+
+		void Initialize(uint32_t historyLength = kDefaultHistoryLength);
+
+		// 1フレーム分の時間を追加する
+		void AddFrame(double milliseconds);
+
+		// 0 <= percentile <= 100
+		// ビンの中で線形補間するため、誤差は kBucketMilliseconds 以内
+		double GetPercentile(double percentile) const;
+
+		// getter
+		const FrameStatsSummary&	GetSummary() const		{ return summary_; }
+		uint64_t					GetFrameCount() const	{ return frameCount_; }
+		uint32_t					GetHistoryLength() const	{ return static_cast<uint32_t>(history_.size()); }
+
+	private:
+		uint32_t GetBucket(double milliseconds) const;
+		void UpdateSummary();
+
+	private:
+		std::vector<double>		history_;
+		uint32_t				historyIndex_{ 0 };
+		uint32_t				historyCount_{ 0 };
+		double					historySum_{ 0.0 };
+
+		std::vector<uint32_t>	buckets_;
+		uint64_t				frameCount_{ 0 };
+
+		FrameStatsSummary		summary_;
+	};	// class FrameStats
+
+}	// namespace vsl
+
+
+//	EOF
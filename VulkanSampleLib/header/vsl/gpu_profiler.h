@@ -0,0 +1,137 @@
+﻿#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan.h>
+#include <vulkan/vulkan.hpp>
+
+
+namespace vsl
+{
+	class Device;
+
+	//----
+	// スコープごとの計測結果
+	struct GpuProfilerEntry
+	{
+		std::string		name;
+		std::string		path;			// 親のスコープ名を '/' でつないだもの
+		uint32_t		depth{ 0 };
+
+		double			lastMilliseconds{ 0.0 };
+		double			averageMilliseconds{ 0.0 };		// 直近 historyLength フレームの平均
+		double			maxMilliseconds{ 0.0 };			// 直近 historyLength フレームの最大
+
+		std::vector<float>	history;	// 直近の計測値、リングバッファ
+		uint32_t			historyIndex{ 0 };
+		uint32_t			historyCount{ 0 };
+	};	// struct GpuProfilerEntry
+
+	//----
+	// タイムスタンプクエリによるGPU時間の計測
+	// 同時に処理されるフレームの数だけクエリプールを持ち、同じフレームのプールを次に使用する際に結果を回収する
+	// 回収時はフェンスの完了を前提とし、結果がまだ書き込まれていない場合は待たずにそのフレームの結果を捨てる
+	class GpuProfiler
+	{
+	public:
+		static const uint32_t	kDefaultMaxScopes = 64;
+		static const uint32_t	kDefaultHistoryLength = 120;
+
+	public:
+		GpuProfiler()
+		{}
+		~GpuProfiler()
+		{
+			Destroy();
+		}
+
+		// frameCount はメインコマンドバッファの数
+		bool Initialize(Device& owner, uint32_t frameCount, uint32_t maxScopes = kDefaultMaxScopes, uint32_t historyLength = kDefaultHistoryLength);
+		void Destroy();
+
+		// フレームの開始
+		// 前回 frameIndex で計測した結果を回収し、クエリのリセットを積む
+		// レンダーパスの外で呼び出すこと
+		void BeginFrame(vk::CommandBuffer& cmdBuffer, uint32_t frameIndex);
+
+		// 名前付きスコープ、入れ子にできる
+		// 開始と終了はどちらも直前までのコマンドの完了時刻を記録する
+		// name は文字列リテラルなど、結果の回収まで有効なものを渡すこと
+		void BeginScope(vk::CommandBuffer& cmdBuffer, const char* name);
+		void EndScope(vk::CommandBuffer& cmdBuffer);
+
+		// ログ出力用の文字列
+		std::string ToText() const;
+
+		// getter
+		bool IsValid() const	{ return pOwner_ != nullptr; }
+		// 初めて計測した順に並ぶ、子スコープは親スコープの後ろに並ぶ
+		const std::vector<GpuProfilerEntry>&	GetEntries() const	{ return entries_; }
+		// 計測可能なスコープ数を超えたため記録しなかったスコープの数
+		uint32_t	GetDroppedCount() const	{ return droppedCount_; }
+
+	private:
+		struct Scope
+		{
+			const char*	name;
+			uint32_t	depth;
+			int32_t		parent;
+			uint32_t	beginQuery, endQuery;
+		};	// struct Scope
+
+		struct Frame
+		{
+			vk::QueryPool		pool;
+			std::vector<Scope>	scopes;
+			uint32_t			queryCount{ 0 };
+			bool				isPending{ false };
+		};	// struct Frame
+
+		void Resolve(Frame& frame);
+		void AddSample(const std::string& path, const char* name, uint32_t depth, double milliseconds);
+
+	private:
+		Device*				pOwner_{ nullptr };
+		double				nanosecondsPerTick_{ 1.0 };
+		uint64_t			timestampMask_{ 0 };
+		uint32_t			maxScopes_{ 0 };
+		uint32_t			historyLength_{ 0 };
+
+		std::vector<Frame>	frames_;
+		Frame*				pCurrent_{ nullptr };
+		std::vector<int32_t>	scopeStack_;		// 記録しなかったスコープは -1
+		uint32_t			droppedCount_{ 0 };
+
+		std::vector<GpuProfilerEntry>	entries_;
+		std::map<std::string, size_t>	entryIndices_;
+	};	// class GpuProfiler
+
+	//----
+	// スコープの開始と終了を対にする
+	class GpuProfileScope
+	{
+	public:
+		GpuProfileScope(GpuProfiler& profiler, vk::CommandBuffer& cmdBuffer, const char* name)
+			: profiler_(profiler), cmdBuffer_(cmdBuffer)
+		{
+			profiler_.BeginScope(cmdBuffer_, name);
+		}
+		~GpuProfileScope()
+		{
+			profiler_.EndScope(cmdBuffer_);
+		}
+
+	private:
+		GpuProfileScope(const GpuProfileScope&) = delete;
+		GpuProfileScope& operator=(const GpuProfileScope&) = delete;
+
+	private:
+		GpuProfiler&		profiler_;
+		vk::CommandBuffer&	cmdBuffer_;
+	};	// class GpuProfileScope
+
+}	// namespace vsl
+
+
+//	EOF
@@ -14,6 +14,9 @@ namespace vsl
 	class Device;
 	class Buffer;
 	class InputData;
+	class GpuProfiler;
+	class PipelineStatistics;
+	class FrameStats;
 
 	class Gui
 	{
@@ -35,7 +38,18 @@ namespace vsl
 		bool CreateFontImage(vk::CommandBuffer& cmdBuff, Buffer& staging);
 
 		// 新しいフレームの開始
-		void BeginNewFrame(uint32_t frameWidth, uint32_t frameHeight, const InputData& input, float frameScale = 1.0f, float timeStep = 1.0f / 60.0f);
+		// timeStep が 0 以下の場合は InputData の経過時間を使用する
+		void BeginNewFrame(uint32_t frameWidth, uint32_t frameHeight, const InputData& input, float frameScale = 1.0f, float timeStep = 0.0f);
+
+		// GPUプロファイラの結果をウィンドウに表示する
+		// BeginNewFrame() と ImGui::Render() の間で呼び出す
+		void ShowGpuProfiler(const GpuProfiler& profiler, const char* title = "GPU Profiler");
+		// パイプライン統計の結果をウィンドウに表示する
+		void ShowPipelineStatistics(const PipelineStatistics& statistics, const char* title = "Pipeline Statistics");
+		// フレーム時間の統計をウィンドウに表示する
+		void ShowFrameStats(const FrameStats& stats, const char* title = "Frame Time");
+		// 直前のフレームのAPI呼び出し回数をウィンドウに表示する
+		void ShowApiCounters(const char* title = "API Counters");
 
 		// レンダーパス開始情報を設定する
 		void SetPassBeginInfo(const vk::RenderPassBeginInfo& info)
@@ -57,7 +71,6 @@ namespace vsl
 
 		vk::Sampler				fontSampler_;
 		vk::DescriptorSetLayout	descSetLayout_;
-		vk::DescriptorPool		descPool_;
 		vk::DescriptorSet		descSet_;
 		vk::PipelineLayout		pipelineLayout_;
 		vk::Pipeline			pipeline_;
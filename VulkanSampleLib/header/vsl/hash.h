@@ -0,0 +1,52 @@
+﻿#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <type_traits>
+
+
+namespace vsl
+{
+	static const uint64_t	kFnvOffsetBasis = 14695981039346656037ULL;
+	static const uint64_t	kFnvPrime = 1099511628211ULL;
+
+	//----
+	// FNV-1a
+	inline uint64_t HashBytes(const void* pData, size_t size, uint64_t seed = kFnvOffsetBasis)
+	{
+		const uint8_t* p = static_cast<const uint8_t*>(pData);
+		for (size_t i = 0; i < size; i++)
+		{
+			seed ^= p[i];
+			seed *= kFnvPrime;
+		}
+		return seed;
+	}
+
+	//----
+	// 値を1つハッシュに混ぜ込む
+	// 構造体はパディングやpNextを含むため、メンバを個別に渡すこと
+	// (vk::Flags はコピーコンストラクタを持つので trivially copyable ではない)
+	template <typename T>
+	inline void HashCombine(uint64_t& seed, const T& value)
+	{
+		static_assert(std::is_standard_layout<T>::value, "HashCombine requires standard layout type.");
+		seed = HashBytes(&value, sizeof(T), seed);
+	}
+
+	//----
+	// float は operator== で等しい値が同じハッシュになるよう -0 を +0 にそろえる
+	// NaN は自身と一致しないので、キーとして使っても検索には一致しない
+	inline void HashCombine(uint64_t& seed, float value)
+	{
+		if (value == 0.0f)
+		{
+			value = 0.0f;
+		}
+		seed = HashBytes(&value, sizeof(value), seed);
+	}
+
+}	// namespace vsl
+
+
+//	EOF
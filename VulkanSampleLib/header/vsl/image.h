@@ -2,6 +2,7 @@
 
 #include <vulkan/vulkan.h>
 #include <vulkan/vulkan.hpp>
+#include <vsl/resource_generation.h>
 
 
 namespace vsl
@@ -45,12 +46,22 @@ namespace vsl
 			Buffer& staging,
 			vk::Format format,
 			uint32_t width, uint32_t height,
-			uint16_t mipLevels = 1, uint16_t arrayLayers = 1);
+			uint16_t mipLevels = 1, uint16_t arrayLayers = 1,
+			vk::DeviceSize stagingOffset = 0);
 
 		void Destroy();
 
 		void SetImageLayout(vk::CommandBuffer cmdBuffer, vk::ImageLayout newImageLayout, vk::ImageSubresourceRange subresourceRange);
 
+		// 任意のサブリソース範囲・フォーマットのView
+		// 初回のみ生成し、以降はDeviceのキャッシュから返す
+		// format が eUndefined の場合はイメージのフォーマットを使用する
+		vk::ImageView GetView(
+			const vk::ImageSubresourceRange& subresourceRange,
+			vk::ImageViewType viewType = vk::ImageViewType::e2D,
+			vk::Format format = vk::Format::eUndefined);
+		vk::ImageView GetMipView(uint32_t mipLevel, uint32_t arrayLayer = 0);
+
 		// getter
 		vk::Image&		GetImage()			{ return image_; }
 		vk::ImageView&	GetView()			{ return view_; }
@@ -59,6 +70,10 @@ namespace vsl
 		vk::Format		GetFormat()	const	{ return format_; }
 		uint16_t		GetWidth()	const	{ return width_; }
 		uint16_t		GetHeight()	const	{ return height_; }
+		uint16_t		GetMipLevels() const	{ return mipLevels_; }
+		uint16_t		GetArrayLayers() const	{ return arrayLayers_; }
+		// 生成するたびに変わる、Viewを作り直したかどうかの判定にも使用できる
+		uint64_t		GetGeneration() const	{ return generation_; }
 
 	private:
 		Device*		pOwner_{ nullptr };
@@ -68,7 +83,10 @@ namespace vsl
 		vk::ImageView		view_, depthView_, stencilView_;
 		vk::Format			format_{ vk::Format::eUndefined };
 		uint16_t			width_{ 0 }, height_{ 0 };
+		uint16_t			mipLevels_{ 0 }, arrayLayers_{ 0 };
+		vk::ImageAspectFlags	aspect_;
 		vk::ImageLayout		currentLayout_{ vk::ImageLayout::eUndefined };
+		uint64_t			generation_{ 0 };
 
 	public:
 		static void SetImageLayout(
@@ -77,6 +95,7 @@ namespace vsl
 			vk::ImageLayout oldImageLayout,
 			vk::ImageLayout newImageLayout,
 			vk::ImageSubresourceRange subresourceRange);
+		static void SwapRedBlue(uint8_t* pPixels, size_t pixelCount);
 	};	// class Image
 
 }	// namespace vsl
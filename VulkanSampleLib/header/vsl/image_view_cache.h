@@ -0,0 +1,55 @@
+﻿#pragma once
+
+#include <mutex>
+#include <unordered_map>
+#include <vulkan/vulkan.h>
+#include <vulkan/vulkan.hpp>
+
+
+namespace vsl
+{
+	class Device;
+
+	//----
+	// イメージビューキャッシュ
+	// サブリソース範囲やフォーマットごとのViewを必要になった時点で生成する
+	// イメージ破棄時は Invalidate でそのイメージのViewをまとめて破棄すること
+	class ImageViewCache
+	{
+	public:
+		ImageViewCache()
+		{}
+		~ImageViewCache()
+		{
+			Destroy();
+		}
+
+		bool Initialize(Device& owner);
+		void Destroy();
+
+		vk::ImageView GetView(const vk::ImageViewCreateInfo& createInfo);
+		void Invalidate(const vk::Image& image);
+
+		// getter
+		size_t	GetViewCount() const;
+
+	private:
+		struct CreateInfoHash
+		{
+			size_t operator()(const vk::ImageViewCreateInfo& info) const;
+		};	// struct CreateInfoHash
+
+		typedef std::unordered_map<vk::ImageViewCreateInfo, vk::ImageView, CreateInfoHash>	ViewMap;
+
+	private:
+		Device*		pOwner_{ nullptr };
+
+		// イメージ単位で破棄できるよう、イメージごとにマップを分ける
+		std::unordered_map<VkImage, ViewMap>	views_;
+		mutable std::mutex	mutex_;
+	};	// class ImageViewCache
+
+}	// namespace vsl
+
+
+//	EOF
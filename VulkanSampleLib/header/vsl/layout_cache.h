@@ -0,0 +1,85 @@
+﻿#pragma once
+
+#include <initializer_list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <vulkan/vulkan.h>
+#include <vulkan/vulkan.hpp>
+
+
+namespace vsl
+{
+	class Device;
+	class Shader;
+
+	//----
+	// デスクリプタセットレイアウト、パイプラインレイアウトのキャッシュ
+	// 同じ構成のレイアウトは1つだけ生成して使い回す
+	// 取得したレイアウトはキャッシュが所有するため、利用側で破棄しないこと
+	class LayoutCache
+	{
+	public:
+		LayoutCache()
+		{}
+		~LayoutCache()
+		{
+			Destroy();
+		}
+
+		bool Initialize(Device& owner);
+		void Destroy();
+
+		// イミュータブルサンプラには対応しない
+		vk::DescriptorSetLayout GetDescriptorSetLayout(const std::vector<vk::DescriptorSetLayoutBinding>& bindings);
+		vk::PipelineLayout GetPipelineLayout(const std::vector<vk::DescriptorSetLayout>& setLayouts, const std::vector<vk::PushConstantRange>& pushConstantRanges);
+
+		// シェーダのリフレクション情報からレイアウトを取得する
+		// 同じ set, binding のリソースはステージフラグをまとめる
+		// outSetLayouts には set 番号順にレイアウトが格納される
+		bool GetLayouts(std::initializer_list<const Shader*> shaders, std::vector<vk::DescriptorSetLayout>& outSetLayouts, vk::PipelineLayout& outPipeLayout);
+
+		// キャッシュしたセットレイアウトが必要とするデスクリプタ数を種類ごとに取得する
+		// このキャッシュで生成したレイアウトでなければ false を返す
+		bool GetDescriptorCounts(const vk::DescriptorSetLayout& layout, std::vector<vk::DescriptorPoolSize>& outCounts);
+
+		// getter
+		size_t	GetDescriptorSetLayoutCount() const	{ return setLayouts_.size(); }
+		size_t	GetPipelineLayoutCount() const		{ return pipeLayouts_.size(); }
+
+	private:
+		typedef std::vector<vk::DescriptorSetLayoutBinding>	BindingList;
+
+		struct PipelineLayoutKey
+		{
+			std::vector<vk::DescriptorSetLayout>	setLayouts;
+			std::vector<vk::PushConstantRange>		pushConstantRanges;
+
+			bool operator==(const PipelineLayoutKey& rhs) const
+			{
+				return (setLayouts == rhs.setLayouts) && (pushConstantRanges == rhs.pushConstantRanges);
+			}
+		};	// struct PipelineLayoutKey
+
+		struct BindingListHash
+		{
+			size_t operator()(const BindingList& bindings) const;
+		};	// struct BindingListHash
+
+		struct PipelineLayoutKeyHash
+		{
+			size_t operator()(const PipelineLayoutKey& key) const;
+		};	// struct PipelineLayoutKeyHash
+
+	private:
+		Device*		pOwner_{ nullptr };
+
+		std::unordered_map<BindingList, vk::DescriptorSetLayout, BindingListHash>			setLayouts_;
+		std::unordered_map<PipelineLayoutKey, vk::PipelineLayout, PipelineLayoutKeyHash>	pipeLayouts_;
+		std::mutex	mutex_;
+	};	// class LayoutCache
+
+}	// namespace vsl
+
+
+//	EOF
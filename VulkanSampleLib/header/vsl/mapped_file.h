@@ -0,0 +1,39 @@
+﻿#pragma once
+
+#include <string>
+#include <windows.h>
+
+
+namespace vsl
+{
+	//----
+	// 読み込み専用のメモリマップドファイル
+	class MappedFile
+	{
+	public:
+		MappedFile()
+		{}
+		~MappedFile()
+		{
+			Close();
+		}
+
+		bool Open(const std::string& filename);
+		void Close();
+
+		// getter
+		const uint8_t*	GetData() const	{ return pData_; }
+		size_t			GetSize() const	{ return size_; }
+		bool			IsOpen() const	{ return pData_ != nullptr; }
+
+	private:
+		HANDLE			hFile_{ INVALID_HANDLE_VALUE };
+		HANDLE			hMapping_{ nullptr };
+		const uint8_t*	pData_{ nullptr };
+		size_t			size_{ 0 };
+	};	// class MappedFile
+
+}	// namespace vsl
+
+
+//	EOF
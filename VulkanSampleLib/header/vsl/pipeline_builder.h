@@ -0,0 +1,111 @@
+﻿#pragma once
+
+#include <future>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan.h>
+#include <vulkan/vulkan.hpp>
+
+
+namespace vsl
+{
+	class Device;
+	class RenderPass;
+
+	//----
+	// グラフィクスパイプラインの設定
+	// デフォルトは三角形リスト、カリングなし、深度テストあり、ブレンドなし、
+	// カラーアタッチメント1枚、ViewportとScissorBoxは動的に変更する
+	class PipelineBuilder
+	{
+	public:
+		PipelineBuilder();
+
+		PipelineBuilder& SetShader(vk::ShaderStageFlagBits stage, const vk::ShaderModule& module, const char* entryPoint = "main");
+		PipelineBuilder& SetVertexBinding(uint32_t binding, uint32_t stride, vk::VertexInputRate inputRate = vk::VertexInputRate::eVertex);
+		PipelineBuilder& AddVertexAttribute(uint32_t location, uint32_t binding, vk::Format format, uint32_t offset);
+		PipelineBuilder& SetTopology(vk::PrimitiveTopology topology, bool primitiveRestart = false);
+		PipelineBuilder& SetRasterizer(vk::PolygonMode polygonMode, vk::CullModeFlags cullMode, vk::FrontFace frontFace = vk::FrontFace::eCounterClockwise);
+		PipelineBuilder& SetDepthState(bool testEnable, bool writeEnable, vk::CompareOp compareOp = vk::CompareOp::eLessOrEqual);
+		PipelineBuilder& SetColorAttachmentCount(uint32_t count);
+		PipelineBuilder& SetBlendState(uint32_t attachment, const vk::PipelineColorBlendAttachmentState& state);
+		PipelineBuilder& SetAlphaBlend(uint32_t attachment);
+		PipelineBuilder& SetSampleCount(vk::SampleCountFlagBits samples);
+		PipelineBuilder& SetDynamicStates(vk::ArrayProxy<const vk::DynamicState> states);
+		PipelineBuilder& SetLayout(const vk::PipelineLayout& layout);
+		PipelineBuilder& SetRenderPass(RenderPass& renderPass, uint32_t subpass = 0);
+
+		// キャッシュ経由でパイプラインを取得する
+		// 取得したパイプラインはキャッシュが所有するため、利用側で破棄しないこと
+		vk::Pipeline Build(Device& owner) const;
+		// ワーカースレッドで生成し、完了時にfutureから受け取る
+		std::shared_future<vk::Pipeline> BuildAsync(Device& owner) const;
+
+		// キャッシュを通さずに直接生成する
+		vk::Pipeline Create(vk::Device& device, const vk::PipelineCache& cache) const;
+
+		// キャッシュのキー
+		// レンダーパスはハンドルではなく互換性を示すハッシュで比較する
+		uint64_t ComputeHash() const;
+		bool IsSameState(const PipelineBuilder& rhs) const;
+		bool UsesShader(const vk::ShaderModule& module) const;
+
+	private:
+		struct ShaderStage
+		{
+			vk::ShaderStageFlagBits	stage;
+			vk::ShaderModule		module;
+			std::string				entryPoint;
+		};	// struct ShaderStage
+
+	private:
+		std::vector<ShaderStage>							stages_;
+		std::vector<vk::VertexInputBindingDescription>		bindings_;
+		std::vector<vk::VertexInputAttributeDescription>	attributes_;
+		vk::PipelineInputAssemblyStateCreateInfo			inputAssembly_;
+		vk::PipelineRasterizationStateCreateInfo			rasterization_;
+		vk::PipelineDepthStencilStateCreateInfo				depthStencil_;
+		std::vector<vk::PipelineColorBlendAttachmentState>	blendAttachments_;
+		vk::SampleCountFlagBits								sampleCount_{ vk::SampleCountFlagBits::e1 };
+		std::vector<vk::DynamicState>						dynamicStates_;
+		vk::PipelineLayout									layout_;
+		vk::RenderPass										renderPass_;
+		uint64_t											renderPassHash_{ 0 };
+		uint32_t											subpass_{ 0 };
+	};	// class PipelineBuilder
+
+	//----
+	// コンピュートパイプラインの設定
+	class ComputePipelineBuilder
+	{
+	public:
+		ComputePipelineBuilder()
+		{}
+
+		ComputePipelineBuilder& SetShader(const vk::ShaderModule& module, const char* entryPoint = "main");
+		ComputePipelineBuilder& SetLayout(const vk::PipelineLayout& layout);
+		// 特殊化定数は32bit値のみ対応する
+		// boolはVkBool32として0/1を渡す
+		ComputePipelineBuilder& SetSpecConstant(uint32_t constantId, uint32_t value);
+		ComputePipelineBuilder& ClearSpecConstants();
+
+		vk::Pipeline Build(Device& owner) const;
+		std::shared_future<vk::Pipeline> BuildAsync(Device& owner) const;
+		vk::Pipeline Create(vk::Device& device, const vk::PipelineCache& cache) const;
+
+		uint64_t ComputeHash() const;
+		bool IsSameState(const ComputePipelineBuilder& rhs) const;
+		bool UsesShader(const vk::ShaderModule& module) const	{ return module_ == module; }
+
+	private:
+		vk::ShaderModule	module_;
+		std::string			entryPoint_{ "main" };
+		vk::PipelineLayout	layout_;
+		std::vector<vk::SpecializationMapEntry>	specEntries_;
+		std::vector<uint32_t>					specData_;
+	};	// class ComputePipelineBuilder
+
+}	// namespace vsl
+
+
+//	EOF
@@ -0,0 +1,102 @@
+﻿#pragma once
+
+#include <future>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <vulkan/vulkan.h>
+#include <vulkan/vulkan.hpp>
+#include <vsl/pipeline_builder.h>
+
+
+namespace vsl
+{
+	class Device;
+
+	//----
+	// パイプラインステートキャッシュ
+	// 設定全体のハッシュをキーに、同じ設定のパイプラインは1つだけ生成する
+	// シェーダモジュールはハンドルで比較するため、モジュールの破棄時に Invalidate() で登録を外す
+	class PipelineStateCache
+	{
+	public:
+		struct Stats
+		{
+			uint32_t	hitCount{ 0 };
+			uint32_t	missCount{ 0 };
+			double		compileMilliseconds{ 0.0 };
+		};	// struct Stats
+
+	public:
+		PipelineStateCache()
+		{}
+		~PipelineStateCache()
+		{
+			Destroy();
+		}
+
+		bool Initialize(Device& owner);
+		void Destroy();
+
+		// cache を省略した場合はDeviceのパイプラインキャッシュを使用する
+		vk::Pipeline GetPipeline(const PipelineBuilder& builder, vk::PipelineCache cache = vk::PipelineCache());
+		vk::Pipeline GetPipeline(const ComputePipelineBuilder& builder, vk::PipelineCache cache = vk::PipelineCache());
+
+		// ワーカースレッドで生成する
+		// 各ワーカーは専用のパイプラインキャッシュを使用する
+		std::shared_future<vk::Pipeline> GetPipelineAsync(const PipelineBuilder& builder);
+		std::shared_future<vk::Pipeline> GetPipelineAsync(const ComputePipelineBuilder& builder);
+
+		// 非同期生成の完了を待ち、ワーカーのキャッシュをDeviceのパイプラインキャッシュに統合する
+		// 統合後はワーカーのキャッシュを作り直すので、前回の統合以降に非同期生成がなければ何もしない
+		// Deviceのパイプラインキャッシュを使った生成と同時に呼び出さないこと
+		bool MergeWorkerCaches();
+
+		// module を使用するパイプラインを検索対象から外す
+		// 記録済みのコマンドから参照されている可能性があるので、パイプライン自体は Destroy() まで破棄しない
+		// ShaderModuleCache がモジュールを破棄する前に呼び出す
+		void Invalidate(const vk::ShaderModule& module);
+
+		// getter
+		Stats	GetStats() const;
+		size_t	GetPipelineCount() const;
+
+	private:
+		template <typename Builder>
+		struct Entry
+		{
+			Builder			state;
+			vk::Pipeline	pipeline;
+		};	// struct Entry
+
+		template <typename Builder>
+		using EntryMap = std::unordered_map<uint64_t, std::vector<Entry<Builder>>>;
+
+		template <typename Builder>
+		vk::Pipeline GetPipelineImpl(EntryMap<Builder>& entries, const Builder& builder, vk::PipelineCache cache);
+		template <typename Builder>
+		std::shared_future<vk::Pipeline> GetPipelineAsyncImpl(const Builder& builder);
+		template <typename Builder>
+		void InvalidateImpl(EntryMap<Builder>& entries, const vk::ShaderModule& module);
+
+		void WaitAsyncJobs();
+
+	private:
+		Device*		pOwner_{ nullptr };
+
+		EntryMap<PipelineBuilder>			graphicsPipelines_;
+		EntryMap<ComputePipelineBuilder>	computePipelines_;
+		Stats								stats_;
+		std::vector<vk::Pipeline>			retiredPipelines_;
+		mutable std::mutex					mutex_;
+
+		std::vector<vk::PipelineCache>					workerCaches_;
+		std::vector<std::shared_future<vk::Pipeline>>	asyncJobs_;
+		bool											hasUnmergedJobs_{ false };
+		std::mutex										asyncMutex_;
+	};	// class PipelineStateCache
+
+}	// namespace vsl
+
+
+//	EOF
@@ -0,0 +1,132 @@
+﻿#pragma once
+
+#include <string>
+#include <vector>
+#include <vulkan/vulkan.h>
+#include <vulkan/vulkan.hpp>
+
+
+namespace vsl
+{
+	class Device;
+
+	class PipelineStatisticsCounter
+	{
+	public:
+		enum Type
+		{
+			InputVertices,			// 入力アセンブラが読み込んだ頂点数
+			VertexInvocations,		// 頂点シェーダの起動数
+			ClippingPrimitives,		// クリッピング後に残ったプリミティブ数
+			FragmentInvocations,	// ピクセルシェーダの起動数
+			ComputeInvocations,		// 計算シェーダの起動数
+
+			Max
+		};
+	};	// class PipelineStatisticsCounter
+
+	//----
+	// スコープごとの1フレーム分の結果
+	struct PipelineStatisticsEntry
+	{
+		std::string		name;
+		uint64_t		values[PipelineStatisticsCounter::Max]{};
+	};	// struct PipelineStatisticsEntry
+
+	//----
+	// パイプライン統計クエリによるシェーダ起動数の計測
+	// GpuProfiler と同様に同時に処理されるフレームの数だけクエリプールを持ち、待たずに結果を回収する
+	// 同じ種類のクエリは同時に1つしか実行できないため、スコープは入れ子にできない
+	// レンダーパス内で開始したスコープは同じサブパス内で終了すること
+	class PipelineStatistics
+	{
+	public:
+		static const uint32_t	kDefaultMaxScopes = 32;
+
+	public:
+		PipelineStatistics()
+		{}
+		~PipelineStatistics()
+		{
+			Destroy();
+		}
+
+		// pipelineStatisticsQuery がサポートされていない場合は false を返す
+		bool Initialize(Device& owner, uint32_t frameCount, uint32_t maxScopes = kDefaultMaxScopes);
+		void Destroy();
+
+		// フレームの開始
+		// 前回 frameIndex で計測した結果を回収し、クエリのリセットを積む
+		// レンダーパスの外で呼び出すこと
+		void BeginFrame(vk::CommandBuffer& cmdBuffer, uint32_t frameIndex);
+
+		// name は文字列リテラルなど、結果の回収まで有効なものを渡すこと
+		void BeginScope(vk::CommandBuffer& cmdBuffer, const char* name);
+		void EndScope(vk::CommandBuffer& cmdBuffer);
+
+		// 最後に回収したフレームの結果から検索する
+		const PipelineStatisticsEntry* Find(const char* name) const;
+
+		// ログ出力用の文字列
+		std::string ToText() const;
+
+		// getter
+		bool IsValid() const	{ return pOwner_ != nullptr; }
+		// 最後に回収したフレームの結果、計測した順に並ぶ
+		const std::vector<PipelineStatisticsEntry>&	GetEntries() const	{ return entries_; }
+		// 入れ子やスコープ数の超過で記録しなかったスコープの数
+		uint32_t	GetDroppedCount() const	{ return droppedCount_; }
+
+	public:
+		static const char* GetCounterName(PipelineStatisticsCounter::Type counter);
+
+	private:
+		struct Frame
+		{
+			vk::QueryPool				pool;
+			std::vector<const char*>	names;
+			bool						isPending{ false };
+		};	// struct Frame
+
+		void Resolve(Frame& frame);
+
+	private:
+		Device*				pOwner_{ nullptr };
+		uint32_t			maxScopes_{ 0 };
+
+		std::vector<Frame>	frames_;
+		Frame*				pCurrent_{ nullptr };
+		std::vector<bool>	scopeStack_;		// 記録したスコープは true
+		uint32_t			droppedCount_{ 0 };
+
+		std::vector<PipelineStatisticsEntry>	entries_;
+	};	// class PipelineStatistics
+
+	//----
+	// スコープの開始と終了を対にする
+	class PipelineStatisticsScope
+	{
+	public:
+		PipelineStatisticsScope(PipelineStatistics& statistics, vk::CommandBuffer& cmdBuffer, const char* name)
+			: statistics_(statistics), cmdBuffer_(cmdBuffer)
+		{
+			statistics_.BeginScope(cmdBuffer_, name);
+		}
+		~PipelineStatisticsScope()
+		{
+			statistics_.EndScope(cmdBuffer_);
+		}
+
+	private:
+		PipelineStatisticsScope(const PipelineStatisticsScope&) = delete;
+		PipelineStatisticsScope& operator=(const PipelineStatisticsScope&) = delete;
+
+	private:
+		PipelineStatistics&	statistics_;
+		vk::CommandBuffer&	cmdBuffer_;
+	};	// class PipelineStatisticsScope
+
+}	// namespace vsl
+
+
+//	EOF
@@ -32,11 +32,14 @@ namespace vsl
 
 		// getter
 		vk::RenderPass& GetPass() { return pass_; }
+		// 互換性のあるレンダーパスは同じ値になる
+		uint64_t GetCompatibilityHash() const { return compatibilityHash_; }
 
 	private:
 		Device*		pOwner_{ nullptr };
 
 		vk::RenderPass		pass_;
+		uint64_t			compatibilityHash_{ 0 };
 	};	// class Buffer
 
 }	// namespace vsl
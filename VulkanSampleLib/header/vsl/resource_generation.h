@@ -0,0 +1,21 @@
+﻿#pragma once
+
+#include <stdint.h>
+#include <atomic>
+
+
+namespace vsl
+{
+	//----
+	// リソースを生成するたびに増える通し番号、0 は未初期化
+	// ハンドルは破棄後に同じ値が再利用されることがあるため、作り直しの検出にはこちらを使用する
+	inline uint64_t NextResourceGeneration()
+	{
+		static std::atomic<uint64_t> sGeneration{ 0 };
+		return ++sGeneration;
+	}
+
+}	// namespace vsl
+
+
+//	EOF
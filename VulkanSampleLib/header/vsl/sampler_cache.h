@@ -0,0 +1,51 @@
+﻿#pragma once
+
+#include <mutex>
+#include <unordered_map>
+#include <vulkan/vulkan.h>
+#include <vulkan/vulkan.hpp>
+
+
+namespace vsl
+{
+	class Device;
+
+	//----
+	// サンプラキャッシュ
+	// 同じ設定のサンプラは1つだけ生成して使い回す
+	// 取得したサンプラはキャッシュが所有するため、利用側で破棄しないこと
+	class SamplerCache
+	{
+	public:
+		SamplerCache()
+		{}
+		~SamplerCache()
+		{
+			Destroy();
+		}
+
+		bool Initialize(Device& owner);
+		void Destroy();
+
+		vk::Sampler GetSampler(const vk::SamplerCreateInfo& createInfo);
+
+		// getter
+		size_t	GetSamplerCount() const	{ return samplers_.size(); }
+
+	private:
+		struct CreateInfoHash
+		{
+			size_t operator()(const vk::SamplerCreateInfo& info) const;
+		};	// struct CreateInfoHash
+
+	private:
+		Device*		pOwner_{ nullptr };
+
+		std::unordered_map<vk::SamplerCreateInfo, vk::Sampler, CreateInfoHash>	samplers_;
+		std::mutex	mutex_;
+	};	// class SamplerCache
+
+}	// namespace vsl
+
+
+//	EOF
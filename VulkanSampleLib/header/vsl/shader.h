@@ -1,5 +1,8 @@
 ﻿#pragma once
 
+#include <array>
+#include <string>
+#include <vector>
 #include <vulkan/vulkan.h>
 #include <vulkan/vulkan.hpp>
 
@@ -7,10 +10,24 @@
 namespace vsl
 {
 	class Device;
+	class ShaderBundle;
+
+	//----
+	// SPIR-Vから取得したリソースのバインド情報
+	struct ShaderResourceBinding
+	{
+		uint32_t			set{ 0 };
+		uint32_t			binding{ 0 };
+		vk::DescriptorType	type{ vk::DescriptorType::eSampler };
+		uint32_t			count{ 1 };
+	};	// struct ShaderResourceBinding
 
 	//----
 	class Shader
 	{
+	public:
+		static const uint32_t	kInvalidSpecId = 0xffffffff;
+
 	public:
 		Shader()
 		{}
@@ -20,16 +37,37 @@ namespace vsl
 		}
 
 		bool CreateFromFile(Device& owner, const std::string& filename);
-		bool CreateFromMemory(Device& owner, const void* pBin, size_t size);
+		// hash は内容のハッシュ、0の場合は内部で計算する
+		bool CreateFromMemory(Device& owner, const void* pBin, size_t size, uint64_t hash = 0);
+		bool CreateFromBundle(Device& owner, const ShaderBundle& bundle, const std::string& name);
 
 		void Destroy();
 
 		// getter
 		vk::ShaderModule& GetModule() { return module_; }
 
+		// リフレクション情報
+		vk::ShaderStageFlagBits						GetStage() const				{ return stage_; }
+		const std::string&							GetEntryPoint() const			{ return entryPoint_; }
+		const std::vector<ShaderResourceBinding>&	GetBindings() const				{ return bindings_; }
+		uint32_t									GetPushConstantSize() const		{ return pushConstantSize_; }
+		const std::array<uint32_t, 3>&				GetLocalSize() const			{ return localSize_; }
+		// local_size_x_id などで指定された場合のスペシャライゼーション定数ID
+		const std::array<uint32_t, 3>&				GetLocalSizeSpecIds() const		{ return localSizeSpecIds_; }
+
+	private:
+		bool Reflect(const uint32_t* pCode, size_t wordCount);
+
 	private:
 		Device*				pOwner_{ nullptr };
 		vk::ShaderModule	module_;
+
+		vk::ShaderStageFlagBits				stage_{ vk::ShaderStageFlagBits::eVertex };
+		std::string							entryPoint_;
+		std::vector<ShaderResourceBinding>	bindings_;
+		uint32_t							pushConstantSize_{ 0 };
+		std::array<uint32_t, 3>				localSize_{ { 1, 1, 1 } };
+		std::array<uint32_t, 3>				localSizeSpecIds_{ { kInvalidSpecId, kInvalidSpecId, kInvalidSpecId } };
 	};	// class Shader
 
 }	// namespace vsl
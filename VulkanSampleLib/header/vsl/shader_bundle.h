@@ -0,0 +1,75 @@
+﻿#pragma once
+
+#include <stdint.h>
+#include <string>
+#include <vsl/mapped_file.h>
+
+
+namespace vsl
+{
+	//----
+	// シェーダバンドルのファイルフォーマット
+	// [ヘッダ][エントリ x entryCount (名前順)][名前文字列 (終端0あり)][SPIR-V (4byte境界)]...
+	// オフセットはすべてファイル先頭からのバイト数
+	static const uint32_t	kShaderBundleMagic = 0x424c5356;		// 'VSLB'
+	static const uint32_t	kShaderBundleVersion = 1;
+	static const uint32_t	kShaderBundleAlignment = 4;
+
+	struct ShaderBundleHeader
+	{
+		uint32_t	magic;
+		uint32_t	version;
+		uint32_t	entryCount;
+		uint32_t	reserved;
+	};	// struct ShaderBundleHeader
+
+	struct ShaderBundleEntry
+	{
+		uint64_t	contentHash;		// SPIR-Vの HashBytes()
+		uint32_t	nameOffset;
+		uint32_t	nameLength;			// 終端0を含まない
+		uint32_t	dataOffset;
+		uint32_t	dataSize;
+	};	// struct ShaderBundleEntry
+
+	//----
+	// シェーダバンドルの読み込み
+	// ファイルはメモリマップされ、SPIR-Vはコピーせずに直接参照する
+	class ShaderBundle
+	{
+	public:
+		struct Blob
+		{
+			const uint32_t*	pCode{ nullptr };
+			size_t			size{ 0 };
+			uint64_t		hash{ 0 };
+		};	// struct Blob
+
+	public:
+		ShaderBundle()
+		{}
+		~ShaderBundle()
+		{
+			Close();
+		}
+
+		bool Open(const std::string& filename);
+		void Close();
+
+		bool Find(const std::string& name, Blob& outBlob) const;
+
+		// getter
+		uint32_t	GetCount() const	{ return pHeader_ ? pHeader_->entryCount : 0; }
+		const char*	GetName(uint32_t index) const;
+		bool		IsOpen() const		{ return pHeader_ != nullptr; }
+
+	private:
+		MappedFile					file_;
+		const ShaderBundleHeader*	pHeader_{ nullptr };
+		const ShaderBundleEntry*	pEntries_{ nullptr };
+	};	// class ShaderBundle
+
+}	// namespace vsl
+
+
+//	EOF
@@ -0,0 +1,60 @@
+﻿#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <vulkan/vulkan.h>
+#include <vulkan/vulkan.hpp>
+
+
+namespace vsl
+{
+	class Device;
+
+	//----
+	// シェーダモジュールキャッシュ
+	// SPIR-Vの内容のハッシュをキーに、同じ内容のモジュールは1つだけ生成する
+	// Acquire() と Release() は対にして呼び出すこと、参照がなくなったモジュールは破棄される
+	class ShaderModuleCache
+	{
+	public:
+		ShaderModuleCache()
+		{}
+		~ShaderModuleCache()
+		{
+			Destroy();
+		}
+
+		bool Initialize(Device& owner);
+		void Destroy();
+
+		// hash に0を指定した場合は内部で計算する
+		vk::ShaderModule Acquire(const void* pCode, size_t size, uint64_t hash = 0);
+		void Release(const vk::ShaderModule& module);
+
+		// getter
+		size_t		GetModuleCount() const;
+		uint32_t	GetHitCount() const		{ return hitCount_.load(std::memory_order_relaxed); }
+
+	private:
+		struct Entry
+		{
+			std::vector<uint8_t>	code;		// ハッシュ衝突時の比較用
+			vk::ShaderModule		module;
+			uint32_t				refCount{ 0 };
+		};	// struct Entry
+
+	private:
+		Device*		pOwner_{ nullptr };
+
+		std::unordered_map<uint64_t, std::vector<Entry>>	entries_;
+		std::unordered_map<VkShaderModule, uint64_t>		moduleHashes_;
+		std::atomic<uint32_t>	hitCount_{ 0 };		// ロックを取らずに読めるようにする
+		mutable std::mutex	mutex_;
+	};	// class ShaderModuleCache
+
+}	// namespace vsl
+
+
+//	EOF
@@ -12,12 +12,16 @@
  * This code is provided without any warranty.  The copyright holder is
  * not liable for anything bad that might happen as a result of the
  * code.
+ *
+ * MODIFIED for VulkanSample: added tga_read_from_memory() which decodes
+ * from a caller-provided buffer (e.g. a memory-mapped file).
  * -------------------------------------------------------------------------*/
 
 #ifndef _TARGA_H_
 #define _TARGA_H_
 
 #include <stdio.h>
+#include <stddef.h>
 #ifndef _MSC_VER
 # include <inttypes.h>
 #else /* MSVC */
@@ -143,6 +147,8 @@ const char *tga_error(const tga_result errcode);
 /* Load/save ---------------------------------------------------------------*/
 tga_result tga_read(tga_image *dest, const char *filename);
 tga_result tga_read_from_FILE(tga_image *dest, FILE *fp);
+tga_result tga_read_from_memory(tga_image *dest, const uint8_t *data,
+    const size_t size);
 tga_result tga_write(const char *filename, const tga_image *src);
 tga_result tga_write_to_FILE(FILE *fp, const tga_image *src);
 
@@ -0,0 +1,66 @@
+﻿#pragma once
+
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan.h>
+#include <vulkan/vulkan.hpp>
+
+
+namespace vsl
+{
+	class Device;
+	class Buffer;
+	class Image;
+
+	//----
+	// 複数テクスチャの一括読み込み
+	// ファイル読み込みとデコードはワーカースレッドで行い、
+	// 転送コマンドは Flush でまとめて1つのコマンドバッファに積む
+	class TextureLoader
+	{
+	public:
+		TextureLoader()
+		{}
+		~TextureLoader()
+		{
+			Clear();
+		}
+
+		bool Initialize(Device& owner);
+
+		// 読み込みリクエスト
+		// 返り値のfutureはデコード完了時に成否が確定する
+		std::shared_future<bool> Load(Image& dst, const std::string& filename);
+
+		// 全てのデコード完了を待ち、Stagingバッファへ書き込んで転送コマンドを積む
+		// stagingはコマンドバッファの実行完了まで破棄しないこと
+		bool Flush(vk::CommandBuffer& cmdBuff, Buffer& staging);
+
+		// 未処理のリクエストを破棄する
+		void Clear();
+
+		// getter
+		size_t	GetPendingCount() const	{ return requests_.size(); }
+
+	private:
+		struct DecodedImage;
+
+		struct Request
+		{
+			Image*							pImage{ nullptr };
+			std::shared_ptr<DecodedImage>	decoded;
+			std::shared_future<bool>		result;
+			vk::DeviceSize					offset{ 0 };
+		};	// struct Request
+
+	private:
+		Device*					pOwner_{ nullptr };
+		std::vector<Request>	requests_;
+	};	// class TextureLoader
+
+}	// namespace vsl
+
+
+//	EOF
@@ -0,0 +1,69 @@
+﻿#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace vsl
+{
+	//----
+	// ワーカースレッドプール
+	// Submitしたジョブはいずれかのワーカーで実行され、結果はfutureで受け取る
+	class ThreadPool
+	{
+	public:
+		static const int	kNotWorkerThread = -1;
+
+	public:
+		ThreadPool()
+		{}
+		~ThreadPool()
+		{
+			Terminate();
+		}
+
+		// threadCount が 0 の場合は論理コア数 - 1 (最低1)
+		bool Initialize(uint32_t threadCount = 0);
+		void Terminate();
+
+		template <typename Func>
+		std::future<typename std::result_of<Func()>::type> Submit(Func&& func)
+		{
+			typedef typename std::result_of<Func()>::type ResultType;
+			auto task = std::make_shared<std::packaged_task<ResultType()>>(std::forward<Func>(func));
+			std::future<ResultType> ret = task->get_future();
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				jobs_.push_back([task]() { (*task)(); });
+			}
+			cond_.notify_one();
+			return ret;
+		}
+
+		// getter
+		uint32_t	GetThreadCount() const	{ return static_cast<uint32_t>(threads_.size()); }
+
+		// 現在のスレッドのワーカー番号 (ワーカー以外は kNotWorkerThread)
+		static int	GetCurrentWorkerIndex();
+
+	private:
+		void WorkerMain(int index);
+
+	private:
+		std::vector<std::thread>			threads_;
+		std::deque<std::function<void()>>	jobs_;
+		std::mutex							mutex_;
+		std::condition_variable				cond_;
+		bool								terminate_{ false };
+	};	// class ThreadPool
+
+}	// namespace vsl
+
+
+//	EOF
@@ -0,0 +1,158 @@
+﻿#include <vsl/api_counters.h>
+#include <algorithm>
+#include <cstdio>
+
+
+namespace vsl
+{
+	namespace
+	{
+		static const char* kCounterNames[] = {
+			"Draw",
+			"Dispatch",
+			"PipelineBarrier",
+			"BindPipeline",
+			"BindDescriptorSets",
+			"UpdateDescriptorSets",
+			"DescriptorWrite",
+			"DescriptorAllocate",
+			"QueueSubmit",
+			"ObjectCreate",
+			"ObjectDestroy",
+		};
+		static_assert(sizeof(kCounterNames) / sizeof(kCounterNames[0]) == ApiCounter::Max, "counter name count mismatch");
+	}	// namespace
+
+	//----
+	ApiCounters& ApiCounters::Instance()
+	{
+		static ApiCounters sInstance;
+		return sInstance;
+	}
+
+	//----
+	ApiCounters::ApiCounters()
+		: history_(kDefaultHistoryLength)
+	{
+		for (auto& c : counts_)
+		{
+			c.store(0, std::memory_order_relaxed);
+		}
+	}
+
+	//----
+	void ApiCounters::EndFrame()
+	{
+		ApiCounterFrame frame;
+		frame.frameIndex = frameIndex_++;
+		for (uint32_t i = 0; i < ApiCounter::Max; i++)
+		{
+			frame.values[i] = counts_[i].exchange(0, std::memory_order_relaxed);
+			totals_[i] += frame.values[i];
+		}
+		lastFrame_ = frame;
+
+		// 履歴から押し出されるフレームが最大値だった計数は、残りの履歴から求め直す
+		uint32_t historyLength = static_cast<uint32_t>(history_.size());
+		bool isEvicted[ApiCounter::Max]{};
+		if (historyCount_ == historyLength)
+		{
+			const ApiCounterFrame& oldest = history_[historyIndex_];
+			for (uint32_t i = 0; i < ApiCounter::Max; i++)
+			{
+				isEvicted[i] = (oldest.values[i] != 0) && (oldest.values[i] >= maxFrame_.values[i]);
+			}
+		}
+
+		history_[historyIndex_] = frame;
+		historyIndex_ = (historyIndex_ + 1) % historyLength;
+		historyCount_ = (std::min)(historyCount_ + 1, historyLength);
+
+		for (uint32_t i = 0; i < ApiCounter::Max; i++)
+		{
+			if (!isEvicted[i])
+			{
+				maxFrame_.values[i] = (std::max)(maxFrame_.values[i], frame.values[i]);
+				continue;
+			}
+			maxFrame_.values[i] = 0;
+			for (uint32_t h = 0; h < historyCount_; h++)
+			{
+				maxFrame_.values[i] = (std::max)(maxFrame_.values[i], history_[h].values[i]);
+			}
+		}
+	}
+
+	//----
+	void ApiCounters::Clear()
+	{
+		lastFrame_ = ApiCounterFrame();
+		maxFrame_ = ApiCounterFrame();
+		historyIndex_ = 0;
+		historyCount_ = 0;
+	}
+
+	//----
+	std::string ApiCounters::ToText() const
+	{
+		std::string ret;
+		char text[256];
+		sprintf_s(text, "API counters (frame %llu)\n%-22s %10s %10s %12s\n",
+			static_cast<unsigned long long>(lastFrame_.frameIndex), "Counter", "last", "max", "total");
+		ret += text;
+		for (uint32_t i = 0; i < ApiCounter::Max; i++)
+		{
+			sprintf_s(text, "%-22s %10llu %10llu %12llu\n", kCounterNames[i],
+				static_cast<unsigned long long>(lastFrame_.values[i]),
+				static_cast<unsigned long long>(maxFrame_.values[i]),
+				static_cast<unsigned long long>(totals_[i]));
+			ret += text;
+		}
+		sprintf_s(text, "Live objects : %lld\n", static_cast<long long>(GetLiveObjectCount()));
+		ret += text;
+		return ret;
+	}
+
+	//----
+	bool ApiCounters::ExportCsv(const char* filename) const
+	{
+		FILE* fp = nullptr;
+		if (fopen_s(&fp, filename, "w") != 0)
+		{
+			return false;
+		}
+
+		fprintf(fp, "frame");
+		for (uint32_t i = 0; i < ApiCounter::Max; i++)
+		{
+			fprintf(fp, ",%s", kCounterNames[i]);
+		}
+		fprintf(fp, "\n");
+
+		// 古いフレームから順に出力する
+		uint32_t length = static_cast<uint32_t>(history_.size());
+		uint32_t start = (historyIndex_ + length - historyCount_) % length;
+		for (uint32_t n = 0; n < historyCount_; n++)
+		{
+			const ApiCounterFrame& frame = history_[(start + n) % length];
+			fprintf(fp, "%llu", static_cast<unsigned long long>(frame.frameIndex));
+			for (uint32_t i = 0; i < ApiCounter::Max; i++)
+			{
+				fprintf(fp, ",%llu", static_cast<unsigned long long>(frame.values[i]));
+			}
+			fprintf(fp, "\n");
+		}
+		fclose(fp);
+		return true;
+	}
+
+	//----
+	const char* ApiCounters::GetCounterName(ApiCounter::Type type)
+	{
+		return (type < ApiCounter::Max) ? kCounterNames[type] : "";
+	}
+
+}	// namespace vsl
+
+
+//	EOF
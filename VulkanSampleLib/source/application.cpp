@@ -1,4 +1,6 @@
 ﻿#include <vsl/application.h>
+#include <chrono>
+#include <cstdio>
 #include <iostream>
 #include <sstream>
 #include <windowsx.h>
@@ -154,6 +156,10 @@ namespace vsl
 		screenWidth_ = screenWidth;
 		screenHeight_ = screenHeight;
 		pInputData_ = &inputData_;
+		inputData_.pFrameStats_ = &frameStats_;
+		frameStats_.Initialize();
+		captureTimes_.clear();
+		captureTimes_.reserve(captureFrameCount_);
 
 		// ウィンドウの初期化
 		if (!InitializeWindow())
@@ -172,9 +178,46 @@ namespace vsl
 			return;
 		}
 
+		VSL_CPU_THREAD_NAME("Main");
+		auto prevTime = std::chrono::steady_clock::now();
+		bool isFirstFrame = true;
 		while (true)
 		{
-			PollEvents();
+			VSL_CPU_SCOPE("Frame");
+
+			// 前フレームのAPI呼び出し回数を確定する
+			ApiCounters::Instance().EndFrame();
+
+			// フレーム時間の計測
+			// 最初のフレームは初期化の時間を含むので統計に入れない
+			auto currentTime = std::chrono::steady_clock::now();
+			double frameMilliseconds = std::chrono::duration<double, std::milli>(currentTime - prevTime).count();
+			prevTime = currentTime;
+			if (isFirstFrame)
+			{
+				isFirstFrame = false;
+				inputData_.deltaTime_ = 0.0f;
+			}
+			else
+			{
+				frameStats_.AddFrame(frameMilliseconds);
+				inputData_.deltaTime_ = static_cast<float>(frameMilliseconds * 0.001);
+
+				if (captureFrameCount_ > 0)
+				{
+					captureTimes_.push_back(frameMilliseconds);
+					if (captureTimes_.size() >= captureFrameCount_)
+					{
+						WriteFrameCapture();
+						break;
+					}
+				}
+			}
+
+			{
+				VSL_CPU_SCOPE("PollEvents");
+				PollEvents();
+			}
 
 			if (closeRequest_)
 			{
@@ -182,6 +225,7 @@ namespace vsl
 			}
 
 			// アプリごとのループ処理
+			VSL_CPU_SCOPE("Loop");
 			if (!loopFunc_(device_, inputData_))
 			{
 				break;
@@ -260,6 +304,40 @@ namespace vsl
 		return true;
 	}
 
+	//----
+	// 計測したフレーム時間をCSVに書き出す
+	bool Application::WriteFrameCapture()
+	{
+		FILE* fp = nullptr;
+		if (fopen_s(&fp, captureFilename_.c_str(), "w") != 0 || !fp)
+		{
+			return false;
+		}
+
+		fprintf(fp, "frame,milliseconds\n");
+		for (size_t i = 0; i < captureTimes_.size(); i++)
+		{
+			fprintf(fp, "%u,%.4f\n", static_cast<uint32_t>(i), captureTimes_[i]);
+		}
+		fclose(fp);
+
+		// 全フレームの統計を出力する
+		FrameStats stats;
+		stats.Initialize(static_cast<uint32_t>(captureTimes_.size()));
+		for (auto t : captureTimes_)
+		{
+			stats.AddFrame(t);
+		}
+		auto& summary = stats.GetSummary();
+		char text[256];
+		sprintf_s(text, "Frame capture : %u frames, avg %.3f ms, p50 %.3f ms, p95 %.3f ms, p99 %.3f ms, max %.3f ms\n",
+			summary.sampleCount, summary.averageMilliseconds, summary.p50Milliseconds,
+			summary.p95Milliseconds, summary.p99Milliseconds, summary.maxMilliseconds);
+		OutputDebugStringA(text);
+
+		return true;
+	}
+
 }	// namespace vsl
 
 
@@ -9,6 +9,7 @@ namespace vsl
 	{
 		pOwner_ = &owner;
 		size_ = size;
+		generation_ = NextResourceGeneration();
 
 		vk::Device& device = owner.GetDevice();
 
@@ -17,6 +18,7 @@ namespace vsl
 		createInfo.size = size;
 		createInfo.usage = usage;
 		buffer_ = device.createBuffer(createInfo);
+		VSL_API_COUNT(ObjectCreate);
 		if (!buffer_)
 		{
 			return false;
@@ -28,6 +30,7 @@ namespace vsl
 		memAlloc.allocationSize = memReqs.size;
 		memAlloc.memoryTypeIndex = owner.GetMemoryTypeIndex(memReqs.memoryTypeBits, memProp);
 		devMem_ = device.allocateMemory(memAlloc);
+		VSL_API_COUNT(ObjectCreate);
 		if (!devMem_)
 		{
 			return false;
@@ -78,6 +81,12 @@ namespace vsl
 		return InitializeCommon(owner, size, vk::BufferUsageFlagBits::eUniformBuffer | vk::BufferUsageFlagBits::eTransferDst, vk::MemoryPropertyFlagBits::eHostVisible, pData);
 	}
 
+	//----
+	bool Buffer::InitializeAsStorageBuffer(Device& owner, size_t size)
+	{
+		return InitializeCommon(owner, size, vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferSrc | vk::BufferUsageFlagBits::eTransferDst, vk::MemoryPropertyFlagBits::eDeviceLocal);
+	}
+
 	//----
 	void Buffer::Destroy()
 	{
@@ -85,11 +94,12 @@ namespace vsl
 		{
 			vk::Device& device = pOwner_->GetDevice();
 			if (view_) { device.destroyBufferView(view_); view_ = vk::BufferView(); }
-			if (buffer_) { device.destroyBuffer(buffer_); buffer_ = vk::Buffer(); }
-			if (devMem_) { device.freeMemory(devMem_); devMem_ = vk::DeviceMemory(); }
+			if (buffer_) { device.destroyBuffer(buffer_); VSL_API_COUNT(ObjectDestroy); buffer_ = vk::Buffer(); }
+			if (devMem_) { device.freeMemory(devMem_); VSL_API_COUNT(ObjectDestroy); devMem_ = vk::DeviceMemory(); }
 		}
 		pOwner_ = nullptr;
 		size_ = 0;
+		generation_ = 0;
 	}
 
 	//----
@@ -0,0 +1,132 @@
+﻿#include <vsl/command_bundle.h>
+#include <vsl/device.h>
+
+
+namespace vsl
+{
+	//----
+	bool CommandBundleCache::Initialize(Device& owner, vk::CommandPool pool)
+	{
+		Destroy();
+
+		if (!pool)
+		{
+			return false;
+		}
+		pOwner_ = &owner;
+		pool_ = pool;
+		return true;
+	}
+
+	//----
+	void CommandBundleCache::Destroy()
+	{
+		if (pOwner_)
+		{
+			for (auto& bundle : bundles_)
+			{
+				pOwner_->GetDevice().freeCommandBuffers(pool_, bundle.second.cmdBuffer);
+				VSL_API_COUNT(ObjectDestroy);
+			}
+		}
+		bundles_.clear();
+		stats_ = CommandBundleStats();
+		pool_ = vk::CommandPool();
+		pOwner_ = nullptr;
+	}
+
+	//----
+	vk::CommandBuffer CommandBundleCache::Get(const std::string& name, const CommandBundleDeps& deps, const RecordFunc& record)
+	{
+		return GetCommon(name, vk::CommandBufferLevel::ePrimary, deps.GetIds(), nullptr, record);
+	}
+
+	//----
+	vk::CommandBuffer CommandBundleCache::GetSecondary(const std::string& name, const CommandBundleDeps& deps, const vk::CommandBufferInheritanceInfo& inheritance, const RecordFunc& record)
+	{
+		CommandBundleDeps allDeps = deps;
+		allDeps.AddHandle(inheritance.renderPass)
+			.AddHandle(inheritance.framebuffer);
+		return GetCommon(name, vk::CommandBufferLevel::eSecondary, allDeps.GetIds(), &inheritance, record);
+	}
+
+	//----
+	void CommandBundleCache::Invalidate(const std::string& name)
+	{
+		auto it = bundles_.find(name);
+		if (it != bundles_.end())
+		{
+			it->second.isValid = false;
+		}
+	}
+
+	//----
+	void CommandBundleCache::InvalidateAll()
+	{
+		for (auto& bundle : bundles_)
+		{
+			bundle.second.isValid = false;
+		}
+	}
+
+	//----
+	vk::CommandBuffer CommandBundleCache::GetCommon(const std::string& name, vk::CommandBufferLevel level, const std::vector<uint64_t>& deps, const vk::CommandBufferInheritanceInfo* pInheritance, const RecordFunc& record)
+	{
+		if (!pOwner_)
+		{
+			return vk::CommandBuffer();
+		}
+
+		// 初回はコマンドバッファを確保する
+		auto it = bundles_.find(name);
+		if (it == bundles_.end())
+		{
+			vk::CommandBufferAllocateInfo allocInfo;
+			allocInfo.commandPool = pool_;
+			allocInfo.level = level;
+			allocInfo.commandBufferCount = 1;
+			std::vector<vk::CommandBuffer> cmdBuffers = pOwner_->GetDevice().allocateCommandBuffers(allocInfo);
+			VSL_API_COUNT(ObjectCreate);
+			if (cmdBuffers.empty())
+			{
+				return vk::CommandBuffer();
+			}
+			it = bundles_.insert(std::make_pair(name, Bundle())).first;
+			it->second.cmdBuffer = cmdBuffers[0];
+		}
+
+		Bundle& bundle = it->second;
+		if (bundle.isValid && (bundle.deps == deps))
+		{
+			stats_.reuseCount++;
+			return bundle.cmdBuffer;
+		}
+
+		// 記録し直す
+		bundle.isValid = false;
+		bundle.cmdBuffer.reset(vk::CommandBufferResetFlags());
+
+		vk::CommandBufferBeginInfo beginInfo;
+		if (pInheritance)
+		{
+			beginInfo.flags = vk::CommandBufferUsageFlagBits::eRenderPassContinue;
+			beginInfo.pInheritanceInfo = pInheritance;
+		}
+		bundle.cmdBuffer.begin(&beginInfo);
+		bool ret = record(bundle.cmdBuffer);
+		bundle.cmdBuffer.end();
+		if (!ret)
+		{
+			return vk::CommandBuffer();
+		}
+
+		bundle.deps = deps;
+		bundle.isValid = true;
+		stats_.recordCount++;
+		return bundle.cmdBuffer;
+	}
+
+}	// namespace vsl
+
+
+//	EOF
@@ -0,0 +1,790 @@
+﻿#include <vsl/cpu_fft.h>
+#include <vsl/thread_pool.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <future>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define VSL_CPU_FFT_SSE		1
+#include <emmintrin.h>
+#endif
+// MSVC はコンパイルオプションなしでAVX2の組み込み関数を使用できる
+#if defined(VSL_CPU_FFT_SSE) && (defined(_MSC_VER) || (defined(__AVX2__) && defined(__FMA__)))
+#define VSL_CPU_FFT_AVX2	1
+#include <immintrin.h>
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+
+namespace vsl
+{
+	namespace
+	{
+		static const double kPi = 3.14159265358979323846;
+
+		//----
+		bool IsPowerOfTwo(uint32_t v)
+		{
+			return (v >= 2) && ((v & (v - 1)) == 0);
+		}
+
+		//----
+		// packHalf2x16 と同じ丸め(最近接偶数)
+		uint16_t FloatToHalf(float f)
+		{
+			uint32_t bits;
+			memcpy(&bits, &f, sizeof(bits));
+			uint32_t sign = (bits >> 16) & 0x8000;
+			int32_t exponent = static_cast<int32_t>((bits >> 23) & 0xff) - 127 + 15;
+			uint32_t mantissa = bits & 0x7fffff;
+
+			if (((bits >> 23) & 0xff) == 0xff)
+			{
+				// inf, nan
+				return static_cast<uint16_t>(sign | 0x7c00 | (mantissa ? 0x200 : 0));
+			}
+			if (exponent >= 0x1f)
+			{
+				return static_cast<uint16_t>(sign | 0x7c00);
+			}
+			if (exponent <= 0)
+			{
+				// 非正規化数
+				if (exponent < -10)
+				{
+					return static_cast<uint16_t>(sign);
+				}
+				mantissa |= 0x800000;
+				uint32_t shift = static_cast<uint32_t>(14 - exponent);
+				uint32_t half = mantissa >> shift;
+				uint32_t rest = mantissa & ((1u << shift) - 1);
+				uint32_t halfway = 1u << (shift - 1);
+				if ((rest > halfway) || ((rest == halfway) && (half & 1)))
+				{
+					half++;
+				}
+				return static_cast<uint16_t>(sign | half);
+			}
+			uint32_t half = (static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13);
+			uint32_t rest = mantissa & 0x1fff;
+			if ((rest > 0x1000) || ((rest == 0x1000) && (half & 1)))
+			{
+				// 繰り上がりで指数が増えても正しい値になる
+				half++;
+			}
+			return static_cast<uint16_t>(sign | half);
+		}
+
+		//----
+		float HalfToFloat(uint16_t h)
+		{
+			uint32_t sign = static_cast<uint32_t>(h & 0x8000) << 16;
+			uint32_t exponent = (h >> 10) & 0x1f;
+			uint32_t mantissa = h & 0x3ff;
+			uint32_t bits;
+			if (exponent == 0x1f)
+			{
+				bits = sign | 0x7f800000 | (mantissa << 13);
+			}
+			else if (exponent == 0)
+			{
+				if (mantissa == 0)
+				{
+					bits = sign;
+				}
+				else
+				{
+					// 非正規化数は正規化してから変換する
+					exponent = 127 - 15 + 1;
+					while (!(mantissa & 0x400))
+					{
+						mantissa <<= 1;
+						exponent--;
+					}
+					bits = sign | (exponent << 23) | ((mantissa & 0x3ff) << 13);
+				}
+			}
+			else
+			{
+				bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+			}
+			float ret;
+			memcpy(&ret, &bits, sizeof(ret));
+			return ret;
+		}
+
+		//----
+		// SIMD幅ごとの演算
+		// MulAdd は a * b + c、MulSub は a * b - c
+		struct ScalarOps
+		{
+			typedef float Type;
+			static const uint32_t kWidth = 1;
+
+			static Type Load(const float* p)				{ return *p; }
+			static void Store(float* p, Type v)				{ *p = v; }
+			static Type Set(float v)						{ return v; }
+			static Type Add(Type a, Type b)					{ return a + b; }
+			static Type Sub(Type a, Type b)					{ return a - b; }
+			static Type Mul(Type a, Type b)					{ return a * b; }
+			static Type MulAdd(Type a, Type b, Type c)		{ return a * b + c; }
+			static Type MulSub(Type a, Type b, Type c)		{ return a * b - c; }
+		};	// struct ScalarOps
+
+#if defined(VSL_CPU_FFT_SSE)
+		struct SseOps
+		{
+			typedef __m128 Type;
+			static const uint32_t kWidth = 4;
+
+			static Type Load(const float* p)				{ return _mm_loadu_ps(p); }
+			static void Store(float* p, Type v)				{ _mm_storeu_ps(p, v); }
+			static Type Set(float v)						{ return _mm_set1_ps(v); }
+			static Type Add(Type a, Type b)					{ return _mm_add_ps(a, b); }
+			static Type Sub(Type a, Type b)					{ return _mm_sub_ps(a, b); }
+			static Type Mul(Type a, Type b)					{ return _mm_mul_ps(a, b); }
+			static Type MulAdd(Type a, Type b, Type c)		{ return _mm_add_ps(_mm_mul_ps(a, b), c); }
+			static Type MulSub(Type a, Type b, Type c)		{ return _mm_sub_ps(_mm_mul_ps(a, b), c); }
+		};	// struct SseOps
+#endif
+
+#if defined(VSL_CPU_FFT_AVX2)
+		struct Avx2Ops
+		{
+			typedef __m256 Type;
+			static const uint32_t kWidth = 8;
+
+			static Type Load(const float* p)				{ return _mm256_loadu_ps(p); }
+			static void Store(float* p, Type v)				{ _mm256_storeu_ps(p, v); }
+			static Type Set(float v)						{ return _mm256_set1_ps(v); }
+			static Type Add(Type a, Type b)					{ return _mm256_add_ps(a, b); }
+			static Type Sub(Type a, Type b)					{ return _mm256_sub_ps(a, b); }
+			static Type Mul(Type a, Type b)					{ return _mm256_mul_ps(a, b); }
+			static Type MulAdd(Type a, Type b, Type c)		{ return _mm256_fmadd_ps(a, b, c); }
+			static Type MulSub(Type a, Type b, Type c)		{ return _mm256_fmsub_ps(a, b, c); }
+		};	// struct Avx2Ops
+#endif
+
+		//----
+		// (wr + i wi) * (xr + i xi)
+		template <typename Ops>
+		inline void ComplexMul(typename Ops::Type wr, typename Ops::Type wi, typename Ops::Type xr, typename Ops::Type xi, typename Ops::Type& rr, typename Ops::Type& ri)
+		{
+			rr = Ops::MulSub(wr, xr, Ops::Mul(wi, xi));
+			ri = Ops::MulAdd(wr, xi, Ops::Mul(wi, xr));
+		}
+
+		//----
+		// 半分の幅 h の radix-2 段
+		template <typename Ops>
+		void Radix2Stage(float* pReal, float* pImag, uint32_t length, uint32_t h, const float* pCos, const float* pSin)
+		{
+			typedef typename Ops::Type V;
+			for (uint32_t base = 0; base < length; base += h * 2)
+			{
+				for (uint32_t j = 0; j < h; j += Ops::kWidth)
+				{
+					uint32_t p0 = base + j;
+					uint32_t p1 = p0 + h;
+					V wr = Ops::Load(pCos + h + j), wi = Ops::Load(pSin + h + j);
+					V x0r = Ops::Load(pReal + p0), x0i = Ops::Load(pImag + p0);
+					V tr, ti;
+					ComplexMul<Ops>(wr, wi, Ops::Load(pReal + p1), Ops::Load(pImag + p1), tr, ti);
+					Ops::Store(pReal + p0, Ops::Add(x0r, tr));
+					Ops::Store(pImag + p0, Ops::Add(x0i, ti));
+					Ops::Store(pReal + p1, Ops::Sub(x0r, tr));
+					Ops::Store(pImag + p1, Ops::Sub(x0i, ti));
+				}
+			}
+		}
+
+		//----
+		// 半分の幅 h と 2h の radix-2 段を1回の読み書きで処理する
+		template <typename Ops>
+		void Radix4Stage(float* pReal, float* pImag, uint32_t length, uint32_t h, const float* pCos, const float* pSin)
+		{
+			typedef typename Ops::Type V;
+			for (uint32_t base = 0; base < length; base += h * 4)
+			{
+				for (uint32_t j = 0; j < h; j += Ops::kWidth)
+				{
+					uint32_t p0 = base + j;
+					uint32_t p1 = p0 + h;
+					uint32_t p2 = p1 + h;
+					uint32_t p3 = p2 + h;
+					V w1r = Ops::Load(pCos + h + j), w1i = Ops::Load(pSin + h + j);
+					V w2r = Ops::Load(pCos + h * 2 + j), w2i = Ops::Load(pSin + h * 2 + j);
+					V w3r = Ops::Load(pCos + h * 3 + j), w3i = Ops::Load(pSin + h * 3 + j);
+
+					// 前半の段
+					V x0r = Ops::Load(pReal + p0), x0i = Ops::Load(pImag + p0);
+					V x2r = Ops::Load(pReal + p2), x2i = Ops::Load(pImag + p2);
+					V t1r, t1i, t3r, t3i;
+					ComplexMul<Ops>(w1r, w1i, Ops::Load(pReal + p1), Ops::Load(pImag + p1), t1r, t1i);
+					ComplexMul<Ops>(w1r, w1i, Ops::Load(pReal + p3), Ops::Load(pImag + p3), t3r, t3i);
+					V ar = Ops::Add(x0r, t1r), ai = Ops::Add(x0i, t1i);
+					V br = Ops::Sub(x0r, t1r), bi = Ops::Sub(x0i, t1i);
+					V cr = Ops::Add(x2r, t3r), ci = Ops::Add(x2i, t3i);
+					V dr = Ops::Sub(x2r, t3r), di = Ops::Sub(x2i, t3i);
+
+					// 後半の段
+					V t2r, t2i, t4r, t4i;
+					ComplexMul<Ops>(w2r, w2i, cr, ci, t2r, t2i);
+					ComplexMul<Ops>(w3r, w3i, dr, di, t4r, t4i);
+					Ops::Store(pReal + p0, Ops::Add(ar, t2r));
+					Ops::Store(pImag + p0, Ops::Add(ai, t2i));
+					Ops::Store(pReal + p2, Ops::Sub(ar, t2r));
+					Ops::Store(pImag + p2, Ops::Sub(ai, t2i));
+					Ops::Store(pReal + p1, Ops::Add(br, t4r));
+					Ops::Store(pImag + p1, Ops::Add(bi, t4i));
+					Ops::Store(pReal + p3, Ops::Sub(br, t4r));
+					Ops::Store(pImag + p3, Ops::Sub(bi, t4i));
+				}
+			}
+		}
+
+		//----
+		template <typename Ops>
+		void Scale(float* pReal, float* pImag, uint32_t length, float scale)
+		{
+			typename Ops::Type s = Ops::Set(scale);
+			for (uint32_t i = 0; i < length; i += Ops::kWidth)
+			{
+				Ops::Store(pReal + i, Ops::Mul(Ops::Load(pReal + i), s));
+				Ops::Store(pImag + i, Ops::Mul(Ops::Load(pImag + i), s));
+			}
+		}
+
+		//----
+		// 1次元FFT
+		// 段の幅がSIMD幅に満たない間はスカラーで処理する
+		template <typename Ops>
+		void TransformLine(float* pReal, float* pImag, uint32_t length, uint32_t log2, const uint32_t* pBitReverse, const float* pCos, const float* pSin, float scale)
+		{
+			for (uint32_t i = 0; i < length; i++)
+			{
+				uint32_t r = pBitReverse[i];
+				if (i < r)
+				{
+					std::swap(pReal[i], pReal[r]);
+					std::swap(pImag[i], pImag[r]);
+				}
+			}
+
+			uint32_t h = 1;
+			if (log2 & 1)
+			{
+				Radix2Stage<ScalarOps>(pReal, pImag, length, h, pCos, pSin);
+				h *= 2;
+			}
+			for (; h < length; h *= 4)
+			{
+				if (h >= Ops::kWidth)
+				{
+					Radix4Stage<Ops>(pReal, pImag, length, h, pCos, pSin);
+				}
+				else
+				{
+					Radix4Stage<ScalarOps>(pReal, pImag, length, h, pCos, pSin);
+				}
+			}
+
+			if (scale != 1.0f)
+			{
+				if (length >= Ops::kWidth)
+				{
+					Scale<Ops>(pReal, pImag, length, scale);
+				}
+				else
+				{
+					Scale<ScalarOps>(pReal, pImag, length, scale);
+				}
+			}
+		}
+
+		//----
+		// 隣り合う kColumnBlock 列をまとめて変換する
+		// データは [length][kColumnBlock] に並べ、SIMDの各要素が別の列を担当する
+		static const uint32_t kColumnBlock = 16;
+
+		template <typename Ops>
+		void TransformColumnBlock(float* pReal, float* pImag, uint32_t length, uint32_t log2, const uint32_t* pBitReverse, const float* pCos, const float* pSin, float scale)
+		{
+			typedef typename Ops::Type V;
+			const uint32_t B = kColumnBlock;
+
+			for (uint32_t i = 0; i < length; i++)
+			{
+				uint32_t r = pBitReverse[i];
+				if (i < r)
+				{
+					std::swap_ranges(pReal + i * B, pReal + i * B + B, pReal + r * B);
+					std::swap_ranges(pImag + i * B, pImag + i * B + B, pImag + r * B);
+				}
+			}
+
+			// 回転因子は全ての列で共通なので、要素に展開して使用する
+			uint32_t h = 1;
+			if (log2 & 1)
+			{
+				for (uint32_t base = 0; base < length; base += 2)
+				{
+					float* r0 = pReal + base * B;
+					float* i0 = pImag + base * B;
+					for (uint32_t l = 0; l < B; l += Ops::kWidth)
+					{
+						V x0r = Ops::Load(r0 + l), x0i = Ops::Load(i0 + l);
+						V x1r = Ops::Load(r0 + B + l), x1i = Ops::Load(i0 + B + l);
+						Ops::Store(r0 + l, Ops::Add(x0r, x1r));
+						Ops::Store(i0 + l, Ops::Add(x0i, x1i));
+						Ops::Store(r0 + B + l, Ops::Sub(x0r, x1r));
+						Ops::Store(i0 + B + l, Ops::Sub(x0i, x1i));
+					}
+				}
+				h = 2;
+			}
+			for (; h < length; h *= 4)
+			{
+				for (uint32_t base = 0; base < length; base += h * 4)
+				{
+					for (uint32_t j = 0; j < h; j++)
+					{
+						V w1r = Ops::Set(pCos[h + j]), w1i = Ops::Set(pSin[h + j]);
+						V w2r = Ops::Set(pCos[h * 2 + j]), w2i = Ops::Set(pSin[h * 2 + j]);
+						V w3r = Ops::Set(pCos[h * 3 + j]), w3i = Ops::Set(pSin[h * 3 + j]);
+						size_t p0 = (base + j) * B;
+						size_t p1 = p0 + h * B;
+						size_t p2 = p1 + h * B;
+						size_t p3 = p2 + h * B;
+						for (uint32_t l = 0; l < B; l += Ops::kWidth)
+						{
+							V x0r = Ops::Load(pReal + p0 + l), x0i = Ops::Load(pImag + p0 + l);
+							V x2r = Ops::Load(pReal + p2 + l), x2i = Ops::Load(pImag + p2 + l);
+							V t1r, t1i, t3r, t3i;
+							ComplexMul<Ops>(w1r, w1i, Ops::Load(pReal + p1 + l), Ops::Load(pImag + p1 + l), t1r, t1i);
+							ComplexMul<Ops>(w1r, w1i, Ops::Load(pReal + p3 + l), Ops::Load(pImag + p3 + l), t3r, t3i);
+							V ar = Ops::Add(x0r, t1r), ai = Ops::Add(x0i, t1i);
+							V br = Ops::Sub(x0r, t1r), bi = Ops::Sub(x0i, t1i);
+							V cr = Ops::Add(x2r, t3r), ci = Ops::Add(x2i, t3i);
+							V dr = Ops::Sub(x2r, t3r), di = Ops::Sub(x2i, t3i);
+
+							V t2r, t2i, t4r, t4i;
+							ComplexMul<Ops>(w2r, w2i, cr, ci, t2r, t2i);
+							ComplexMul<Ops>(w3r, w3i, dr, di, t4r, t4i);
+							Ops::Store(pReal + p0 + l, Ops::Add(ar, t2r));
+							Ops::Store(pImag + p0 + l, Ops::Add(ai, t2i));
+							Ops::Store(pReal + p2 + l, Ops::Sub(ar, t2r));
+							Ops::Store(pImag + p2 + l, Ops::Sub(ai, t2i));
+							Ops::Store(pReal + p1 + l, Ops::Add(br, t4r));
+							Ops::Store(pImag + p1 + l, Ops::Add(bi, t4i));
+							Ops::Store(pReal + p3 + l, Ops::Sub(br, t4r));
+							Ops::Store(pImag + p3 + l, Ops::Sub(bi, t4i));
+						}
+					}
+				}
+			}
+
+			if (scale != 1.0f)
+			{
+				Scale<Ops>(pReal, pImag, length * B, scale);
+			}
+		}
+
+		typedef void (*TransformLineFunc)(float*, float*, uint32_t, uint32_t, const uint32_t*, const float*, const float*, float);
+
+		//----
+		TransformLineFunc GetTransformLineFunc(CpuFFTSimd::Type simd)
+		{
+			switch (simd)
+			{
+#if defined(VSL_CPU_FFT_AVX2)
+			case CpuFFTSimd::AVX2:	return &TransformLine<Avx2Ops>;
+#endif
+#if defined(VSL_CPU_FFT_SSE)
+			case CpuFFTSimd::SSE:	return &TransformLine<SseOps>;
+#endif
+			default:				return &TransformLine<ScalarOps>;
+			}
+		}
+
+		//----
+		TransformLineFunc GetTransformColumnBlockFunc(CpuFFTSimd::Type simd)
+		{
+			switch (simd)
+			{
+#if defined(VSL_CPU_FFT_AVX2)
+			case CpuFFTSimd::AVX2:	return &TransformColumnBlock<Avx2Ops>;
+#endif
+#if defined(VSL_CPU_FFT_SSE)
+			case CpuFFTSimd::SSE:	return &TransformColumnBlock<SseOps>;
+#endif
+			default:				return &TransformColumnBlock<ScalarOps>;
+			}
+		}
+	}	// namespace
+
+	//----
+	void CpuFFTImage::Initialize(uint32_t w, uint32_t h)
+	{
+		width = w;
+		height = h;
+		real.assign(static_cast<size_t>(w) * h * kChannelCount, 0.0f);
+		imaginary.assign(static_cast<size_t>(w) * h * kChannelCount, 0.0f);
+	}
+
+	//----
+	void CpuFFTImage::SetRGBA8(const uint8_t* pPixels)
+	{
+		uint32_t planeSize = width * height;
+		for (uint32_t i = 0; i < planeSize; i++)
+		{
+			for (uint32_t c = 0; c < kChannelCount; c++)
+			{
+				real[c * planeSize + i] = static_cast<float>(pPixels[i * 4 + c]) / 255.0f;
+				imaginary[c * planeSize + i] = 0.0f;
+			}
+		}
+	}
+
+	//----
+	void CpuFFTImage::FromImagePixels(const void* pReal, const void* pImaginary, FFTPrecision::Type precision)
+	{
+		uint32_t planeSize = width * height;
+		const void* pSrcs[2] = { pReal, pImaginary };
+		float* pDsts[2] = { real.data(), imaginary.data() };
+		for (int part = 0; part < 2; part++)
+		{
+			if (!pSrcs[part])
+			{
+				std::fill(pDsts[part], pDsts[part] + planeSize * kChannelCount, 0.0f);
+				continue;
+			}
+			// アルファは読み飛ばす
+			for (uint32_t i = 0; i < planeSize; i++)
+			{
+				for (uint32_t c = 0; c < kChannelCount; c++)
+				{
+					pDsts[part][c * planeSize + i] = (precision == FFTPrecision::Single)
+						? static_cast<const float*>(pSrcs[part])[i * 4 + c]
+						: HalfToFloat(static_cast<const uint16_t*>(pSrcs[part])[i * 4 + c]);
+				}
+			}
+		}
+	}
+
+	//----
+	void CpuFFTImage::FromPacked(const void* pPacked, FFTPrecision::Type precision)
+	{
+		uint32_t planeSize = width * height;
+		if (precision == FFTPrecision::Single)
+		{
+			// チャンネルごとに実部、虚部の順でfp32が並ぶ
+			const float* pSrc = static_cast<const float*>(pPacked);
+			for (uint32_t i = 0; i < planeSize; i++)
+			{
+				for (uint32_t c = 0; c < kChannelCount; c++)
+				{
+					real[c * planeSize + i] = pSrc[(i * kChannelCount + c) * 2 + 0];
+					imaginary[c * planeSize + i] = pSrc[(i * kChannelCount + c) * 2 + 1];
+				}
+			}
+			return;
+		}
+
+		const uint32_t* pSrc = static_cast<const uint32_t*>(pPacked);
+		for (uint32_t i = 0; i < planeSize; i++)
+		{
+			for (uint32_t c = 0; c < kChannelCount; c++)
+			{
+				uint32_t v = pSrc[i * kChannelCount + c];
+				real[c * planeSize + i] = HalfToFloat(static_cast<uint16_t>(v & 0xffff));
+				imaginary[c * planeSize + i] = HalfToFloat(static_cast<uint16_t>(v >> 16));
+			}
+		}
+	}
+
+	//----
+	void CpuFFTImage::ToPacked(void* pPacked, FFTPrecision::Type precision) const
+	{
+		uint32_t planeSize = width * height;
+		if (precision == FFTPrecision::Single)
+		{
+			float* pDst = static_cast<float*>(pPacked);
+			for (uint32_t i = 0; i < planeSize; i++)
+			{
+				for (uint32_t c = 0; c < kChannelCount; c++)
+				{
+					pDst[(i * kChannelCount + c) * 2 + 0] = real[c * planeSize + i];
+					pDst[(i * kChannelCount + c) * 2 + 1] = imaginary[c * planeSize + i];
+				}
+			}
+			return;
+		}
+
+		uint32_t* pDst = static_cast<uint32_t*>(pPacked);
+		for (uint32_t i = 0; i < planeSize; i++)
+		{
+			for (uint32_t c = 0; c < kChannelCount; c++)
+			{
+				uint32_t r = FloatToHalf(real[c * planeSize + i]);
+				uint32_t im = FloatToHalf(imaginary[c * planeSize + i]);
+				pDst[i * kChannelCount + c] = r | (im << 16);
+			}
+		}
+	}
+
+	//----
+	FFTError FFTError::Compare(const CpuFFTImage& reference, const CpuFFTImage& target)
+	{
+		FFTError ret;
+		if ((reference.width != target.width) || (reference.height != target.height) || reference.real.empty())
+		{
+			ret.maxError = ret.rmsError = HUGE_VAL;
+			return ret;
+		}
+
+		double maxDiff = 0.0, maxRef = 0.0;
+		double sumDiff = 0.0, sumRef = 0.0;
+		for (size_t i = 0; i < reference.real.size(); i++)
+		{
+			double dr = static_cast<double>(target.real[i]) - reference.real[i];
+			double di = static_cast<double>(target.imaginary[i]) - reference.imaginary[i];
+			double diff2 = dr * dr + di * di;
+			double ref2 = static_cast<double>(reference.real[i]) * reference.real[i] + static_cast<double>(reference.imaginary[i]) * reference.imaginary[i];
+			maxDiff = (std::max)(maxDiff, diff2);
+			maxRef = (std::max)(maxRef, ref2);
+			sumDiff += diff2;
+			sumRef += ref2;
+		}
+		ret.maxError = (maxRef > 0.0) ? std::sqrt(maxDiff / maxRef) : std::sqrt(maxDiff);
+		ret.rmsError = (sumRef > 0.0) ? std::sqrt(sumDiff / sumRef) : std::sqrt(sumDiff / reference.real.size());
+		return ret;
+	}
+
+	//----
+	CpuFFTSimd::Type CpuFFTPlan::GetSupportedSimd()
+	{
+#if defined(VSL_CPU_FFT_AVX2)
+#if defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 0);
+		bool hasLeaf7 = info[0] >= 7;
+		__cpuid(info, 1);
+		bool hasFma = (info[2] & (1 << 12)) != 0;
+		bool hasOsxsave = (info[2] & (1 << 27)) != 0;
+		bool hasAvx = (info[2] & (1 << 28)) != 0;
+		bool hasAvx2 = false;
+		if (hasLeaf7)
+		{
+			__cpuidex(info, 7, 0);
+			hasAvx2 = (info[1] & (1 << 5)) != 0;
+		}
+		// OSがYMMレジスタを保存するか
+		bool hasOsSupport = hasOsxsave && ((_xgetbv(0) & 0x6) == 0x6);
+		if (hasFma && hasAvx && hasAvx2 && hasOsSupport)
+		{
+			return CpuFFTSimd::AVX2;
+		}
+#else
+		if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+		{
+			return CpuFFTSimd::AVX2;
+		}
+#endif
+#endif
+#if defined(VSL_CPU_FFT_SSE)
+		return CpuFFTSimd::SSE;
+#else
+		return CpuFFTSimd::Scalar;
+#endif
+	}
+
+	//----
+	void CpuFFTPlan::InitializeTable(LineTable& table, uint32_t length)
+	{
+		table.length = length;
+		table.log2 = 0;
+		while ((1u << table.log2) < length)
+		{
+			table.log2++;
+		}
+
+		table.bitReverse.resize(length);
+		for (uint32_t i = 0; i < length; i++)
+		{
+			uint32_t r = 0;
+			for (uint32_t b = 0; b < table.log2; b++)
+			{
+				r |= ((i >> b) & 1) << (table.log2 - 1 - b);
+			}
+			table.bitReverse[i] = r;
+		}
+
+		// 順変換は e^(-2 pi i j / 2h)、逆変換は共役
+		double sign = (desc_.direction == FFTDirection::Forward) ? -1.0 : 1.0;
+		table.cosTable.assign(length, 0.0f);
+		table.sinTable.assign(length, 0.0f);
+		for (uint32_t h = 1; h < length; h *= 2)
+		{
+			for (uint32_t j = 0; j < h; j++)
+			{
+				double a = kPi * static_cast<double>(j) / static_cast<double>(h);
+				table.cosTable[h + j] = static_cast<float>(std::cos(a));
+				table.sinTable[h + j] = static_cast<float>(sign * std::sin(a));
+			}
+		}
+	}
+
+	//----
+	bool CpuFFTPlan::Initialize(const FFTPlanDesc& desc, ThreadPool* pPool, CpuFFTSimd::Type simd)
+	{
+		Destroy();
+
+		if (!IsPowerOfTwo(desc.width) || !IsPowerOfTwo(desc.height) || (desc.batch == 0))
+		{
+			return false;
+		}
+
+		desc_ = desc;
+		pPool_ = pPool;
+		simd_ = (std::min)(simd, GetSupportedSimd());
+		InitializeTable(rowTable_, desc.width);
+		InitializeTable(columnTable_, desc.height);
+		isValid_ = true;
+		return true;
+	}
+
+	//----
+	void CpuFFTPlan::Destroy()
+	{
+		rowTable_ = LineTable();
+		columnTable_ = LineTable();
+		pPool_ = nullptr;
+		isValid_ = false;
+	}
+
+	//----
+	// [begin, end) の範囲を分割してワーカーと呼び出しスレッドで処理する
+	void CpuFFTPlan::ParallelFor(uint32_t count, const std::function<void(uint32_t, uint32_t)>& func)
+	{
+		// ワーカーから呼ばれた場合、完了待ちでワーカーを占有しないように呼び出しスレッドだけで処理する
+		uint32_t threadCount = pPool_ ? pPool_->GetThreadCount() : 0;
+		if ((threadCount == 0) || (count < 2) || (ThreadPool::GetCurrentWorkerIndex() != ThreadPool::kNotWorkerThread))
+		{
+			func(0, count);
+			return;
+		}
+
+		uint32_t chunkCount = (std::min)(threadCount + 1, count);
+		std::vector<std::future<void>> futures;
+		for (uint32_t i = 1; i < chunkCount; i++)
+		{
+			uint32_t begin = count * i / chunkCount;
+			uint32_t end = count * (i + 1) / chunkCount;
+			futures.push_back(pPool_->Submit([&func, begin, end]() { func(begin, end); }));
+		}
+		func(0, count / chunkCount);
+		for (auto& f : futures)
+		{
+			f.get();
+		}
+	}
+
+	//----
+	// 行を変換する、チャンネルの平面は連続している
+	void CpuFFTPlan::TransformRows(float* pReal, float* pImag)
+	{
+		TransformLineFunc transform = GetTransformLineFunc(simd_);
+		const LineTable& table = rowTable_;
+		float scale = 1.0f / std::sqrt(static_cast<float>(table.length));
+
+		ParallelFor(desc_.height * CpuFFTImage::kChannelCount, [&](uint32_t begin, uint32_t end)
+		{
+			for (uint32_t line = begin; line < end; line++)
+			{
+				size_t offset = static_cast<size_t>(line) * desc_.width;
+				transform(pReal + offset, pImag + offset, table.length, table.log2, table.bitReverse.data(), table.cosTable.data(), table.sinTable.data(), scale);
+			}
+		});
+	}
+
+	//----
+	// 列を変換する
+	// 隣り合う列をまとめて一時バッファに集めてから変換する、幅が足りない場合は1列ずつ変換する
+	void CpuFFTPlan::TransformColumns(float* pReal, float* pImag)
+	{
+		const LineTable& table = columnTable_;
+		float scale = 1.0f / std::sqrt(static_cast<float>(table.length));
+		uint32_t width = desc_.width;
+		size_t planeSize = static_cast<size_t>(width) * desc_.height;
+		bool isBlock = (width % kColumnBlock) == 0;
+		uint32_t blockWidth = isBlock ? kColumnBlock : 1;
+		uint32_t blocksPerPlane = width / blockWidth;
+		TransformLineFunc transform = isBlock ? GetTransformColumnBlockFunc(simd_) : GetTransformLineFunc(simd_);
+
+		ParallelFor(blocksPerPlane * CpuFFTImage::kChannelCount, [&](uint32_t begin, uint32_t end)
+		{
+			std::vector<float> tempReal(table.length * blockWidth), tempImag(table.length * blockWidth);
+			for (uint32_t block = begin; block < end; block++)
+			{
+				size_t offset = (block / blocksPerPlane) * planeSize + (block % blocksPerPlane) * blockWidth;
+				float* pR = pReal + offset;
+				float* pI = pImag + offset;
+				for (uint32_t i = 0; i < table.length; i++)
+				{
+					memcpy(&tempReal[i * blockWidth], pR + i * width, sizeof(float) * blockWidth);
+					memcpy(&tempImag[i * blockWidth], pI + i * width, sizeof(float) * blockWidth);
+				}
+				transform(tempReal.data(), tempImag.data(), table.length, table.log2, table.bitReverse.data(), table.cosTable.data(), table.sinTable.data(), scale);
+				for (uint32_t i = 0; i < table.length; i++)
+				{
+					memcpy(pR + i * width, &tempReal[i * blockWidth], sizeof(float) * blockWidth);
+					memcpy(pI + i * width, &tempImag[i * blockWidth], sizeof(float) * blockWidth);
+				}
+			}
+		});
+	}
+
+	//----
+	bool CpuFFTPlan::Execute(const CpuFFTImage* pInputs, CpuFFTImage* pOutputs)
+	{
+		if (!isValid_)
+		{
+			return false;
+		}
+
+		uint32_t width = desc_.width;
+		uint32_t height = desc_.height;
+		uint32_t planeSize = width * height;
+		uint32_t channels = CpuFFTImage::kChannelCount;
+		for (uint32_t i = 0; i < desc_.batch; i++)
+		{
+			const CpuFFTImage& input = pInputs[i];
+			CpuFFTImage& output = pOutputs[i];
+			if ((input.width != width) || (input.height != height) || (input.real.size() != static_cast<size_t>(planeSize) * channels))
+			{
+				return false;
+			}
+
+			// 出力にコピーしてその場で変換する
+			if (&input != &output)
+			{
+				output.width = width;
+				output.height = height;
+				output.real = input.real;
+				output.imaginary = input.imaginary;
+			}
+
+			TransformRows(output.real.data(), output.imaginary.data());
+			TransformColumns(output.real.data(), output.imaginary.data());
+		}
+		return true;
+	}
+
+}	// namespace vsl
+
+
+//	EOF
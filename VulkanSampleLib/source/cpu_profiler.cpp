@@ -0,0 +1,159 @@
+﻿#include <vsl/cpu_profiler.h>
+#include <algorithm>
+#include <cstdio>
+
+
+namespace vsl
+{
+	namespace
+	{
+		//----
+		// JSON の文字列として出力できるようにエスケープする
+		std::string EscapeJson(const char* str)
+		{
+			std::string ret;
+			for (const char* p = str; *p; p++)
+			{
+				if ((*p == '"') || (*p == '\\'))
+				{
+					ret += '\\';
+				}
+				else if (static_cast<unsigned char>(*p) < 0x20)
+				{
+					continue;
+				}
+				ret += *p;
+			}
+			return ret;
+		}
+	}	// namespace
+
+	//----
+	CpuProfiler& CpuProfiler::Instance()
+	{
+		static CpuProfiler sInstance;
+		return sInstance;
+	}
+
+	//----
+	CpuProfiler::CpuProfiler()
+		: epoch_(Clock::now())
+	{}
+
+	//----
+	CpuProfiler::ThreadBuffer* CpuProfiler::GetThreadBuffer()
+	{
+		// スレッドごとに初回のみ登録する
+		// バッファはプロファイラが所有するため、スレッドの終了後もエクスポートできる
+		static thread_local ThreadBuffer* tpBuffer = nullptr;
+		if (!tpBuffer)
+		{
+			std::unique_ptr<ThreadBuffer> buffer(new ThreadBuffer());
+			buffer->events.resize(kDefaultEventsPerThread);
+
+			std::lock_guard<std::mutex> lock(mutex_);
+			buffer->threadId = static_cast<uint32_t>(threadBuffers_.size());
+			tpBuffer = buffer.get();
+			threadBuffers_.push_back(std::move(buffer));
+		}
+		return tpBuffer;
+	}
+
+	//----
+	void CpuProfiler::Record(const char* name, int64_t begin, int64_t end)
+	{
+		if (!isEnabled_)
+		{
+			return;
+		}
+
+		// 書き込むのはこのスレッドだけなので、書き込み後に件数を公開すればよい
+		ThreadBuffer* pBuffer = GetThreadBuffer();
+		uint64_t index = pBuffer->writeCount.load(std::memory_order_relaxed);
+		CpuProfileEvent& e = pBuffer->events[index % pBuffer->events.size()];
+		e.name = name;
+		e.begin = begin;
+		e.end = end;
+		pBuffer->writeCount.store(index + 1, std::memory_order_release);
+	}
+
+	//----
+	void CpuProfiler::SetThreadName(const std::string& name)
+	{
+		ThreadBuffer* pBuffer = GetThreadBuffer();
+		std::lock_guard<std::mutex> lock(mutex_);
+		pBuffer->name = name;
+	}
+
+	//----
+	void CpuProfiler::Clear()
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		for (auto& buffer : threadBuffers_)
+		{
+			buffer->writeCount.store(0, std::memory_order_relaxed);
+		}
+	}
+
+	//----
+	std::string CpuProfiler::ToChromeTrace()
+	{
+		std::string ret = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+		char str[512];
+		bool isFirst = true;
+		auto Append = [&](const char* line)
+		{
+			if (!isFirst)
+			{
+				ret += ",\n";
+			}
+			ret += line;
+			isFirst = false;
+		};
+
+		std::lock_guard<std::mutex> lock(mutex_);
+		for (auto& buffer : threadBuffers_)
+		{
+			if (!buffer->name.empty())
+			{
+				sprintf_s(str, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+					buffer->threadId, EscapeJson(buffer->name.c_str()).c_str());
+				Append(str);
+			}
+
+			// リングバッファの古い順に出力する
+			uint64_t writeCount = buffer->writeCount.load(std::memory_order_acquire);
+			uint64_t capacity = buffer->events.size();
+			uint64_t count = (std::min)(writeCount, capacity);
+			for (uint64_t i = writeCount - count; i < writeCount; i++)
+			{
+				const CpuProfileEvent& e = buffer->events[i % capacity];
+				// タイムスタンプはマイクロ秒
+				sprintf_s(str, "{\"name\":\"%s\",\"cat\":\"vsl\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+					EscapeJson(e.name).c_str(), buffer->threadId,
+					static_cast<double>(e.begin) * 1e-3, static_cast<double>(e.end - e.begin) * 1e-3);
+				Append(str);
+			}
+		}
+		ret += "\n]}\n";
+		return ret;
+	}
+
+	//----
+	bool CpuProfiler::ExportChromeTrace(const char* filename)
+	{
+		std::string json = ToChromeTrace();
+		FILE* fp = nullptr;
+		if (fopen_s(&fp, filename, "w") != 0)
+		{
+			return false;
+		}
+		bool ret = fwrite(json.data(), 1, json.size(), fp) == json.size();
+		fclose(fp);
+		return ret;
+	}
+
+}	// namespace vsl
+
+
+//	EOF
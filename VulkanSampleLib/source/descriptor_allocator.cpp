@@ -0,0 +1,223 @@
+﻿#include <vsl/descriptor_allocator.h>
+#include <vsl/device.h>
+#include <vsl/descriptor_writer.h>
+#include <algorithm>
+
+
+namespace
+{
+	// VK_KHR_maintenance1 で追加されたエラー
+	// 使用しているヘッダには定義がないため値を直接指定する
+	static const vk::Result	kResultErrorOutOfPoolMemory = static_cast<vk::Result>(-1000069000);
+
+	static const vsl::DescriptorAllocator::PoolSizeRatio	kDefaultRatios[] = {
+		{ vk::DescriptorType::eSampler, 0.5f },
+		{ vk::DescriptorType::eCombinedImageSampler, 2.0f },
+		{ vk::DescriptorType::eSampledImage, 2.0f },
+		{ vk::DescriptorType::eStorageImage, 2.0f },
+		{ vk::DescriptorType::eUniformBuffer, 1.0f },
+		{ vk::DescriptorType::eStorageBuffer, 1.0f },
+		{ vk::DescriptorType::eUniformBufferDynamic, 0.5f },
+		{ vk::DescriptorType::eStorageBufferDynamic, 0.5f },
+		{ vk::DescriptorType::eInputAttachment, 0.5f },
+	};
+}	// namespace
+
+namespace vsl
+{
+	//----
+	bool DescriptorAllocator::Initialize(Device& owner, uint32_t setsPerPool, const std::vector<PoolSizeRatio>& ratios)
+	{
+		if (setsPerPool == 0)
+		{
+			return false;
+		}
+
+		pOwner_ = &owner;
+		nextSetsPerPool_ = (std::min)(setsPerPool, kMaxSetsPerPool);
+		if (ratios.empty())
+		{
+			ratios_.assign(std::begin(kDefaultRatios), std::end(kDefaultRatios));
+		}
+		else
+		{
+			ratios_ = ratios;
+		}
+		return true;
+	}
+
+	//----
+	void DescriptorAllocator::Destroy()
+	{
+		if (pOwner_)
+		{
+			vk::Device& device = pOwner_->GetDevice();
+			if (currentPool_.pool)
+			{
+				device.destroyDescriptorPool(currentPool_.pool);
+				VSL_API_COUNT(ObjectDestroy);
+			}
+			for (auto& p : usedPools_)
+			{
+				device.destroyDescriptorPool(p.pool);
+				VSL_API_COUNT(ObjectDestroy);
+			}
+			for (auto& p : freePools_)
+			{
+				device.destroyDescriptorPool(p.pool);
+				VSL_API_COUNT(ObjectDestroy);
+			}
+			currentPool_ = Pool();
+			usedPools_.clear();
+			freePools_.clear();
+			allocatedSetCount_ = 0;
+
+			DescriptorWriter::InvalidateAll(allocatedSets_);
+			allocatedSets_.clear();
+		}
+		pOwner_ = nullptr;
+	}
+
+	//----
+	// 空きプールを取得する、なければ前回の倍のサイズで作成する
+	bool DescriptorAllocator::GrabPool(const std::vector<vk::DescriptorPoolSize>* pMinCounts)
+	{
+		if (currentPool_.pool)
+		{
+			usedPools_.push_back(currentPool_);
+			currentPool_ = Pool();
+		}
+
+		if (!pMinCounts && !freePools_.empty())
+		{
+			currentPool_ = freePools_.back();
+			freePools_.pop_back();
+			return true;
+		}
+
+		std::vector<vk::DescriptorPoolSize> sizes;
+		for (auto& r : ratios_)
+		{
+			uint32_t count = static_cast<uint32_t>(r.ratio * static_cast<float>(nextSetsPerPool_));
+			sizes.push_back(vk::DescriptorPoolSize(r.type, (std::max)(count, 1u)));
+		}
+		if (pMinCounts)
+		{
+			// 比率にない種類や比率より多く使うレイアウトでも確保できるようにする
+			for (auto& m : *pMinCounts)
+			{
+				auto it = std::find_if(sizes.begin(), sizes.end(), [&](const vk::DescriptorPoolSize& s)
+				{
+					return s.type == m.type;
+				});
+				if (it != sizes.end())
+				{
+					it->descriptorCount = (std::max)(it->descriptorCount, m.descriptorCount);
+				}
+				else
+				{
+					sizes.push_back(m);
+				}
+			}
+		}
+
+		vk::DescriptorPoolCreateInfo info;
+		info.maxSets = nextSetsPerPool_;
+		info.poolSizeCount = static_cast<uint32_t>(sizes.size());
+		info.pPoolSizes = sizes.data();
+		currentPool_.pool = pOwner_->GetDevice().createDescriptorPool(info);
+		VSL_API_COUNT(ObjectCreate);
+		currentPool_.maxSets = nextSetsPerPool_;
+		currentPool_.setCount = 0;
+		if (!currentPool_.pool)
+		{
+			return false;
+		}
+
+		nextSetsPerPool_ = (std::min)(nextSetsPerPool_ * 2, kMaxSetsPerPool);
+		return true;
+	}
+
+	//----
+	vk::DescriptorSet DescriptorAllocator::Allocate(const vk::DescriptorSetLayout& layout)
+	{
+		// セット数の上限に達していたら次のプールへ
+		if (!currentPool_.pool || currentPool_.setCount >= currentPool_.maxSets)
+		{
+			if (!GrabPool())
+			{
+				return vk::DescriptorSet();
+			}
+		}
+
+		vk::DescriptorSetAllocateInfo allocInfo;
+		allocInfo.descriptorPool = currentPool_.pool;
+		allocInfo.descriptorSetCount = 1;
+		allocInfo.pSetLayouts = &layout;
+
+		vk::DescriptorSet set;
+		vk::Result result = pOwner_->GetDevice().allocateDescriptorSets(&allocInfo, &set);
+		if (result != vk::Result::eSuccess)
+		{
+			// デスクリプタ数が足りない場合のみ新しいプールで1回だけやり直す、他のエラーはそのまま失敗とする
+			// 新しいプールはレイアウトが必要とする数を必ず持たせる
+			bool isPoolFull = (result == vk::Result::eErrorFragmentedPool) || (result == kResultErrorOutOfPoolMemory);
+			if (!isPoolFull)
+			{
+				return vk::DescriptorSet();
+			}
+			std::vector<vk::DescriptorPoolSize> minCounts;
+			bool hasCounts = pOwner_->GetLayoutCache().GetDescriptorCounts(layout, minCounts);
+			if (!GrabPool(hasCounts ? &minCounts : nullptr))
+			{
+				return vk::DescriptorSet();
+			}
+
+			allocInfo.descriptorPool = currentPool_.pool;
+			result = pOwner_->GetDevice().allocateDescriptorSets(&allocInfo, &set);
+			if (result != vk::Result::eSuccess)
+			{
+				return vk::DescriptorSet();
+			}
+		}
+
+		currentPool_.setCount++;
+		allocatedSetCount_++;
+		allocatedSets_.push_back(set);
+		VSL_API_COUNT(DescriptorAllocate);
+		return set;
+	}
+
+	//----
+	void DescriptorAllocator::Reset()
+	{
+		if (!pOwner_)
+		{
+			return;
+		}
+
+		if (currentPool_.pool)
+		{
+			usedPools_.push_back(currentPool_);
+			currentPool_ = Pool();
+		}
+
+		// プール単位でリセットするので、セット数に関係なくコストは小さい
+		vk::Device& device = pOwner_->GetDevice();
+		for (auto& p : usedPools_)
+		{
+			device.resetDescriptorPool(p.pool);
+			p.setCount = 0;
+			freePools_.push_back(p);
+		}
+		usedPools_.clear();
+		allocatedSetCount_ = 0;
+
+		DescriptorWriter::InvalidateAll(allocatedSets_);
+		allocatedSets_.clear();
+	}
+
+}	// namespace vsl
+
+
+//	EOF
@@ -0,0 +1,208 @@
+﻿#include <vsl/descriptor_writer.h>
+#include <vsl/device.h>
+#include <vsl/hash.h>
+#include <algorithm>
+#include <iterator>
+#include <mutex>
+#include <unordered_set>
+
+
+namespace vsl
+{
+	namespace
+	{
+		//----
+		// 初期化済みのライター
+		struct WriterRegistry
+		{
+			std::mutex						mutex;
+			std::vector<DescriptorWriter*>	writers;
+		};	// struct WriterRegistry
+
+		WriterRegistry& GetWriterRegistry()
+		{
+			static WriterRegistry sRegistry;
+			return sRegistry;
+		}
+	}	// namespace
+
+	//----
+	size_t DescriptorWriter::WriteKeyHash::operator()(const WriteKey& key) const
+	{
+		uint64_t h = kFnvOffsetBasis;
+		HashCombine(h, key.set);
+		HashCombine(h, key.binding);
+		HashCombine(h, key.arrayElement);
+		return static_cast<size_t>(h);
+	}
+
+	//----
+	bool DescriptorWriter::Initialize(Device& owner)
+	{
+		if (!pOwner_)
+		{
+			WriterRegistry& registry = GetWriterRegistry();
+			std::lock_guard<std::mutex> lock(registry.mutex);
+			registry.writers.push_back(this);
+		}
+		pOwner_ = &owner;
+		return true;
+	}
+
+	//----
+	void DescriptorWriter::Destroy()
+	{
+		if (pOwner_)
+		{
+			WriterRegistry& registry = GetWriterRegistry();
+			std::lock_guard<std::mutex> lock(registry.mutex);
+			registry.writers.erase(std::remove(registry.writers.begin(), registry.writers.end(), this), registry.writers.end());
+		}
+		pending_.clear();
+		current_.clear();
+		pOwner_ = nullptr;
+	}
+
+	//----
+	DescriptorWriter& DescriptorWriter::WriteImage(const vk::DescriptorSet& set, uint32_t binding, vk::DescriptorType type, const vk::DescriptorImageInfo& info, uint32_t arrayElement)
+	{
+		WriteKey key{ static_cast<VkDescriptorSet>(set), binding, arrayElement };
+		WriteValue value;
+		value.type = type;
+		value.image = info;
+		Write(key, value);
+		return *this;
+	}
+
+	//----
+	DescriptorWriter& DescriptorWriter::WriteBuffer(const vk::DescriptorSet& set, uint32_t binding, vk::DescriptorType type, const vk::DescriptorBufferInfo& info, uint32_t arrayElement)
+	{
+		WriteKey key{ static_cast<VkDescriptorSet>(set), binding, arrayElement };
+		WriteValue value;
+		value.type = type;
+		value.buffer = info;
+		Write(key, value);
+		return *this;
+	}
+
+	//----
+	void DescriptorWriter::Write(const WriteKey& key, const WriteValue& value)
+	{
+		// 反映済みの内容と同じなら記録中の書き込みも取り消す
+		auto it = current_.find(key);
+		if (it != current_.end() && it->second == value)
+		{
+			pending_.erase(key);
+			skipCount_++;
+			return;
+		}
+
+		pending_[key] = value;
+	}
+
+	//----
+	uint32_t DescriptorWriter::Flush()
+	{
+		if (!pOwner_ || pending_.empty())
+		{
+			return 0;
+		}
+
+		// 情報構造体のアドレスは pending_ の要素を直接参照する
+		std::vector<vk::WriteDescriptorSet> writes;
+		writes.reserve(pending_.size());
+		for (auto& p : pending_)
+		{
+			const WriteKey& key = p.first;
+			const WriteValue& value = p.second;
+
+			vk::WriteDescriptorSet write;
+			write.dstSet = key.set;
+			write.dstBinding = key.binding;
+			write.dstArrayElement = key.arrayElement;
+			write.descriptorCount = 1;
+			write.descriptorType = value.type;
+			switch (value.type)
+			{
+			case vk::DescriptorType::eUniformBuffer:
+			case vk::DescriptorType::eStorageBuffer:
+			case vk::DescriptorType::eUniformBufferDynamic:
+			case vk::DescriptorType::eStorageBufferDynamic:
+				write.pBufferInfo = &value.buffer;
+				break;
+			default:
+				write.pImageInfo = &value.image;
+				break;
+			}
+			writes.push_back(write);
+		}
+		UpdateDescriptorSets(pOwner_->GetDevice(), writes);
+
+		for (auto& p : pending_)
+		{
+			current_[p.first] = p.second;
+		}
+		pending_.clear();
+
+		uint32_t count = static_cast<uint32_t>(writes.size());
+		writeCount_ += count;
+		return count;
+	}
+
+	//----
+	void DescriptorWriter::Invalidate(const vk::DescriptorSet& set)
+	{
+		VkDescriptorSet s = static_cast<VkDescriptorSet>(set);
+		for (auto it = current_.begin(); it != current_.end();)
+		{
+			it = (it->first.set == s) ? current_.erase(it) : std::next(it);
+		}
+		for (auto it = pending_.begin(); it != pending_.end();)
+		{
+			it = (it->first.set == s) ? pending_.erase(it) : std::next(it);
+		}
+	}
+
+	//----
+	void DescriptorWriter::Invalidate(const std::vector<vk::DescriptorSet>& sets)
+	{
+		if (sets.empty() || (current_.empty() && pending_.empty()))
+		{
+			return;
+		}
+
+		std::unordered_set<VkDescriptorSet> s;
+		for (auto& set : sets)
+		{
+			s.insert(static_cast<VkDescriptorSet>(set));
+		}
+		for (auto it = current_.begin(); it != current_.end();)
+		{
+			it = (s.count(it->first.set) > 0) ? current_.erase(it) : std::next(it);
+		}
+		for (auto it = pending_.begin(); it != pending_.end();)
+		{
+			it = (s.count(it->first.set) > 0) ? pending_.erase(it) : std::next(it);
+		}
+	}
+
+	//----
+	void DescriptorWriter::InvalidateAll(const std::vector<vk::DescriptorSet>& sets)
+	{
+		if (sets.empty())
+		{
+			return;
+		}
+
+		WriterRegistry& registry = GetWriterRegistry();
+		std::lock_guard<std::mutex> lock(registry.mutex);
+		for (auto w : registry.writers)
+		{
+			w->Invalidate(sets);
+		}
+	}
+
+}	// namespace vsl
+
+
+//	EOF
@@ -233,17 +233,37 @@ namespace vsl
 #endif
 
 		vkPipelineCache_ = vkDevice_.createPipelineCache(vk::PipelineCacheCreateInfo());
+		VSL_API_COUNT(ObjectCreate);
+
+		// ワーカースレッド起動
+		// パイプラインキャッシュのワーカー用キャッシュ数に影響するので先に起動しておく
+		if (!threadPool_.Initialize())
+		{
+			return false;
+		}
+		if (!samplerCache_.Initialize(*this) || !imageViewCache_.Initialize(*this) || !layoutCache_.Initialize(*this) || !shaderModuleCache_.Initialize(*this) || !pipelineStateCache_.Initialize(*this))
+		{
+			return false;
+		}
 		vkQueue_ = vkDevice_.getQueue(graphicsQueueIndex, 0);
 		vkComputeQueue_ = vkDevice_.getQueue(computeQueueIndex, (computeQueueIndex == graphicsQueueIndex) ? 1 : 0);
 
+		// タイムスタンプの有効ビットより上位は不定なので、読み出した値はこのマスクをかけて使う
+		{
+			uint32_t validBits = vkPhysicalDevice_.getQueueFamilyProperties()[graphicsQueueIndex].timestampValidBits;
+			timestampMask_ = (validBits >= 64) ? UINT64_MAX : ((1ull << validBits) - 1);
+		}
+
 		// コマンドプール作成
 		vk::CommandPoolCreateInfo cmdPoolInfo;
 		cmdPoolInfo.queueFamilyIndex = graphicsQueueIndex;
 		cmdPoolInfo.flags = vk::CommandPoolCreateFlagBits::eResetCommandBuffer;
 		vkCmdPool_ = vkDevice_.createCommandPool(cmdPoolInfo);
+		VSL_API_COUNT(ObjectCreate);
 
 		cmdPoolInfo.queueFamilyIndex = computeQueueIndex;
 		vkComputeCmdPool_ = vkDevice_.createCommandPool(cmdPoolInfo);
+		VSL_API_COUNT(ObjectCreate);
 
 		// スワップチェイン初期化
 		if (!vkSwapchain_.Initialize(*this, hInst, hWnd))
@@ -261,9 +281,11 @@ namespace vsl
 
 			// Presentの完了を確認するため
 			vkPresentComplete_ = vkDevice_.createSemaphore(semaphoreCreateInfo);
+			VSL_API_COUNT(ObjectCreate);
 
 			// 描画コマンドの処理完了を確認するため
 			vkRenderComplete_ = vkDevice_.createSemaphore(semaphoreCreateInfo);
+			VSL_API_COUNT(ObjectCreate);
 
 			if (!vkPresentComplete_ || !vkRenderComplete_)
 			{
@@ -277,9 +299,28 @@ namespace vsl
 			allocInfo.commandPool = vkCmdPool_;
 			allocInfo.commandBufferCount = vkSwapchain_.GetImageCount();
 			vkCmdBuffers_ = vkDevice_.allocateCommandBuffers(allocInfo);
+			VSL_API_COUNT_N(ObjectCreate, vkCmdBuffers_.size());
 
 			allocInfo.commandPool = vkComputeCmdPool_;
 			vkComputeCmdBuffers_ = vkDevice_.allocateCommandBuffers(allocInfo);
+			VSL_API_COUNT_N(ObjectCreate, vkComputeCmdBuffers_.size());
+		}
+
+		// デスクリプタセットアロケータ作成
+		// フレーム用はコマンドバッファと同じくスワップチェインのイメージ数だけ用意する
+		{
+			if (!descAllocator_.Initialize(*this))
+			{
+				return false;
+			}
+			frameDescAllocators_ = std::vector<DescriptorAllocator>(vkSwapchain_.GetImageCount());
+			for (auto& a : frameDescAllocators_)
+			{
+				if (!a.Initialize(*this))
+				{
+					return false;
+				}
+			}
 		}
 
 		return true;
@@ -294,16 +335,33 @@ namespace vsl
 		vkQueue_.waitIdle();
 		vkDevice_.waitIdle();
 
+		threadPool_.Terminate();
+
 		vkDevice_.freeCommandBuffers(vkComputeCmdPool_, vkComputeCmdBuffers_);
+		VSL_API_COUNT_N(ObjectDestroy, vkComputeCmdBuffers_.size());
 		vkDevice_.freeCommandBuffers(vkCmdPool_, vkCmdBuffers_);
+		VSL_API_COUNT_N(ObjectDestroy, vkCmdBuffers_.size());
 		vkDevice_.destroySemaphore(vkPresentComplete_);
+		VSL_API_COUNT(ObjectDestroy);
 		vkDevice_.destroySemaphore(vkRenderComplete_);
+		VSL_API_COUNT(ObjectDestroy);
 
 		vkSwapchain_.Destroy();
 
+		frameDescAllocators_.clear();
+		descAllocator_.Destroy();
+		pipelineStateCache_.Destroy();
+		layoutCache_.Destroy();
+		shaderModuleCache_.Destroy();
+		imageViewCache_.Destroy();
+		samplerCache_.Destroy();
+
 		vkDevice_.destroyCommandPool(vkComputeCmdPool_);
+		VSL_API_COUNT(ObjectDestroy);
 		vkDevice_.destroyCommandPool(vkCmdPool_);
+		VSL_API_COUNT(ObjectDestroy);
 		vkDevice_.destroyPipelineCache(vkPipelineCache_);
+		VSL_API_COUNT(ObjectDestroy);
 		vkDevice_.destroy();
 #if defined(_DEBUG)
 		g_fDestroyDebugReportCallback(vkInstance_, g_fMsgCallback, nullptr);
@@ -314,12 +372,20 @@ namespace vsl
 	//----
 	vk::CommandBuffer& Device::BeginMainCommandBuffer()
 	{
+		VSL_CPU_SCOPE("BeginMainCommandBuffer");
 		auto& cmdBuffer = GetCurrentCommandBuffer();
 
+		// 前回このコマンドバッファで使用したデスクリプタセットを破棄する
+		// SubmitAndPresent() でフェンスを待っているのでGPUからは参照されていない
+		frameDescAllocators_[currentBufferIndex_].Reset();
+
 		cmdBuffer.reset(vk::CommandBufferResetFlagBits::eReleaseResources);
 		vk::CommandBufferBeginInfo cmdBufInfo;
 		cmdBuffer.begin(cmdBufInfo);
 
+#if VSL_CPU_PROFILER
+		recordBeginTime_ = CpuProfiler::Instance().Now();
+#endif
 		return cmdBuffer;
 	}
 
@@ -342,11 +408,18 @@ namespace vsl
 
 		// コマンドバッファを終了
 		cmdBuffer.end();
+
+#if VSL_CPU_PROFILER
+		CpuProfiler& profiler = CpuProfiler::Instance();
+		profiler.Record("RecordCommands", recordBeginTime_, profiler.Now());
+#endif
 	}
 
 	//----
 	void Device::SubmitAndPresent(uint32_t waitSemaphoreCount, vk::Semaphore* pWaitSemaphores, vk::PipelineStageFlags* pWaitStages, uint32_t signalSemaphoreCount, vk::Semaphore* pSignalSemaphores)
 	{
+		VSL_CPU_SCOPE("SubmitAndPresent");
+
 		// Submit
 		{
 			std::vector<vk::Semaphore> waitSem(1), signalSem(1);
@@ -383,9 +456,15 @@ namespace vsl
 
 			// Queueに対してSubmitする
 			vk::Fence fence = vkSwapchain_.GetSubmitFence(true);
-			vkQueue_.submit(submitInfo, fence);
-			vk::Result fenceRes = vkDevice_.waitForFences(fence, VK_TRUE, kFenceTimeout);
-			assert(fenceRes == vk::Result::eSuccess);
+			{
+				VSL_CPU_SCOPE("Submit");
+				QueueSubmit(vkQueue_, submitInfo, fence);
+			}
+			{
+				VSL_CPU_SCOPE("WaitFence");
+				vk::Result fenceRes = vkDevice_.waitForFences(fence, VK_TRUE, kFenceTimeout);
+				assert(fenceRes == vk::Result::eSuccess);
+			}
 		}
 
 		// Present
@@ -0,0 +1,800 @@
+﻿#include <vsl/fft.h>
+#include <vsl/device.h>
+#include <vsl/shader_bundle.h>
+#include <vsl/layout_cache.h>
+#include <vsl/pipeline_builder.h>
+#include <vsl/descriptor_allocator.h>
+#include <algorithm>
+#include <cstring>
+
+
+namespace vsl
+{
+	namespace
+	{
+		// fft.h の特殊化定数ID
+		static const uint32_t kSpecIdLength = 0;
+		static const uint32_t kSpecIdButterflyCount = 1;
+		static const uint32_t kSpecIdRowPass = 2;
+		static const uint32_t kSpecIdInputType = 3;
+		static const uint32_t kSpecIdOutputType = 4;
+		static const uint32_t kSpecIdPitch = 5;
+		static const uint32_t kSpecIdRealPair = 6;
+		static const uint32_t kSpecIdFusePasses = 7;
+		static const uint32_t kSpecIdStepType = 8;
+		static const uint32_t kSpecIdStepCount = 9;
+		static const uint32_t kSpecIdSharedHalf = 10;
+
+		// fft.h の STEP_TYPE
+		static const uint32_t kStepSingle = 0;
+		static const uint32_t kStepFirst = 1;
+		static const uint32_t kStepSecond = 2;
+
+		// fft.h のバインド番号
+		static const uint32_t kBindingInputReal = 0;
+		static const uint32_t kBindingInputImaginary = 1;
+		static const uint32_t kBindingOutputReal = 2;
+		static const uint32_t kBindingOutputImaginary = 3;
+		static const uint32_t kBindingSource = 4;
+		static const uint32_t kBindingInputBuffer = 5;
+		static const uint32_t kBindingOutputBuffer = 6;
+
+		// 1要素あたりの共有メモリ使用量
+		// 中間値はRGBの複素数を2本、fp32は uint 6つ、fp16x2 は uint 3つ
+		// 回転因子テーブルは半分の長さの vec2
+		uint32_t GetSharedBytesPerElement(FFTPrecision::Type precision)
+		{
+			uint32_t scratch = (precision == FFTPrecision::PackedHalf) ? 3 * 4 : 6 * 4;
+			return 2 * scratch + 8 / 2;
+		}
+
+		//----
+		bool IsPowerOfTwo(uint32_t v)
+		{
+			return (v >= 2) && ((v & (v - 1)) == 0);
+		}
+
+		//----
+		uint32_t Log2(uint32_t v)
+		{
+			uint32_t ret = 0;
+			while ((1u << ret) < v)
+			{
+				ret++;
+			}
+			return ret;
+		}
+
+		//----
+		// イメージの1ピクセルのバイト数
+		uint32_t GetImagePixelBytes(FFTPrecision::Type precision)
+		{
+			return (precision == FFTPrecision::Single) ? 16 : 8;
+		}
+
+		//----
+		// 1要素あたりの読み込みバイト数
+		// RealImage の読み込みは順変換の元画像(rgba8)
+		uint32_t GetReadBytes(FFTDataType::Type type, FFTPrecision::Type precision)
+		{
+			switch (type)
+			{
+			case FFTDataType::RealImage:		return 4;
+			case FFTDataType::ComplexImages:	return GetImagePixelBytes(precision) * 2;
+			default:							return FFTPlan::GetPackedElementSize(precision);
+			}
+		}
+
+		//----
+		// 1要素あたりの書き込みバイト数
+		// RealImage の書き込みは逆変換の結果(rgba16f, rgba32f)
+		uint32_t GetWriteBytes(FFTDataType::Type type, FFTPrecision::Type precision)
+		{
+			switch (type)
+			{
+			case FFTDataType::RealImage:		return GetImagePixelBytes(precision);
+			case FFTDataType::ComplexImages:	return GetImagePixelBytes(precision) * 2;
+			default:							return FFTPlan::GetPackedElementSize(precision);
+			}
+		}
+
+		//----
+		template <typename T>
+		uint64_t ToKey(const T& handle)
+		{
+			uint64_t ret = 0;
+			memcpy(&ret, &handle, (std::min)(sizeof(ret), sizeof(handle)));
+			return ret;
+		}
+	}	// namespace
+
+	//----
+	bool FFT::Initialize(Device& owner, const ShaderBundle& bundle)
+	{
+		pOwner_ = &owner;
+
+		// 古いバンドルでは256固定のシェーダを使用する
+		ShaderBundle::Blob blob;
+		if (!bundle.Find("fft.comp.spv", blob) || !bundle.Find("ifft.comp.spv", blob))
+		{
+			return InitializeFixed(owner, bundle);
+		}
+
+		if (!shaders_[0][FFTDirection::Forward].CreateFromBundle(owner, bundle, "fft.comp.spv"))
+		{
+			return false;
+		}
+		if (!shaders_[0][FFTDirection::Inverse].CreateFromBundle(owner, bundle, "ifft.comp.spv"))
+		{
+			return false;
+		}
+
+		// fp32で格納するシェーダは任意、無ければ Single を使用できない
+		isSingleAvailable_ = shaders_[1][FFTDirection::Forward].CreateFromBundle(owner, bundle, "fft32.comp.spv")
+			&& shaders_[1][FFTDirection::Inverse].CreateFromBundle(owner, bundle, "ifft32.comp.spv");
+
+		// 順変換と逆変換でレイアウトを共有する
+		// fp32のシェーダはイメージのフォーマットのみ異なるため、同じレイアウトを使用する
+		std::vector<vk::DescriptorSetLayout> setLayouts;
+		if (!owner.GetLayoutCache().GetLayouts({ &shaders_[0][0], &shaders_[0][1] }, setLayouts, pipeLayout_) || (setLayouts.size() != 1))
+		{
+			return false;
+		}
+		setLayout_ = setLayouts[0];
+
+		// 1行をワークグループ1つで処理するため、ワークグループサイズと共有メモリの上限で最大長が決まる
+		vk::PhysicalDeviceLimits limits = owner.GetPhysicalDevice().getProperties().limits;
+		for (int i = 0; i < FFTPrecision::Max; i++)
+		{
+			uint32_t maxLength = (std::min)(limits.maxComputeWorkGroupInvocations, limits.maxComputeWorkGroupSize[0]);
+			maxLength = (std::min)(maxLength, limits.maxComputeSharedMemorySize / GetSharedBytesPerElement(static_cast<FFTPrecision::Type>(i)));
+			maxLengths_[i] = 1;
+			while (maxLengths_[i] * 2 <= maxLength)
+			{
+				maxLengths_[i] *= 2;
+			}
+		}
+		storageAlignment_ = limits.minStorageBufferOffsetAlignment;
+
+		return true;
+	}
+
+	//----
+	// 256固定のシェーダは方向と行/列パスごとに4つあり、特殊化定数を持たない
+	// 入出力はストレージイメージのみで、4つのシェーダでレイアウトを共有する
+	bool FFT::InitializeFixed(Device& owner, const ShaderBundle& bundle)
+	{
+		static const char* kFixedNames[2][2] = {
+			{ "fft_r.comp.spv", "fft_c.comp.spv" },
+			{ "ifft_r.comp.spv", "ifft_c.comp.spv" },
+		};
+		for (int d = 0; d < 2; d++)
+		{
+			for (int p = 0; p < 2; p++)
+			{
+				if (!fixedShaders_[d][p].CreateFromBundle(owner, bundle, kFixedNames[d][p]))
+				{
+					return false;
+				}
+			}
+		}
+
+		std::vector<vk::DescriptorSetLayout> setLayouts;
+		if (!owner.GetLayoutCache().GetLayouts({ &fixedShaders_[0][0], &fixedShaders_[0][1], &fixedShaders_[1][0], &fixedShaders_[1][1] }, setLayouts, pipeLayout_)
+			|| (setLayouts.size() != 1))
+		{
+			return false;
+		}
+		setLayout_ = setLayouts[0];
+
+		// fp16で格納する長さ256のみ
+		maxLengths_[FFTPrecision::Half] = kFixedLength;
+		isFixedKernel_ = true;
+
+		return true;
+	}
+
+	//----
+	void FFT::Destroy()
+	{
+		for (auto& shaders : shaders_)
+		{
+			for (auto& s : shaders)
+			{
+				s.Destroy();
+			}
+		}
+		for (auto& shaders : fixedShaders_)
+		{
+			for (auto& s : shaders)
+			{
+				s.Destroy();
+			}
+		}
+		isSingleAvailable_ = false;
+		isFixedKernel_ = false;
+		// レイアウトとパイプラインはDeviceのキャッシュが所有している
+		setLayout_ = vk::DescriptorSetLayout();
+		pipeLayout_ = vk::PipelineLayout();
+		for (auto& l : maxLengths_)
+		{
+			l = 0;
+		}
+		pOwner_ = nullptr;
+	}
+
+	//----
+	bool FFT::IsSupported(const FFTPlanDesc& desc) const
+	{
+		if (!pOwner_)
+		{
+			return false;
+		}
+		if (!IsPowerOfTwo(desc.width) || !IsPowerOfTwo(desc.height))
+		{
+			return false;
+		}
+		if ((desc.precision < 0) || (desc.precision >= FFTPrecision::Max))
+		{
+			return false;
+		}
+		if ((desc.precision == FFTPrecision::Single) && !isSingleAvailable_)
+		{
+			return false;
+		}
+		if (isFixedKernel_ && ((desc.width != kFixedLength) || (desc.height != kFixedLength) || (desc.precision != FFTPrecision::Half)))
+		{
+			return false;
+		}
+		if ((desc.width > GetMaxTransformLength(desc.precision)) || (desc.height > GetMaxTransformLength(desc.precision)))
+		{
+			return false;
+		}
+		return desc.batch != 0;
+	}
+
+	//----
+	FFTPrecision::Type FFT::ResolvePrecision(const FFTPlanDesc& desc) const
+	{
+		if (desc.precision == FFTPrecision::Single)
+		{
+			return desc.precision;
+		}
+		// 長いほど段数が増え、丸め誤差が積み重なる
+		if (((desc.width > kMaxHalfLength) || (desc.height > kMaxHalfLength)) && isSingleAvailable_)
+		{
+			return FFTPrecision::Single;
+		}
+		return desc.precision;
+	}
+
+	//----
+	// 方向とパスの設定の組み合わせごとにパイプラインを取得する
+	// 同じ組み合わせはDeviceのパイプラインキャッシュから返される
+	vk::Pipeline FFT::GetPipeline(FFTDirection::Type direction, const PassDesc& pass)
+	{
+		ComputePipelineBuilder builder;
+		if (isFixedKernel_)
+		{
+			// 256固定のシェーダは行パスと列パスで別のシェーダを使用する
+			builder.SetShader(fixedShaders_[direction][pass.isRowPass ? 0 : 1].GetModule())
+				.SetLayout(pipeLayout_);
+			return builder.Build(*pOwner_);
+		}
+
+		uint32_t storage = (pass.precision == FFTPrecision::Single) ? 1 : 0;
+		builder.SetShader(shaders_[storage][direction].GetModule())
+			.SetLayout(pipeLayout_)
+			.SetSpecConstant(kSpecIdLength, pass.length)
+			.SetSpecConstant(kSpecIdButterflyCount, Log2(pass.length))
+			.SetSpecConstant(kSpecIdRowPass, pass.isRowPass ? VK_TRUE : VK_FALSE)
+			.SetSpecConstant(kSpecIdInputType, pass.input)
+			.SetSpecConstant(kSpecIdOutputType, pass.output)
+			.SetSpecConstant(kSpecIdPitch, pass.pitch)
+			.SetSpecConstant(kSpecIdRealPair, pass.realPair ? VK_TRUE : VK_FALSE)
+			.SetSpecConstant(kSpecIdFusePasses, pass.fusePasses ? VK_TRUE : VK_FALSE)
+			.SetSpecConstant(kSpecIdStepType, pass.stepType)
+			.SetSpecConstant(kSpecIdStepCount, pass.stepCount)
+			.SetSpecConstant(kSpecIdSharedHalf, (pass.precision == FFTPrecision::PackedHalf) ? VK_TRUE : VK_FALSE);
+		return builder.Build(*pOwner_);
+	}
+
+	//----
+	// length = pSplit[0] * pSplit[1] となるように、なるべく均等に分割する
+	bool FFT::GetSplit(uint32_t length, FFTPrecision::Type precision, uint32_t* pSplit) const
+	{
+		if (length <= maxLengths_[precision])
+		{
+			pSplit[0] = pSplit[1] = 0;
+			return false;
+		}
+		uint32_t log2 = Log2(length);
+		pSplit[0] = 1u << ((log2 + 1) / 2);
+		pSplit[1] = length / pSplit[0];
+		return true;
+	}
+
+	//----
+	bool FFTPlan::Initialize(FFT& engine, vk::CommandBuffer& cmdBuffer, const FFTPlanDesc& desc)
+	{
+		Destroy();
+
+		if (!engine.IsSupported(desc))
+		{
+			return false;
+		}
+		desc_ = desc;
+
+		Device& device = *engine.GetDevice();
+
+		// 分割する場合は2段目の入力用に中間バッファをもう1枚使用する
+		bool isRowSplit = engine.GetSplit(desc.width, desc.precision, rowSplit_);
+		bool isColumnSplit = engine.GetSplit(desc.height, desc.precision, columnSplit_);
+		workSlices_ = (isRowSplit || isColumnSplit) ? 2 : 1;
+
+		vk::ImageSubresourceRange colorSubRange(vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1);
+		if (engine.IsFixedKernel())
+		{
+			// 256固定のシェーダはバッファを扱えないので、中間はイメージにする
+			workImages_ = std::vector<Image>(desc.batch * 2);
+			for (auto& image : workImages_)
+			{
+				if (!image.InitializeAsColorBuffer(device, cmdBuffer, vk::Format::eR16G16B16A16Sfloat,
+					static_cast<uint16_t>(desc.width), static_cast<uint16_t>(desc.height), 1, 1, true))
+				{
+					return false;
+				}
+				image.SetImageLayout(cmdBuffer, vk::ImageLayout::eGeneral, colorSubRange);
+			}
+		}
+		else
+		{
+			// 中間バッファはバッチごとにアライメントを揃えて並べる
+			vk::DeviceSize align = (std::max)(engine.storageAlignment_, vk::DeviceSize(1));
+			workStride_ = (GetPackedSize() + align - 1) / align * align;
+			if (!workBuffer_.InitializeAsStorageBuffer(device, static_cast<size_t>(workStride_ * workSlices_ * desc.batch)))
+			{
+				return false;
+			}
+		}
+
+		// 使用しないバインドに設定するイメージ
+		vk::Format dummyFormat = (desc.precision == FFTPrecision::Single) ? vk::Format::eR32G32B32A32Sfloat : vk::Format::eR16G16B16A16Sfloat;
+		if (!dummyImage_.InitializeAsColorBuffer(device, cmdBuffer, dummyFormat, 1, 1, 1, 1, true))
+		{
+			return false;
+		}
+		dummyImage_.SetImageLayout(cmdBuffer, vk::ImageLayout::eGeneral, colorSubRange);
+		if (desc.direction == FFTDirection::Forward)
+		{
+			if (!dummySource_.InitializeAsColorBuffer(device, cmdBuffer, vk::Format::eR8G8B8A8Unorm, 1, 1, 1, 1, true))
+			{
+				return false;
+			}
+			dummySource_.SetImageLayout(cmdBuffer, vk::ImageLayout::eGeneral, colorSubRange);
+		}
+
+		// セットは入出力の組み合わせごとにパス数分確保する
+		// ストレージイメージとストレージバッファのみ使用する
+		std::vector<DescriptorAllocator::PoolSizeRatio> ratios = {
+			{ vk::DescriptorType::eStorageImage, 5.0f },
+			{ vk::DescriptorType::eStorageBuffer, 2.0f },
+		};
+		if (!descAllocator_.Initialize(device, GetPassCount() * desc.batch * 4, ratios))
+		{
+			return false;
+		}
+		if (!descWriter_.Initialize(device))
+		{
+			return false;
+		}
+
+		pEngine_ = &engine;
+		generation_ = NextResourceGeneration();
+		return true;
+	}
+
+	//----
+	void FFTPlan::Destroy()
+	{
+		// パイプラインはDeviceのキャッシュが所有している
+		// 呼び出し側でGPUがセットを参照していないことを保証すること
+		descSets_.clear();
+		descAllocator_.Destroy();
+		descWriter_.Destroy();
+		workBuffer_.Destroy();
+		workImages_.clear();
+		dummyImage_.Destroy();
+		dummySource_.Destroy();
+		for (auto& p : rowPipelines_)
+		{
+			p = vk::Pipeline();
+		}
+		for (auto& p : columnPipelines_)
+		{
+			p = vk::Pipeline();
+		}
+		rowSecondPipeline_ = columnFirstPipeline_ = vk::Pipeline();
+		rowSplit_[0] = rowSplit_[1] = 0;
+		columnSplit_[0] = columnSplit_[1] = 0;
+		workStride_ = 0;
+		workSlices_ = 1;
+		generation_ = 0;
+		pEngine_ = nullptr;
+	}
+
+	//----
+	void FFTPlan::ReleaseDescriptorSets()
+	{
+		if (!pEngine_)
+		{
+			return;
+		}
+		descSets_.clear();
+		descAllocator_.Reset();
+		generation_ = NextResourceGeneration();
+	}
+
+	//----
+	uint64_t FFTPlan::ComputeBytesMoved(const FFTPlanDesc& desc, FFTDataType::Type input, FFTDataType::Type output, FFTDataType::Type work)
+	{
+		// 行パスは 入力 -> 中間、列パスは 中間 -> 出力
+		uint64_t perElement = GetReadBytes(input, desc.precision) + GetWriteBytes(work, desc.precision)
+			+ GetReadBytes(work, desc.precision) + GetWriteBytes(output, desc.precision);
+		return perElement * desc.width * desc.height * desc.batch;
+	}
+
+	//----
+	uint64_t FFTPlan::GetBytesMoved(FFTDataType::Type input, FFTDataType::Type output) const
+	{
+		// 分割したパスごとに中間バッファへの書き込みと読み込みが増える
+		uint32_t splitCount = (rowSplit_[0] ? 1 : 0) + (columnSplit_[0] ? 1 : 0);
+		uint64_t perElement = (GetWriteBytes(FFTDataType::PackedBuffer, desc_.precision) + GetReadBytes(FFTDataType::PackedBuffer, desc_.precision)) * splitCount;
+		// 256固定のシェーダは中間もイメージ2枚
+		FFTDataType::Type work = (pEngine_ && pEngine_->IsFixedKernel()) ? FFTDataType::ComplexImages : FFTDataType::PackedBuffer;
+		return ComputeBytesMoved(desc_, input, output, work) + perElement * desc_.width * desc_.height * desc_.batch;
+	}
+
+	//----
+	const char* FFTPlan::GetPassName(uint32_t index) const
+	{
+		static const char* kRowNames[] = { "row", "row step1", "row step2" };
+		static const char* kColumnNames[] = { "column", "column step1", "column step2" };
+
+		uint32_t rowPassCount = rowSplit_[0] ? 2 : 1;
+		if (index < rowPassCount)
+		{
+			return kRowNames[rowSplit_[0] ? index + 1 : 0];
+		}
+		index -= rowPassCount;
+		if (index < (columnSplit_[0] ? 2u : 1u))
+		{
+			return kColumnNames[columnSplit_[0] ? index + 1 : 0];
+		}
+		return "";
+	}
+
+	//----
+	uint32_t FFTPlan::ComputeLineTransforms(const FFTPlanDesc& desc, FFTDataType::Type input, FFTDataType::Type output)
+	{
+		uint32_t rows = IsRowPaired(desc, input) ? desc.height / 2 : desc.height;
+		uint32_t columns = IsColumnPaired(desc, output) ? desc.width / 2 : desc.width;
+		return (rows + columns) * desc.batch;
+	}
+
+	//----
+	// 変換に使わないバインドもシェーダから静的に参照されるため、ダミーを設定しておく
+	void FFTPlan::WriteDescriptorSet(const vk::DescriptorSet& set, const FFTData& input, const FFTData& output)
+	{
+		vk::ImageView dummy = dummyImage_.GetView();
+		vk::ImageView inR = dummy, inI = dummy, outR = dummy, outI = dummy;
+		vk::ImageView source = dummySource_.GetView();
+		vk::DescriptorBufferInfo workInfo(workBuffer_.GetBuffer(), 0, GetPackedSize());
+		vk::DescriptorBufferInfo inInfo = workInfo, outInfo = workInfo;
+
+		switch (input.type)
+		{
+		case FFTDataType::RealImage:
+			source = input.real;
+			break;
+		case FFTDataType::ComplexImages:
+			inR = input.real;
+			inI = input.imaginary;
+			break;
+		default:
+			inInfo = vk::DescriptorBufferInfo(input.buffer, input.offset, GetPackedSize());
+			break;
+		}
+		switch (output.type)
+		{
+		case FFTDataType::RealImage:
+			outR = output.real;
+			break;
+		case FFTDataType::ComplexImages:
+			outR = output.real;
+			outI = output.imaginary;
+			break;
+		default:
+			outInfo = vk::DescriptorBufferInfo(output.buffer, output.offset, GetPackedSize());
+			break;
+		}
+
+		auto WriteImage = [&](uint32_t binding, const vk::ImageView& view)
+		{
+			vk::DescriptorImageInfo info(vk::Sampler(), view, vk::ImageLayout::eGeneral);
+			descWriter_.WriteImage(set, binding, vk::DescriptorType::eStorageImage, info);
+		};
+		// 256固定のシェーダは元画像も binding 0 から読み込み、バッファは使用しない
+		bool isFixed = pEngine_->IsFixedKernel();
+		if (isFixed && (input.type == FFTDataType::RealImage))
+		{
+			inR = input.real;
+		}
+		WriteImage(kBindingInputReal, inR);
+		WriteImage(kBindingInputImaginary, inI);
+		WriteImage(kBindingOutputReal, outR);
+		WriteImage(kBindingOutputImaginary, outI);
+		if (isFixed)
+		{
+			return;
+		}
+		if (desc_.direction == FFTDirection::Forward)
+		{
+			WriteImage(kBindingSource, source);
+		}
+		descWriter_.WriteBuffer(set, kBindingInputBuffer, vk::DescriptorType::eStorageBuffer, inInfo);
+		descWriter_.WriteBuffer(set, kBindingOutputBuffer, vk::DescriptorType::eStorageBuffer, outInfo);
+	}
+
+	//----
+	const std::vector<vk::DescriptorSet>& FFTPlan::GetDescriptorSets(const FFTData* pInputs, const FFTData* pOutputs)
+	{
+		std::vector<uint64_t> key;
+		for (uint32_t i = 0; i < desc_.batch; i++)
+		{
+			for (auto pData : { &pInputs[i], &pOutputs[i] })
+			{
+				key.push_back(pData->type);
+				key.push_back(ToKey(pData->real));
+				key.push_back(ToKey(pData->imaginary));
+				key.push_back(ToKey(pData->buffer));
+				key.push_back(pData->offset);
+				key.push_back(pData->generations[0]);
+				key.push_back(pData->generations[1]);
+			}
+		}
+		auto it = descSets_.find(key);
+		if (it != descSets_.end())
+		{
+			return it->second;
+		}
+
+		// セットは個別に解放できないため、組み合わせが多すぎる場合は失敗させる
+		static const std::vector<vk::DescriptorSet> kEmptySets;
+		if (descSets_.size() >= kMaxDescriptorSetEntries)
+		{
+			return kEmptySets;
+		}
+
+		std::vector<vk::DescriptorSet> sets;
+		for (uint32_t i = 0; i < desc_.batch; i++)
+		{
+			// パスの順に 入力 -> (中間1 ->) 中間0 (-> 中間1) -> 出力
+			FFTData work = pEngine_->IsFixedKernel()
+				? FFTData::Complex(workImages_[i * 2 + 0].GetView(), workImages_[i * 2 + 1].GetView())
+				: FFTData::Packed(workBuffer_.GetBuffer(), workStride_ * workSlices_ * i);
+			FFTData workStep = FFTData::Packed(workBuffer_.GetBuffer(), workStride_ * (workSlices_ * i + 1));
+			auto AddSet = [&](const FFTData& input, const FFTData& output)
+			{
+				vk::DescriptorSet set = descAllocator_.Allocate(pEngine_->setLayout_);
+				if (!set)
+				{
+					return;
+				}
+				sets.push_back(set);
+				WriteDescriptorSet(set, input, output);
+			};
+
+			if (rowSplit_[0])
+			{
+				AddSet(pInputs[i], workStep);
+				AddSet(workStep, work);
+			}
+			else
+			{
+				AddSet(pInputs[i], work);
+			}
+			if (columnSplit_[0])
+			{
+				AddSet(work, workStep);
+				AddSet(workStep, pOutputs[i]);
+			}
+			else
+			{
+				AddSet(work, pOutputs[i]);
+			}
+		}
+		descWriter_.Flush();
+		if (sets.size() != desc_.batch * GetPassCount())
+		{
+			return kEmptySets;
+		}
+
+		return descSets_[key] = sets;
+	}
+
+	//----
+	bool FFTPlan::Execute(vk::CommandBuffer& cmdBuffer, const FFTData* pInputs, const FFTData* pOutputs, const FFTTimestamp* pTimestamp)
+	{
+		if (!pEngine_)
+		{
+			return false;
+		}
+
+		FFTDataType::Type inType = pInputs[0].type;
+		FFTDataType::Type outType = pOutputs[0].type;
+		if ((desc_.direction == FFTDirection::Forward) && (outType == FFTDataType::RealImage))
+		{
+			return false;
+		}
+		if ((desc_.direction == FFTDirection::Inverse) && (inType == FFTDataType::RealImage))
+		{
+			return false;
+		}
+		for (uint32_t i = 1; i < desc_.batch; i++)
+		{
+			if ((pInputs[i].type != inType) || (pOutputs[i].type != outType))
+			{
+				return false;
+			}
+		}
+
+		// 256固定のシェーダは 実数画像 -> 複素イメージ -> 実数画像 の形式のみ
+		bool isFixed = pEngine_->IsFixedKernel();
+		if (isFixed)
+		{
+			bool isForward = (desc_.direction == FFTDirection::Forward);
+			if ((inType != (isForward ? FFTDataType::RealImage : FFTDataType::ComplexImages))
+				|| (outType != (isForward ? FFTDataType::ComplexImages : FFTDataType::RealImage)))
+			{
+				return false;
+			}
+		}
+
+		// 行パスは幅、列パスは高さの長さで変換する
+		// 中間バッファの1行は幅分の要素を持つ
+		// 実数の2行をまとめる場合は1つのワークグループで2行を処理する、分割したパスではまとめない
+		bool rowPaired = IsRowPaired(desc_, inType) && !rowSplit_[0] && !isFixed;
+		bool columnPaired = IsColumnPaired(desc_, outType) && !columnSplit_[0] && !isFixed;
+		bool fusePasses = (desc_.butterfly == FFTButterfly::Radix4);
+
+		FFT::PassDesc rowPass;
+		rowPass.length = desc_.width;
+		rowPass.isRowPass = true;
+		rowPass.input = inType;
+		rowPass.pitch = desc_.width;
+		rowPass.realPair = rowPaired;
+		rowPass.fusePasses = fusePasses;
+		rowPass.precision = desc_.precision;
+		FFT::PassDesc columnPass = rowPass;
+		columnPass.length = desc_.height;
+		columnPass.isRowPass = false;
+		columnPass.input = FFTDataType::PackedBuffer;
+		columnPass.output = outType;
+		columnPass.realPair = columnPaired;
+
+		// 分割する場合は1段目が入力、2段目が出力の形式を持つ
+		// split[0] 個の長さ split[1] の変換 -> split[1] 個の長さ split[0] の変換
+		auto SetupSplit = [](const FFT::PassDesc& base, const uint32_t* split, FFT::PassDesc& first, FFT::PassDesc& second)
+		{
+			first = second = base;
+			first.length = split[1];
+			first.output = FFTDataType::PackedBuffer;
+			first.stepType = kStepFirst;
+			first.stepCount = split[0];
+			second.length = split[0];
+			second.input = FFTDataType::PackedBuffer;
+			second.stepType = kStepSecond;
+			second.stepCount = split[1];
+		};
+		FFT::PassDesc rowFirst, rowSecond, columnFirst, columnSecond;
+		if (rowSplit_[0])
+		{
+			SetupSplit(rowPass, rowSplit_, rowFirst, rowSecond);
+			rowPass = rowFirst;
+		}
+		if (columnSplit_[0])
+		{
+			SetupSplit(columnPass, columnSplit_, columnFirst, columnSecond);
+			columnPass = columnSecond;
+		}
+
+		vk::Pipeline& rowPipeline = rowPipelines_[inType];
+		vk::Pipeline& columnPipeline = columnPipelines_[outType];
+		if (!rowPipeline)
+		{
+			rowPipeline = pEngine_->GetPipeline(desc_.direction, rowPass);
+		}
+		if (!columnPipeline)
+		{
+			columnPipeline = pEngine_->GetPipeline(desc_.direction, columnPass);
+		}
+		if (rowSplit_[0] && !rowSecondPipeline_)
+		{
+			rowSecondPipeline_ = pEngine_->GetPipeline(desc_.direction, rowSecond);
+		}
+		if (columnSplit_[0] && !columnFirstPipeline_)
+		{
+			columnFirstPipeline_ = pEngine_->GetPipeline(desc_.direction, columnFirst);
+		}
+		if (!rowPipeline || !columnPipeline || (rowSplit_[0] && !rowSecondPipeline_) || (columnSplit_[0] && !columnFirstPipeline_))
+		{
+			return false;
+		}
+
+		const std::vector<vk::DescriptorSet>& sets = GetDescriptorSets(pInputs, pOutputs);
+		if (sets.empty())
+		{
+			return false;
+		}
+		vk::PipelineLayout& pipeLayout = pEngine_->pipeLayout_;
+		uint32_t passCount = GetPassCount();
+
+		// 計算シェーダ間の書き込み -> 読み込み、書き込みの同期
+		vk::MemoryBarrier barrier(
+			vk::AccessFlagBits::eShaderWrite,
+			vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite);
+
+		// 開始時と各パスの終了時にタイムスタンプを書き込む
+		if (pTimestamp)
+		{
+			cmdBuffer.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, pTimestamp->pool, pTimestamp->firstQuery);
+		}
+
+		// x は分割したパスの変換番号、y は行または列
+		auto RecordPass = [&](vk::Pipeline& pipeline, uint32_t passIndex, uint32_t groupsX, uint32_t groupsY)
+		{
+			CmdPipelineBarrier(cmdBuffer, vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader, vk::DependencyFlags(), barrier, nullptr, nullptr);
+			CmdBindPipeline(cmdBuffer, vk::PipelineBindPoint::eCompute, pipeline);
+			for (uint32_t i = 0; i < desc_.batch; i++)
+			{
+				CmdBindDescriptorSets(cmdBuffer, vk::PipelineBindPoint::eCompute, pipeLayout, 0, sets[i * passCount + passIndex], nullptr);
+				CmdDispatch(cmdBuffer, groupsX, groupsY, 1);
+			}
+			if (pTimestamp)
+			{
+				cmdBuffer.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, pTimestamp->pool, pTimestamp->firstQuery + passIndex + 1);
+			}
+		};
+
+		uint32_t passIndex = 0;
+
+		// row pass
+		if (rowSplit_[0])
+		{
+			RecordPass(rowPipeline, passIndex++, rowSplit_[0], desc_.height);
+			RecordPass(rowSecondPipeline_, passIndex++, rowSplit_[1], desc_.height);
+		}
+		else
+		{
+			RecordPass(rowPipeline, passIndex++, 1, rowPaired ? desc_.height / 2 : desc_.height);
+		}
+
+		// column pass
+		if (columnSplit_[0])
+		{
+			RecordPass(columnFirstPipeline_, passIndex++, columnSplit_[0], desc_.width);
+			RecordPass(columnPipeline, passIndex++, columnSplit_[1], desc_.width);
+		}
+		else
+		{
+			RecordPass(columnPipeline, passIndex++, 1, columnPaired ? desc_.width / 2 : desc_.width);
+		}
+
+		return true;
+	}
+
+}	// namespace vsl
+
+
+//	EOF
@@ -0,0 +1,306 @@
+﻿#include <vsl/fft_benchmark.h>
+#include <vsl/device.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+
+
+namespace vsl
+{
+	//----
+	bool FFTBenchmark::Initialize(Device& owner, uint32_t maxQueries)
+	{
+		Destroy();
+
+		// グラフィクスキューと計算キューでタイムスタンプが使えない場合は計測できない
+		vk::PhysicalDeviceLimits limits = owner.GetPhysicalDevice().getProperties().limits;
+		if (!limits.timestampComputeAndGraphics || (owner.GetTimestampMask() == 0) || (maxQueries < 2))
+		{
+			return false;
+		}
+		nanosecondsPerTick_ = static_cast<double>(limits.timestampPeriod);
+		timestampMask_ = owner.GetTimestampMask();
+
+		vk::Device& device = owner.GetDevice();
+		vk::QueryPoolCreateInfo poolInfo(vk::QueryPoolCreateFlags(), vk::QueryType::eTimestamp, maxQueries);
+		queryPool_ = device.createQueryPool(poolInfo);
+		VSL_API_COUNT(ObjectCreate);
+		if (!queryPool_)
+		{
+			return false;
+		}
+		queryCount_ = maxQueries;
+
+		vk::CommandBufferAllocateInfo allocInfo;
+		allocInfo.commandPool = owner.GetCommandPool();
+		allocInfo.commandBufferCount = 1;
+		cmdBuffer_ = device.allocateCommandBuffers(allocInfo)[0];
+		VSL_API_COUNT(ObjectCreate);
+
+		fence_ = device.createFence(vk::FenceCreateInfo());
+		VSL_API_COUNT(ObjectCreate);
+
+		pOwner_ = &owner;
+		return true;
+	}
+
+	//----
+	void FFTBenchmark::Destroy()
+	{
+		if (!pOwner_)
+		{
+			return;
+		}
+
+		vk::Device& device = pOwner_->GetDevice();
+		if (fence_)
+		{
+			device.destroyFence(fence_);
+			VSL_API_COUNT(ObjectDestroy);
+			fence_ = vk::Fence();
+		}
+		if (cmdBuffer_)
+		{
+			device.freeCommandBuffers(pOwner_->GetCommandPool(), cmdBuffer_);
+			VSL_API_COUNT(ObjectDestroy);
+			cmdBuffer_ = vk::CommandBuffer();
+		}
+		if (queryPool_)
+		{
+			device.destroyQueryPool(queryPool_);
+			VSL_API_COUNT(ObjectDestroy);
+			queryPool_ = vk::QueryPool();
+		}
+		queryCount_ = 0;
+		referenceGigaBytesPerSecond_ = 0.0;
+		pOwner_ = nullptr;
+	}
+
+	//----
+	bool FFTBenchmark::Run(FFTPlan& plan, const FFTData* pInputs, const FFTData* pOutputs, uint32_t warmup, uint32_t iterations, FFTBenchmarkResult& result)
+	{
+		if (!pOwner_ || !plan.IsValid() || (iterations == 0))
+		{
+			return false;
+		}
+
+		// 反復ごとにパス数 + 1 個のクエリを使う
+		uint32_t passCount = plan.GetPassCount();
+		uint32_t queriesPerIteration = passCount + 1;
+		if (iterations * queriesPerIteration > queryCount_)
+		{
+			return false;
+		}
+		uint32_t queryCount = iterations * queriesPerIteration;
+
+		cmdBuffer_.reset(vk::CommandBufferResetFlags());
+		vk::CommandBufferBeginInfo beginInfo;
+		beginInfo.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
+		cmdBuffer_.begin(&beginInfo);
+		cmdBuffer_.resetQueryPool(queryPool_, 0, queryCount);
+
+		// ウォームアップはクロックの立ち上がりとキャッシュの準備のため、計測はしない
+		for (uint32_t i = 0; i < warmup; i++)
+		{
+			if (!plan.Execute(cmdBuffer_, pInputs, pOutputs))
+			{
+				cmdBuffer_.end();
+				return false;
+			}
+		}
+		for (uint32_t i = 0; i < iterations; i++)
+		{
+			FFTTimestamp timestamp;
+			timestamp.pool = queryPool_;
+			timestamp.firstQuery = i * queriesPerIteration;
+			if (!plan.Execute(cmdBuffer_, pInputs, pOutputs, &timestamp))
+			{
+				cmdBuffer_.end();
+				return false;
+			}
+		}
+		cmdBuffer_.end();
+
+		std::vector<uint64_t> timestamps;
+		if (!SubmitAndWait() || !ReadTimestamps(queryCount, timestamps))
+		{
+			return false;
+		}
+
+		// パスごとの差分を反復数で平均する
+		std::vector<uint64_t> passTicks(passCount, 0);
+		uint64_t totalTicks = 0;
+		for (uint32_t i = 0; i < iterations; i++)
+		{
+			const uint64_t* pTimes = &timestamps[i * queriesPerIteration];
+			for (uint32_t p = 0; p < passCount; p++)
+			{
+				passTicks[p] += GetTicks(pTimes[p], pTimes[p + 1]);
+			}
+			totalTicks += GetTicks(pTimes[0], pTimes[passCount]);
+		}
+
+		double msPerTick = nanosecondsPerTick_ * 1e-6 / static_cast<double>(iterations);
+		result.passMilliseconds.resize(passCount);
+		for (uint32_t p = 0; p < passCount; p++)
+		{
+			result.passMilliseconds[p] = static_cast<double>(passTicks[p]) * msPerTick;
+		}
+		result.totalMilliseconds = static_cast<double>(totalTicks) * msPerTick;
+
+		double seconds = result.totalMilliseconds * 1e-3;
+		uint64_t bytes = plan.GetBytesMoved(pInputs[0].type, pOutputs[0].type);
+		result.transformsPerSecond = (seconds > 0.0) ? static_cast<double>(plan.GetDesc().batch) / seconds : 0.0;
+		result.gigaBytesPerSecond = (seconds > 0.0) ? static_cast<double>(bytes) / seconds * 1e-9 : 0.0;
+		result.referenceGigaBytesPerSecond = referenceGigaBytesPerSecond_;
+		return true;
+	}
+
+	//----
+	bool FFTBenchmark::MeasureCopyBandwidth(vk::DeviceSize size, uint32_t iterations)
+	{
+		if (!pOwner_ || (iterations == 0) || (iterations * 2 > queryCount_))
+		{
+			return false;
+		}
+
+		Buffer src, dst;
+		if (!src.InitializeAsStorageBuffer(*pOwner_, static_cast<size_t>(size))
+			|| !dst.InitializeAsStorageBuffer(*pOwner_, static_cast<size_t>(size)))
+		{
+			return false;
+		}
+
+		cmdBuffer_.reset(vk::CommandBufferResetFlags());
+		vk::CommandBufferBeginInfo beginInfo;
+		beginInfo.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
+		cmdBuffer_.begin(&beginInfo);
+		cmdBuffer_.resetQueryPool(queryPool_, 0, iterations * 2);
+
+		// 1回目は計測に含めず、以降は前のコピーの完了を待ってから計測する
+		dst.CopyFrom(cmdBuffer_, src);
+		for (uint32_t i = 0; i < iterations; i++)
+		{
+			vk::MemoryBarrier barrier(vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eTransferWrite);
+			CmdPipelineBarrier(cmdBuffer_, vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer, vk::DependencyFlags(), barrier, nullptr, nullptr);
+			cmdBuffer_.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, queryPool_, i * 2);
+			dst.CopyFrom(cmdBuffer_, src);
+			cmdBuffer_.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, queryPool_, i * 2 + 1);
+		}
+		cmdBuffer_.end();
+
+		std::vector<uint64_t> timestamps;
+		bool ret = SubmitAndWait() && ReadTimestamps(iterations * 2, timestamps);
+		src.Destroy();
+		dst.Destroy();
+		if (!ret)
+		{
+			return false;
+		}
+
+		// 最速の1回を採用する、コピーは読み込みと書き込みで2倍のメモリ量
+		uint64_t minTicks = UINT64_MAX;
+		for (uint32_t i = 0; i < iterations; i++)
+		{
+			minTicks = (std::min)(minTicks, GetTicks(timestamps[i * 2], timestamps[i * 2 + 1]));
+		}
+		double seconds = static_cast<double>(minTicks) * nanosecondsPerTick_ * 1e-9;
+		referenceGigaBytesPerSecond_ = (seconds > 0.0) ? static_cast<double>(size * 2) / seconds * 1e-9 : 0.0;
+		return true;
+	}
+
+	//----
+	bool FFTBenchmark::SubmitAndWait()
+	{
+		vk::Device& device = pOwner_->GetDevice();
+
+		vk::SubmitInfo submitInfo;
+		submitInfo.pCommandBuffers = &cmdBuffer_;
+		submitInfo.commandBufferCount = 1;
+		device.resetFences(fence_);
+		QueueSubmit(pOwner_->GetQueue(), submitInfo, fence_);
+		VSL_CPU_SCOPE("WaitFence");
+		return device.waitForFences(fence_, VK_TRUE, UINT64_MAX) == vk::Result::eSuccess;
+	}
+
+	//----
+	bool FFTBenchmark::ReadTimestamps(uint32_t count, std::vector<uint64_t>& timestamps)
+	{
+		timestamps.resize(count);
+		vk::Result result = pOwner_->GetDevice().getQueryPoolResults(queryPool_, 0, count,
+			timestamps.size() * sizeof(uint64_t), timestamps.data(), sizeof(uint64_t),
+			vk::QueryResultFlagBits::e64 | vk::QueryResultFlagBits::eWait);
+		return result == vk::Result::eSuccess;
+	}
+
+	//----
+	std::string FFTBenchmark::ToText(const char* name, const FFTPlan& plan, const FFTBenchmarkResult& result)
+	{
+		const FFTPlanDesc& desc = plan.GetDesc();
+		char str[256];
+		std::string ret;
+
+		sprintf_s(str, "%s %ux%u x%u : %.3f ms, %.1f transforms/s, %.2f GB/s",
+			name, desc.width, desc.height, desc.batch,
+			result.totalMilliseconds, result.transformsPerSecond, result.gigaBytesPerSecond);
+		ret += str;
+		if (result.referenceGigaBytesPerSecond > 0.0)
+		{
+			sprintf_s(str, " (%.1f%% of copy %.2f GB/s)",
+				result.gigaBytesPerSecond / result.referenceGigaBytesPerSecond * 100.0, result.referenceGigaBytesPerSecond);
+			ret += str;
+		}
+		ret += "\n";
+		for (size_t i = 0; i < result.passMilliseconds.size(); i++)
+		{
+			sprintf_s(str, "  %-14s : %.3f ms\n", plan.GetPassName(static_cast<uint32_t>(i)), result.passMilliseconds[i]);
+			ret += str;
+		}
+		return ret;
+	}
+
+	//----
+	std::string FFTBenchmark::GetCsvHeader()
+	{
+		std::string ret = "name,width,height,batch,total_ms,transforms_per_sec,gb_per_sec,reference_gb_per_sec";
+		for (uint32_t i = 0; i < kMaxCsvPasses; i++)
+		{
+			char str[32];
+			sprintf_s(str, ",pass%u_ms", i);
+			ret += str;
+		}
+		ret += "\n";
+		return ret;
+	}
+
+	//----
+	std::string FFTBenchmark::ToCsv(const char* name, const FFTPlan& plan, const FFTBenchmarkResult& result)
+	{
+		const FFTPlanDesc& desc = plan.GetDesc();
+		char str[256];
+		std::string ret;
+
+		sprintf_s(str, "%s,%u,%u,%u,%.4f,%.2f,%.3f,%.3f",
+			name, desc.width, desc.height, desc.batch,
+			result.totalMilliseconds, result.transformsPerSecond, result.gigaBytesPerSecond, result.referenceGigaBytesPerSecond);
+		ret += str;
+		for (uint32_t i = 0; i < kMaxCsvPasses; i++)
+		{
+			if (i < result.passMilliseconds.size())
+			{
+				sprintf_s(str, ",%.4f", result.passMilliseconds[i]);
+				ret += str;
+			}
+			else
+			{
+				ret += ",";
+			}
+		}
+		ret += "\n";
+		return ret;
+	}
+
+}	// namespace vsl
+
+
+//	EOF
@@ -0,0 +1,536 @@
+﻿#include <vsl/fft_convolution.h>
+#include <vsl/device.h>
+#include <vsl/shader_bundle.h>
+#include <vsl/layout_cache.h>
+#include <vsl/pipeline_builder.h>
+#include <vsl/descriptor_allocator.h>
+#include <vsl/cpu_fft.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+
+namespace vsl
+{
+	namespace
+	{
+		// convolve.comp, fft_multiply.comp のバインド番号
+		static const uint32_t kBindingSpatialSource = 0;
+		static const uint32_t kBindingSpatialOutput = 1;
+		static const uint32_t kBindingSpatialWeights = 2;
+		static const uint32_t kBindingMultiplySpectrum = 0;
+		static const uint32_t kBindingMultiplyKernel = 1;
+
+		// ワークグループサイズ
+		static const uint32_t kSpatialGroupSize = 8;
+		static const uint32_t kMultiplyGroupSize = 64;
+
+		// FFTの負荷の見積もり(直接畳み込みの1タップ換算)
+		// バタフライ1段と、パスごとのメモリの読み書き
+		static const double kButterflyCost = 2.0;
+		static const double kPassCost = 8.0;
+		static const double kMultiplyCost = 2.0;
+
+		static const double kPi = 3.14159265358979323846;
+
+		//----
+		uint32_t Log2(uint32_t v)
+		{
+			uint32_t ret = 0;
+			while ((1u << ret) < v)
+			{
+				ret++;
+			}
+			return ret;
+		}
+
+		//----
+		template <typename T>
+		uint64_t ToKey(const T& handle)
+		{
+			uint64_t ret = 0;
+			memcpy(&ret, &handle, (std::min)(sizeof(ret), sizeof(handle)));
+			return ret;
+		}
+
+		//----
+		// チャンネルごとに合計を1にする
+		void Normalize(FFTConvolutionKernel& kernel)
+		{
+			for (uint32_t c = 0; c < 3; c++)
+			{
+				double sum = 0.0;
+				for (size_t i = c; i < kernel.weights.size(); i += 3)
+				{
+					sum += kernel.weights[i];
+				}
+				if (sum <= 0.0)
+				{
+					continue;
+				}
+				for (size_t i = c; i < kernel.weights.size(); i += 3)
+				{
+					kernel.weights[i] = static_cast<float>(kernel.weights[i] / sum);
+				}
+			}
+		}
+	}	// namespace
+
+	//----
+	FFTConvolutionKernel FFTConvolutionKernel::Gaussian(uint32_t radius, float sigma)
+	{
+		FFTConvolutionKernel ret;
+		ret.radius = radius;
+		uint32_t width = ret.GetWidth();
+		ret.weights.resize(width * width * 3);
+
+		double s = (std::max)(static_cast<double>(sigma), 1e-3);
+		for (uint32_t y = 0; y < width; y++)
+		{
+			for (uint32_t x = 0; x < width; x++)
+			{
+				double dx = static_cast<double>(x) - radius;
+				double dy = static_cast<double>(y) - radius;
+				float w = static_cast<float>(std::exp(-(dx * dx + dy * dy) / (2.0 * s * s)));
+				for (uint32_t c = 0; c < 3; c++)
+				{
+					ret.weights[(y * width + x) * 3 + c] = w;
+				}
+			}
+		}
+		Normalize(ret);
+		return ret;
+	}
+
+	//----
+	FFTConvolutionKernel FFTConvolutionKernel::Star(uint32_t radius, uint32_t streakCount)
+	{
+		FFTConvolutionKernel ret;
+		ret.radius = radius;
+		uint32_t width = ret.GetWidth();
+		ret.weights.resize(width * width * 3);
+
+		// 長い波長ほど遠くまで伸びるようにする
+		static const double kChannelLength[] = { 1.0, 0.8, 0.6 };
+		double length = (std::max)(static_cast<double>(radius) / 3.0, 1.0);
+		uint32_t count = (std::max)(streakCount, 1u);
+		for (uint32_t y = 0; y < width; y++)
+		{
+			for (uint32_t x = 0; x < width; x++)
+			{
+				double dx = static_cast<double>(x) - radius;
+				double dy = static_cast<double>(y) - radius;
+				double d = std::sqrt(dx * dx + dy * dy);
+
+				// 最も近い光条までの垂直距離
+				double angle = std::atan2(dy, dx);
+				double step = 2.0 * kPi / count;
+				double diff = std::fmod(angle + 2.0 * kPi, step);
+				diff = (std::min)(diff, step - diff);
+				double perpendicular = d * std::sin(diff);
+				double streak = std::exp(-perpendicular * perpendicular * 2.0);
+
+				for (uint32_t c = 0; c < 3; c++)
+				{
+					double falloff = std::exp(-d / (length * kChannelLength[c]));
+					double core = (d < 0.5) ? 1.0 : 0.0;
+					ret.weights[(y * width + x) * 3 + c] = static_cast<float>(streak * falloff + core);
+				}
+			}
+		}
+		Normalize(ret);
+		return ret;
+	}
+
+	//----
+	bool FFTConvolution::Initialize(FFT& engine, const ShaderBundle& bundle, vk::CommandBuffer& cmdBuffer, const FFTConvolutionDesc& desc)
+	{
+		Destroy();
+
+		// スペクトルは PackedBuffer で持つため、256固定のシェーダでは使用できない
+		if (engine.IsFixedKernel() || (desc.precision == FFTPrecision::Single))
+		{
+			return false;
+		}
+
+		FFTPlanDesc planDesc;
+		planDesc.width = desc.width;
+		planDesc.height = desc.height;
+		planDesc.precision = desc.precision;
+		planDesc.direction = FFTDirection::Forward;
+		if (!forward_.Initialize(engine, cmdBuffer, planDesc))
+		{
+			return false;
+		}
+		planDesc.direction = FFTDirection::Inverse;
+		if (!inverse_.Initialize(engine, cmdBuffer, planDesc))
+		{
+			return false;
+		}
+
+		Device& device = *engine.GetDevice();
+		size_t spectrumSize = static_cast<size_t>(forward_.GetPackedSize());
+		uint32_t maxWidth = desc.maxSpatialRadius * 2 + 1;
+		if (!spectrum_.InitializeAsStorageBuffer(device, spectrumSize)
+			|| !kernelSpectrum_.InitializeAsStorageBuffer(device, spectrumSize)
+			|| !weights_.InitializeAsStorageBuffer(device, maxWidth * maxWidth * sizeof(float) * 4))
+		{
+			return false;
+		}
+
+		if (!multiplyShader_.CreateFromBundle(device, bundle, "fft_multiply.comp.spv")
+			|| !spatialShader_.CreateFromBundle(device, bundle, "convolve.comp.spv"))
+		{
+			return false;
+		}
+
+		// レイアウトとパイプラインはDeviceのキャッシュが所有する
+		auto CreatePipeline = [&](Shader& shader, vk::DescriptorSetLayout& setLayout, vk::PipelineLayout& pipeLayout, vk::Pipeline& pipeline)
+		{
+			std::vector<vk::DescriptorSetLayout> setLayouts;
+			if (!device.GetLayoutCache().GetLayouts({ &shader }, setLayouts, pipeLayout) || (setLayouts.size() != 1))
+			{
+				return false;
+			}
+			setLayout = setLayouts[0];
+
+			ComputePipelineBuilder builder;
+			builder.SetShader(shader.GetModule())
+				.SetLayout(pipeLayout);
+			pipeline = builder.Build(device);
+			return static_cast<bool>(pipeline);
+		};
+		if (!CreatePipeline(multiplyShader_, multiplySetLayout_, multiplyPipeLayout_, multiplyPipeline_)
+			|| !CreatePipeline(spatialShader_, spatialSetLayout_, spatialPipeLayout_, spatialPipeline_))
+		{
+			return false;
+		}
+
+		// セットは畳み込みのアロケータから確保し、破棄でまとめて解放する
+		// 直接畳み込みのセットは ReleaseDescriptorSets() で解放できるように分ける
+		std::vector<DescriptorAllocator::PoolSizeRatio> ratios = {
+			{ vk::DescriptorType::eStorageBuffer, 2.0f },
+		};
+		std::vector<DescriptorAllocator::PoolSizeRatio> spatialRatios = {
+			{ vk::DescriptorType::eStorageImage, 2.0f },
+			{ vk::DescriptorType::eStorageBuffer, 1.0f },
+		};
+		if (!descAllocator_.Initialize(device, 1, ratios) || !spatialAllocator_.Initialize(device, kMaxSpatialSets, spatialRatios))
+		{
+			return false;
+		}
+		if (!descWriter_.Initialize(device))
+		{
+			return false;
+		}
+
+		// 乗算のセットは入出力が固定
+		multiplySet_ = descAllocator_.Allocate(multiplySetLayout_);
+		if (!multiplySet_)
+		{
+			return false;
+		}
+		descWriter_.WriteBuffer(multiplySet_, kBindingMultiplySpectrum, vk::DescriptorType::eStorageBuffer, vk::DescriptorBufferInfo(spectrum_.GetBuffer(), 0, spectrumSize));
+		descWriter_.WriteBuffer(multiplySet_, kBindingMultiplyKernel, vk::DescriptorType::eStorageBuffer, vk::DescriptorBufferInfo(kernelSpectrum_.GetBuffer(), 0, spectrumSize));
+		descWriter_.Flush();
+
+		desc_ = desc;
+		pEngine_ = &engine;
+		return true;
+	}
+
+	//----
+	void FFTConvolution::Destroy()
+	{
+		// レイアウトとパイプラインはDeviceのキャッシュが所有している
+		spatialSets_.clear();
+		multiplySet_ = vk::DescriptorSet();
+		descAllocator_.Destroy();
+		spatialAllocator_.Destroy();
+		descWriter_.Destroy();
+		multiplyPipeline_ = spatialPipeline_ = vk::Pipeline();
+		multiplyPipeLayout_ = spatialPipeLayout_ = vk::PipelineLayout();
+		multiplySetLayout_ = spatialSetLayout_ = vk::DescriptorSetLayout();
+		multiplyShader_.Destroy();
+		spatialShader_.Destroy();
+		spectrum_.Destroy();
+		kernelSpectrum_.Destroy();
+		weights_.Destroy();
+		forward_.Destroy();
+		inverse_.Destroy();
+		radius_ = 0;
+		hasKernel_ = false;
+		pEngine_ = nullptr;
+	}
+
+	//----
+	bool FFTConvolution::SetKernel(const FFTConvolutionKernel& kernel)
+	{
+		if (!pEngine_)
+		{
+			return false;
+		}
+		uint32_t width = kernel.GetWidth();
+		if ((width > desc_.width) || (width > desc_.height) || (kernel.weights.size() != width * width * 3))
+		{
+			return false;
+		}
+
+		// カーネルの中心を原点に置き、負の位置は反対側に回り込ませる
+		// FFT は順逆とも 1/sqrt(N) でスケーリングするため、スペクトル同士の積から畳み込みを得るにはカーネルを sqrt(N) 倍しておく
+		float spectrumScale = std::sqrt(static_cast<float>(desc_.width * desc_.height));
+		CpuFFTImage image;
+		image.Initialize(desc_.width, desc_.height);
+		for (uint32_t y = 0; y < width; y++)
+		{
+			uint32_t py = (y + desc_.height - kernel.radius) & (desc_.height - 1);
+			for (uint32_t x = 0; x < width; x++)
+			{
+				uint32_t px = (x + desc_.width - kernel.radius) & (desc_.width - 1);
+				for (uint32_t c = 0; c < CpuFFTImage::kChannelCount; c++)
+				{
+					image.GetReal(c)[py * desc_.width + px] = kernel.weights[(y * width + x) * 3 + c] * spectrumScale;
+				}
+			}
+		}
+
+		Device& device = *pEngine_->GetDevice();
+		size_t spectrumSize = static_cast<size_t>(forward_.GetPackedSize());
+		std::vector<uint8_t> packed(spectrumSize);
+		image.ToPacked(packed.data(), desc_.precision);
+		Buffer packedStaging, weightsStaging;
+		if (!packedStaging.InitializeAsStaging(device, spectrumSize, packed.data()))
+		{
+			return false;
+		}
+
+		// 直接畳み込みの重みは vec4 で並べる
+		bool isSpatialAvailable = kernel.radius <= desc_.maxSpatialRadius;
+		size_t weightsSize = width * width * sizeof(float) * 4;
+		if (isSpatialAvailable)
+		{
+			std::vector<float> weights(width * width * 4, 0.0f);
+			for (uint32_t i = 0; i < width * width; i++)
+			{
+				for (uint32_t c = 0; c < 3; c++)
+				{
+					weights[i * 4 + c] = kernel.weights[i * 3 + c];
+				}
+			}
+			if (!weightsStaging.InitializeAsStaging(device, weightsSize, weights.data()))
+			{
+				return false;
+			}
+		}
+
+		// キュー全体の完了は待たず、転送とFFTは専用のフェンスで待つ
+		bool ret = SubmitAndWait([&](vk::CommandBuffer& cmdBuffer)
+		{
+			// 同じキューに先に積まれた Execute() がカーネルと spectrum_ を参照し終えてから上書きする
+			{
+				vk::MemoryBarrier barrier(vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eTransferWrite);
+				CmdPipelineBarrier(cmdBuffer, vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eTransfer, vk::DependencyFlags(), barrier, nullptr, nullptr);
+			}
+			// 作業用に spectrum_ を使って順変換する
+			spectrum_.CopyFrom(cmdBuffer, packedStaging);
+			if (isSpatialAvailable)
+			{
+				weights_.CopyFrom(cmdBuffer, weightsStaging, 0, 0, weightsSize);
+			}
+			{
+				vk::MemoryBarrier barrier(vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eShaderRead);
+				CmdPipelineBarrier(cmdBuffer, vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eComputeShader, vk::DependencyFlags(), barrier, nullptr, nullptr);
+			}
+			forward_.Execute(cmdBuffer, FFTData::Packed(spectrum_), FFTData::Packed(kernelSpectrum_));
+			{
+				vk::MemoryBarrier barrier(vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite);
+				CmdPipelineBarrier(cmdBuffer, vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader, vk::DependencyFlags(), barrier, nullptr, nullptr);
+			}
+		});
+		packedStaging.Destroy();
+		weightsStaging.Destroy();
+		if (!ret)
+		{
+			return false;
+		}
+
+		radius_ = kernel.radius;
+		hasKernel_ = true;
+		return true;
+	}
+
+	//----
+	bool FFTConvolution::Execute(vk::CommandBuffer& cmdBuffer, const FFTData& input, const FFTData& output, FFTConvolutionMethod::Type method)
+	{
+		if (!pEngine_ || !hasKernel_)
+		{
+			return false;
+		}
+		if ((input.type != FFTDataType::RealImage) || (output.type != FFTDataType::RealImage))
+		{
+			return false;
+		}
+
+		vk::MemoryBarrier barrier(
+			vk::AccessFlagBits::eShaderWrite,
+			vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite);
+
+		if (ResolveMethod(method) == FFTConvolutionMethod::Spatial)
+		{
+			vk::DescriptorSet set = GetSpatialSet(input, output);
+			if (!set)
+			{
+				return false;
+			}
+			int32_t radius = static_cast<int32_t>(radius_);
+			CmdPipelineBarrier(cmdBuffer, vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader, vk::DependencyFlags(), barrier, nullptr, nullptr);
+			CmdBindPipeline(cmdBuffer, vk::PipelineBindPoint::eCompute, spatialPipeline_);
+			CmdBindDescriptorSets(cmdBuffer, vk::PipelineBindPoint::eCompute, spatialPipeLayout_, 0, set, nullptr);
+			cmdBuffer.pushConstants(spatialPipeLayout_, vk::ShaderStageFlagBits::eCompute, 0, sizeof(radius), &radius);
+			CmdDispatch(cmdBuffer, (desc_.width + kSpatialGroupSize - 1) / kSpatialGroupSize, (desc_.height + kSpatialGroupSize - 1) / kSpatialGroupSize, 1);
+			return true;
+		}
+
+		// 順変換 -> カーネルのスペクトルを乗算 -> 逆変換
+		FFTData spectrum = FFTData::Packed(spectrum_);
+		if (!forward_.Execute(cmdBuffer, input, spectrum))
+		{
+			return false;
+		}
+
+		uint32_t count = desc_.width * desc_.height * CpuFFTImage::kChannelCount;
+		CmdPipelineBarrier(cmdBuffer, vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader, vk::DependencyFlags(), barrier, nullptr, nullptr);
+		CmdBindPipeline(cmdBuffer, vk::PipelineBindPoint::eCompute, multiplyPipeline_);
+		CmdBindDescriptorSets(cmdBuffer, vk::PipelineBindPoint::eCompute, multiplyPipeLayout_, 0, multiplySet_, nullptr);
+		cmdBuffer.pushConstants(multiplyPipeLayout_, vk::ShaderStageFlagBits::eCompute, 0, sizeof(count), &count);
+		CmdDispatch(cmdBuffer, (count + kMultiplyGroupSize - 1) / kMultiplyGroupSize, 1, 1);
+
+		return inverse_.Execute(cmdBuffer, spectrum, output);
+	}
+
+	//----
+	FFTConvolutionMethod::Type FFTConvolution::ResolveMethod(FFTConvolutionMethod::Type method) const
+	{
+		if (method == FFTConvolutionMethod::Auto)
+		{
+			method = ChooseMethod(desc_.width, desc_.height, radius_);
+		}
+		// 重みバッファに収まらない半径は直接畳み込みできない
+		if ((method == FFTConvolutionMethod::Spatial) && (radius_ > desc_.maxSpatialRadius))
+		{
+			method = FFTConvolutionMethod::FFT;
+		}
+		return method;
+	}
+
+	//----
+	// 直接畳み込みは (2r+1)^2 タップ
+	// FFTは順変換と逆変換がそれぞれ行と列の2パスで、各パスで log2(長さ) 段のバタフライを計算する
+	double FFTConvolution::EstimateCost(FFTConvolutionMethod::Type method, uint32_t width, uint32_t height, uint32_t radius)
+	{
+		if (method == FFTConvolutionMethod::Auto)
+		{
+			method = ChooseMethod(width, height, radius);
+		}
+		if (method == FFTConvolutionMethod::Spatial)
+		{
+			double taps = static_cast<double>(radius * 2 + 1);
+			return taps * taps;
+		}
+		double transform = kButterflyCost * (Log2(width) + Log2(height)) + kPassCost * 2.0;
+		return transform * 2.0 + kMultiplyCost;
+	}
+
+	//----
+	FFTConvolutionMethod::Type FFTConvolution::ChooseMethod(uint32_t width, uint32_t height, uint32_t radius)
+	{
+		double spatial = EstimateCost(FFTConvolutionMethod::Spatial, width, height, radius);
+		double fft = EstimateCost(FFTConvolutionMethod::FFT, width, height, radius);
+		return (spatial <= fft) ? FFTConvolutionMethod::Spatial : FFTConvolutionMethod::FFT;
+	}
+
+	//----
+	bool FFTConvolution::SubmitAndWait(const std::function<void(vk::CommandBuffer&)>& record)
+	{
+		Device& device = *pEngine_->GetDevice();
+		vk::Device& d = device.GetDevice();
+
+		vk::CommandBufferAllocateInfo allocInfo;
+		allocInfo.commandPool = device.GetCommandPool();
+		allocInfo.commandBufferCount = 1;
+		vk::CommandBuffer cmdBuffer = d.allocateCommandBuffers(allocInfo)[0];
+		VSL_API_COUNT(ObjectCreate);
+
+		vk::CommandBufferBeginInfo beginInfo;
+		beginInfo.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
+		cmdBuffer.begin(&beginInfo);
+		record(cmdBuffer);
+		cmdBuffer.end();
+
+		vk::Fence fence = d.createFence(vk::FenceCreateInfo());
+		VSL_API_COUNT(ObjectCreate);
+		vk::SubmitInfo submitInfo;
+		submitInfo.pCommandBuffers = &cmdBuffer;
+		submitInfo.commandBufferCount = 1;
+		QueueSubmit(device.GetQueue(), submitInfo, fence);
+		bool ret = false;
+		{
+			VSL_CPU_SCOPE("WaitFence");
+			ret = d.waitForFences(fence, VK_TRUE, UINT64_MAX) == vk::Result::eSuccess;
+		}
+
+		d.destroyFence(fence);
+		VSL_API_COUNT(ObjectDestroy);
+		d.freeCommandBuffers(device.GetCommandPool(), cmdBuffer);
+		VSL_API_COUNT(ObjectDestroy);
+		return ret;
+	}
+
+	//----
+	void FFTConvolution::ReleaseDescriptorSets()
+	{
+		if (!pEngine_)
+		{
+			return;
+		}
+		spatialSets_.clear();
+		spatialAllocator_.Reset();
+		forward_.ReleaseDescriptorSets();
+		inverse_.ReleaseDescriptorSets();
+	}
+
+	//----
+	vk::DescriptorSet FFTConvolution::GetSpatialSet(const FFTData& input, const FFTData& output)
+	{
+		std::vector<uint64_t> key = { ToKey(input.real), input.generations[0], ToKey(output.real), output.generations[0] };
+		auto it = spatialSets_.find(key);
+		if (it != spatialSets_.end())
+		{
+			return it->second;
+		}
+
+		// セットは個別に解放できないため、組み合わせが多すぎる場合は失敗させる
+		if (spatialSets_.size() >= kMaxSpatialSets)
+		{
+			return vk::DescriptorSet();
+		}
+
+		vk::DescriptorSet set = spatialAllocator_.Allocate(spatialSetLayout_);
+		if (!set)
+		{
+			return set;
+		}
+		vk::DescriptorImageInfo sourceInfo(vk::Sampler(), input.real, vk::ImageLayout::eGeneral);
+		vk::DescriptorImageInfo outputInfo(vk::Sampler(), output.real, vk::ImageLayout::eGeneral);
+		descWriter_.WriteImage(set, kBindingSpatialSource, vk::DescriptorType::eStorageImage, sourceInfo);
+		descWriter_.WriteImage(set, kBindingSpatialOutput, vk::DescriptorType::eStorageImage, outputInfo);
+		descWriter_.WriteBuffer(set, kBindingSpatialWeights, vk::DescriptorType::eStorageBuffer, weights_.GetDescInfo());
+		descWriter_.Flush();
+
+		return spatialSets_[key] = set;
+	}
+
+}	// namespace vsl
+
+
+//	EOF
@@ -0,0 +1,307 @@
+﻿#include <vsl/fft_validator.h>
+#include <vsl/device.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+
+namespace vsl
+{
+	//----
+	bool FFTValidator::Initialize(FFT& engine, vk::CommandBuffer& cmdBuffer, const FFTPlanDesc& desc)
+	{
+		Destroy();
+
+		FFTPlanDesc validateDesc = desc;
+		validateDesc.batch = 1;
+		validateDesc.direction = FFTDirection::Inverse;
+		if (!inversePlan_.Initialize(engine, cmdBuffer, validateDesc))
+		{
+			return false;
+		}
+		validateDesc.direction = FFTDirection::Forward;
+		if (!plan_.Initialize(engine, cmdBuffer, validateDesc))
+		{
+			return false;
+		}
+		pOwner_ = engine.GetDevice();
+		if (!cpuPlan_.Initialize(validateDesc, &pOwner_->GetThreadPool()))
+		{
+			return false;
+		}
+
+		// テスト画像はノイズと低周波の波を混ぜたもの
+		source_.Initialize(desc.width, desc.height);
+		uint32_t seed = 12345;
+		for (uint32_t c = 0; c < CpuFFTImage::kChannelCount; c++)
+		{
+			float* pReal = source_.GetReal(c);
+			for (uint32_t y = 0; y < desc.height; y++)
+			{
+				for (uint32_t x = 0; x < desc.width; x++)
+				{
+					seed = seed * 1103515245 + 12345;
+					float noise = static_cast<float>((seed >> 16) & 0xff) / 255.0f;
+					float wave = 0.5f + 0.5f * std::sin(static_cast<float>(x * (c + 1) + y * 2) * 0.05f);
+					pReal[y * desc.width + x] = noise * 0.5f + wave * 0.5f;
+				}
+			}
+		}
+
+		// 同じ画像を rgba8 に丸めてイメージの入力にする
+		uint32_t planeSize = desc.width * desc.height;
+		std::vector<uint8_t> pixels(static_cast<size_t>(planeSize) * 4, 0xff);
+		for (uint32_t i = 0; i < planeSize; i++)
+		{
+			for (uint32_t c = 0; c < CpuFFTImage::kChannelCount; c++)
+			{
+				float v = (std::min)((std::max)(source_.GetReal(c)[i], 0.0f), 1.0f);
+				pixels[i * 4 + c] = static_cast<uint8_t>(v * 255.0f + 0.5f);
+			}
+		}
+		imageSource_.Initialize(desc.width, desc.height);
+		imageSource_.SetRGBA8(pixels.data());
+		if (!InitializeImages(cmdBuffer, pixels))
+		{
+			return false;
+		}
+
+		// 256固定のシェーダは PackedBuffer を扱えないため、イメージの検証のみ行う
+		isPackedChecked_ = !engine.IsFixedKernel();
+		if (!isPackedChecked_)
+		{
+			return true;
+		}
+
+		// PackedBuffer に詰めた後に戻し、GPUと同じ精度の値をCPUの入力にする
+		std::vector<uint32_t> packed(static_cast<size_t>(plan_.GetPackedSize() / sizeof(uint32_t)));
+		source_.ToPacked(packed.data(), validateDesc.precision);
+		source_.FromPacked(packed.data(), validateDesc.precision);
+
+		size_t size = static_cast<size_t>(plan_.GetPackedSize());
+		if (!upload_.InitializeAsStaging(*pOwner_, size)
+			|| !input_.InitializeAsStorageBuffer(*pOwner_, size)
+			|| !output_.InitializeAsStorageBuffer(*pOwner_, size)
+			|| !readback_.InitializeAsStaging(*pOwner_, size))
+		{
+			return false;
+		}
+
+		vk::Device& device = pOwner_->GetDevice();
+		void* pMapped = device.mapMemory(upload_.GetDevMem(), 0, size, vk::MemoryMapFlags());
+		if (!pMapped)
+		{
+			return false;
+		}
+		memcpy(pMapped, packed.data(), size);
+		device.flushMappedMemoryRanges(vk::MappedMemoryRange(upload_.GetDevMem(), 0, VK_WHOLE_SIZE));
+		device.unmapMemory(upload_.GetDevMem());
+
+		return true;
+	}
+
+	//----
+	// 入力の rgba8 イメージと、スペクトル、逆変換結果のイメージを作成する
+	// スペクトルと逆変換結果は格納精度に合わせて rgba16f か rgba32f にする
+	bool FFTValidator::InitializeImages(vk::CommandBuffer& cmdBuffer, const std::vector<uint8_t>& pixels)
+	{
+		const FFTPlanDesc& desc = plan_.GetDesc();
+		uint32_t maxDimension = pOwner_->GetPhysicalDevice().getProperties().limits.maxImageDimension2D;
+		if ((desc.width > maxDimension) || (desc.height > maxDimension))
+		{
+			return false;
+		}
+
+		vk::ImageSubresourceRange colorSubRange(vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1);
+		if (!imageUpload_.InitializeAsStaging(*pOwner_, pixels.size(), pixels.data())
+			|| !inputImage_.InitializeFromStaging(*pOwner_, cmdBuffer, imageUpload_, vk::Format::eR8G8B8A8Unorm, desc.width, desc.height))
+		{
+			return false;
+		}
+		inputImage_.SetImageLayout(cmdBuffer, vk::ImageLayout::eGeneral, colorSubRange);
+
+		bool isSingle = desc.precision == FFTPrecision::Single;
+		vk::Format format = isSingle ? vk::Format::eR32G32B32A32Sfloat : vk::Format::eR16G16B16A16Sfloat;
+		imageBytes_ = static_cast<vk::DeviceSize>(desc.width) * desc.height * (isSingle ? 16 : 8);
+		Image* pImages[] = { &spectrumImages_[0], &spectrumImages_[1], &resultImage_ };
+		for (auto pImage : pImages)
+		{
+			if (!pImage->InitializeAsColorBuffer(
+				*pOwner_, cmdBuffer,
+				format,
+				static_cast<uint16_t>(desc.width), static_cast<uint16_t>(desc.height), 1, 1, true))
+			{
+				return false;
+			}
+			pImage->SetImageLayout(cmdBuffer, vk::ImageLayout::eGeneral, colorSubRange);
+		}
+		return imageReadback_.InitializeAsStaging(*pOwner_, static_cast<size_t>(imageBytes_ * 3));
+	}
+
+	//----
+	void FFTValidator::Destroy()
+	{
+		plan_.Destroy();
+		inversePlan_.Destroy();
+		cpuPlan_.Destroy();
+		source_ = CpuFFTImage();
+		imageSource_ = CpuFFTImage();
+		upload_.Destroy();
+		input_.Destroy();
+		output_.Destroy();
+		readback_.Destroy();
+		isPackedChecked_ = false;
+		imageUpload_.Destroy();
+		imageReadback_.Destroy();
+		inputImage_.Destroy();
+		for (auto& image : spectrumImages_)
+		{
+			image.Destroy();
+		}
+		resultImage_.Destroy();
+		imageBytes_ = 0;
+		pOwner_ = nullptr;
+	}
+
+	//----
+	bool FFTValidator::Record(vk::CommandBuffer& cmdBuffer)
+	{
+		if (!plan_.IsValid())
+		{
+			return false;
+		}
+
+		if (isPackedChecked_)
+		{
+			// 転送 -> 計算シェーダ
+			input_.CopyFrom(cmdBuffer, upload_);
+			{
+				vk::MemoryBarrier barrier(vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eShaderRead);
+				CmdPipelineBarrier(cmdBuffer, vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eComputeShader, vk::DependencyFlags(), barrier, nullptr, nullptr);
+			}
+
+			if (!plan_.Execute(cmdBuffer, FFTData::Packed(input_), FFTData::Packed(output_)))
+			{
+				return false;
+			}
+		}
+
+		// rgba8 のイメージから順変換し、そのスペクトルを逆変換する
+		// Execute は開始時に直前の計算シェーダの書き込みと同期をとる
+		FFTData spectrum = FFTData::Complex(spectrumImages_[0], spectrumImages_[1]);
+		if (!plan_.Execute(cmdBuffer, FFTData::Real(inputImage_), spectrum)
+			|| !inversePlan_.Execute(cmdBuffer, spectrum, FFTData::Real(resultImage_)))
+		{
+			return false;
+		}
+
+		// 計算シェーダ -> 転送 -> ホスト
+		{
+			vk::MemoryBarrier barrier(vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eTransferRead);
+			CmdPipelineBarrier(cmdBuffer, vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eTransfer, vk::DependencyFlags(), barrier, nullptr, nullptr);
+		}
+		if (isPackedChecked_)
+		{
+			readback_.CopyFrom(cmdBuffer, output_);
+		}
+		Image* pImages[] = { &spectrumImages_[0], &spectrumImages_[1], &resultImage_ };
+		for (uint32_t i = 0; i < 3; i++)
+		{
+			vk::BufferImageCopy copyRegion;
+			copyRegion.bufferOffset = imageBytes_ * i;
+			copyRegion.imageSubresource.aspectMask = vk::ImageAspectFlagBits::eColor;
+			copyRegion.imageSubresource.layerCount = 1;
+			copyRegion.imageExtent = vk::Extent3D(pImages[i]->GetWidth(), pImages[i]->GetHeight(), 1);
+			cmdBuffer.copyImageToBuffer(pImages[i]->GetImage(), vk::ImageLayout::eGeneral, imageReadback_.GetBuffer(), 1, &copyRegion);
+		}
+		{
+			vk::MemoryBarrier barrier(vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eHostRead);
+			CmdPipelineBarrier(cmdBuffer, vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eHost, vk::DependencyFlags(), barrier, nullptr, nullptr);
+		}
+		return true;
+	}
+
+	//----
+	bool FFTValidator::ReadBack(Buffer& buffer, vk::DeviceSize size, std::vector<uint8_t>& outData)
+	{
+		vk::Device& device = pOwner_->GetDevice();
+		void* pMapped = device.mapMemory(buffer.GetDevMem(), 0, size, vk::MemoryMapFlags());
+		if (!pMapped)
+		{
+			return false;
+		}
+		device.invalidateMappedMemoryRanges(vk::MappedMemoryRange(buffer.GetDevMem(), 0, VK_WHOLE_SIZE));
+		outData.resize(static_cast<size_t>(size));
+		memcpy(outData.data(), pMapped, outData.size());
+		device.unmapMemory(buffer.GetDevMem());
+		return true;
+	}
+
+	//----
+	bool FFTValidator::Resolve(FFTValidationErrors& errors)
+	{
+		if (!plan_.IsValid())
+		{
+			return false;
+		}
+
+		const FFTPlanDesc& desc = plan_.GetDesc();
+		errors = FFTValidationErrors();
+		std::vector<uint8_t> data;
+		CpuFFTImage cpuResult;
+		if (isPackedChecked_)
+		{
+			if (!ReadBack(readback_, plan_.GetPackedSize(), data))
+			{
+				return false;
+			}
+			CpuFFTImage gpuResult;
+			gpuResult.Initialize(desc.width, desc.height);
+			gpuResult.FromPacked(data.data(), desc.precision);
+
+			if (!cpuPlan_.Execute(source_, cpuResult))
+			{
+				return false;
+			}
+			errors.packed = FFTError::Compare(cpuResult, gpuResult);
+			errors.isPackedValid = true;
+		}
+
+		// スペクトルはCPUの変換と、逆変換の結果は rgba8 に丸めた入力と比較する
+		if (!ReadBack(imageReadback_, imageBytes_ * 3, data))
+		{
+			return false;
+		}
+		CpuFFTImage gpuSpectrum, gpuResult;
+		gpuSpectrum.Initialize(desc.width, desc.height);
+		gpuSpectrum.FromImagePixels(data.data(), data.data() + imageBytes_, desc.precision);
+		gpuResult.Initialize(desc.width, desc.height);
+		gpuResult.FromImagePixels(data.data() + imageBytes_ * 2, nullptr, desc.precision);
+
+		if (!cpuPlan_.Execute(imageSource_, cpuResult))
+		{
+			return false;
+		}
+		errors.realImage = FFTError::Compare(cpuResult, gpuSpectrum);
+		errors.roundTrip = FFTError::Compare(imageSource_, gpuResult);
+		return true;
+	}
+
+	//----
+	bool FFTValidator::Benchmark(FFTBenchmark& benchmark, uint32_t warmup, uint32_t iterations, FFTBenchmarkResult& result)
+	{
+		if (!plan_.IsValid())
+		{
+			return false;
+		}
+		if (!isPackedChecked_)
+		{
+			return benchmark.Run(plan_, FFTData::Real(inputImage_), FFTData::Complex(spectrumImages_[0], spectrumImages_[1]), warmup, iterations, result);
+		}
+		return benchmark.Run(plan_, FFTData::Packed(input_), FFTData::Packed(output_), warmup, iterations, result);
+	}
+
+}	// namespace vsl
+
+
+//	EOF
@@ -0,0 +1,105 @@
+﻿#include <vsl/frame_stats.h>
+#include <algorithm>
+
+
+namespace vsl
+{
+	const double FrameStats::kBucketMilliseconds = 0.1;
+
+	//----
+	void FrameStats::Initialize(uint32_t historyLength)
+	{
+		history_.assign((std::max)(historyLength, 1u), 0.0);
+		historyIndex_ = 0;
+		historyCount_ = 0;
+		historySum_ = 0.0;
+		buckets_.assign(kBucketCount, 0);
+		frameCount_ = 0;
+		summary_ = FrameStatsSummary();
+	}
+
+	//----
+	void FrameStats::AddFrame(double milliseconds)
+	{
+		milliseconds = (std::max)(milliseconds, 0.0);
+
+		// 一番古い値をヒストグラムから取り除く
+		if (historyCount_ == history_.size())
+		{
+			double oldest = history_[historyIndex_];
+			buckets_[GetBucket(oldest)]--;
+			historySum_ -= oldest;
+		}
+		else
+		{
+			historyCount_++;
+		}
+
+		history_[historyIndex_] = milliseconds;
+		historyIndex_ = (historyIndex_ + 1) % static_cast<uint32_t>(history_.size());
+		historySum_ += milliseconds;
+		buckets_[GetBucket(milliseconds)]++;
+		frameCount_++;
+
+		summary_.lastMilliseconds = milliseconds;
+		UpdateSummary();
+	}
+
+	//----
+	double FrameStats::GetPercentile(double percentile) const
+	{
+		if (historyCount_ == 0)
+		{
+			return 0.0;
+		}
+
+		// percentile 位置のサンプルを含むビンを探す
+		double rank = (std::min)((std::max)(percentile, 0.0), 100.0) * 0.01 * historyCount_;
+		uint32_t accum = 0;
+		for (uint32_t i = 0; i < kBucketCount; i++)
+		{
+			if (buckets_[i] == 0)
+			{
+				continue;
+			}
+			if (accum + buckets_[i] >= rank)
+			{
+				// 最後のビンは上限がないので最大値で抑える
+				double lower = i * kBucketMilliseconds;
+				double t = (rank - accum) / buckets_[i];
+				double ret = lower + t * kBucketMilliseconds;
+				return (std::min)(ret, summary_.maxMilliseconds);
+			}
+			accum += buckets_[i];
+		}
+		return summary_.maxMilliseconds;
+	}
+
+	//----
+	uint32_t FrameStats::GetBucket(double milliseconds) const
+	{
+		double bucket = milliseconds / kBucketMilliseconds;
+		return (bucket >= kBucketCount - 1) ? kBucketCount - 1 : static_cast<uint32_t>(bucket);
+	}
+
+	//----
+	void FrameStats::UpdateSummary()
+	{
+		// 最大値はビンの精度では足りないので履歴から求める
+		double maxValue = 0.0;
+		for (uint32_t i = 0; i < historyCount_; i++)
+		{
+			maxValue = (std::max)(maxValue, history_[i]);
+		}
+		summary_.maxMilliseconds = maxValue;
+		summary_.averageMilliseconds = historySum_ / historyCount_;
+		summary_.p50Milliseconds = GetPercentile(50.0);
+		summary_.p95Milliseconds = GetPercentile(95.0);
+		summary_.p99Milliseconds = GetPercentile(99.0);
+		summary_.sampleCount = historyCount_;
+	}
+
+}	// namespace vsl
+
+
+//	EOF
@@ -0,0 +1,259 @@
+﻿#include <vsl/gpu_profiler.h>
+#include <vsl/device.h>
+#include <algorithm>
+#include <cstdio>
+
+
+namespace vsl
+{
+	//----
+	bool GpuProfiler::Initialize(Device& owner, uint32_t frameCount, uint32_t maxScopes, uint32_t historyLength)
+	{
+		Destroy();
+
+		// グラフィクスキューでタイムスタンプが使えない場合は計測できない
+		vk::PhysicalDeviceLimits limits = owner.GetPhysicalDevice().getProperties().limits;
+		if (!limits.timestampComputeAndGraphics || (owner.GetTimestampMask() == 0) || (frameCount == 0) || (maxScopes == 0) || (historyLength == 0))
+		{
+			return false;
+		}
+		nanosecondsPerTick_ = static_cast<double>(limits.timestampPeriod);
+		timestampMask_ = owner.GetTimestampMask();
+
+		vk::Device& device = owner.GetDevice();
+		vk::QueryPoolCreateInfo poolInfo(vk::QueryPoolCreateFlags(), vk::QueryType::eTimestamp, maxScopes * 2);
+		frames_.resize(frameCount);
+		for (auto& frame : frames_)
+		{
+			frame.pool = device.createQueryPool(poolInfo);
+			VSL_API_COUNT(ObjectCreate);
+			if (!frame.pool)
+			{
+				pOwner_ = &owner;
+				Destroy();
+				return false;
+			}
+			frame.scopes.reserve(maxScopes);
+		}
+
+		maxScopes_ = maxScopes;
+		historyLength_ = historyLength;
+		pOwner_ = &owner;
+		return true;
+	}
+
+	//----
+	void GpuProfiler::Destroy()
+	{
+		if (pOwner_)
+		{
+			vk::Device& device = pOwner_->GetDevice();
+			for (auto& frame : frames_)
+			{
+				if (frame.pool)
+				{
+					device.destroyQueryPool(frame.pool);
+					VSL_API_COUNT(ObjectDestroy);
+				}
+			}
+		}
+		frames_.clear();
+		pCurrent_ = nullptr;
+		scopeStack_.clear();
+		entries_.clear();
+		entryIndices_.clear();
+		droppedCount_ = 0;
+		pOwner_ = nullptr;
+	}
+
+	//----
+	void GpuProfiler::BeginFrame(vk::CommandBuffer& cmdBuffer, uint32_t frameIndex)
+	{
+		pCurrent_ = nullptr;
+		scopeStack_.clear();
+		if (!pOwner_ || (frameIndex >= frames_.size()))
+		{
+			return;
+		}
+
+		Frame& frame = frames_[frameIndex];
+		if (frame.isPending)
+		{
+			Resolve(frame);
+		}
+
+		cmdBuffer.resetQueryPool(frame.pool, 0, maxScopes_ * 2);
+		frame.scopes.clear();
+		frame.queryCount = 0;
+		frame.isPending = true;
+		pCurrent_ = &frame;
+	}
+
+	//----
+	void GpuProfiler::BeginScope(vk::CommandBuffer& cmdBuffer, const char* name)
+	{
+		if (!pCurrent_)
+		{
+			return;
+		}
+		if (pCurrent_->scopes.size() >= maxScopes_)
+		{
+			scopeStack_.push_back(-1);
+			droppedCount_++;
+			return;
+		}
+
+		// 親は記録されたスコープのうち最も内側のもの
+		int32_t parent = -1;
+		for (auto it = scopeStack_.rbegin(); it != scopeStack_.rend(); ++it)
+		{
+			if (*it >= 0)
+			{
+				parent = *it;
+				break;
+			}
+		}
+
+		Scope scope;
+		scope.name = name;
+		scope.depth = (parent >= 0) ? pCurrent_->scopes[parent].depth + 1 : 0;
+		scope.parent = parent;
+		scope.beginQuery = pCurrent_->queryCount++;
+		scope.endQuery = pCurrent_->queryCount++;
+		cmdBuffer.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, pCurrent_->pool, scope.beginQuery);
+
+		scopeStack_.push_back(static_cast<int32_t>(pCurrent_->scopes.size()));
+		pCurrent_->scopes.push_back(scope);
+	}
+
+	//----
+	void GpuProfiler::EndScope(vk::CommandBuffer& cmdBuffer)
+	{
+		if (!pCurrent_ || scopeStack_.empty())
+		{
+			return;
+		}
+		int32_t index = scopeStack_.back();
+		scopeStack_.pop_back();
+		if (index >= 0)
+		{
+			cmdBuffer.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, pCurrent_->pool, pCurrent_->scopes[index].endQuery);
+		}
+	}
+
+	//----
+	std::string GpuProfiler::ToText() const
+	{
+		std::string ret;
+		char str[256];
+		for (auto& entry : entries_)
+		{
+			sprintf_s(str, "%*s%s : %.3f ms (avg %.3f ms, max %.3f ms)\n",
+				static_cast<int>(entry.depth * 2), "", entry.name.c_str(),
+				entry.lastMilliseconds, entry.averageMilliseconds, entry.maxMilliseconds);
+			ret += str;
+		}
+		return ret;
+	}
+
+	//----
+	void GpuProfiler::Resolve(Frame& frame)
+	{
+		frame.isPending = false;
+		if (frame.queryCount == 0)
+		{
+			return;
+		}
+
+		// フェンスの完了後に呼ばれるため待たない
+		// 閉じられていないスコープがあると eNotReady になるので、そのフレームは捨てる
+		std::vector<uint64_t> timestamps(frame.queryCount);
+		vk::Result result = pOwner_->GetDevice().getQueryPoolResults(frame.pool, 0, frame.queryCount,
+			timestamps.size() * sizeof(uint64_t), timestamps.data(), sizeof(uint64_t),
+			vk::QueryResultFlagBits::e64);
+		if (result != vk::Result::eSuccess)
+		{
+			return;
+		}
+
+		// 同じフレームで同じスコープが複数回ある場合は合計する
+		std::vector<std::string> paths(frame.scopes.size());
+		std::vector<double> milliseconds(frame.scopes.size(), 0.0);
+		std::map<std::string, size_t> firstIndices;
+		for (size_t i = 0; i < frame.scopes.size(); i++)
+		{
+			const Scope& scope = frame.scopes[i];
+			paths[i] = (scope.parent >= 0) ? paths[scope.parent] + "/" + scope.name : std::string(scope.name);
+
+			// 有効ビットの範囲で一周した場合もマスクした差分で求まる
+			uint64_t begin = timestamps[scope.beginQuery] & timestampMask_;
+			uint64_t end = timestamps[scope.endQuery] & timestampMask_;
+			double ticks = static_cast<double>((end - begin) & timestampMask_);
+			size_t first = firstIndices.insert(std::make_pair(paths[i], i)).first->second;
+			milliseconds[first] += ticks * nanosecondsPerTick_ * 1e-6;
+		}
+		for (auto& it : firstIndices)
+		{
+			const Scope& scope = frame.scopes[it.second];
+			AddSample(it.first, scope.name, scope.depth, milliseconds[it.second]);
+		}
+	}
+
+	//----
+	void GpuProfiler::AddSample(const std::string& path, const char* name, uint32_t depth, double milliseconds)
+	{
+		auto it = entryIndices_.find(path);
+		if (it == entryIndices_.end())
+		{
+			// 親の最後の子孫の後ろに挿入して、親子の順に並べる
+			size_t pos = entries_.size();
+			size_t slash = path.rfind('/');
+			if (slash != std::string::npos)
+			{
+				std::string parentPath = path.substr(0, slash);
+				auto parent = entryIndices_.find(parentPath);
+				if (parent != entryIndices_.end())
+				{
+					pos = parent->second + 1;
+					while ((pos < entries_.size()) && (entries_[pos].path.compare(0, parentPath.size() + 1, parentPath + "/") == 0))
+					{
+						pos++;
+					}
+				}
+			}
+
+			GpuProfilerEntry entry;
+			entry.name = name;
+			entry.path = path;
+			entry.depth = depth;
+			entry.history.resize(historyLength_);
+			entries_.insert(entries_.begin() + pos, entry);
+
+			entryIndices_.clear();
+			for (size_t i = 0; i < entries_.size(); i++)
+			{
+				entryIndices_[entries_[i].path] = i;
+			}
+			it = entryIndices_.find(path);
+		}
+
+		GpuProfilerEntry& entry = entries_[it->second];
+		entry.lastMilliseconds = milliseconds;
+		entry.history[entry.historyIndex] = static_cast<float>(milliseconds);
+		entry.historyIndex = (entry.historyIndex + 1) % historyLength_;
+		entry.historyCount = (std::min)(entry.historyCount + 1, historyLength_);
+
+		double sum = 0.0, maxValue = 0.0;
+		for (uint32_t i = 0; i < entry.historyCount; i++)
+		{
+			sum += entry.history[i];
+			maxValue = (std::max)(maxValue, static_cast<double>(entry.history[i]));
+		}
+		entry.averageMilliseconds = sum / entry.historyCount;
+		entry.maxMilliseconds = maxValue;
+	}
+
+}	// namespace vsl
+
+
+//	EOF
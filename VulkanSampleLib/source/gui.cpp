@@ -1,6 +1,12 @@
 ﻿#include <vsl/gui.h>
 #include <vsl/application.h>
 #include <vsl/buffer.h>
+#include <vsl/pipeline_builder.h>
+#include <vsl/gpu_profiler.h>
+#include <vsl/pipeline_statistics.h>
+#include <vsl/frame_stats.h>
+#include <vsl/api_counters.h>
+#include <vsl/cpu_profiler.h>
 #include <glm/glm.hpp>
 
 
@@ -256,7 +262,7 @@ namespace vsl
 			samplerCreateInfo.maxAnisotropy = 8;
 			samplerCreateInfo.anisotropyEnable = VK_TRUE;
 			samplerCreateInfo.borderColor = vk::BorderColor::eFloatOpaqueWhite;
-			fontSampler_ = owner.GetDevice().createSampler(samplerCreateInfo);
+			fontSampler_ = owner.GetSamplerCache().GetSampler(samplerCreateInfo);
 		}
 
 		// DescriptorSet
@@ -277,37 +283,17 @@ namespace vsl
 				info.bindingCount = static_cast<uint32_t>(layoutBindings.size());
 				info.pBindings = layoutBindings.data();
 				descSetLayout_ = owner.GetDevice().createDescriptorSetLayout(info, nullptr);
+				VSL_API_COUNT(ObjectCreate);
 				if (!descSetLayout_)
 				{
 					return false;
 				}
 			}
 
-			// Pool
-			{
-				std::array<vk::DescriptorPoolSize, 1> typeCounts;
-				typeCounts[0].type = vk::DescriptorType::eCombinedImageSampler;
-				typeCounts[0].descriptorCount = 1;
-
-				// デスクリプタプールを生成
-				vk::DescriptorPoolCreateInfo info;
-				info.poolSizeCount = static_cast<uint32_t>(typeCounts.size());
-				info.pPoolSizes = typeCounts.data();
-				info.maxSets = 1;
-				descPool_ = owner.GetDevice().createDescriptorPool(info);
-				if (!descPool_)
-				{
-					return false;
-				}
-			}
-
 			// Set
+			// Deviceのアロケータから確保する
 			{
-				vk::DescriptorSetAllocateInfo allocInfo;
-				allocInfo.descriptorPool = descPool_;
-				allocInfo.descriptorSetCount = 1;
-				allocInfo.pSetLayouts = &descSetLayout_;
-				descSet_ = owner.GetDevice().allocateDescriptorSets(allocInfo)[0];
+				descSet_ = owner.GetDescriptorAllocator().Allocate(descSetLayout_);
 				if (!descSet_)
 				{
 					return false;
@@ -328,89 +314,29 @@ namespace vsl
 				info.pushConstantRangeCount = 1;
 				info.pPushConstantRanges = &pushConstantRange;
 				pipelineLayout_ = owner.GetDevice().createPipelineLayout(info);
+				VSL_API_COUNT(ObjectCreate);
 			}
 
 			// Pipeline
 			{
-				vk::PipelineInputAssemblyStateCreateInfo iaInfo(
-					vk::PipelineInputAssemblyStateCreateFlags(),
-					vk::PrimitiveTopology::eTriangleList);
-
-				vk::PipelineRasterizationStateCreateInfo rsInfo(
-					vk::PipelineRasterizationStateCreateFlags(),
-					0, 0, vk::PolygonMode::eFill,
-					vk::CullModeFlagBits::eNone, vk::FrontFace::eCounterClockwise,
-					0, 0.0f, 0.0f, 0.0f, 1.0f);
-
 				vk::PipelineColorBlendAttachmentState blendAttachmentState(
 					VK_TRUE, vk::BlendFactor::eSrcAlpha, vk::BlendFactor::eOneMinusSrcAlpha, vk::BlendOp::eAdd,
 					vk::BlendFactor::eOneMinusSrcAlpha, vk::BlendFactor::eZero, vk::BlendOp::eAdd,
 					vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG | vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA);
-				vk::PipelineColorBlendStateCreateInfo blendInfo(
-					vk::PipelineColorBlendStateCreateFlags(), 0, vk::LogicOp::eClear, 1, &blendAttachmentState);
-
-				vk::PipelineViewportStateCreateInfo viewportInfo(vk::PipelineViewportStateCreateFlags(), 1, nullptr, 1, nullptr);
-
-				vk::DynamicState dynamicStates[] = { vk::DynamicState::eViewport, vk::DynamicState::eScissor };
-				vk::PipelineDynamicStateCreateInfo dynamicInfo(vk::PipelineDynamicStateCreateFlags(), ARRAYSIZE(dynamicStates), dynamicStates);
-
-				vk::PipelineDepthStencilStateCreateInfo dsInfo;
-
-				vk::PipelineMultisampleStateCreateInfo msInfo;
-				msInfo.pSampleMask = nullptr;
-				msInfo.rasterizationSamples = vk::SampleCountFlagBits::e1;
-
-				std::array<vk::VertexInputBindingDescription, 1> bindDescs;
-				bindDescs[0].binding = 0;		// 0番へバインド
-				bindDescs[0].stride = sizeof(ImDrawVertex);
-				bindDescs[0].inputRate = vk::VertexInputRate::eVertex;
-
-				std::array<vk::VertexInputAttributeDescription, 3> attribDescs;
-				// Position
-				attribDescs[0].binding = 0;
-				attribDescs[0].location = 0;
-				attribDescs[0].format = vk::Format::eR32G32Sfloat;
-				attribDescs[0].offset = 0;
-				// UV
-				attribDescs[1].binding = 0;
-				attribDescs[1].location = 1;
-				attribDescs[1].format = vk::Format::eR32G32Sfloat;
-				attribDescs[1].offset = sizeof(glm::vec2);
-				// Color
-				attribDescs[2].binding = 0;
-				attribDescs[2].location = 2;
-				attribDescs[2].format = vk::Format::eR8G8B8A8Unorm;
-				attribDescs[2].offset = attribDescs[1].offset + sizeof(glm::vec2);
-
-				vk::PipelineVertexInputStateCreateInfo vinputState;
-				vinputState.vertexBindingDescriptionCount = static_cast<uint32_t>(bindDescs.size());
-				vinputState.pVertexBindingDescriptions = bindDescs.data();
-				vinputState.vertexAttributeDescriptionCount = static_cast<uint32_t>(attribDescs.size());
-				vinputState.pVertexAttributeDescriptions = attribDescs.data();
-
-				std::array<vk::PipelineShaderStageCreateInfo, 2> shaderStages;
-				shaderStages[0].stage = vk::ShaderStageFlagBits::eVertex;
-				shaderStages[0].module = vshader_.GetModule();
-				shaderStages[0].pName = "main";
-				shaderStages[1].stage = vk::ShaderStageFlagBits::eFragment;
-				shaderStages[1].module = pshader_.GetModule();
-				shaderStages[1].pName = "main";
-
-				vk::GraphicsPipelineCreateInfo pipelineCreateInfo;
-				pipelineCreateInfo.layout = pipelineLayout_;
-				pipelineCreateInfo.renderPass = renderPass_.GetPass();
-				pipelineCreateInfo.stageCount = static_cast<uint32_t>(shaderStages.size());
-				pipelineCreateInfo.pStages = shaderStages.data();
-				pipelineCreateInfo.pVertexInputState = &vinputState;
-				pipelineCreateInfo.pInputAssemblyState = &iaInfo;
-				pipelineCreateInfo.pRasterizationState = &rsInfo;
-				pipelineCreateInfo.pColorBlendState = &blendInfo;
-				pipelineCreateInfo.pMultisampleState = &msInfo;
-				pipelineCreateInfo.pViewportState = &viewportInfo;
-				pipelineCreateInfo.pDepthStencilState = &dsInfo;
-				pipelineCreateInfo.pDynamicState = &dynamicInfo;
-
-				pipeline_ = owner.GetDevice().createGraphicsPipelines(owner.GetPipelineCache(), pipelineCreateInfo, nullptr)[0];
+
+				PipelineBuilder builder;
+				builder.SetShader(vk::ShaderStageFlagBits::eVertex, vshader_.GetModule())
+					.SetShader(vk::ShaderStageFlagBits::eFragment, pshader_.GetModule())
+					.SetVertexBinding(0, sizeof(ImDrawVertex))
+					.AddVertexAttribute(0, 0, vk::Format::eR32G32Sfloat, 0)						// Position
+					.AddVertexAttribute(1, 0, vk::Format::eR32G32Sfloat, sizeof(glm::vec2))		// UV
+					.AddVertexAttribute(2, 0, vk::Format::eR8G8B8A8Unorm, sizeof(glm::vec2) * 2)	// Color
+					.SetDepthState(false, false)
+					.SetBlendState(0, blendAttachmentState)
+					.SetLayout(pipelineLayout_)
+					.SetRenderPass(renderPass_);
+
+				pipeline_ = builder.Build(owner);
 				if (!pipeline_)
 				{
 					return false;
@@ -437,20 +363,15 @@ namespace vsl
 			delete[] vertexBuffers_;
 			delete[] indexBuffers_;
 
-			if (fontSampler_)
-			{
-				d.destroySampler(fontSampler_);
-				fontSampler_ = vk::Sampler();
-			}
+			// サンプラはキャッシュが所有している
+			fontSampler_ = vk::Sampler();
 
-			if (descPool_)
-			{
-				d.destroyDescriptorPool(descPool_);
-				descPool_ = vk::DescriptorPool();
-			}
+			// デスクリプタセットはアロケータが所有している
+			descSet_ = vk::DescriptorSet();
 			if (descSetLayout_)
 			{
 				d.destroyDescriptorSetLayout(descSetLayout_);
+				VSL_API_COUNT(ObjectDestroy);
 				descSetLayout_ = vk::DescriptorSetLayout();
 			}
 
@@ -461,8 +382,9 @@ namespace vsl
 
 			renderPass_.Destroy();
 
-			d.destroyPipeline(pipeline_);
+			pipeline_ = vk::Pipeline();
 			d.destroyPipelineLayout(pipelineLayout_);
+			VSL_API_COUNT(ObjectDestroy);
 
 			pOwner_ = nullptr;
 		}
@@ -505,7 +427,7 @@ namespace vsl
 			std::array<vk::WriteDescriptorSet, 1> descSetInfos{
 				vk::WriteDescriptorSet(descSet_, 0, 0, 1, vk::DescriptorType::eCombinedImageSampler, &texDescInfo, nullptr, nullptr),
 			};
-			pOwner_->GetDevice().updateDescriptorSets(descSetInfos, nullptr);
+			UpdateDescriptorSets(pOwner_->GetDevice(), descSetInfos);
 		}
 
 		io.Fonts->SetTexID(fontTexture_.GetImage());
@@ -516,6 +438,7 @@ namespace vsl
 	//----
 	void Gui::RenderDrawList(ImDrawData* draw_data)
 	{
+		VSL_CPU_SCOPE("Gui::RenderDrawList");
 		ImGuiIO& io = ImGui::GetIO();
 
 		Gui* pThis = guiHandle_;
@@ -573,8 +496,8 @@ namespace vsl
 
 		// 各種リソース等のバインド
 		{
-			cmdBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pThis->pipelineLayout_, 0, pThis->descSet_, nullptr);
-			cmdBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, pThis->pipeline_);
+			CmdBindDescriptorSets(cmdBuffer, vk::PipelineBindPoint::eGraphics, pThis->pipelineLayout_, 0, pThis->descSet_, nullptr);
+			CmdBindPipeline(cmdBuffer, vk::PipelineBindPoint::eGraphics, pThis->pipeline_);
 
 			vk::DeviceSize offsets = 0;
 			cmdBuffer.bindVertexBuffers(0, vbuffer.GetBuffer(), offsets);
@@ -608,7 +531,7 @@ namespace vsl
 						vk::Extent2D((uint32_t)(pcmd->ClipRect.z - pcmd->ClipRect.x), (uint32_t)(pcmd->ClipRect.w - pcmd->ClipRect.y + 1/* +1 ??? */)));
 					cmdBuffer.setScissor(0, scissor);
 
-					cmdBuffer.drawIndexed(pcmd->ElemCount, 1, idx_offset, vtx_offset, 1);
+					CmdDrawIndexed(cmdBuffer, pcmd->ElemCount, 1, idx_offset, vtx_offset, 1);
 				}
 				idx_offset += pcmd->ElemCount;
 			}
@@ -629,7 +552,12 @@ namespace vsl
 		io.DisplayFramebufferScale = ImVec2(frameScale, frameScale);
 
 		// 時間進行を指定
-		io.DeltaTime = timeStep;
+		// ImGui は 0 を受け付けないので、計測値がない最初のフレームは 1/60 とする
+		if (timeStep <= 0.0f)
+		{
+			timeStep = input.GetDeltaTime();
+		}
+		io.DeltaTime = (timeStep > 0.0f) ? timeStep : (1.0f / 60.0f);
 
 		// TODO: マウスによる操作
 		io.MousePos = ImVec2((float)input.GetMouseX(), (float)input.GetMouseY());
@@ -641,6 +569,89 @@ namespace vsl
 		ImGui::NewFrame();
 	}
 
+	//----
+	void Gui::ShowGpuProfiler(const GpuProfiler& profiler, const char* title)
+	{
+		if (ImGui::Begin(title))
+		{
+			// 子スコープは字下げして親の後ろに並べる
+			ImGui::Text("%-24s %8s %8s %8s", "Scope (ms)", "last", "avg", "max");
+			for (auto& entry : profiler.GetEntries())
+			{
+				std::string name(entry.depth * 2, ' ');
+				name += entry.name;
+				ImGui::Text("%-24s %8.3f %8.3f %8.3f", name.c_str(),
+					entry.lastMilliseconds, entry.averageMilliseconds, entry.maxMilliseconds);
+			}
+			if (profiler.GetDroppedCount() > 0)
+			{
+				ImGui::Text("Dropped scopes : %u", profiler.GetDroppedCount());
+			}
+		}
+		ImGui::End();
+	}
+
+	//----
+	void Gui::ShowPipelineStatistics(const PipelineStatistics& statistics, const char* title)
+	{
+		if (ImGui::Begin(title))
+		{
+			// スコープごとに全カウンタを並べる
+			for (auto& entry : statistics.GetEntries())
+			{
+				ImGui::Text("%s", entry.name.c_str());
+				for (uint32_t i = 0; i < PipelineStatisticsCounter::Max; i++)
+				{
+					auto counter = static_cast<PipelineStatisticsCounter::Type>(i);
+					ImGui::Text("  %-22s %12llu", PipelineStatistics::GetCounterName(counter), static_cast<unsigned long long>(entry.values[i]));
+				}
+			}
+			if (statistics.GetDroppedCount() > 0)
+			{
+				ImGui::Text("Dropped scopes : %u", statistics.GetDroppedCount());
+			}
+		}
+		ImGui::End();
+	}
+
+	//----
+	void Gui::ShowFrameStats(const FrameStats& stats, const char* title)
+	{
+		if (ImGui::Begin(title))
+		{
+			auto& summary = stats.GetSummary();
+			ImGui::Text("Last : %8.3f ms (%6.1f fps)", summary.lastMilliseconds,
+				(summary.lastMilliseconds > 0.0) ? 1000.0 / summary.lastMilliseconds : 0.0);
+			ImGui::Text("Avg  : %8.3f ms", summary.averageMilliseconds);
+			ImGui::Text("P50  : %8.3f ms", summary.p50Milliseconds);
+			ImGui::Text("P95  : %8.3f ms", summary.p95Milliseconds);
+			ImGui::Text("P99  : %8.3f ms", summary.p99Milliseconds);
+			ImGui::Text("Max  : %8.3f ms", summary.maxMilliseconds);
+			ImGui::Text("Samples : %u / %u", summary.sampleCount, stats.GetHistoryLength());
+		}
+		ImGui::End();
+	}
+
+	//----
+	void Gui::ShowApiCounters(const char* title)
+	{
+		if (ImGui::Begin(title))
+		{
+			const ApiCounters& counters = ApiCounters::Instance();
+			const ApiCounterFrame& last = counters.GetLastFrame();
+			const ApiCounterFrame& max = counters.GetMaxFrame();
+			ImGui::Text("%-22s %10s %10s", "Counter", "last", "max");
+			for (uint32_t i = 0; i < ApiCounter::Max; i++)
+			{
+				auto type = static_cast<ApiCounter::Type>(i);
+				ImGui::Text("%-22s %10llu %10llu", ApiCounters::GetCounterName(type),
+					static_cast<unsigned long long>(last.values[i]), static_cast<unsigned long long>(max.values[i]));
+			}
+			ImGui::Text("Live objects : %lld", static_cast<long long>(counters.GetLiveObjectCount()));
+		}
+		ImGui::End();
+	}
+
 }	// namespace vsl
 
 
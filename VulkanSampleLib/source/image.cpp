@@ -2,6 +2,7 @@
 #include <vsl/device.h>
 #include <vsl/buffer.h>
 #include <vsl/targa.h>
+#include <vsl/mapped_file.h>
 
 
 namespace vsl
@@ -16,15 +17,19 @@ namespace vsl
 		bool useCompute)
 	{
 		pOwner_ = &owner;
+		generation_ = NextResourceGeneration();
 		format_ = format;
 		width_ = width;
 		height_ = height;
+		mipLevels_ = mipLevels;
+		arrayLayers_ = arrayLayers;
 
 		// 指定のフォーマットがサポートされているか調べる
 		vk::FormatProperties formatProps = owner.GetPhysicalDevice().getFormatProperties(format);
 		assert(formatProps.optimalTilingFeatures & vk::FormatFeatureFlagBits::eColorAttachment);
 
 		vk::ImageAspectFlags aspect = vk::ImageAspectFlagBits::eColor;
+		aspect_ = aspect;
 
 		vk::Device& device = owner.GetDevice();
 
@@ -36,8 +41,9 @@ namespace vsl
 		imageCreateInfo.format = format;
 		imageCreateInfo.mipLevels = mipLevels;
 		imageCreateInfo.arrayLayers = arrayLayers;
-		imageCreateInfo.usage = vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled | computeFlag;
+		imageCreateInfo.usage = vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransferSrc | vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled | computeFlag;
 		image_ = device.createImage(imageCreateInfo);
+		VSL_API_COUNT(ObjectCreate);
 		if (!image_)
 		{
 			return false;
@@ -49,6 +55,7 @@ namespace vsl
 		memAlloc.allocationSize = memReqs.size;
 		memAlloc.memoryTypeIndex = owner.GetMemoryTypeIndex(memReqs.memoryTypeBits, vk::MemoryPropertyFlagBits::eDeviceLocal);
 		devMem_ = device.allocateMemory(memAlloc);
+		VSL_API_COUNT(ObjectCreate);
 		if (!devMem_)
 		{
 			return false;
@@ -64,7 +71,7 @@ namespace vsl
 		viewCreateInfo.subresourceRange.levelCount = 1;
 		viewCreateInfo.subresourceRange.layerCount = 1;
 		viewCreateInfo.image = image_;
-		view_ = device.createImageView(viewCreateInfo);
+		view_ = owner.GetImageViewCache().GetView(viewCreateInfo);
 		if (!view_)
 		{
 			return false;
@@ -101,9 +108,12 @@ namespace vsl
 		bool useCompute)
 	{
 		pOwner_ = &owner;
+		generation_ = NextResourceGeneration();
 		format_ = format;
 		width_ = width;
 		height_ = height;
+		mipLevels_ = mipLevels;
+		arrayLayers_ = arrayLayers;
 
 		// 指定のフォーマットがサポートされているか調べる
 		vk::FormatProperties formatProps = owner.GetPhysicalDevice().getFormatProperties(format);
@@ -124,6 +134,7 @@ namespace vsl
 			aspect = vk::ImageAspectFlagBits::eDepth;
 			break;
 		}
+		aspect_ = aspect;
 
 		vk::Device& device = owner.GetDevice();
 
@@ -137,6 +148,7 @@ namespace vsl
 		imageCreateInfo.arrayLayers = arrayLayers;
 		imageCreateInfo.usage = vk::ImageUsageFlagBits::eDepthStencilAttachment | vk::ImageUsageFlagBits::eSampled | computeFlag;
 		image_ = device.createImage(imageCreateInfo);
+		VSL_API_COUNT(ObjectCreate);
 		if (!image_)
 		{
 			return false;
@@ -148,6 +160,7 @@ namespace vsl
 		memAlloc.allocationSize = memReqs.size;
 		memAlloc.memoryTypeIndex = owner.GetMemoryTypeIndex(memReqs.memoryTypeBits, vk::MemoryPropertyFlagBits::eDeviceLocal);
 		devMem_ = device.allocateMemory(memAlloc);
+		VSL_API_COUNT(ObjectCreate);
 		if (!devMem_)
 		{
 			return false;
@@ -163,7 +176,7 @@ namespace vsl
 		viewCreateInfo.subresourceRange.levelCount = 1;
 		viewCreateInfo.subresourceRange.layerCount = 1;
 		viewCreateInfo.image = image_;
-		view_ = device.createImageView(viewCreateInfo);
+		view_ = owner.GetImageViewCache().GetView(viewCreateInfo);
 		if (!view_)
 		{
 			return false;
@@ -181,10 +194,10 @@ namespace vsl
 		else
 		{
 			viewCreateInfo.subresourceRange.aspectMask = vk::ImageAspectFlagBits::eDepth;
-			depthView_ = device.createImageView(viewCreateInfo);
+			depthView_ = owner.GetImageViewCache().GetView(viewCreateInfo);
 
 			viewCreateInfo.subresourceRange.aspectMask = vk::ImageAspectFlagBits::eStencil;
-			stencilView_ = device.createImageView(viewCreateInfo);
+			stencilView_ = owner.GetImageViewCache().GetView(viewCreateInfo);
 
 			if (!depthView_ || !stencilView_)
 			{
@@ -220,19 +233,22 @@ namespace vsl
 		Buffer& staging,
 		const std::string& filename)
 	{
+		// ファイルをメモリにマップして直接デコードする
 		tga_image tgaImage;
-		if (tga_read(&tgaImage, filename.c_str()) != TGA_NOERR)
 		{
-			return false;
+			MappedFile file;
+			if (!file.Open(filename))
+			{
+				return false;
+			}
+			if (tga_read_from_memory(&tgaImage, file.GetData(), file.GetSize()) != TGA_NOERR)
+			{
+				return false;
+			}
 		}
 
 		// カラーチャンネルのスワップを行う
-		for (size_t s = 0; s < tgaImage.width * tgaImage.height; s++)
-		{
-			size_t rc = s * 4 + 2;
-			size_t bc = s * 4 + 0;
-			std::swap(tgaImage.image_data[rc], tgaImage.image_data[bc]);
-		}
+		SwapRedBlue(tgaImage.image_data, tgaImage.width * tgaImage.height);
 
 		vk::Device& device = owner.GetDevice();
 		bool ret = false;
@@ -263,13 +279,18 @@ end:
 		Buffer& staging,
 		vk::Format format,
 		uint32_t width, uint32_t height,
-		uint16_t mipLevels, uint16_t arrayLayers)
+		uint16_t mipLevels, uint16_t arrayLayers,
+		vk::DeviceSize stagingOffset)
 	{
 		pOwner_ = &owner;
+		generation_ = NextResourceGeneration();
 
 		format_ = format;
 		width_ = width;
 		height_ = height;
+		mipLevels_ = mipLevels;
+		arrayLayers_ = arrayLayers;
+		aspect_ = vk::ImageAspectFlagBits::eColor;
 
 		vk::Device& device = owner.GetDevice();
 		bool ret = false;
@@ -285,6 +306,7 @@ end:
 			imageCreateInfo.usage = vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eStorage;
 			imageCreateInfo.initialLayout = vk::ImageLayout::ePreinitialized;
 			image_ = device.createImage(imageCreateInfo);
+			VSL_API_COUNT(ObjectCreate);
 			if (!image_)
 			{
 				return false;
@@ -295,6 +317,7 @@ end:
 			memAllocInfo.allocationSize = memReqs.size;
 			memAllocInfo.memoryTypeIndex = owner.GetMemoryTypeIndex(memReqs.memoryTypeBits, vk::MemoryPropertyFlagBits::eDeviceLocal);
 			devMem_ = device.allocateMemory(memAllocInfo);
+			VSL_API_COUNT(ObjectCreate);
 			if (!devMem_)
 			{
 				return false;
@@ -314,7 +337,7 @@ end:
 			viewCreateInfo.subresourceRange.layerCount = arrayLayers;
 			viewCreateInfo.subresourceRange.levelCount = mipLevels;
 			viewCreateInfo.image = image_;
-			view_ = device.createImageView(viewCreateInfo);
+			view_ = owner.GetImageViewCache().GetView(viewCreateInfo);
 			if (!view_)
 			{
 				return false;
@@ -344,7 +367,7 @@ end:
 			bufferCopyRegion.imageExtent.width = width;
 			bufferCopyRegion.imageExtent.height = height;
 			bufferCopyRegion.imageSubresource.mipLevel = 0;
-			bufferCopyRegion.bufferOffset = 0;
+			bufferCopyRegion.bufferOffset = stagingOffset;
 			cmdBuff.copyBufferToImage(staging.GetBuffer(), image_, vk::ImageLayout::eTransferDstOptimal, 1, &bufferCopyRegion);
 
 			// コピー完了後にレイアウト変更
@@ -367,13 +390,14 @@ end:
 		if (pOwner_)
 		{
 			vk::Device& device = pOwner_->GetDevice();
-			if (stencilView_ && view_ != stencilView_) { device.destroyImageView(stencilView_); stencilView_ = vk::ImageView(); }
-			if (depthView_ && view_ != depthView_) { device.destroyImageView(depthView_); depthView_ = vk::ImageView(); }
-			if (view_) { device.destroyImageView(view_); view_ = vk::ImageView(); }
-			if (image_) { device.destroyImage(image_); image_ = vk::Image(); }
-			if (devMem_) { device.freeMemory(devMem_); devMem_ = vk::DeviceMemory(); }
+			// Viewはキャッシュが所有しているので、イメージ単位でまとめて破棄する
+			if (image_) { pOwner_->GetImageViewCache().Invalidate(image_); }
+			view_ = depthView_ = stencilView_ = vk::ImageView();
+			if (image_) { device.destroyImage(image_); VSL_API_COUNT(ObjectDestroy); image_ = vk::Image(); }
+			if (devMem_) { device.freeMemory(devMem_); VSL_API_COUNT(ObjectDestroy); devMem_ = vk::DeviceMemory(); }
 		}
 		pOwner_ = nullptr;
+		generation_ = 0;
 	}
 
 	//----
@@ -383,6 +407,52 @@ end:
 		currentLayout_ = newImageLayout;
 	}
 
+	//----
+	vk::ImageView Image::GetView(
+		const vk::ImageSubresourceRange& subresourceRange,
+		vk::ImageViewType viewType,
+		vk::Format format)
+	{
+		if (!pOwner_ || !image_)
+		{
+			return vk::ImageView();
+		}
+
+		vk::ImageViewCreateInfo viewCreateInfo;
+		viewCreateInfo.viewType = viewType;
+		viewCreateInfo.format = (format == vk::Format::eUndefined) ? format_ : format;
+		viewCreateInfo.components = { vk::ComponentSwizzle::eR, vk::ComponentSwizzle::eG, vk::ComponentSwizzle::eB, vk::ComponentSwizzle::eA };
+		viewCreateInfo.subresourceRange = subresourceRange;
+		viewCreateInfo.image = image_;
+		return pOwner_->GetImageViewCache().GetView(viewCreateInfo);
+	}
+
+	//----
+	vk::ImageView Image::GetMipView(uint32_t mipLevel, uint32_t arrayLayer)
+	{
+		// 深度・ステンシル両方を持つ場合、シェーダからは片方しか参照できないので深度を選ぶ
+		vk::ImageAspectFlags aspect = aspect_;
+		if (aspect == (vk::ImageAspectFlagBits::eDepth | vk::ImageAspectFlagBits::eStencil))
+		{
+			aspect = vk::ImageAspectFlagBits::eDepth;
+		}
+		return GetView(vk::ImageSubresourceRange(aspect, mipLevel, 1, arrayLayer, 1));
+	}
+
+	//----
+	// BGRA → RGBA のチャンネル入れ替え
+	// 1ピクセルを32bitとして扱い、R と B をまとめて入れ替える
+	void Image::SwapRedBlue(uint8_t* pPixels, size_t pixelCount)
+	{
+		for (size_t i = 0; i < pixelCount; i++)
+		{
+			uint32_t c;
+			memcpy(&c, pPixels + i * 4, sizeof(c));
+			c = (c & 0xff00ff00) | ((c >> 16) & 0x000000ff) | ((c & 0x000000ff) << 16);
+			memcpy(pPixels + i * 4, &c, sizeof(c));
+		}
+	}
+
 	//----
 	// イメージレイアウトを設定するため、バリアを貼る
 	// Deviceなどに左右されないが、Applicationの静的メンバ関数として実装する
@@ -432,7 +502,7 @@ end:
 
 		// Put barrier on top
 		// Put barrier inside setup command buffer
-		cmdbuffer.pipelineBarrier(
+		CmdPipelineBarrier(cmdbuffer,
 			vk::PipelineStageFlagBits::eTopOfPipe,
 			vk::PipelineStageFlagBits::eTopOfPipe,
 			vk::DependencyFlags(),
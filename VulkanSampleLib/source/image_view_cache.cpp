@@ -0,0 +1,119 @@
+﻿#include <vsl/image_view_cache.h>
+#include <vsl/device.h>
+#include <vsl/hash.h>
+
+
+namespace vsl
+{
+	//----
+	size_t ImageViewCache::CreateInfoHash::operator()(const vk::ImageViewCreateInfo& info) const
+	{
+		uint64_t h = kFnvOffsetBasis;
+		HashCombine(h, info.flags);
+		HashCombine(h, info.viewType);
+		HashCombine(h, info.format);
+		HashCombine(h, info.components.r);
+		HashCombine(h, info.components.g);
+		HashCombine(h, info.components.b);
+		HashCombine(h, info.components.a);
+		HashCombine(h, info.subresourceRange.aspectMask);
+		HashCombine(h, info.subresourceRange.baseMipLevel);
+		HashCombine(h, info.subresourceRange.levelCount);
+		HashCombine(h, info.subresourceRange.baseArrayLayer);
+		HashCombine(h, info.subresourceRange.layerCount);
+		return static_cast<size_t>(h);
+	}
+
+	//----
+	bool ImageViewCache::Initialize(Device& owner)
+	{
+		pOwner_ = &owner;
+		return true;
+	}
+
+	//----
+	void ImageViewCache::Destroy()
+	{
+		if (pOwner_)
+		{
+			vk::Device& device = pOwner_->GetDevice();
+			for (auto& image : views_)
+			{
+				for (auto& v : image.second)
+				{
+					device.destroyImageView(v.second);
+					VSL_API_COUNT(ObjectDestroy);
+				}
+			}
+			views_.clear();
+		}
+		pOwner_ = nullptr;
+	}
+
+	//----
+	vk::ImageView ImageViewCache::GetView(const vk::ImageViewCreateInfo& createInfo)
+	{
+		// 拡張構造体はキーに含められない
+		assert(createInfo.pNext == nullptr);
+		assert(createInfo.image);
+
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		ViewMap& views = views_[static_cast<VkImage>(createInfo.image)];
+		auto it = views.find(createInfo);
+		if (it != views.end())
+		{
+			return it->second;
+		}
+
+		vk::ImageView view = pOwner_->GetDevice().createImageView(createInfo);
+		VSL_API_COUNT(ObjectCreate);
+		if (view)
+		{
+			views[createInfo] = view;
+		}
+		return view;
+	}
+
+	//----
+	void ImageViewCache::Invalidate(const vk::Image& image)
+	{
+		if (!pOwner_)
+		{
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		auto it = views_.find(static_cast<VkImage>(image));
+		if (it == views_.end())
+		{
+			return;
+		}
+
+		vk::Device& device = pOwner_->GetDevice();
+		for (auto& v : it->second)
+		{
+			device.destroyImageView(v.second);
+			VSL_API_COUNT(ObjectDestroy);
+		}
+		views_.erase(it);
+	}
+
+	//----
+	size_t ImageViewCache::GetViewCount() const
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		size_t count = 0;
+		for (auto& image : views_)
+		{
+			count += image.second.size();
+		}
+		return count;
+	}
+
+}	// namespace vsl
+
+
+//	EOF
@@ -0,0 +1,247 @@
+﻿#include <vsl/layout_cache.h>
+#include <vsl/device.h>
+#include <vsl/shader.h>
+#include <vsl/hash.h>
+#include <algorithm>
+#include <map>
+
+
+namespace vsl
+{
+	//----
+	size_t LayoutCache::BindingListHash::operator()(const BindingList& bindings) const
+	{
+		uint64_t h = kFnvOffsetBasis;
+		for (auto& b : bindings)
+		{
+			HashCombine(h, b.binding);
+			HashCombine(h, b.descriptorType);
+			HashCombine(h, b.descriptorCount);
+			HashCombine(h, b.stageFlags);
+		}
+		return static_cast<size_t>(h);
+	}
+
+	//----
+	size_t LayoutCache::PipelineLayoutKeyHash::operator()(const PipelineLayoutKey& key) const
+	{
+		uint64_t h = kFnvOffsetBasis;
+		for (auto& l : key.setLayouts)
+		{
+			HashCombine(h, static_cast<VkDescriptorSetLayout>(l));
+		}
+		for (auto& r : key.pushConstantRanges)
+		{
+			HashCombine(h, r.stageFlags);
+			HashCombine(h, r.offset);
+			HashCombine(h, r.size);
+		}
+		return static_cast<size_t>(h);
+	}
+
+	//----
+	bool LayoutCache::Initialize(Device& owner)
+	{
+		pOwner_ = &owner;
+		return true;
+	}
+
+	//----
+	void LayoutCache::Destroy()
+	{
+		if (pOwner_)
+		{
+			vk::Device& device = pOwner_->GetDevice();
+			for (auto& l : pipeLayouts_)
+			{
+				device.destroyPipelineLayout(l.second);
+				VSL_API_COUNT(ObjectDestroy);
+			}
+			pipeLayouts_.clear();
+			for (auto& l : setLayouts_)
+			{
+				device.destroyDescriptorSetLayout(l.second);
+				VSL_API_COUNT(ObjectDestroy);
+			}
+			setLayouts_.clear();
+		}
+		pOwner_ = nullptr;
+	}
+
+	//----
+	vk::DescriptorSetLayout LayoutCache::GetDescriptorSetLayout(const std::vector<vk::DescriptorSetLayoutBinding>& bindings)
+	{
+		// binding 番号順に揃えてキーにする
+		BindingList key = bindings;
+		std::sort(key.begin(), key.end(), [](const vk::DescriptorSetLayoutBinding& l, const vk::DescriptorSetLayoutBinding& r)
+		{
+			return l.binding < r.binding;
+		});
+		for (auto& b : key)
+		{
+			assert(b.pImmutableSamplers == nullptr);
+			b.pImmutableSamplers = nullptr;
+		}
+
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		auto it = setLayouts_.find(key);
+		if (it != setLayouts_.end())
+		{
+			return it->second;
+		}
+
+		vk::DescriptorSetLayoutCreateInfo createInfo;
+		createInfo.bindingCount = static_cast<uint32_t>(key.size());
+		createInfo.pBindings = key.data();
+		vk::DescriptorSetLayout layout = pOwner_->GetDevice().createDescriptorSetLayout(createInfo);
+		VSL_API_COUNT(ObjectCreate);
+		if (layout)
+		{
+			setLayouts_[key] = layout;
+		}
+		return layout;
+	}
+
+	//----
+	bool LayoutCache::GetDescriptorCounts(const vk::DescriptorSetLayout& layout, std::vector<vk::DescriptorPoolSize>& outCounts)
+	{
+		outCounts.clear();
+
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		// レイアウト数は少ないので線形に探す
+		auto it = std::find_if(setLayouts_.begin(), setLayouts_.end(), [&](const std::pair<const BindingList, vk::DescriptorSetLayout>& l)
+		{
+			return l.second == layout;
+		});
+		if (it == setLayouts_.end())
+		{
+			return false;
+		}
+
+		for (auto& b : it->first)
+		{
+			auto c = std::find_if(outCounts.begin(), outCounts.end(), [&](const vk::DescriptorPoolSize& s)
+			{
+				return s.type == b.descriptorType;
+			});
+			if (c != outCounts.end())
+			{
+				c->descriptorCount += b.descriptorCount;
+			}
+			else
+			{
+				outCounts.push_back(vk::DescriptorPoolSize(b.descriptorType, b.descriptorCount));
+			}
+		}
+		return true;
+	}
+
+	//----
+	vk::PipelineLayout LayoutCache::GetPipelineLayout(const std::vector<vk::DescriptorSetLayout>& setLayouts, const std::vector<vk::PushConstantRange>& pushConstantRanges)
+	{
+		PipelineLayoutKey key;
+		key.setLayouts = setLayouts;
+		key.pushConstantRanges = pushConstantRanges;
+
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		auto it = pipeLayouts_.find(key);
+		if (it != pipeLayouts_.end())
+		{
+			return it->second;
+		}
+
+		vk::PipelineLayoutCreateInfo createInfo;
+		createInfo.setLayoutCount = static_cast<uint32_t>(key.setLayouts.size());
+		createInfo.pSetLayouts = key.setLayouts.data();
+		createInfo.pushConstantRangeCount = static_cast<uint32_t>(key.pushConstantRanges.size());
+		createInfo.pPushConstantRanges = key.pushConstantRanges.data();
+		vk::PipelineLayout layout = pOwner_->GetDevice().createPipelineLayout(createInfo);
+		VSL_API_COUNT(ObjectCreate);
+		if (layout)
+		{
+			pipeLayouts_[key] = layout;
+		}
+		return layout;
+	}
+
+	//----
+	bool LayoutCache::GetLayouts(std::initializer_list<const Shader*> shaders, std::vector<vk::DescriptorSetLayout>& outSetLayouts, vk::PipelineLayout& outPipeLayout)
+	{
+		// set ごとにバインド情報をまとめる
+		std::map<uint32_t, std::map<uint32_t, vk::DescriptorSetLayoutBinding>> sets;
+		vk::PushConstantRange pushRange(vk::ShaderStageFlags(), 0, 0);
+		for (auto pShader : shaders)
+		{
+			if (!pShader)
+			{
+				continue;
+			}
+
+			vk::ShaderStageFlagBits stage = pShader->GetStage();
+			for (auto& rb : pShader->GetBindings())
+			{
+				auto& slot = sets[rb.set];
+				auto it = slot.find(rb.binding);
+				if (it == slot.end())
+				{
+					slot[rb.binding] = vk::DescriptorSetLayoutBinding(rb.binding, rb.type, rb.count, stage);
+				}
+				else
+				{
+					// 同じバインド先で型が食い違う場合は失敗
+					if (it->second.descriptorType != rb.type || it->second.descriptorCount != rb.count)
+					{
+						return false;
+					}
+					it->second.stageFlags |= stage;
+				}
+			}
+
+			// プッシュ定数は先頭から最大サイズまでを1つの範囲とする
+			if (pShader->GetPushConstantSize() > 0)
+			{
+				pushRange.stageFlags |= stage;
+				pushRange.size = (std::max)(pushRange.size, pShader->GetPushConstantSize());
+			}
+		}
+
+		// set 番号に抜けがある場合は空のレイアウトで埋める
+		outSetLayouts.clear();
+		if (!sets.empty())
+		{
+			outSetLayouts.resize(sets.rbegin()->first + 1);
+		}
+		for (uint32_t i = 0; i < outSetLayouts.size(); i++)
+		{
+			std::vector<vk::DescriptorSetLayoutBinding> bindings;
+			auto it = sets.find(i);
+			if (it != sets.end())
+			{
+				for (auto& b : it->second)
+				{
+					bindings.push_back(b.second);
+				}
+			}
+			outSetLayouts[i] = GetDescriptorSetLayout(bindings);
+			if (!outSetLayouts[i])
+			{
+				return false;
+			}
+		}
+
+		std::vector<vk::PushConstantRange> pushRanges;
+		if (pushRange.size > 0)
+		{
+			pushRanges.push_back(pushRange);
+		}
+		outPipeLayout = GetPipelineLayout(outSetLayouts, pushRanges);
+		return outPipeLayout.operator bool();
+	}
+
+}	// namespace vsl
+
+
+//	EOF
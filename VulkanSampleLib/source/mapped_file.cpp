@@ -0,0 +1,55 @@
+﻿#include <vsl/mapped_file.h>
+
+
+namespace vsl
+{
+	//----
+	bool MappedFile::Open(const std::string& filename)
+	{
+		Close();
+
+		hFile_ = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (hFile_ == INVALID_HANDLE_VALUE)
+		{
+			return false;
+		}
+
+		LARGE_INTEGER fileSize;
+		if (!GetFileSizeEx(hFile_, &fileSize) || fileSize.QuadPart == 0)
+		{
+			// サイズ0のファイルはマップできない
+			Close();
+			return false;
+		}
+		size_ = static_cast<size_t>(fileSize.QuadPart);
+
+		hMapping_ = CreateFileMappingA(hFile_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (!hMapping_)
+		{
+			Close();
+			return false;
+		}
+
+		pData_ = static_cast<const uint8_t*>(MapViewOfFile(hMapping_, FILE_MAP_READ, 0, 0, 0));
+		if (!pData_)
+		{
+			Close();
+			return false;
+		}
+
+		return true;
+	}
+
+	//----
+	void MappedFile::Close()
+	{
+		if (pData_) { UnmapViewOfFile(pData_); pData_ = nullptr; }
+		if (hMapping_) { CloseHandle(hMapping_); hMapping_ = nullptr; }
+		if (hFile_ != INVALID_HANDLE_VALUE) { CloseHandle(hFile_); hFile_ = INVALID_HANDLE_VALUE; }
+		size_ = 0;
+	}
+
+}	// namespace vsl
+
+
+//	EOF
@@ -0,0 +1,424 @@
+﻿#include <vsl/pipeline_builder.h>
+#include <vsl/device.h>
+#include <vsl/render_pass.h>
+#include <vsl/hash.h>
+
+
+namespace vsl
+{
+	//----
+	PipelineBuilder::PipelineBuilder()
+	{
+		inputAssembly_.topology = vk::PrimitiveTopology::eTriangleList;
+
+		rasterization_.polygonMode = vk::PolygonMode::eFill;
+		rasterization_.cullMode = vk::CullModeFlagBits::eNone;
+		rasterization_.frontFace = vk::FrontFace::eCounterClockwise;
+		rasterization_.lineWidth = 1.0f;
+
+		depthStencil_.depthTestEnable = VK_TRUE;
+		depthStencil_.depthWriteEnable = VK_TRUE;
+		depthStencil_.depthCompareOp = vk::CompareOp::eLessOrEqual;
+		depthStencil_.back.failOp = vk::StencilOp::eKeep;
+		depthStencil_.back.passOp = vk::StencilOp::eKeep;
+		depthStencil_.back.compareOp = vk::CompareOp::eAlways;
+		depthStencil_.front = depthStencil_.back;
+
+		SetColorAttachmentCount(1);
+
+		dynamicStates_.push_back(vk::DynamicState::eViewport);
+		dynamicStates_.push_back(vk::DynamicState::eScissor);
+	}
+
+	//----
+	PipelineBuilder& PipelineBuilder::SetShader(vk::ShaderStageFlagBits stage, const vk::ShaderModule& module, const char* entryPoint)
+	{
+		for (auto& s : stages_)
+		{
+			if (s.stage == stage)
+			{
+				s.module = module;
+				s.entryPoint = entryPoint;
+				return *this;
+			}
+		}
+		ShaderStage s;
+		s.stage = stage;
+		s.module = module;
+		s.entryPoint = entryPoint;
+		stages_.push_back(s);
+		return *this;
+	}
+
+	//----
+	PipelineBuilder& PipelineBuilder::SetVertexBinding(uint32_t binding, uint32_t stride, vk::VertexInputRate inputRate)
+	{
+		for (auto& b : bindings_)
+		{
+			if (b.binding == binding)
+			{
+				b.stride = stride;
+				b.inputRate = inputRate;
+				return *this;
+			}
+		}
+		bindings_.push_back(vk::VertexInputBindingDescription(binding, stride, inputRate));
+		return *this;
+	}
+
+	//----
+	PipelineBuilder& PipelineBuilder::AddVertexAttribute(uint32_t location, uint32_t binding, vk::Format format, uint32_t offset)
+	{
+		attributes_.push_back(vk::VertexInputAttributeDescription(location, binding, format, offset));
+		return *this;
+	}
+
+	//----
+	PipelineBuilder& PipelineBuilder::SetTopology(vk::PrimitiveTopology topology, bool primitiveRestart)
+	{
+		inputAssembly_.topology = topology;
+		inputAssembly_.primitiveRestartEnable = primitiveRestart ? VK_TRUE : VK_FALSE;
+		return *this;
+	}
+
+	//----
+	PipelineBuilder& PipelineBuilder::SetRasterizer(vk::PolygonMode polygonMode, vk::CullModeFlags cullMode, vk::FrontFace frontFace)
+	{
+		rasterization_.polygonMode = polygonMode;
+		rasterization_.cullMode = cullMode;
+		rasterization_.frontFace = frontFace;
+		return *this;
+	}
+
+	//----
+	PipelineBuilder& PipelineBuilder::SetDepthState(bool testEnable, bool writeEnable, vk::CompareOp compareOp)
+	{
+		depthStencil_.depthTestEnable = testEnable ? VK_TRUE : VK_FALSE;
+		depthStencil_.depthWriteEnable = writeEnable ? VK_TRUE : VK_FALSE;
+		depthStencil_.depthCompareOp = compareOp;
+		return *this;
+	}
+
+	//----
+	PipelineBuilder& PipelineBuilder::SetColorAttachmentCount(uint32_t count)
+	{
+		vk::PipelineColorBlendAttachmentState state;
+		state.colorWriteMask = vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG | vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA;
+		blendAttachments_.resize(count, state);
+		return *this;
+	}
+
+	//----
+	PipelineBuilder& PipelineBuilder::SetBlendState(uint32_t attachment, const vk::PipelineColorBlendAttachmentState& state)
+	{
+		assert(attachment < blendAttachments_.size());
+		blendAttachments_[attachment] = state;
+		return *this;
+	}
+
+	//----
+	// 一般的な半透明合成
+	PipelineBuilder& PipelineBuilder::SetAlphaBlend(uint32_t attachment)
+	{
+		vk::PipelineColorBlendAttachmentState state;
+		state.colorWriteMask = vk::ColorComponentFlagBits::eR | vk::ColorComponentFlagBits::eG | vk::ColorComponentFlagBits::eB | vk::ColorComponentFlagBits::eA;
+		state.blendEnable = VK_TRUE;
+		state.colorBlendOp = vk::BlendOp::eAdd;
+		state.srcColorBlendFactor = vk::BlendFactor::eSrcAlpha;
+		state.dstColorBlendFactor = vk::BlendFactor::eOneMinusSrcAlpha;
+		state.alphaBlendOp = vk::BlendOp::eAdd;
+		state.srcAlphaBlendFactor = vk::BlendFactor::eOne;
+		state.dstAlphaBlendFactor = vk::BlendFactor::eZero;
+		return SetBlendState(attachment, state);
+	}
+
+	//----
+	PipelineBuilder& PipelineBuilder::SetSampleCount(vk::SampleCountFlagBits samples)
+	{
+		sampleCount_ = samples;
+		return *this;
+	}
+
+	//----
+	PipelineBuilder& PipelineBuilder::SetDynamicStates(vk::ArrayProxy<const vk::DynamicState> states)
+	{
+		dynamicStates_.assign(states.begin(), states.end());
+		return *this;
+	}
+
+	//----
+	PipelineBuilder& PipelineBuilder::SetLayout(const vk::PipelineLayout& layout)
+	{
+		layout_ = layout;
+		return *this;
+	}
+
+	//----
+	PipelineBuilder& PipelineBuilder::SetRenderPass(RenderPass& renderPass, uint32_t subpass)
+	{
+		renderPass_ = renderPass.GetPass();
+		renderPassHash_ = renderPass.GetCompatibilityHash();
+		subpass_ = subpass;
+		return *this;
+	}
+
+	//----
+	vk::Pipeline PipelineBuilder::Build(Device& owner) const
+	{
+		return owner.GetPipelineStateCache().GetPipeline(*this);
+	}
+
+	//----
+	std::shared_future<vk::Pipeline> PipelineBuilder::BuildAsync(Device& owner) const
+	{
+		return owner.GetPipelineStateCache().GetPipelineAsync(*this);
+	}
+
+	//----
+	vk::Pipeline PipelineBuilder::Create(vk::Device& device, const vk::PipelineCache& cache) const
+	{
+		// シェーダ設定
+		std::vector<vk::PipelineShaderStageCreateInfo> shaderStages(stages_.size());
+		for (size_t i = 0; i < stages_.size(); i++)
+		{
+			shaderStages[i].stage = stages_[i].stage;
+			shaderStages[i].module = stages_[i].module;
+			shaderStages[i].pName = stages_[i].entryPoint.c_str();
+		}
+
+		// 頂点入力
+		vk::PipelineVertexInputStateCreateInfo vinputState;
+		vinputState.vertexBindingDescriptionCount = static_cast<uint32_t>(bindings_.size());
+		vinputState.pVertexBindingDescriptions = bindings_.data();
+		vinputState.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributes_.size());
+		vinputState.pVertexAttributeDescriptions = attributes_.data();
+
+		// ブレンドモード
+		vk::PipelineColorBlendStateCreateInfo colorBlendState;
+		colorBlendState.attachmentCount = static_cast<uint32_t>(blendAttachments_.size());
+		colorBlendState.pAttachments = blendAttachments_.data();
+
+		// ViewportとScissorBoxは動的に設定する前提
+		vk::PipelineViewportStateCreateInfo viewportState;
+		viewportState.viewportCount = 1;
+		viewportState.scissorCount = 1;
+
+		vk::PipelineDynamicStateCreateInfo dynamicState;
+		dynamicState.dynamicStateCount = static_cast<uint32_t>(dynamicStates_.size());
+		dynamicState.pDynamicStates = dynamicStates_.data();
+
+		vk::PipelineMultisampleStateCreateInfo multisampleState;
+		multisampleState.rasterizationSamples = sampleCount_;
+
+		vk::GraphicsPipelineCreateInfo pipelineCreateInfo;
+		pipelineCreateInfo.layout = layout_;
+		pipelineCreateInfo.renderPass = renderPass_;
+		pipelineCreateInfo.subpass = subpass_;
+		pipelineCreateInfo.stageCount = static_cast<uint32_t>(shaderStages.size());
+		pipelineCreateInfo.pStages = shaderStages.data();
+		pipelineCreateInfo.pVertexInputState = &vinputState;
+		pipelineCreateInfo.pInputAssemblyState = &inputAssembly_;
+		pipelineCreateInfo.pRasterizationState = &rasterization_;
+		pipelineCreateInfo.pColorBlendState = &colorBlendState;
+		pipelineCreateInfo.pMultisampleState = &multisampleState;
+		pipelineCreateInfo.pViewportState = &viewportState;
+		pipelineCreateInfo.pDepthStencilState = &depthStencil_;
+		pipelineCreateInfo.pDynamicState = dynamicStates_.empty() ? nullptr : &dynamicState;
+
+		return device.createGraphicsPipelines(cache, pipelineCreateInfo, nullptr)[0];
+	}
+
+	//----
+	uint64_t PipelineBuilder::ComputeHash() const
+	{
+		uint64_t h = kFnvOffsetBasis;
+		for (auto& s : stages_)
+		{
+			HashCombine(h, s.stage);
+			HashCombine(h, static_cast<VkShaderModule>(s.module));
+			h = HashBytes(s.entryPoint.data(), s.entryPoint.size(), h);
+		}
+		for (auto& b : bindings_)
+		{
+			HashCombine(h, b.binding);
+			HashCombine(h, b.stride);
+			HashCombine(h, b.inputRate);
+		}
+		for (auto& a : attributes_)
+		{
+			HashCombine(h, a.location);
+			HashCombine(h, a.binding);
+			HashCombine(h, a.format);
+			HashCombine(h, a.offset);
+		}
+		HashCombine(h, inputAssembly_.topology);
+		HashCombine(h, inputAssembly_.primitiveRestartEnable);
+		HashCombine(h, rasterization_.depthClampEnable);
+		HashCombine(h, rasterization_.rasterizerDiscardEnable);
+		HashCombine(h, rasterization_.polygonMode);
+		HashCombine(h, rasterization_.cullMode);
+		HashCombine(h, rasterization_.frontFace);
+		HashCombine(h, rasterization_.depthBiasEnable);
+		HashCombine(h, rasterization_.lineWidth);
+		HashCombine(h, depthStencil_.depthTestEnable);
+		HashCombine(h, depthStencil_.depthWriteEnable);
+		HashCombine(h, depthStencil_.depthCompareOp);
+		HashCombine(h, depthStencil_.stencilTestEnable);
+		for (auto& b : blendAttachments_)
+		{
+			HashCombine(h, b.blendEnable);
+			HashCombine(h, b.srcColorBlendFactor);
+			HashCombine(h, b.dstColorBlendFactor);
+			HashCombine(h, b.colorBlendOp);
+			HashCombine(h, b.srcAlphaBlendFactor);
+			HashCombine(h, b.dstAlphaBlendFactor);
+			HashCombine(h, b.alphaBlendOp);
+			HashCombine(h, b.colorWriteMask);
+		}
+		HashCombine(h, sampleCount_);
+		for (auto& d : dynamicStates_)
+		{
+			HashCombine(h, d);
+		}
+		HashCombine(h, static_cast<VkPipelineLayout>(layout_));
+		HashCombine(h, renderPassHash_);
+		HashCombine(h, subpass_);
+		return h;
+	}
+
+	//----
+	bool PipelineBuilder::IsSameState(const PipelineBuilder& rhs) const
+	{
+		if (stages_.size() != rhs.stages_.size())
+		{
+			return false;
+		}
+		for (size_t i = 0; i < stages_.size(); i++)
+		{
+			if (stages_[i].stage != rhs.stages_[i].stage
+				|| stages_[i].module != rhs.stages_[i].module
+				|| stages_[i].entryPoint != rhs.stages_[i].entryPoint)
+			{
+				return false;
+			}
+		}
+		return (bindings_ == rhs.bindings_)
+			&& (attributes_ == rhs.attributes_)
+			&& (inputAssembly_ == rhs.inputAssembly_)
+			&& (rasterization_ == rhs.rasterization_)
+			&& (depthStencil_ == rhs.depthStencil_)
+			&& (blendAttachments_ == rhs.blendAttachments_)
+			&& (sampleCount_ == rhs.sampleCount_)
+			&& (dynamicStates_ == rhs.dynamicStates_)
+			&& (layout_ == rhs.layout_)
+			&& (renderPassHash_ == rhs.renderPassHash_)
+			&& (subpass_ == rhs.subpass_);
+	}
+
+	//----
+	bool PipelineBuilder::UsesShader(const vk::ShaderModule& module) const
+	{
+		for (auto& s : stages_)
+		{
+			if (s.module == module)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	//----
+	ComputePipelineBuilder& ComputePipelineBuilder::SetShader(const vk::ShaderModule& module, const char* entryPoint)
+	{
+		module_ = module;
+		entryPoint_ = entryPoint;
+		return *this;
+	}
+
+	//----
+	ComputePipelineBuilder& ComputePipelineBuilder::SetLayout(const vk::PipelineLayout& layout)
+	{
+		layout_ = layout;
+		return *this;
+	}
+
+	//----
+	ComputePipelineBuilder& ComputePipelineBuilder::SetSpecConstant(uint32_t constantId, uint32_t value)
+	{
+		// 同じIDは上書きする
+		for (size_t i = 0; i < specEntries_.size(); i++)
+		{
+			if (specEntries_[i].constantID == constantId)
+			{
+				specData_[i] = value;
+				return *this;
+			}
+		}
+		uint32_t offset = static_cast<uint32_t>(specData_.size() * sizeof(uint32_t));
+		specEntries_.push_back(vk::SpecializationMapEntry(constantId, offset, sizeof(uint32_t)));
+		specData_.push_back(value);
+		return *this;
+	}
+
+	//----
+	ComputePipelineBuilder& ComputePipelineBuilder::ClearSpecConstants()
+	{
+		specEntries_.clear();
+		specData_.clear();
+		return *this;
+	}
+
+	//----
+	vk::Pipeline ComputePipelineBuilder::Build(Device& owner) const
+	{
+		return owner.GetPipelineStateCache().GetPipeline(*this);
+	}
+
+	//----
+	std::shared_future<vk::Pipeline> ComputePipelineBuilder::BuildAsync(Device& owner) const
+	{
+		return owner.GetPipelineStateCache().GetPipelineAsync(*this);
+	}
+
+	//----
+	vk::Pipeline ComputePipelineBuilder::Create(vk::Device& device, const vk::PipelineCache& cache) const
+	{
+		vk::SpecializationInfo specInfo(
+			static_cast<uint32_t>(specEntries_.size()), specEntries_.data(),
+			specData_.size() * sizeof(uint32_t), specData_.data());
+		vk::PipelineShaderStageCreateInfo shaderInfo(vk::PipelineShaderStageCreateFlags(), vk::ShaderStageFlagBits::eCompute, module_, entryPoint_.c_str(),
+			specEntries_.empty() ? nullptr : &specInfo);
+		vk::ComputePipelineCreateInfo pipelineCreateInfo(vk::PipelineCreateFlags(), shaderInfo, layout_);
+		return device.createComputePipeline(cache, pipelineCreateInfo);
+	}
+
+	//----
+	uint64_t ComputePipelineBuilder::ComputeHash() const
+	{
+		uint64_t h = kFnvOffsetBasis;
+		HashCombine(h, static_cast<VkShaderModule>(module_));
+		h = HashBytes(entryPoint_.data(), entryPoint_.size(), h);
+		HashCombine(h, static_cast<VkPipelineLayout>(layout_));
+		for (auto& entry : specEntries_)
+		{
+			HashCombine(h, entry.constantID);
+		}
+		h = HashBytes(specData_.data(), specData_.size() * sizeof(uint32_t), h);
+		return h;
+	}
+
+	//----
+	bool ComputePipelineBuilder::IsSameState(const ComputePipelineBuilder& rhs) const
+	{
+		return (module_ == rhs.module_)
+			&& (entryPoint_ == rhs.entryPoint_)
+			&& (layout_ == rhs.layout_)
+			&& (specEntries_ == rhs.specEntries_)
+			&& (specData_ == rhs.specData_);
+	}
+
+}	// namespace vsl
+
+
+//	EOF
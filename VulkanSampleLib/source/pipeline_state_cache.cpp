@@ -0,0 +1,287 @@
+﻿#include <vsl/pipeline_state_cache.h>
+#include <vsl/device.h>
+#include <chrono>
+#include <iterator>
+
+
+namespace vsl
+{
+	//----
+	bool PipelineStateCache::Initialize(Device& owner)
+	{
+		pOwner_ = &owner;
+
+		// ワーカースレッドごとのパイプラインキャッシュ
+		uint32_t workerCount = owner.GetThreadPool().GetThreadCount();
+		workerCaches_.resize(workerCount);
+		for (auto& c : workerCaches_)
+		{
+			c = owner.GetDevice().createPipelineCache(vk::PipelineCacheCreateInfo());
+			VSL_API_COUNT(ObjectCreate);
+			if (!c)
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	//----
+	void PipelineStateCache::Destroy()
+	{
+		if (pOwner_)
+		{
+			WaitAsyncJobs();
+
+			vk::Device& device = pOwner_->GetDevice();
+			for (auto& c : workerCaches_)
+			{
+				if (c) { device.destroyPipelineCache(c); VSL_API_COUNT(ObjectDestroy); }
+			}
+			workerCaches_.clear();
+
+			for (auto& bucket : graphicsPipelines_)
+			{
+				for (auto& e : bucket.second)
+				{
+					device.destroyPipeline(e.pipeline);
+					VSL_API_COUNT(ObjectDestroy);
+				}
+			}
+			for (auto& bucket : computePipelines_)
+			{
+				for (auto& e : bucket.second)
+				{
+					device.destroyPipeline(e.pipeline);
+					VSL_API_COUNT(ObjectDestroy);
+				}
+			}
+			for (auto& p : retiredPipelines_)
+			{
+				device.destroyPipeline(p);
+				VSL_API_COUNT(ObjectDestroy);
+			}
+			graphicsPipelines_.clear();
+			computePipelines_.clear();
+			retiredPipelines_.clear();
+			stats_ = Stats();
+		}
+		pOwner_ = nullptr;
+	}
+
+	//----
+	vk::Pipeline PipelineStateCache::GetPipeline(const PipelineBuilder& builder, vk::PipelineCache cache)
+	{
+		return GetPipelineImpl(graphicsPipelines_, builder, cache);
+	}
+
+	//----
+	vk::Pipeline PipelineStateCache::GetPipeline(const ComputePipelineBuilder& builder, vk::PipelineCache cache)
+	{
+		return GetPipelineImpl(computePipelines_, builder, cache);
+	}
+
+	//----
+	std::shared_future<vk::Pipeline> PipelineStateCache::GetPipelineAsync(const PipelineBuilder& builder)
+	{
+		return GetPipelineAsyncImpl(builder);
+	}
+
+	//----
+	std::shared_future<vk::Pipeline> PipelineStateCache::GetPipelineAsync(const ComputePipelineBuilder& builder)
+	{
+		return GetPipelineAsyncImpl(builder);
+	}
+
+	//----
+	bool PipelineStateCache::MergeWorkerCaches()
+	{
+		// ジョブの投入を止めた状態で完了を待ち、ワーカーのキャッシュを使うジョブがない状態にする
+		std::lock_guard<std::mutex> lock(asyncMutex_);
+		for (auto& j : asyncJobs_)
+		{
+			j.wait();
+		}
+		asyncJobs_.clear();
+
+		if (!hasUnmergedJobs_ || workerCaches_.empty())
+		{
+			return true;
+		}
+		hasUnmergedJobs_ = false;
+
+		vk::Device& device = pOwner_->GetDevice();
+		vk::Result result = device.mergePipelineCaches(
+			pOwner_->GetPipelineCache(), static_cast<uint32_t>(workerCaches_.size()), workerCaches_.data());
+		if (result != vk::Result::eSuccess)
+		{
+			return false;
+		}
+
+		// 統合済みの内容を次回も統合しないよう、空のキャッシュに作り直す
+		for (auto& c : workerCaches_)
+		{
+			device.destroyPipelineCache(c);
+			VSL_API_COUNT(ObjectDestroy);
+			c = device.createPipelineCache(vk::PipelineCacheCreateInfo());
+			VSL_API_COUNT(ObjectCreate);
+			if (!c)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	//----
+	void PipelineStateCache::Invalidate(const vk::ShaderModule& module)
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		InvalidateImpl(graphicsPipelines_, module);
+		InvalidateImpl(computePipelines_, module);
+	}
+
+	//----
+	template <typename Builder>
+	void PipelineStateCache::InvalidateImpl(EntryMap<Builder>& entries, const vk::ShaderModule& module)
+	{
+		for (auto bucket = entries.begin(); bucket != entries.end(); )
+		{
+			auto& list = bucket->second;
+			for (auto it = list.begin(); it != list.end(); )
+			{
+				if (it->state.UsesShader(module))
+				{
+					retiredPipelines_.push_back(it->pipeline);
+					it = list.erase(it);
+				}
+				else
+				{
+					++it;
+				}
+			}
+			bucket = list.empty() ? entries.erase(bucket) : std::next(bucket);
+		}
+	}
+
+	//----
+	template <typename Builder>
+	std::shared_future<vk::Pipeline> PipelineStateCache::GetPipelineAsyncImpl(const Builder& builder)
+	{
+		// 統合中はワーカーのキャッシュを作り直すので、投入もロックの中で行う
+		std::lock_guard<std::mutex> lock(asyncMutex_);
+
+		// ステートはコピーしてワーカーに渡す
+		std::shared_future<vk::Pipeline> ret = pOwner_->GetThreadPool().Submit([this, builder]()
+		{
+			int index = ThreadPool::GetCurrentWorkerIndex();
+			return GetPipeline(builder, workerCaches_[index]);
+		}).share();
+
+		asyncJobs_.push_back(ret);
+		hasUnmergedJobs_ = true;
+		return ret;
+	}
+
+	//----
+	void PipelineStateCache::WaitAsyncJobs()
+	{
+		std::vector<std::shared_future<vk::Pipeline>> jobs;
+		{
+			std::lock_guard<std::mutex> lock(asyncMutex_);
+			jobs.swap(asyncJobs_);
+		}
+		for (auto& j : jobs)
+		{
+			j.wait();
+		}
+	}
+
+	//----
+	template <typename Builder>
+	vk::Pipeline PipelineStateCache::GetPipelineImpl(EntryMap<Builder>& entries, const Builder& builder, vk::PipelineCache cache)
+	{
+		uint64_t hash = builder.ComputeHash();
+
+		// 登録済みならそれを返す
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			auto it = entries.find(hash);
+			if (it != entries.end())
+			{
+				for (auto& e : it->second)
+				{
+					if (e.state.IsSameState(builder))
+					{
+						stats_.hitCount++;
+						return e.pipeline;
+					}
+				}
+			}
+		}
+
+		// 生成はロックの外で行い、他スレッドの取得を止めない
+		auto start = std::chrono::high_resolution_clock::now();
+		vk::Device& device = pOwner_->GetDevice();
+		vk::Pipeline pipeline = builder.Create(device, cache ? cache : pOwner_->GetPipelineCache());
+		auto end = std::chrono::high_resolution_clock::now();
+		if (!pipeline)
+		{
+			return pipeline;
+		}
+		VSL_API_COUNT(ObjectCreate);
+
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		// 同じ設定が他スレッドで先に登録されていたらそちらを使う
+		auto& bucket = entries[hash];
+		for (auto& e : bucket)
+		{
+			if (e.state.IsSameState(builder))
+			{
+				device.destroyPipeline(pipeline);
+				VSL_API_COUNT(ObjectDestroy);
+				stats_.hitCount++;
+				return e.pipeline;
+			}
+		}
+
+		stats_.missCount++;
+		stats_.compileMilliseconds += std::chrono::duration<double, std::milli>(end - start).count();
+
+		Entry<Builder> entry;
+		entry.state = builder;
+		entry.pipeline = pipeline;
+		bucket.push_back(entry);
+		return pipeline;
+	}
+
+	//----
+	PipelineStateCache::Stats PipelineStateCache::GetStats() const
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		return stats_;
+	}
+
+	//----
+	size_t PipelineStateCache::GetPipelineCount() const
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		size_t count = 0;
+		for (auto& bucket : graphicsPipelines_)
+		{
+			count += bucket.second.size();
+		}
+		for (auto& bucket : computePipelines_)
+		{
+			count += bucket.second.size();
+		}
+		return count;
+	}
+
+}	// namespace vsl
+
+
+//	EOF
@@ -0,0 +1,222 @@
+﻿#include <vsl/pipeline_statistics.h>
+#include <vsl/device.h>
+#include <cstdio>
+#include <cstring>
+
+
+namespace vsl
+{
+	namespace
+	{
+		// PipelineStatisticsCounter の順に並べる
+		// 結果はフラグのビットが小さい順に書き込まれるため、この順序と一致する
+		static const vk::QueryPipelineStatisticFlags kStatisticFlags =
+			vk::QueryPipelineStatisticFlagBits::eInputAssemblyVertices
+			| vk::QueryPipelineStatisticFlagBits::eVertexShaderInvocations
+			| vk::QueryPipelineStatisticFlagBits::eClippingPrimitives
+			| vk::QueryPipelineStatisticFlagBits::eFragmentShaderInvocations
+			| vk::QueryPipelineStatisticFlagBits::eComputeShaderInvocations;
+
+		static const char* kCounterNames[] =
+		{
+			"input vertices",
+			"vertex invocations",
+			"clipping primitives",
+			"fragment invocations",
+			"compute invocations",
+		};
+		static_assert(sizeof(kCounterNames) / sizeof(kCounterNames[0]) == PipelineStatisticsCounter::Max, "kCounterNames must match PipelineStatisticsCounter.");
+	}	// namespace
+
+	//----
+	bool PipelineStatistics::Initialize(Device& owner, uint32_t frameCount, uint32_t maxScopes)
+	{
+		Destroy();
+
+		// Device は対応している機能をすべて有効にしている
+		if (!owner.GetPhysicalDevice().getFeatures().pipelineStatisticsQuery || (frameCount == 0) || (maxScopes == 0))
+		{
+			return false;
+		}
+
+		vk::Device& device = owner.GetDevice();
+		vk::QueryPoolCreateInfo poolInfo(vk::QueryPoolCreateFlags(), vk::QueryType::ePipelineStatistics, maxScopes, kStatisticFlags);
+		frames_.resize(frameCount);
+		for (auto& frame : frames_)
+		{
+			frame.pool = device.createQueryPool(poolInfo);
+			VSL_API_COUNT(ObjectCreate);
+			if (!frame.pool)
+			{
+				pOwner_ = &owner;
+				Destroy();
+				return false;
+			}
+			frame.names.reserve(maxScopes);
+		}
+
+		maxScopes_ = maxScopes;
+		pOwner_ = &owner;
+		return true;
+	}
+
+	//----
+	void PipelineStatistics::Destroy()
+	{
+		if (pOwner_)
+		{
+			vk::Device& device = pOwner_->GetDevice();
+			for (auto& frame : frames_)
+			{
+				if (frame.pool)
+				{
+					device.destroyQueryPool(frame.pool);
+					VSL_API_COUNT(ObjectDestroy);
+				}
+			}
+		}
+		frames_.clear();
+		pCurrent_ = nullptr;
+		scopeStack_.clear();
+		entries_.clear();
+		droppedCount_ = 0;
+		pOwner_ = nullptr;
+	}
+
+	//----
+	void PipelineStatistics::BeginFrame(vk::CommandBuffer& cmdBuffer, uint32_t frameIndex)
+	{
+		pCurrent_ = nullptr;
+		scopeStack_.clear();
+		if (!pOwner_ || (frameIndex >= frames_.size()))
+		{
+			return;
+		}
+
+		Frame& frame = frames_[frameIndex];
+		if (frame.isPending)
+		{
+			Resolve(frame);
+		}
+
+		cmdBuffer.resetQueryPool(frame.pool, 0, maxScopes_);
+		frame.names.clear();
+		frame.isPending = true;
+		pCurrent_ = &frame;
+	}
+
+	//----
+	void PipelineStatistics::BeginScope(vk::CommandBuffer& cmdBuffer, const char* name)
+	{
+		if (!pCurrent_)
+		{
+			return;
+		}
+
+		// 実行中のスコープがある場合とクエリが足りない場合は記録しない
+		bool isActive = false;
+		for (bool b : scopeStack_)
+		{
+			isActive = isActive || b;
+		}
+		if (isActive || (pCurrent_->names.size() >= maxScopes_))
+		{
+			scopeStack_.push_back(false);
+			droppedCount_++;
+			return;
+		}
+
+		uint32_t query = static_cast<uint32_t>(pCurrent_->names.size());
+		cmdBuffer.beginQuery(pCurrent_->pool, query, vk::QueryControlFlags());
+		pCurrent_->names.push_back(name);
+		scopeStack_.push_back(true);
+	}
+
+	//----
+	void PipelineStatistics::EndScope(vk::CommandBuffer& cmdBuffer)
+	{
+		if (!pCurrent_ || scopeStack_.empty())
+		{
+			return;
+		}
+		bool isRecorded = scopeStack_.back();
+		scopeStack_.pop_back();
+		if (isRecorded)
+		{
+			uint32_t query = static_cast<uint32_t>(pCurrent_->names.size()) - 1;
+			cmdBuffer.endQuery(pCurrent_->pool, query);
+		}
+	}
+
+	//----
+	const PipelineStatisticsEntry* PipelineStatistics::Find(const char* name) const
+	{
+		for (auto& entry : entries_)
+		{
+			if (entry.name == name)
+			{
+				return &entry;
+			}
+		}
+		return nullptr;
+	}
+
+	//----
+	std::string PipelineStatistics::ToText() const
+	{
+		std::string ret;
+		char str[256];
+		for (auto& entry : entries_)
+		{
+			ret += entry.name + " :";
+			for (uint32_t i = 0; i < PipelineStatisticsCounter::Max; i++)
+			{
+				sprintf_s(str, " %s %llu", kCounterNames[i], static_cast<unsigned long long>(entry.values[i]));
+				ret += str;
+				ret += (i + 1 < PipelineStatisticsCounter::Max) ? "," : "\n";
+			}
+		}
+		return ret;
+	}
+
+	//----
+	const char* PipelineStatistics::GetCounterName(PipelineStatisticsCounter::Type counter)
+	{
+		return (counter < PipelineStatisticsCounter::Max) ? kCounterNames[counter] : "";
+	}
+
+	//----
+	void PipelineStatistics::Resolve(Frame& frame)
+	{
+		frame.isPending = false;
+		uint32_t count = static_cast<uint32_t>(frame.names.size());
+		if (count == 0)
+		{
+			entries_.clear();
+			return;
+		}
+
+		// フェンスの完了後に呼ばれるため待たない
+		// 終了していないスコープがあると eNotReady になるので、前回の結果を残す
+		const uint32_t kStride = sizeof(uint64_t) * PipelineStatisticsCounter::Max;
+		std::vector<uint64_t> values(count * PipelineStatisticsCounter::Max);
+		vk::Result result = pOwner_->GetDevice().getQueryPoolResults(frame.pool, 0, count,
+			values.size() * sizeof(uint64_t), values.data(), kStride,
+			vk::QueryResultFlagBits::e64);
+		if (result != vk::Result::eSuccess)
+		{
+			return;
+		}
+
+		entries_.resize(count);
+		for (uint32_t i = 0; i < count; i++)
+		{
+			entries_[i].name = frame.names[i];
+			memcpy(entries_[i].values, &values[i * PipelineStatisticsCounter::Max], kStride);
+		}
+	}
+
+}	// namespace vsl
+
+
+//	EOF
@@ -1,5 +1,6 @@
 ﻿#include <vsl/render_pass.h>
 #include <vsl/device.h>
+#include <vsl/hash.h>
 
 
 namespace vsl
@@ -21,6 +22,37 @@ namespace vsl
 		renderPassInfo.dependencyCount = (uint32_t)dependencies.size();
 		renderPassInfo.pDependencies = dependencies.data();
 		pass_ = device.GetDevice().createRenderPass(renderPassInfo);
+		VSL_API_COUNT(ObjectCreate);
+
+		// 互換性判定用のハッシュ
+		// アタッチメントのフォーマットとサンプル数、サブパスの参照が同じなら互換とみなす
+		// ロード・ストア操作やレイアウトは互換性に影響しない
+		{
+			auto hashRefs = [](uint64_t& h, uint32_t count, const vk::AttachmentReference* pRefs)
+			{
+				HashCombine(h, count);
+				for (uint32_t i = 0; pRefs && i < count; i++)
+				{
+					HashCombine(h, pRefs[i].attachment);
+				}
+			};
+
+			uint64_t h = kFnvOffsetBasis;
+			for (auto& a : attachDescs)
+			{
+				HashCombine(h, a.format);
+				HashCombine(h, a.samples);
+			}
+			for (auto& s : subpasses)
+			{
+				HashCombine(h, s.pipelineBindPoint);
+				hashRefs(h, s.inputAttachmentCount, s.pInputAttachments);
+				hashRefs(h, s.colorAttachmentCount, s.pColorAttachments);
+				hashRefs(h, s.pResolveAttachments ? s.colorAttachmentCount : 0, s.pResolveAttachments);
+				hashRefs(h, s.pDepthStencilAttachment ? 1 : 0, s.pDepthStencilAttachment);
+			}
+			compatibilityHash_ = h;
+		}
 
 		return pass_.operator bool();
 	}
@@ -95,7 +127,7 @@ namespace vsl
 		if (pOwner_)
 		{
 			vk::Device& device = pOwner_->GetDevice();
-			if (pass_) { device.destroyRenderPass(pass_); pass_ = vk::RenderPass(); }
+			if (pass_) { device.destroyRenderPass(pass_); VSL_API_COUNT(ObjectDestroy); pass_ = vk::RenderPass(); }
 		}
 		pOwner_ = nullptr;
 	}
@@ -0,0 +1,80 @@
+﻿#include <vsl/sampler_cache.h>
+#include <vsl/device.h>
+#include <vsl/hash.h>
+
+
+namespace vsl
+{
+	//----
+	size_t SamplerCache::CreateInfoHash::operator()(const vk::SamplerCreateInfo& info) const
+	{
+		uint64_t h = kFnvOffsetBasis;
+		HashCombine(h, info.flags);
+		HashCombine(h, info.magFilter);
+		HashCombine(h, info.minFilter);
+		HashCombine(h, info.mipmapMode);
+		HashCombine(h, info.addressModeU);
+		HashCombine(h, info.addressModeV);
+		HashCombine(h, info.addressModeW);
+		HashCombine(h, info.mipLodBias);
+		HashCombine(h, info.anisotropyEnable);
+		HashCombine(h, info.maxAnisotropy);
+		HashCombine(h, info.compareEnable);
+		HashCombine(h, info.compareOp);
+		HashCombine(h, info.minLod);
+		HashCombine(h, info.maxLod);
+		HashCombine(h, info.borderColor);
+		HashCombine(h, info.unnormalizedCoordinates);
+		return static_cast<size_t>(h);
+	}
+
+	//----
+	bool SamplerCache::Initialize(Device& owner)
+	{
+		pOwner_ = &owner;
+		return true;
+	}
+
+	//----
+	void SamplerCache::Destroy()
+	{
+		if (pOwner_)
+		{
+			vk::Device& device = pOwner_->GetDevice();
+			for (auto& s : samplers_)
+			{
+				device.destroySampler(s.second);
+				VSL_API_COUNT(ObjectDestroy);
+			}
+			samplers_.clear();
+		}
+		pOwner_ = nullptr;
+	}
+
+	//----
+	vk::Sampler SamplerCache::GetSampler(const vk::SamplerCreateInfo& createInfo)
+	{
+		// 拡張構造体はキーに含められない
+		assert(createInfo.pNext == nullptr);
+
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		auto it = samplers_.find(createInfo);
+		if (it != samplers_.end())
+		{
+			return it->second;
+		}
+
+		vk::Sampler sampler = pOwner_->GetDevice().createSampler(createInfo);
+		VSL_API_COUNT(ObjectCreate);
+		if (sampler)
+		{
+			samplers_[createInfo] = sampler;
+		}
+		return sampler;
+	}
+
+}	// namespace vsl
+
+
+//	EOF
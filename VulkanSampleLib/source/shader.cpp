@@ -1,32 +1,214 @@
 ﻿#include <vsl/shader.h>
 #include <vsl/device.h>
+#include <vsl/mapped_file.h>
+#include <vsl/shader_bundle.h>
+#include <algorithm>
 
 
+namespace
+{
+	//----
+	// SPIR-Vの解析に必要な定数のみ定義
+	static const uint32_t	kSpvMagicNumber = 0x07230203;
+	static const uint32_t	kSpvInvalid = 0xffffffff;
+
+	enum SpvOp
+	{
+		kSpvOpEntryPoint = 15,
+		kSpvOpExecutionMode = 16,
+		kSpvOpTypeInt = 21,
+		kSpvOpTypeFloat = 22,
+		kSpvOpTypeVector = 23,
+		kSpvOpTypeMatrix = 24,
+		kSpvOpTypeImage = 25,
+		kSpvOpTypeSampler = 26,
+		kSpvOpTypeSampledImage = 27,
+		kSpvOpTypeArray = 28,
+		kSpvOpTypeRuntimeArray = 29,
+		kSpvOpTypeStruct = 30,
+		kSpvOpTypePointer = 32,
+		kSpvOpConstant = 43,
+		kSpvOpConstantComposite = 44,
+		kSpvOpSpecConstant = 50,
+		kSpvOpSpecConstantComposite = 51,
+		kSpvOpVariable = 59,
+		kSpvOpDecorate = 71,
+		kSpvOpMemberDecorate = 72,
+	};
+
+	enum SpvDecoration
+	{
+		kSpvDecorationSpecId = 1,
+		kSpvDecorationBlock = 2,
+		kSpvDecorationBufferBlock = 3,
+		kSpvDecorationArrayStride = 6,
+		kSpvDecorationMatrixStride = 7,
+		kSpvDecorationBuiltIn = 11,
+		kSpvDecorationBinding = 33,
+		kSpvDecorationDescriptorSet = 34,
+		kSpvDecorationOffset = 35,
+	};
+
+	enum SpvStorageClass
+	{
+		kSpvStorageClassUniformConstant = 0,
+		kSpvStorageClassUniform = 2,
+		kSpvStorageClassPushConstant = 9,
+		kSpvStorageClassStorageBuffer = 12,
+	};
+
+	static const uint32_t	kSpvExecutionModeLocalSize = 17;
+	static const uint32_t	kSpvBuiltInWorkgroupSize = 25;
+	static const uint32_t	kSpvDimBuffer = 5;
+	static const uint32_t	kSpvDimSubpassData = 6;
+
+	//----
+	// IDごとの解析結果
+	struct SpvId
+	{
+		uint32_t				opcode{ 0 };
+		uint32_t				typeId{ kSpvInvalid };		// 変数・定数の型、ポインタや配列の要素型
+		uint32_t				storageClass{ kSpvInvalid };
+		std::vector<uint32_t>	operands;					// 型・複合定数のオペランド
+		uint32_t				value{ 0 };					// 定数値
+
+		uint32_t				set{ kSpvInvalid };
+		uint32_t				binding{ kSpvInvalid };
+		uint32_t				specId{ kSpvInvalid };
+		uint32_t				builtIn{ kSpvInvalid };
+		uint32_t				arrayStride{ 0 };
+		bool					isBlock{ false };
+		bool					isBufferBlock{ false };
+		std::vector<uint32_t>	memberOffsets;
+		std::vector<uint32_t>	memberMatrixStrides;
+	};	// struct SpvId
+
+	//----
+	// 型のバイトサイズ (プッシュ定数のサイズ計算用)
+	uint32_t GetSpvTypeSize(const std::vector<SpvId>& ids, uint32_t typeId, uint32_t matrixStride = 0)
+	{
+		if (typeId >= ids.size())
+		{
+			return 0;
+		}
+
+		const SpvId& t = ids[typeId];
+		switch (t.opcode)
+		{
+		case kSpvOpTypeInt:
+		case kSpvOpTypeFloat:
+			return t.operands[0] / 8;
+		case kSpvOpTypeVector:
+			return GetSpvTypeSize(ids, t.operands[0]) * t.operands[1];
+		case kSpvOpTypeMatrix:
+			if (matrixStride == 0)
+			{
+				// MatrixStrideの指定がなければ列ベクトルを16byte境界に揃える
+				matrixStride = (GetSpvTypeSize(ids, t.operands[0]) + 15) & ~15u;
+			}
+			return matrixStride * t.operands[1];
+		case kSpvOpTypeArray:
+			{
+				uint32_t length = (t.operands[1] < ids.size()) ? ids[t.operands[1]].value : 0;
+				uint32_t stride = t.arrayStride ? t.arrayStride : GetSpvTypeSize(ids, t.operands[0], matrixStride);
+				return stride * length;
+			}
+		case kSpvOpTypeStruct:
+			{
+				uint32_t size = 0;
+				for (size_t i = 0; i < t.operands.size(); i++)
+				{
+					uint32_t offset = (i < t.memberOffsets.size()) ? t.memberOffsets[i] : size;
+					uint32_t stride = (i < t.memberMatrixStrides.size()) ? t.memberMatrixStrides[i] : 0;
+					size = (std::max)(size, offset + GetSpvTypeSize(ids, t.operands[i], stride));
+				}
+				return size;
+			}
+		default:
+			return 0;
+		}
+	}
+
+	//----
+	// リソースの型からデスクリプタタイプを決める
+	bool GetSpvDescriptorType(const SpvId& type, uint32_t storageClass, vk::DescriptorType& outType)
+	{
+		if (storageClass == kSpvStorageClassStorageBuffer)
+		{
+			outType = vk::DescriptorType::eStorageBuffer;
+			return true;
+		}
+		if (storageClass == kSpvStorageClassUniform)
+		{
+			outType = type.isBufferBlock ? vk::DescriptorType::eStorageBuffer : vk::DescriptorType::eUniformBuffer;
+			return true;
+		}
+
+		switch (type.opcode)
+		{
+		case kSpvOpTypeSampler:
+			outType = vk::DescriptorType::eSampler;
+			return true;
+		case kSpvOpTypeSampledImage:
+			outType = vk::DescriptorType::eCombinedImageSampler;
+			return true;
+		case kSpvOpTypeImage:
+			{
+				// operands : sampled type, dim, depth, arrayed, ms, sampled, format
+				uint32_t dim = type.operands[1];
+				uint32_t sampled = type.operands[5];
+				if (dim == kSpvDimBuffer)
+				{
+					outType = (sampled == 2) ? vk::DescriptorType::eStorageTexelBuffer : vk::DescriptorType::eUniformTexelBuffer;
+				}
+				else if (dim == kSpvDimSubpassData)
+				{
+					outType = vk::DescriptorType::eInputAttachment;
+				}
+				else
+				{
+					outType = (sampled == 2) ? vk::DescriptorType::eStorageImage : vk::DescriptorType::eSampledImage;
+				}
+				return true;
+			}
+		default:
+			return false;
+		}
+	}
+
+	//----
+	vk::ShaderStageFlagBits GetSpvStage(uint32_t executionModel)
+	{
+		switch (executionModel)
+		{
+		case 1: return vk::ShaderStageFlagBits::eTessellationControl;
+		case 2: return vk::ShaderStageFlagBits::eTessellationEvaluation;
+		case 3: return vk::ShaderStageFlagBits::eGeometry;
+		case 4: return vk::ShaderStageFlagBits::eFragment;
+		case 5: return vk::ShaderStageFlagBits::eCompute;
+		default: return vk::ShaderStageFlagBits::eVertex;
+		}
+	}
+}	// namespace
+
 namespace vsl
 {
 	//----
 	bool Shader::CreateFromFile(Device& owner, const std::string& filename)
 	{
-		// ファイル読み込み
-		std::vector<uint8_t> bin;
-		FILE* fp = nullptr;
-		if (fopen_s(&fp, filename.c_str(), "rb") != 0)
+		// ファイルはメモリマップして直接参照する
+		MappedFile file;
+		if (!file.Open(filename))
 		{
 			assert(!"Do NOT read shader file.\n");
 			return false;
 		}
-		fseek(fp, 0, SEEK_END);
-		size_t size = ftell(fp);
-		fseek(fp, 0, SEEK_SET);
-		bin.resize(size);
-		fread(bin.data(), size, 1, fp);
-		fclose(fp);
 
-		return CreateFromMemory(owner, bin.data(), size);
+		return CreateFromMemory(owner, file.GetData(), file.GetSize());
 	}
 
 	//----
-	bool Shader::CreateFromMemory(Device& owner, const void* pBin, size_t size)
+	bool Shader::CreateFromMemory(Device& owner, const void* pBin, size_t size, uint64_t hash)
 	{
 		// 作成済みの場合は失敗
 		if (module_)
@@ -34,28 +216,272 @@ namespace vsl
 			return false;
 		}
 
-		// Shaderモジュール作成
-		vk::ShaderModuleCreateInfo moduleCreateInfo;
-		moduleCreateInfo.codeSize = size;
-		moduleCreateInfo.pCode = reinterpret_cast<const uint32_t*>(pBin);
-		module_ = owner.GetDevice().createShaderModule(moduleCreateInfo);
+		// リフレクション情報の取得
+		if (!Reflect(reinterpret_cast<const uint32_t*>(pBin), size / sizeof(uint32_t)))
+		{
+			return false;
+		}
+
+		// Shaderモジュール取得
+		// 同じ内容のモジュールはDeviceのキャッシュで共有される
+		module_ = owner.GetShaderModuleCache().Acquire(pBin, size, hash);
 
 		pOwner_ = &owner;
 		return module_.operator bool();
 	}
 
+	//----
+	bool Shader::CreateFromBundle(Device& owner, const ShaderBundle& bundle, const std::string& name)
+	{
+		ShaderBundle::Blob blob;
+		if (!bundle.Find(name, blob))
+		{
+			return false;
+		}
+
+		return CreateFromMemory(owner, blob.pCode, blob.size, blob.hash);
+	}
+
 	//----
 	void Shader::Destroy()
 	{
 		if (pOwner_ && module_)
 		{
-			pOwner_->GetDevice().destroyShaderModule(module_);
+			pOwner_->GetShaderModuleCache().Release(module_);
 
 			module_ = vk::ShaderModule();
 			pOwner_ = nullptr;
 		}
 	}
 
+	//----
+	// SPIR-Vを解析してリソースのバインド情報などを取得する
+	bool Shader::Reflect(const uint32_t* pCode, size_t wordCount)
+	{
+		if (wordCount < 5 || pCode[0] != kSpvMagicNumber)
+		{
+			return false;
+		}
+
+		std::vector<SpvId> ids(pCode[3]);
+		uint32_t workgroupSizeId = kSpvInvalid;
+		bool hasEntryPoint = false;
+
+		// 命令を順に走査して必要な情報を集める
+		const uint32_t* p = pCode + 5;
+		const uint32_t* pEnd = pCode + wordCount;
+		while (p < pEnd)
+		{
+			uint32_t opcode = p[0] & 0xffff;
+			uint32_t count = p[0] >> 16;
+			if (count == 0 || p + count > pEnd)
+			{
+				return false;
+			}
+
+			switch (opcode)
+			{
+			case kSpvOpEntryPoint:
+				// 最初のエントリーポイントのみ扱う
+				if (!hasEntryPoint && count >= 4)
+				{
+					stage_ = GetSpvStage(p[1]);
+					entryPoint_ = reinterpret_cast<const char*>(p + 3);
+					hasEntryPoint = true;
+				}
+				break;
+			case kSpvOpExecutionMode:
+				if (count >= 6 && p[2] == kSpvExecutionModeLocalSize)
+				{
+					localSize_[0] = p[3];
+					localSize_[1] = p[4];
+					localSize_[2] = p[5];
+				}
+				break;
+			case kSpvOpTypeInt:
+			case kSpvOpTypeFloat:
+			case kSpvOpTypeVector:
+			case kSpvOpTypeMatrix:
+			case kSpvOpTypeImage:
+			case kSpvOpTypeSampler:
+			case kSpvOpTypeSampledImage:
+			case kSpvOpTypeArray:
+			case kSpvOpTypeRuntimeArray:
+			case kSpvOpTypeStruct:
+				if (p[1] < ids.size())
+				{
+					ids[p[1]].opcode = opcode;
+					ids[p[1]].operands.assign(p + 2, p + count);
+					if (opcode == kSpvOpTypeArray || opcode == kSpvOpTypeRuntimeArray || opcode == kSpvOpTypeSampledImage)
+					{
+						ids[p[1]].typeId = p[2];
+					}
+				}
+				break;
+			case kSpvOpTypePointer:
+				if (p[1] < ids.size())
+				{
+					ids[p[1]].opcode = opcode;
+					ids[p[1]].storageClass = p[2];
+					ids[p[1]].typeId = p[3];
+				}
+				break;
+			case kSpvOpConstant:
+			case kSpvOpSpecConstant:
+				if (p[2] < ids.size())
+				{
+					ids[p[2]].opcode = opcode;
+					ids[p[2]].typeId = p[1];
+					ids[p[2]].value = (count >= 4) ? p[3] : 0;
+				}
+				break;
+			case kSpvOpConstantComposite:
+			case kSpvOpSpecConstantComposite:
+				if (p[2] < ids.size())
+				{
+					ids[p[2]].opcode = opcode;
+					ids[p[2]].typeId = p[1];
+					ids[p[2]].operands.assign(p + 3, p + count);
+				}
+				break;
+			case kSpvOpVariable:
+				if (p[2] < ids.size())
+				{
+					ids[p[2]].opcode = opcode;
+					ids[p[2]].typeId = p[1];
+					ids[p[2]].storageClass = p[3];
+				}
+				break;
+			case kSpvOpDecorate:
+				if (p[1] < ids.size())
+				{
+					SpvId& id = ids[p[1]];
+					uint32_t value = (count >= 4) ? p[3] : 0;
+					switch (p[2])
+					{
+					case kSpvDecorationSpecId:			id.specId = value; break;
+					case kSpvDecorationBlock:			id.isBlock = true; break;
+					case kSpvDecorationBufferBlock:		id.isBufferBlock = true; break;
+					case kSpvDecorationArrayStride:		id.arrayStride = value; break;
+					case kSpvDecorationBinding:			id.binding = value; break;
+					case kSpvDecorationDescriptorSet:	id.set = value; break;
+					case kSpvDecorationBuiltIn:
+						id.builtIn = value;
+						if (value == kSpvBuiltInWorkgroupSize)
+						{
+							workgroupSizeId = p[1];
+						}
+						break;
+					}
+				}
+				break;
+			case kSpvOpMemberDecorate:
+				if (p[1] < ids.size() && count >= 5)
+				{
+					SpvId& id = ids[p[1]];
+					uint32_t member = p[2];
+					if (p[3] == kSpvDecorationOffset)
+					{
+						if (id.memberOffsets.size() <= member) id.memberOffsets.resize(member + 1, 0);
+						id.memberOffsets[member] = p[4];
+					}
+					else if (p[3] == kSpvDecorationMatrixStride)
+					{
+						if (id.memberMatrixStrides.size() <= member) id.memberMatrixStrides.resize(member + 1, 0);
+						id.memberMatrixStrides[member] = p[4];
+					}
+				}
+				break;
+			}
+
+			p += count;
+		}
+
+		if (!hasEntryPoint)
+		{
+			return false;
+		}
+
+		// リソース変数からバインド情報を作成する
+		bindings_.clear();
+		pushConstantSize_ = 0;
+		for (auto& v : ids)
+		{
+			if (v.opcode != kSpvOpVariable || v.typeId >= ids.size())
+			{
+				continue;
+			}
+			const SpvId& pointer = ids[v.typeId];
+			if (pointer.typeId >= ids.size())
+			{
+				continue;
+			}
+
+			if (v.storageClass == kSpvStorageClassPushConstant)
+			{
+				pushConstantSize_ = (std::max)(pushConstantSize_, GetSpvTypeSize(ids, pointer.typeId));
+				continue;
+			}
+			if (v.storageClass != kSpvStorageClassUniformConstant
+				&& v.storageClass != kSpvStorageClassUniform
+				&& v.storageClass != kSpvStorageClassStorageBuffer)
+			{
+				continue;
+			}
+			if (v.binding == kSpvInvalid)
+			{
+				continue;
+			}
+
+			// 配列は要素数をデスクリプタ数とする
+			ShaderResourceBinding b;
+			b.set = (v.set == kSpvInvalid) ? 0 : v.set;
+			b.binding = v.binding;
+			b.count = 1;
+			const SpvId* pType = &ids[pointer.typeId];
+			while (pType->opcode == kSpvOpTypeArray || pType->opcode == kSpvOpTypeRuntimeArray)
+			{
+				if (pType->opcode == kSpvOpTypeArray && pType->operands[1] < ids.size())
+				{
+					b.count *= ids[pType->operands[1]].value;
+				}
+				if (pType->typeId >= ids.size())
+				{
+					return false;
+				}
+				pType = &ids[pType->typeId];
+			}
+			if (!GetSpvDescriptorType(*pType, v.storageClass, b.type))
+			{
+				return false;
+			}
+			bindings_.push_back(b);
+		}
+
+		// set, binding 順に並べておく
+		std::sort(bindings_.begin(), bindings_.end(), [](const ShaderResourceBinding& l, const ShaderResourceBinding& r)
+		{
+			return (l.set != r.set) ? (l.set < r.set) : (l.binding < r.binding);
+		});
+
+		// WorkgroupSizeが定数で指定されている場合は LocalSize より優先される
+		if (workgroupSizeId != kSpvInvalid)
+		{
+			const SpvId& composite = ids[workgroupSizeId];
+			for (size_t i = 0; i < 3 && i < composite.operands.size(); i++)
+			{
+				uint32_t c = composite.operands[i];
+				if (c < ids.size())
+				{
+					localSize_[i] = ids[c].value;
+					localSizeSpecIds_[i] = ids[c].specId;
+				}
+			}
+		}
+
+		return true;
+	}
+
 }	// namespace vsl
 
 
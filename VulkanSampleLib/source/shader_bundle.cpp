@@ -0,0 +1,113 @@
+﻿#include <vsl/shader_bundle.h>
+#include <cstring>
+
+
+namespace vsl
+{
+	//----
+	bool ShaderBundle::Open(const std::string& filename)
+	{
+		Close();
+
+		if (!file_.Open(filename))
+		{
+			return false;
+		}
+
+		// ヘッダとエントリの範囲を検証する
+		const uint8_t* pData = file_.GetData();
+		size_t size = file_.GetSize();
+		if (size < sizeof(ShaderBundleHeader))
+		{
+			Close();
+			return false;
+		}
+		const ShaderBundleHeader* pHeader = reinterpret_cast<const ShaderBundleHeader*>(pData);
+		if (pHeader->magic != kShaderBundleMagic || pHeader->version != kShaderBundleVersion)
+		{
+			Close();
+			return false;
+		}
+		if (sizeof(ShaderBundleHeader) + static_cast<uint64_t>(pHeader->entryCount) * sizeof(ShaderBundleEntry) > size)
+		{
+			Close();
+			return false;
+		}
+		const ShaderBundleEntry* pEntries = reinterpret_cast<const ShaderBundleEntry*>(pData + sizeof(ShaderBundleHeader));
+		for (uint32_t i = 0; i < pHeader->entryCount; i++)
+		{
+			const ShaderBundleEntry& e = pEntries[i];
+			bool isValid = (static_cast<uint64_t>(e.nameOffset) + e.nameLength < size)
+				&& (pData[e.nameOffset + e.nameLength] == '\0')
+				&& (static_cast<uint64_t>(e.dataOffset) + e.dataSize <= size)
+				&& (e.dataOffset % kShaderBundleAlignment == 0)
+				&& (e.dataSize % sizeof(uint32_t) == 0);
+			if (!isValid)
+			{
+				Close();
+				return false;
+			}
+		}
+
+		pHeader_ = pHeader;
+		pEntries_ = pEntries;
+		return true;
+	}
+
+	//----
+	void ShaderBundle::Close()
+	{
+		pHeader_ = nullptr;
+		pEntries_ = nullptr;
+		file_.Close();
+	}
+
+	//----
+	// エントリは名前順に並んでいるので二分探索する
+	bool ShaderBundle::Find(const std::string& name, Blob& outBlob) const
+	{
+		if (!pHeader_)
+		{
+			return false;
+		}
+
+		const uint8_t* pData = file_.GetData();
+		uint32_t lo = 0, hi = pHeader_->entryCount;
+		while (lo < hi)
+		{
+			uint32_t mid = (lo + hi) / 2;
+			const ShaderBundleEntry& e = pEntries_[mid];
+			int cmp = strcmp(name.c_str(), reinterpret_cast<const char*>(pData + e.nameOffset));
+			if (cmp == 0)
+			{
+				outBlob.pCode = reinterpret_cast<const uint32_t*>(pData + e.dataOffset);
+				outBlob.size = e.dataSize;
+				outBlob.hash = e.contentHash;
+				return true;
+			}
+			if (cmp < 0)
+			{
+				hi = mid;
+			}
+			else
+			{
+				lo = mid + 1;
+			}
+		}
+		return false;
+	}
+
+	//----
+	const char* ShaderBundle::GetName(uint32_t index) const
+	{
+		if (!pHeader_ || index >= pHeader_->entryCount)
+		{
+			return nullptr;
+		}
+		return reinterpret_cast<const char*>(file_.GetData() + pEntries_[index].nameOffset);
+	}
+
+}	// namespace vsl
+
+
+//	EOF
@@ -0,0 +1,131 @@
+﻿#include <vsl/shader_module_cache.h>
+#include <vsl/device.h>
+#include <vsl/hash.h>
+#include <cstring>
+
+
+namespace vsl
+{
+	//----
+	bool ShaderModuleCache::Initialize(Device& owner)
+	{
+		pOwner_ = &owner;
+		return true;
+	}
+
+	//----
+	void ShaderModuleCache::Destroy()
+	{
+		if (pOwner_)
+		{
+			// 解放されずに残っているモジュールもここで破棄する
+			vk::Device& device = pOwner_->GetDevice();
+			for (auto& bucket : entries_)
+			{
+				for (auto& e : bucket.second)
+				{
+					device.destroyShaderModule(e.module);
+					VSL_API_COUNT(ObjectDestroy);
+				}
+			}
+			entries_.clear();
+			moduleHashes_.clear();
+		}
+		pOwner_ = nullptr;
+	}
+
+	//----
+	vk::ShaderModule ShaderModuleCache::Acquire(const void* pCode, size_t size, uint64_t hash)
+	{
+		if (!pOwner_ || !pCode || size == 0)
+		{
+			return vk::ShaderModule();
+		}
+		if (hash == 0)
+		{
+			hash = HashBytes(pCode, size);
+		}
+
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		auto& bucket = entries_[hash];
+		for (auto& e : bucket)
+		{
+			if (e.code.size() == size && memcmp(e.code.data(), pCode, size) == 0)
+			{
+				e.refCount++;
+				hitCount_++;
+				return e.module;
+			}
+		}
+
+		vk::ShaderModuleCreateInfo createInfo;
+		createInfo.codeSize = size;
+		createInfo.pCode = reinterpret_cast<const uint32_t*>(pCode);
+		vk::ShaderModule module = pOwner_->GetDevice().createShaderModule(createInfo);
+		VSL_API_COUNT(ObjectCreate);
+		if (!module)
+		{
+			return module;
+		}
+
+		Entry entry;
+		entry.code.assign(static_cast<const uint8_t*>(pCode), static_cast<const uint8_t*>(pCode) + size);
+		entry.module = module;
+		entry.refCount = 1;
+		bucket.push_back(std::move(entry));
+		moduleHashes_[static_cast<VkShaderModule>(module)] = hash;
+		return module;
+	}
+
+	//----
+	void ShaderModuleCache::Release(const vk::ShaderModule& module)
+	{
+		if (!pOwner_ || !module)
+		{
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock(mutex_);
+
+		auto hit = moduleHashes_.find(static_cast<VkShaderModule>(module));
+		if (hit == moduleHashes_.end())
+		{
+			return;
+		}
+
+		auto& bucket = entries_[hit->second];
+		for (auto it = bucket.begin(); it != bucket.end(); ++it)
+		{
+			if (it->module != module)
+			{
+				continue;
+			}
+			if (--it->refCount == 0)
+			{
+				// 破棄後に同じハンドル値が再利用されると、別のコードから生成したパイプラインが返ってしまう
+				pOwner_->GetPipelineStateCache().Invalidate(it->module);
+				pOwner_->GetDevice().destroyShaderModule(it->module);
+				VSL_API_COUNT(ObjectDestroy);
+				bucket.erase(it);
+				if (bucket.empty())
+				{
+					entries_.erase(hit->second);
+				}
+				moduleHashes_.erase(hit);
+			}
+			break;
+		}
+	}
+
+	//----
+	size_t ShaderModuleCache::GetModuleCount() const
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		return moduleHashes_.size();
+	}
+
+}	// namespace vsl
+
+
+//	EOF
@@ -120,6 +120,7 @@ namespace vsl
 			swapchainCreateInfo.compositeAlpha = vk::CompositeAlphaFlagBitsKHR::eOpaque;
 
 			swapchain_ = device.createSwapchainKHR(swapchainCreateInfo);
+			VSL_API_COUNT(ObjectCreate);
 			if (!swapchain_)
 			{
 				return false;
@@ -132,8 +133,10 @@ namespace vsl
 			for (uint32_t i = 0; i < imageCount_; i++)
 			{
 				device.destroyImageView(images_[i].view);
+				VSL_API_COUNT(ObjectDestroy);
 			}
 			device.destroySwapchainKHR(oldSwapchain);
+			VSL_API_COUNT(ObjectDestroy);
 		}
 
 		vk::ImageViewCreateInfo viewCreateInfo;
@@ -153,6 +156,7 @@ namespace vsl
 			images_[i].image = swapChainImages[i];
 			viewCreateInfo.image = swapChainImages[i];
 			images_[i].view = device.createImageView(viewCreateInfo);
+			VSL_API_COUNT(ObjectCreate);
 			images_[i].fence = vk::Fence();
 		}
 
@@ -188,16 +192,18 @@ namespace vsl
 
 		for (auto& image : images_)
 		{
-			if (image.view) device.destroyImageView(image.view);
-			if (image.fence) device.destroyFence(image.fence);
+			if (image.view) { device.destroyImageView(image.view); VSL_API_COUNT(ObjectDestroy); }
+			if (image.fence) { device.destroyFence(image.fence); VSL_API_COUNT(ObjectDestroy); }
 		}
 		device.destroySwapchainKHR(swapchain_);
+		VSL_API_COUNT(ObjectDestroy);
 		inst.destroySurfaceKHR(surface_);
 	}
 
 	//----
 	uint32_t Swapchain::AcquireNextImage(vk::Semaphore presentCompleteSemaphore)
 	{
+		VSL_CPU_SCOPE("AcquireNextImage");
 		auto resultValue = pOwner_->GetDevice().acquireNextImageKHR(swapchain_, UINT64_MAX, presentCompleteSemaphore, vk::Fence());
 		assert(resultValue.result == vk::Result::eSuccess);
 
@@ -208,6 +214,7 @@ namespace vsl
 	//----
 	vk::Result Swapchain::Present(vk::Semaphore waitSemaphore)
 	{
+		VSL_CPU_SCOPE("Present");
 		presentInfo_.waitSemaphoreCount = waitSemaphore ? 1 : 0;
 		presentInfo_.pWaitSemaphores = &waitSemaphore;
 		return pOwner_->GetQueue().presentKHR(presentInfo_);
@@ -221,18 +228,21 @@ namespace vsl
 		while (image.fence)
 		{
 			// Fenceが有効な間は完了するまで待つ
+			VSL_CPU_SCOPE("WaitFence");
 			vk::Result fenceRes = device.waitForFences(image.fence, VK_TRUE, kFenceTimeout);
 			if (fenceRes == vk::Result::eSuccess)
 			{
 				if (destroy)
 				{
 					device.destroyFence(image.fence);
+					VSL_API_COUNT(ObjectDestroy);
 				}
 				image.fence = vk::Fence();
 			}
 		}
 
 		image.fence = device.createFence(vk::FenceCreateFlags());
+		VSL_API_COUNT(ObjectCreate);
 		return image.fence;
 	}
 
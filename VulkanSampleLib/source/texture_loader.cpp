@@ -0,0 +1,201 @@
+﻿#include <vsl/texture_loader.h>
+#include <vsl/device.h>
+#include <vsl/buffer.h>
+#include <vsl/image.h>
+#include <vsl/mapped_file.h>
+#include <vsl/targa.h>
+
+
+namespace
+{
+	// Stagingバッファ上の各テクスチャの配置アライメント
+	static const vk::DeviceSize		kStagingAlignment = 16;
+
+	vk::DeviceSize AlignUp(vk::DeviceSize v, vk::DeviceSize align)
+	{
+		return (v + align - 1) & ~(align - 1);
+	}
+}	// namespace
+
+namespace vsl
+{
+	//----
+	// デコード済みイメージ
+	struct TextureLoader::DecodedImage
+	{
+		tga_image	tga;
+		bool		valid{ false };
+
+		~DecodedImage()
+		{
+			if (valid)
+			{
+				tga_free_buffers(&tga);
+			}
+		}
+
+		bool Decode(const std::string& filename)
+		{
+			MappedFile file;
+			if (!file.Open(filename))
+			{
+				return false;
+			}
+			if (tga_read_from_memory(&tga, file.GetData(), file.GetSize()) != TGA_NOERR)
+			{
+				return false;
+			}
+			valid = true;
+
+			// 24bit/32bitのフルカラーのみ対応
+			return !tga_is_colormapped(&tga) && !tga_is_mono(&tga) && (tga.pixel_depth == 24 || tga.pixel_depth == 32);
+		}
+
+		size_t GetRGBASize() const
+		{
+			return static_cast<size_t>(tga.width) * tga.height * 4;
+		}
+
+		// BGR(A) から RGBA に変換しながら書き込む
+		void WriteRGBA(uint8_t* pDst) const
+		{
+			size_t pixelCount = static_cast<size_t>(tga.width) * tga.height;
+			if (tga.pixel_depth == 32)
+			{
+				memcpy(pDst, tga.image_data, pixelCount * 4);
+				Image::SwapRedBlue(pDst, pixelCount);
+			}
+			else
+			{
+				const uint8_t* pSrc = tga.image_data;
+				for (size_t i = 0; i < pixelCount; i++, pSrc += 3, pDst += 4)
+				{
+					pDst[0] = pSrc[2];
+					pDst[1] = pSrc[1];
+					pDst[2] = pSrc[0];
+					pDst[3] = 0xff;
+				}
+			}
+		}
+	};	// struct TextureLoader::DecodedImage
+
+	//----
+	bool TextureLoader::Initialize(Device& owner)
+	{
+		pOwner_ = &owner;
+		return true;
+	}
+
+	//----
+	std::shared_future<bool> TextureLoader::Load(Image& dst, const std::string& filename)
+	{
+		Request req;
+		req.pImage = &dst;
+		req.decoded = std::make_shared<DecodedImage>();
+
+		// ファイル読み込みとデコードはワーカースレッドで実行
+		std::shared_ptr<DecodedImage> decoded = req.decoded;
+		req.result = pOwner_->GetThreadPool().Submit([decoded, filename]()
+		{
+			return decoded->Decode(filename);
+		}).share();
+
+		requests_.push_back(req);
+		return req.result;
+	}
+
+	//----
+	bool TextureLoader::Flush(vk::CommandBuffer& cmdBuff, Buffer& staging)
+	{
+		if (requests_.empty())
+		{
+			return true;
+		}
+
+		bool ret = true;
+
+		// デコード完了を待ち、Stagingバッファ上の配置を決める
+		vk::DeviceSize totalSize = 0;
+		std::vector<Request*> loaded;
+		for (auto& req : requests_)
+		{
+			if (!req.result.get())
+			{
+				ret = false;
+				continue;
+			}
+			totalSize = AlignUp(totalSize, kStagingAlignment);
+			req.offset = totalSize;
+			totalSize += req.decoded->GetRGBASize();
+			loaded.push_back(&req);
+		}
+		if (loaded.empty())
+		{
+			requests_.clear();
+			return ret;
+		}
+
+		// 全テクスチャ分のStagingバッファを1つだけ確保する
+		if (!staging.InitializeAsStaging(*pOwner_, static_cast<size_t>(totalSize)))
+		{
+			requests_.clear();
+			return false;
+		}
+
+		// RGBA変換とStagingへの書き込みはテクスチャごとに並列で行う
+		{
+			vk::Device& device = pOwner_->GetDevice();
+			uint8_t* pMapped = static_cast<uint8_t*>(device.mapMemory(staging.GetDevMem(), 0, totalSize));
+
+			std::vector<std::future<void>> writes;
+			writes.reserve(loaded.size());
+			for (auto pReq : loaded)
+			{
+				std::shared_ptr<DecodedImage> decoded = pReq->decoded;
+				uint8_t* pDst = pMapped + pReq->offset;
+				writes.push_back(pOwner_->GetThreadPool().Submit([decoded, pDst]()
+				{
+					decoded->WriteRGBA(pDst);
+				}));
+			}
+			for (auto& w : writes)
+			{
+				w.wait();
+			}
+
+			device.flushMappedMemoryRanges(vk::MappedMemoryRange(staging.GetDevMem(), 0, VK_WHOLE_SIZE));
+			device.unmapMemory(staging.GetDevMem());
+		}
+
+		// 転送コマンドは同じコマンドバッファにまとめて積む
+		for (auto pReq : loaded)
+		{
+			const tga_image& tga = pReq->decoded->tga;
+			if (!pReq->pImage->InitializeFromStaging(*pOwner_, cmdBuff, staging, vk::Format::eR8G8B8A8Unorm, tga.width, tga.height, 1, 1, pReq->offset))
+			{
+				ret = false;
+			}
+		}
+
+		requests_.clear();
+		return ret;
+	}
+
+	//----
+	void TextureLoader::Clear()
+	{
+		// 実行中のデコードは完了を待ってから破棄する
+		for (auto& req : requests_)
+		{
+			if (req.result.valid())
+			{
+				req.result.wait();
+			}
+		}
+		requests_.clear();
+	}
+
+}	// namespace vsl
+
+
+//	EOF
@@ -0,0 +1,86 @@
+﻿#include <vsl/thread_pool.h>
+#include <vsl/cpu_profiler.h>
+#include <string>
+
+
+namespace
+{
+	thread_local int	tWorkerIndex = vsl::ThreadPool::kNotWorkerThread;
+}	// namespace
+
+namespace vsl
+{
+	//----
+	bool ThreadPool::Initialize(uint32_t threadCount)
+	{
+		if (!threads_.empty())
+		{
+			return false;
+		}
+
+		if (threadCount == 0)
+		{
+			uint32_t hw = std::thread::hardware_concurrency();
+			threadCount = (hw > 1) ? hw - 1 : 1;
+		}
+
+		terminate_ = false;
+		threads_.reserve(threadCount);
+		for (uint32_t i = 0; i < threadCount; i++)
+		{
+			threads_.push_back(std::thread(&ThreadPool::WorkerMain, this, static_cast<int>(i)));
+		}
+		return true;
+	}
+
+	//----
+	void ThreadPool::Terminate()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			terminate_ = true;
+		}
+		cond_.notify_all();
+
+		// 積まれているジョブは全て処理してから終了する
+		for (auto& t : threads_)
+		{
+			t.join();
+		}
+		threads_.clear();
+	}
+
+	//----
+	int ThreadPool::GetCurrentWorkerIndex()
+	{
+		return tWorkerIndex;
+	}
+
+	//----
+	void ThreadPool::WorkerMain(int index)
+	{
+		tWorkerIndex = index;
+		VSL_CPU_THREAD_NAME("Worker " + std::to_string(index));
+
+		while (true)
+		{
+			std::function<void()> job;
+			{
+				std::unique_lock<std::mutex> lock(mutex_);
+				cond_.wait(lock, [this]() { return terminate_ || !jobs_.empty(); });
+				if (jobs_.empty())
+				{
+					break;
+				}
+				job = std::move(jobs_.front());
+				jobs_.pop_front();
+			}
+			VSL_CPU_SCOPE("ThreadPool::Job");
+			job();
+		}
+	}
+
+}	// namespace vsl
+
+
+//	EOF